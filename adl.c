@@ -20,6 +20,7 @@
 #endif
 
 #include "miner.h"
+#include "ocl.h"
 #include "ADL_SDK/adl_sdk.h"
 #include "compat.h"
 
@@ -48,7 +49,6 @@ static pthread_mutex_t adl_lock;
 struct gpu_adapters {
   int iAdapterIndex;
   int iBusNumber;
-  int virtual_gpu;
   int id;
 };
 
@@ -319,10 +319,38 @@ static bool prepare_adl(void)
   return true;
 }
 
+static pthread_t adl_thread;
+static bool adl_thread_started, adl_prepared;
+
+static void *adl_prepare_thread(__maybe_unused void *userdata)
+{
+  RenameThread("ADLInit");
+  adl_prepared = prepare_adl();
+  return NULL;
+}
+
+/* Start loading and initialising the ADL library in the background.
+ * ADL_Main_Control_Refresh alone can take seconds on a big rig. */
+void start_adl(void)
+{
+  if (!adl_thread_started && !pthread_create(&adl_thread, NULL, adl_prepare_thread, NULL))
+    adl_thread_started = true;
+}
+
+static bool wait_adl(void)
+{
+  if (!adl_thread_started)
+    return prepare_adl();
+  pthread_join(adl_thread, NULL);
+  adl_thread_started = false;
+  return adl_prepared;
+}
+
 void init_adl(int nDevs)
 {
   int result, i, j, devices = 0, last_adapter = -1, gpu = 0, dummy = 0;
-  struct gpu_adapters adapters[MAX_GPUDEVICES], vadapters[MAX_GPUDEVICES];
+  struct gpu_adapters adapters[MAX_GPUDEVICES];
+  int adl_of[MAX_GPUDEVICES], amd_gpus = 0;
   bool devs_match = true;
   ADLBiosInfo BiosInfo;
 
@@ -333,7 +361,7 @@ void init_adl(int nDevs)
     return;
   }
 
-  if (!prepare_adl())
+  if (!wait_adl())
     return;
 
   // Obtain the number of adapters for the system
@@ -418,17 +446,9 @@ void init_adl(int nDevs)
     adapters[devices].iBusNumber = lpInfo[i].iBusNumber;
     adapters[devices].id = i;
 
-    /* We found a truly new adapter instead of a logical
-     * one. Now since there's no way of correlating the
-     * opencl enumerated devices and the ADL enumerated
-     * ones, we have to assume they're in the same order.*/
-    if (++devices > nDevs && devs_match) {
-      applog(LOG_ERR, "ADL found more devices than opencl!");
-      applog(LOG_ERR, "There is possibly at least one GPU that doesn't support OpenCL");
-      applog(LOG_ERR, "Use the gpu map feature to reliably map OpenCL to ADL");
-      devs_match = false;
-    }
     last_adapter = lpAdapterID;
+    if (++devices >= MAX_GPUDEVICES)
+      break;
 
     if (!lpAdapterID) {
       applog(LOG_INFO, "Adapter returns ID 0 meaning not AMD. Card order might be confused");
@@ -436,74 +456,97 @@ void init_adl(int nDevs)
     }
   }
 
-  if (devices < nDevs) {
-    applog(LOG_ERR, "ADL found less devices than opencl!");
-    applog(LOG_ERR, "There is possibly more than one display attached to a GPU");
-    applog(LOG_ERR, "Use the gpu map feature to reliably map OpenCL to ADL");
-    devs_match = false;
-  }
+  /* Pair each OpenCL device with its ADL adapter. AMD drivers report the
+   * PCI bus of their GPUs and adapters are matched on it. Without it the
+   * AMD GPUs are assumed to be in the same order as the adapters. CPUs,
+   * accelerators and other vendors' GPUs get no adapter. */
+  for (i = 0; i < nDevs; i++) {
+    int bus;
 
-  for (i = 0; i < devices; i++) {
-    vadapters[i].virtual_gpu = i;
-    vadapters[i].id = adapters[i].id;
-  }
+    adl_of[i] = -1;
+    if (!clDeviceAMDGPU(i, &bus)) {
+      applog(LOG_INFO, "OpenCL device %d is not an AMD GPU, no hardware monitoring", i);
+      continue;
+    }
 
-  /* Apply manually provided OpenCL to ADL mapping, if any */
-  for (i = 0; i < nDevs; i++) {
     if (gpus[i].mapped) {
-      vadapters[gpus[i].virtual_adl].virtual_gpu = i;
+      if (gpus[i].virtual_adl < devices)
+        adl_of[i] = gpus[i].virtual_adl;
+      else
+        devs_match = false;
       applog(LOG_INFO, "Mapping OpenCL device %d to ADL device %d", i, gpus[i].virtual_adl);
-    } else {
-      gpus[i].virtual_adl = i;
     }
+    else if (bus >= 0) {
+      for (j = 0; j < devices && adapters[j].iBusNumber != bus; j++);
+      if (j < devices)
+        adl_of[i] = j;
+      else {
+        applog(LOG_ERR, "No ADL device found on bus %d of OpenCL device %d", bus, i);
+        devs_match = false;
+      }
+    }
+    else if (amd_gpus < devices)
+      adl_of[i] = amd_gpus;
+    else
+      devs_match = false;
+    amd_gpus++;
+  }
+
+  if (amd_gpus != devices) {
+    applog(LOG_ERR, "ADL found %d devices and OpenCL %d AMD GPUs", devices, amd_gpus);
+    applog(LOG_ERR, "Use the gpu map feature to reliably map OpenCL to ADL");
   }
 
   if (!devs_match) {
-    applog(LOG_ERR, "WARNING: Number of OpenCL and ADL devices did not match!");
+    applog(LOG_ERR, "WARNING: Not all AMD GPUs could be matched to an ADL device!");
     applog(LOG_ERR, "Hardware monitoring may NOT match up with devices!");
   } else if (opt_reorder) {
+    int order[MAX_GPUDEVICES], n = 0;
+
     /* Windows has some kind of random ordering for bus number IDs and
      * ordering the GPUs according to ascending order fixes it. Linux
-     * has usually sequential but decreasing order instead! */
-    for (i = 0; i < devices; i++) {
-      int j, virtual_gpu;
+     * has usually sequential but decreasing order instead! The GPUs with
+     * an adapter swap devices among themselves so that they follow it. */
+    for (i = 0; i < nDevs; i++)
+      if (adl_of[i] >= 0)
+        order[n++] = i;
+
+    for (i = 0; i < n; i++) {
+      int virtual_gpu = 0;
 
-      virtual_gpu = 0;
-      for (j = 0; j < devices; j++) {
+      for (j = 0; j < n; j++) {
         if (i == j)
           continue;
 #ifdef WIN32
-        if (adapters[j].iBusNumber < adapters[i].iBusNumber)
+        if (adapters[adl_of[order[j]]].iBusNumber < adapters[adl_of[order[i]]].iBusNumber)
 #else
-        if (adapters[j].iBusNumber > adapters[i].iBusNumber)
+        if (adapters[adl_of[order[j]]].iBusNumber > adapters[adl_of[order[i]]].iBusNumber)
 #endif
           virtual_gpu++;
       }
       if (virtual_gpu != i) {
         applog(LOG_INFO, "Mapping device %d to GPU %d according to Bus Number order",
-               i, virtual_gpu);
-        vadapters[virtual_gpu].virtual_gpu = i;
-        vadapters[virtual_gpu].id = adapters[i].id;
+               order[i], order[virtual_gpu]);
+        gpus[order[virtual_gpu]].virtual_gpu = order[i];
       }
     }
   }
 
-  if (devices > nDevs)
-    devices = nDevs;
-
-  for (gpu = 0; gpu < devices; gpu++) {
+  for (gpu = 0; gpu < nDevs; gpu++) {
     struct gpu_adl *ga;
     int iAdapterIndex;
     int lpAdapterID;
     ADLODPerformanceLevels *lpOdPerformanceLevels;
-    int lev, adlGpu;
+    int lev;
     size_t plsize;
     ADLBiosInfo BiosInfo;
 
-    adlGpu = gpus[gpu].virtual_adl;
-    i = vadapters[adlGpu].id;
+    /* Monitoring follows the OpenCL device the GPU mines on */
+    if (adl_of[gpus[gpu].virtual_gpu] < 0)
+      continue;
+    gpus[gpu].virtual_adl = adl_of[gpus[gpu].virtual_gpu];
+    i = adapters[gpus[gpu].virtual_adl].id;
     iAdapterIndex = lpInfo[i].iAdapterIndex;
-    gpus[gpu].virtual_gpu = vadapters[adlGpu].virtual_gpu;
 
     /* Get unique identifier of the adapter, 0 means not AMD */
     result = ADL_Adapter_ID_Get(iAdapterIndex, &lpAdapterID);
@@ -682,14 +725,16 @@ void init_adl(int nDevs)
     ga->lasttemp = __gpu_temp(ga);
   }
 
-  for (gpu = 0; gpu < devices; gpu++) {
+  for (gpu = 0; gpu < nDevs; gpu++) {
     struct gpu_adl *ga = &gpus[gpu].adl;
     int j;
 
-    for (j = 0; j < devices; j++) {
+    if (!gpus[gpu].has_adl)
+      continue;
+    for (j = 0; j < nDevs; j++) {
       struct gpu_adl *other_ga;
 
-      if (j == gpu)
+      if (j == gpu || !gpus[j].has_adl)
         continue;
 
       other_ga = &gpus[j].adl;
@@ -1396,6 +1441,33 @@ void gpu_autotune(int gpu, enum dev_enable *denable)
   ga->lasttemp = temp;
 }
 
+/* Lower the engine clock of a GPU that failed its self-test by one
+ * overdrive step and keep auto-tuning from raising it again. Returns false
+ * if the clock can't be lowered any further. */
+bool gpu_backoff(int gpu)
+{
+  struct cgpu_info *cgpu = &gpus[gpu];
+  struct gpu_adl *ga = &cgpu->adl;
+  int engine, newengine;
+
+  if (!cgpu->has_adl || !adl_active)
+    return false;
+
+  engine = gpu_engineclock(gpu) * 100;
+  if (engine <= 0 || engine <= ga->minspeed)
+    return false;
+
+  newengine = engine - ga->lpOdParameters.sEngineClock.iStep;
+  if (newengine < ga->minspeed)
+    newengine = ga->minspeed;
+
+  applog(LOG_WARNING, "GPU %d failed self-test, lowering engine clock to %d", gpu, newengine / 100);
+  if (set_engineclock(gpu, newengine / 100))
+    return false;
+  ga->maxspeed = newengine;
+  return true;
+}
+
 void set_defaultfan(int gpu)
 {
   struct gpu_adl *ga;
@@ -1767,6 +1839,13 @@ static void free_adl(void)
 #endif
 }
 
+/* Undo start_adl() when no GPU turned up to use ADL with */
+void stop_adl(void)
+{
+  if (adl_thread_started && wait_adl())
+    free_adl();
+}
+
 void clear_adl(int nDevs)
 {
   struct gpu_adl *ga;
@@ -7,6 +7,8 @@ extern bool opt_reorder;
 extern int opt_hysteresis;
 extern int opt_targettemp;
 extern int opt_overheattemp;
+void start_adl(void);
+void stop_adl(void);
 void init_adl(int nDevs);
 float gpu_temp(int gpu);
 int gpu_engineclock(int gpu);
@@ -20,14 +22,18 @@ bool gpu_stats(int gpu, float *temp, int *engineclock, int *memclock, float *vdd
                int *activity, int *fanspeed, int *fanpercent, int *powertune);
 void change_gpusettings(int gpu);
 void gpu_autotune(int gpu, enum dev_enable *denable);
+bool gpu_backoff(int gpu);
 void clear_adl(int nDevs);
 
 #else /* HAVE_ADL */
 
 #define adl_active (0)
+static inline void start_adl(void) {}
+static inline void stop_adl(void) {}
 static inline void init_adl(__maybe_unused int nDevs) {}
 static inline void change_gpusettings(__maybe_unused int gpu) { }
 static inline void clear_adl(__maybe_unused int nDevs) {}
+static inline bool gpu_backoff(__maybe_unused int gpu) { return false; }
 
 #endif /* HAVE_ADL */
 
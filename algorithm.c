@@ -123,25 +123,48 @@ void sha256d_midstate(struct work *work)
 #define CL_NEXTKERNEL_SET_ARG_0(var) CL_NEXTKERNEL_SET_ARG_N(0, var)
 #define CL_NEXTKERNEL_SET_ARG(var) CL_NEXTKERNEL_SET_ARG_N(num++, var)
 
+/* Thread concurrency is a kernel argument so intensity changes reuse the
+ * binary. N is only baked in for plain scrypt, where it never changes;
+ * N-factor coins pass it at run time too. */
 static void append_scrypt_compiler_options(struct _build_kernel_data *data, struct cgpu_info *cgpu, struct _algorithm_t *algorithm)
 {
   char buf[255];
-  sprintf(buf, " -D LOOKUP_GAP=%d -D CONCURRENT_THREADS=%u -D NFACTOR=%d",
-    cgpu->lookup_gap, (unsigned int)cgpu->thread_concurrency, algorithm->nfactor);
+  sprintf(buf, " -D LOOKUP_GAP=%d", data->lookup_gap);
   strcat(data->compiler_options, buf);
-
-  sprintf(buf, "lg%utc%unf%u", cgpu->lookup_gap, (unsigned int)cgpu->thread_concurrency, algorithm->nfactor);
+  sprintf(buf, "lg%u", data->lookup_gap);
   strcat(data->binary_filename, buf);
+
+  if (algorithm->type == ALGO_SCRYPT) {
+    sprintf(buf, " -D NFACTOR=%d", algorithm->nfactor);
+    strcat(data->compiler_options, buf);
+    sprintf(buf, "nf%u", algorithm->nfactor);
+    strcat(data->binary_filename, buf);
+  }
 }
 
+/* Only for the multi-kernel lyra2rev2 and yescrypt-multi, whose stage
+ * kernels size their buffers from MAX_GLOBAL_THREADS at build time */
 static void append_neoscrypt_compiler_options(struct _build_kernel_data *data, struct cgpu_info *cgpu, struct _algorithm_t *algorithm)
 {
   char buf[255];
   sprintf(buf, " %s-D MAX_GLOBAL_THREADS=%lu ",
-    ((cgpu->lookup_gap > 0) ? " -D LOOKUP_GAP=2 " : ""), (unsigned long)cgpu->thread_concurrency);
+    ((data->lookup_gap > 0) ? " -D LOOKUP_GAP=2 " : ""), (unsigned long)data->thread_concurrency);
+  strcat(data->compiler_options, buf);
+
+  sprintf(buf, "%stc%lu", ((data->lookup_gap > 0) ? "lg" : ""), (unsigned long)data->thread_concurrency);
+  strcat(data->binary_filename, buf);
+}
+
+/* No thread concurrency in the options or binary name, so intensity and TC
+ * changes reuse the binary. pluck and yescrypt take MAX_GLOBAL_THREADS as
+ * a kernel argument; neoscrypt doesn't use it at all */
+static void append_pluck_compiler_options(struct _build_kernel_data *data, struct cgpu_info *cgpu, struct _algorithm_t *algorithm)
+{
+  char buf[255];
+  sprintf(buf, " %s", ((data->lookup_gap > 0) ? " -D LOOKUP_GAP=2 " : ""));
   strcat(data->compiler_options, buf);
 
-  sprintf(buf, "%stc%lu", ((cgpu->lookup_gap > 0) ? "lg" : ""), (unsigned long)cgpu->thread_concurrency);
+  sprintf(buf, "%s", ((data->lookup_gap > 0) ? "lg" : ""));
   strcat(data->binary_filename, buf);
 }
 
@@ -149,10 +172,25 @@ static void append_blake256_compiler_options(struct _build_kernel_data *data, st
 {
   char buf[255];
   sprintf(buf, " -D LOOKUP_GAP=%d -D MAX_GLOBAL_THREADS=%lu ",
-    cgpu->lookup_gap, (unsigned long)cgpu->thread_concurrency);
+    data->lookup_gap, (unsigned long)data->thread_concurrency);
+  strcat(data->compiler_options, buf);
+
+  sprintf(buf, "tc%lu", (unsigned long)data->thread_concurrency);
+  strcat(data->binary_filename, buf);
+}
+
+/* Only passed when set, so kernels keep their own default placement otherwise */
+static void append_table_compiler_options(struct _build_kernel_data *data, struct cgpu_info *cgpu, struct _algorithm_t *algorithm)
+{
+  char buf[255];
+
+  if (opt_table_placement == TABLES_DEFAULT)
+    return;
+
+  sprintf(buf, " -D TABLE_PLACEMENT=%d ", opt_table_placement);
   strcat(data->compiler_options, buf);
 
-  sprintf(buf, "tc%lu", (unsigned long)cgpu->thread_concurrency);
+  sprintf(buf, "tp%d", opt_table_placement);
   strcat(data->binary_filename, buf);
 }
 
@@ -165,6 +203,8 @@ static void append_x11_compiler_options(struct _build_kernel_data *data, struct
 
   sprintf(buf, "ku%u%s%s", (unsigned int)opt_keccak_unroll, ((opt_blake_compact) ? "bc" : ""), ((opt_luffa_parallel) ? "lp" : ""));
   strcat(data->binary_filename, buf);
+
+  append_table_compiler_options(data, cgpu, algorithm);
 }
 
 
@@ -192,7 +232,7 @@ static cl_int queue_scrypt_kernel(struct __clState *clState, struct _dev_blk_ctx
 
   le_target = *(cl_uint *)(blk->work->device_target + 28);
   memcpy(clState->cldata, blk->work->data, 80);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
+  status = write_header(clState, 80);
 
   CL_SET_ARG(clState->CLbuffer0);
   CL_SET_ARG(clState->outputBuffer);
@@ -200,6 +240,8 @@ static cl_int queue_scrypt_kernel(struct __clState *clState, struct _dev_blk_ctx
   CL_SET_VARG(4, &midstate[0]);
   CL_SET_VARG(4, &midstate[16]);
   CL_SET_ARG(le_target);
+  CL_SET_ARG(clState->nfactor);
+  CL_SET_ARG(clState->thread_concurrency);
 
   return status;
 }
@@ -217,7 +259,7 @@ static cl_int queue_neoscrypt_kernel(_clState *clState, dev_blk_ctx *blk, __mayb
    * The compiler will get rid of it anyway. */
   le_target = (cl_uint)le32toh(((uint32_t *)blk->work->/*device_*/target)[7]);
   memcpy(clState->cldata, blk->work->data, 80);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
+  status = write_header(clState, 80);
 
   CL_SET_ARG(clState->CLbuffer0);
   CL_SET_ARG(clState->outputBuffer);
@@ -242,7 +284,7 @@ static cl_int queue_credits_kernel(_clState *clState, dev_blk_ctx *blk, __maybe_
 
   memcpy(clState->cldata, blk->work->data, 168);
 //  flip168(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 168, clState->cldata, 0, NULL, NULL);
+  status = write_header(clState, 168);
 
   CL_SET_ARG(clState->CLbuffer0);
   CL_SET_ARG(clState->outputBuffer);
@@ -267,7 +309,7 @@ static cl_int queue_yescrypt_kernel(_clState *clState, dev_blk_ctx *blk, __maybe
 
 //  memcpy(clState->cldata, blk->work->data, 80);
   flip80(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
+  status = write_header(clState, 80);
 
   CL_SET_ARG(clState->CLbuffer0);
   CL_SET_ARG(clState->outputBuffer);
@@ -275,6 +317,7 @@ static cl_int queue_yescrypt_kernel(_clState *clState, dev_blk_ctx *blk, __maybe
   CL_SET_ARG(clState->buffer1);
   CL_SET_ARG(clState->buffer2);
   CL_SET_ARG(le_target);
+  CL_SET_ARG(clState->thread_concurrency);
 
   return status;
 }
@@ -292,7 +335,7 @@ static cl_int queue_yescrypt_multikernel(_clState *clState, dev_blk_ctx *blk, __
   le_target = (cl_uint)le32toh(((uint32_t *)blk->work->/*device_*/target)[7]);
   memcpy(clState->cldata, blk->work->data, 80);
 //  flip80(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
+  status = write_header(clState, 80);
 //pbkdf and initial sha
   kernel = &clState->kernel;
 
@@ -353,7 +396,7 @@ static cl_int queue_maxcoin_kernel(struct __clState *clState, struct _dev_blk_ct
   cl_int status = 0;
 
   flip80(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
+  status = write_header(clState, 80);
 
   CL_SET_ARG(clState->CLbuffer0);
   CL_SET_ARG(clState->outputBuffer);
@@ -370,7 +413,52 @@ static cl_int queue_sph_kernel(struct __clState *clState, struct _dev_blk_ctx *b
 
   le_target = *(cl_ulong *)(blk->work->device_target + 24);
   flip80(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
+  status = write_header(clState, 80);
+
+  CL_SET_ARG(clState->CLbuffer0);
+  CL_SET_ARG(clState->outputBuffer);
+  CL_SET_ARG(le_target);
+
+  return status;
+}
+
+static cl_int queue_fuguecoin_kernel(struct __clState *clState, struct _dev_blk_ctx *blk, __maybe_unused cl_uint threads)
+{
+  cl_kernel *kernel = &clState->kernel;
+  unsigned int num = 0;
+  cl_ulong le_target;
+  cl_int status = 0;
+
+  le_target = *(cl_ulong *)(blk->work->device_target + 24);
+  // fuguecoin and twecoin only need the state left by fuguecoin_midstate()
+  memcpy(clState->cldata, blk->work->precalc, 120);
+  status = write_header(clState, 120);
+
+  CL_SET_ARG(clState->CLbuffer0);
+  CL_SET_ARG(clState->outputBuffer);
+  CL_SET_ARG(le_target);
+
+  return status;
+}
+
+/* Header followed by the first-block state left by calc_midstate, for
+ * the kernels that start from x11_midstate() or animecoin_midstate() */
+static cl_int write_precalc_header(struct __clState *clState, struct work *work)
+{
+  flip80(clState->cldata, work->data);
+  memcpy(clState->cldata + 80, work->precalc, 128);
+  return write_header(clState, 80 + 128);
+}
+
+static cl_int queue_animecoin_kernel(struct __clState *clState, struct _dev_blk_ctx *blk, __maybe_unused cl_uint threads)
+{
+  cl_kernel *kernel = &clState->kernel;
+  unsigned int num = 0;
+  cl_ulong le_target;
+  cl_int status = 0;
+
+  le_target = *(cl_ulong *)(blk->work->device_target + 24);
+  status = write_precalc_header(clState, blk->work);
 
   CL_SET_ARG(clState->CLbuffer0);
   CL_SET_ARG(clState->outputBuffer);
@@ -387,8 +475,7 @@ static cl_int queue_darkcoin_mod_kernel(struct __clState *clState, struct _dev_b
   cl_int status = 0;
 
   le_target = *(cl_ulong *)(blk->work->device_target + 24);
-  flip80(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
+  status = write_precalc_header(clState, blk->work);
 
   // blake - search
   kernel = &clState->kernel;
@@ -423,6 +510,92 @@ static cl_int queue_darkcoin_mod_kernel(struct __clState *clState, struct _dev_b
   return status;
 }
 
+/* Kernel arguments shared by the quark chains split at their branches */
+static cl_int set_quark_mod_args(struct __clState *clState, cl_ulong le_target)
+{
+  cl_kernel *kernel;
+  unsigned int num;
+  cl_int status = 0;
+
+  // buffer1 holds the branch counters and nonce lists filled by
+  // search1, search5 and search9 for the kernels after them
+  // blake (bmw for animecoin) - search
+  kernel = &clState->kernel;
+  num = 0;
+  CL_SET_ARG(clState->CLbuffer0);
+  CL_SET_ARG(clState->padbuffer8);
+  CL_SET_ARG(clState->buffer1);
+  // bmw (blake for animecoin), split - search1
+  kernel = clState->extra_kernels;
+  CL_SET_ARG_0(clState->padbuffer8);
+  CL_SET_ARG_N(1, clState->buffer1);
+  // groestl if bit set - search2
+  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
+  CL_SET_ARG_N(1, clState->buffer1);
+  // skein otherwise - search3
+  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
+  CL_SET_ARG_N(1, clState->buffer1);
+  // groestl - search4
+  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
+  // jh, split - search5
+  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
+  CL_SET_ARG_N(1, clState->buffer1);
+  // blake if bit set - search6
+  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
+  CL_SET_ARG_N(1, clState->buffer1);
+  // bmw otherwise - search7
+  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
+  CL_SET_ARG_N(1, clState->buffer1);
+  // keccak - search8
+  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
+  // skein, split - search9
+  CL_NEXTKERNEL_SET_ARG_0(clState->padbuffer8);
+  CL_SET_ARG_N(1, clState->buffer1);
+  // keccak if bit set - search10
+  num = 0;
+  CL_NEXTKERNEL_SET_ARG(clState->padbuffer8);
+  CL_SET_ARG(clState->buffer1);
+  CL_SET_ARG(clState->outputBuffer);
+  CL_SET_ARG(le_target);
+  // jh otherwise - search11
+  num = 0;
+  CL_NEXTKERNEL_SET_ARG(clState->padbuffer8);
+  CL_SET_ARG(clState->buffer1);
+  CL_SET_ARG(clState->outputBuffer);
+  CL_SET_ARG(le_target);
+
+  return status;
+}
+
+static cl_int queue_quarkcoin_mod_kernel(struct __clState *clState, struct _dev_blk_ctx *blk, __maybe_unused cl_uint threads)
+{
+  cl_ulong le_target;
+  cl_int status;
+
+  le_target = *(cl_ulong *)(blk->work->device_target + 24);
+  flip80(clState->cldata, blk->work->data);
+  status = write_header(clState, 80);
+  status |= set_quark_mod_args(clState, le_target);
+
+  return status;
+}
+
+static cl_int queue_animecoin_mod_kernel(struct __clState *clState, struct _dev_blk_ctx *blk, __maybe_unused cl_uint threads)
+{
+  cl_ulong le_target;
+  cl_int status;
+
+  le_target = *(cl_ulong *)(blk->work->device_target + 24);
+  status = write_precalc_header(clState, blk->work);
+  status |= set_quark_mod_args(clState, le_target);
+
+  return status;
+}
+
+/* buffer1 counters of the branch kernels search2/3, search6/7 and
+ * search10/11, in extra kernel order */
+static const int quark_mod_counters[] = { -1, 0, 1, -1, -1, 2, 3, -1, -1, 4, 5 };
+
 
 static cl_int queue_sibcoin_mod_kernel(struct __clState *clState, struct _dev_blk_ctx *blk, __maybe_unused cl_uint threads)
 {
@@ -433,7 +606,7 @@ static cl_int queue_sibcoin_mod_kernel(struct __clState *clState, struct _dev_bl
 
   le_target = *(cl_ulong *)(blk->work->device_target + 24);
   flip80(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
+  status = write_header(clState, 80);
 
   // blake - search
   kernel = &clState->kernel;
@@ -479,8 +652,7 @@ static cl_int queue_bitblock_kernel(struct __clState *clState, struct _dev_blk_c
   cl_int status = 0;
 
   le_target = *(cl_ulong *)(blk->work->device_target + 24);
-  flip80(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
+  status = write_precalc_header(clState, blk->work);
 
   // blake - search
   kernel = &clState->kernel;
@@ -532,7 +704,7 @@ static cl_int queue_bitblockold_kernel(struct __clState *clState, struct _dev_bl
 
   le_target = *(cl_ulong *)(blk->work->device_target + 24);
   flip80(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
+  status = write_header(clState, 80);
 
   // blake - search
   kernel = &clState->kernel;
@@ -576,8 +748,7 @@ static cl_int queue_marucoin_mod_kernel(struct __clState *clState, struct _dev_b
   cl_int status = 0;
 
   le_target = *(cl_ulong *)(blk->work->device_target + 24);
-  flip80(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
+  status = write_precalc_header(clState, blk->work);
 
   // blake - search
   kernel = &clState->kernel;
@@ -625,7 +796,7 @@ static cl_int queue_marucoin_mod_old_kernel(struct __clState *clState, struct _d
 
   le_target = *(cl_ulong *)(blk->work->device_target + 24);
   flip80(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
+  status = write_header(clState, 80);
 
   // blake - search
   kernel = &clState->kernel;
@@ -669,7 +840,7 @@ static cl_int queue_talkcoin_mod_kernel(struct __clState *clState, struct _dev_b
 
   le_target = *(cl_ulong *)(blk->work->device_target + 24);
   flip80(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
+  status = write_header(clState, 80);
 
   // blake - search
   kernel = &clState->kernel;
@@ -700,8 +871,7 @@ static cl_int queue_x14_kernel(struct __clState *clState, struct _dev_blk_ctx *b
   cl_int status = 0;
 
   le_target = *(cl_ulong *)(blk->work->device_target + 24);
-  flip80(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
+  status = write_precalc_header(clState, blk->work);
 
   // blake - search
   kernel = &clState->kernel;
@@ -751,7 +921,7 @@ static cl_int queue_x14_old_kernel(struct __clState *clState, struct _dev_blk_ct
 
   le_target = *(cl_ulong *)(blk->work->device_target + 24);
   flip80(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
+  status = write_header(clState, 80);
 
   // blake - search
   kernel = &clState->kernel;
@@ -795,7 +965,7 @@ static cl_int queue_fresh_kernel(struct __clState *clState, struct _dev_blk_ctx
 
   le_target = *(cl_ulong *)(blk->work->device_target + 24);
   flip80(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
+  status = write_header(clState, 80);
 
   // shavite 1 - search
   kernel = &clState->kernel;
@@ -826,7 +996,9 @@ static cl_int queue_whirlcoin_kernel(struct __clState *clState, struct _dev_blk_
 
   le_target = *(cl_ulong *)(blk->work->device_target + 24);
   flip80(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
+  // the kernel starts from the state after the first 64 bytes
+  memcpy(clState->cldata, blk->work->precalc, 64);
+  status = write_header(clState, 80);
 
   //clbuffer, hashes
   kernel = &clState->kernel;
@@ -848,32 +1020,13 @@ static cl_int queue_whirlcoin_kernel(struct __clState *clState, struct _dev_blk_
 
 static cl_int queue_whirlpoolx_kernel(struct __clState *clState, struct _dev_blk_ctx *blk, __maybe_unused cl_uint threads)
 {
-  uint64_t midblock[8], key[8] = { 0 }, tmp[8] = { 0 };
   cl_ulong le_target;
   cl_int status;
 
   le_target = *(cl_ulong *)(blk->work->device_target + 24);
   flip80(clState->cldata, blk->work->data);
 
-  memcpy(midblock, clState->cldata, 64);
-
-  // midblock = n, key = h
-  for (int i = 0; i < 10; ++i) {
-    tmp[0] = WHIRLPOOL_ROUND_CONSTANTS[i];
-    whirlpool_round(key, tmp);
-    tmp[0] = 0;
-    whirlpool_round(midblock, tmp);
-
-    for (int x = 0; x < 8; ++x) {
-      midblock[x] ^= key[x];
-    }
-  }
-
-  for (int i = 0; i < 8; ++i) {
-    midblock[i] ^= ((uint64_t *)(clState->cldata))[i];
-  }
-
-  status = clSetKernelArg(clState->kernel, 0, sizeof(cl_ulong8), (cl_ulong8 *)&midblock);
+  status = clSetKernelArg(clState->kernel, 0, sizeof(cl_ulong8), (cl_ulong8 *)blk->work->precalc);
   status |= clSetKernelArg(clState->kernel, 1, sizeof(cl_ulong), (void *)(((uint64_t *)clState->cldata) + 8));
   status |= clSetKernelArg(clState->kernel, 2, sizeof(cl_ulong), (void *)(((uint64_t *)clState->cldata) + 9));
   status |= clSetKernelArg(clState->kernel, 3, sizeof(cl_mem), (void *)&clState->outputBuffer);
@@ -891,7 +1044,7 @@ static cl_int queue_lyra2re_kernel(struct __clState *clState, struct _dev_blk_ct
 
   le_target = *(cl_ulong *)(blk->work->device_target + 24);
   flip80(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
+  status = write_header(clState, 80);
 
   // blake - search
   kernel = &clState->kernel;
@@ -936,7 +1089,7 @@ static cl_int queue_lyra2rev2_kernel(struct __clState *clState, struct _dev_blk_
   //  le_target = *(cl_uint *)(blk->work->device_target + 28);
   le_target = *(cl_ulong *)(blk->work->device_target + 24);
   flip80(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
+  status = write_header(clState, 80);
 
   // blake - search
   kernel = &clState->kernel;
@@ -989,12 +1142,13 @@ static cl_int queue_pluck_kernel(_clState *clState, dev_blk_ctx *blk, __maybe_un
 
   le_target = (cl_uint)le32toh(((uint32_t *)blk->work->/*device_*/target)[7]);
   flip80(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
+  status = write_header(clState, 80);
 
   CL_SET_ARG(clState->CLbuffer0);
   CL_SET_ARG(clState->outputBuffer);
   CL_SET_ARG(clState->padbuffer8);
   CL_SET_ARG(le_target);
+  CL_SET_ARG(clState->thread_concurrency);
 
   return status;
 }
@@ -1008,7 +1162,7 @@ static cl_int queue_blake_kernel(_clState *clState, dev_blk_ctx *blk, __maybe_un
 
   le_target = *(cl_ulong *)(blk->work->device_target + 24);
   flip80(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
+  status = write_header(clState, 80);
 
   CL_SET_ARG(clState->outputBuffer);
   CL_SET_ARG(blk->work->blk.ctx_a);
@@ -1036,7 +1190,7 @@ static cl_int queue_sia_kernel(struct __clState *clState, struct _dev_blk_ctx *b
 
   le_target = *(cl_ulong *)(blk->work->device_target + 24);
   flip80(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 80, clState->cldata, 0, NULL, NULL);
+  status = write_header(clState, 80);
 
   CL_SET_ARG(clState->CLbuffer0);
   CL_SET_ARG(clState->outputBuffer);
@@ -1087,7 +1241,7 @@ static cl_int queue_lbry_kernel(struct __clState *clState, struct _dev_blk_ctx *
 
   le_target = *(cl_ulong *)(blk->work->target + 24);
   flip112(clState->cldata, blk->work->data);
-  status = clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, 112, clState->cldata, 0, NULL, NULL);
+  status = write_header(clState, 112);
 
   CL_SET_ARG(clState->CLbuffer0);
   CL_SET_ARG(clState->padbuffer8);
@@ -1117,12 +1271,12 @@ static algorithm_settings_t algos[] = {
 #undef A_SCRYPT
 
 #define A_NEOSCRYPT(a) \
-  { a, ALGO_NEOSCRYPT, "", 1, 65536, 65536, 0, 0, 0xFF, 0xFFFF000000000000ULL, 0x0000ffffUL, 0, -1, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, neoscrypt_regenhash, NULL, NULL, queue_neoscrypt_kernel, gen_hash, append_neoscrypt_compiler_options }
+  { a, ALGO_NEOSCRYPT, "", 1, 65536, 65536, 0, 0, 0xFF, 0xFFFF000000000000ULL, 0x0000ffffUL, 0, -1, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, neoscrypt_regenhash, NULL, NULL, queue_neoscrypt_kernel, gen_hash, append_pluck_compiler_options }
   A_NEOSCRYPT("neoscrypt"),
 #undef A_NEOSCRYPT
 
 #define A_PLUCK(a) \
-  { a, ALGO_PLUCK, "", 1, 65536, 65536, 0, 0, 0xFF, 0xFFFF000000000000ULL, 0x0000ffffUL, 0, -1, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, pluck_regenhash, NULL, NULL, queue_pluck_kernel, gen_hash, append_neoscrypt_compiler_options }
+  { a, ALGO_PLUCK, "", 1, 65536, 65536, 0, 0, 0xFF, 0xFFFF000000000000ULL, 0x0000ffffUL, 0, -1, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, pluck_regenhash, NULL, NULL, queue_pluck_kernel, gen_hash, append_pluck_compiler_options }
   A_PLUCK("pluck"),
 #undef A_PLUCK
 
@@ -1137,7 +1291,7 @@ static algorithm_settings_t algos[] = {
 #undef A_DECRED
 
 #define A_YESCRYPT(a) \
-  { a, ALGO_YESCRYPT, "", 1, 65536, 65536, 0, 0, 0xFF, 0xFFFF000000000000ULL, 0x0000ffffUL, 0, -1, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, yescrypt_regenhash, NULL, NULL, queue_yescrypt_kernel, gen_hash, append_neoscrypt_compiler_options}
+  { a, ALGO_YESCRYPT, "", 1, 65536, 65536, 0, 0, 0xFF, 0xFFFF000000000000ULL, 0x0000ffffUL, 0, -1, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, yescrypt_regenhash, NULL, NULL, queue_yescrypt_kernel, gen_hash, append_pluck_compiler_options}
   A_YESCRYPT("yescrypt"),
 #undef A_YESCRYPT
 
@@ -1147,57 +1301,59 @@ static algorithm_settings_t algos[] = {
 #undef A_YESCRYPT_MULTI
 
   // kernels starting from this will have difficulty calculated by using quarkcoin algorithm
-#define A_QUARK(a, b) \
-  { a, ALGO_QUARK, "", 256, 256, 256, 0, 0, 0xFF, 0xFFFFFFULL, 0x0000ffffUL, 0, 0, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, b, NULL, NULL, queue_sph_kernel, gen_hash, append_x11_compiler_options }
-  A_QUARK("quarkcoin", quarkcoin_regenhash),
-  A_QUARK("qubitcoin", qubitcoin_regenhash),
-  A_QUARK("animecoin", animecoin_regenhash),
-  A_QUARK("sifcoin", sifcoin_regenhash),
+#define A_QUARK(a, b, c) \
+  { a, ALGO_QUARK, "", 256, 256, 256, 0, 0, 0xFF, 0xFFFFFFULL, 0x0000ffffUL, 0, 0, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, b, NULL, NULL, queue_sph_kernel, gen_hash, append_x11_compiler_options, c }
+  A_QUARK("quarkcoin", quarkcoin_regenhash, quarkcoin_regenhash_batch),
+  A_QUARK("qubitcoin", qubitcoin_regenhash, NULL),
+  { "animecoin", ALGO_QUARK, "", 256, 256, 256, 0, 0, 0xFF, 0xFFFFFFULL, 0x0000ffffUL, 0, 0, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, animecoin_regenhash, animecoin_midstate, NULL, queue_animecoin_kernel, gen_hash, append_x11_compiler_options },
+  A_QUARK("sifcoin", sifcoin_regenhash, NULL),
 #undef A_QUARK
+  { "quarkcoin-mod", ALGO_QUARK, "", 256, 256, 256, 0, 0, 0xFF, 0xFFFFFFULL, 0x0000ffffUL, 11, 8 * 16 * 4194304, 0, quarkcoin_regenhash, NULL, NULL, queue_quarkcoin_mod_kernel, gen_hash, append_x11_compiler_options, quarkcoin_regenhash_batch, quark_mod_counters },
+  { "animecoin-mod", ALGO_QUARK, "", 256, 256, 256, 0, 0, 0xFF, 0xFFFFFFULL, 0x0000ffffUL, 11, 8 * 16 * 4194304, 0, animecoin_regenhash, animecoin_midstate, NULL, queue_animecoin_mod_kernel, gen_hash, append_x11_compiler_options, NULL, quark_mod_counters },
 
   // kernels starting from this will have difficulty calculated by using bitcoin algorithm
 #define A_DARK(a, b) \
   { a, ALGO_X11, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 0, 0, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, b, NULL, NULL, queue_sph_kernel, gen_hash, append_x11_compiler_options }
-  A_DARK("darkcoin", darkcoin_regenhash),
+  { "darkcoin", ALGO_X11, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 0, 0, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, darkcoin_regenhash, NULL, NULL, queue_sph_kernel, gen_hash, append_x11_compiler_options, darkcoin_regenhash_batch },
   A_DARK("sibcoin", sibcoin_regenhash),  
   A_DARK("inkcoin", inkcoin_regenhash),
   A_DARK("myriadcoin-groestl", myriadcoin_groestl_regenhash),
 #undef A_DARK
 
-  { "twecoin", ALGO_TWE, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 0, 0, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, twecoin_regenhash, NULL, NULL, queue_sph_kernel, sha256, NULL },
+  { "twecoin", ALGO_TWE, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 0, 0, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, twecoin_regenhash, fuguecoin_midstate, NULL, queue_fuguecoin_kernel, sha256, append_table_compiler_options },
   { "maxcoin", ALGO_KECCAK, "", 1, 256, 1, 4, 15, 0x0F, 0xFFFFULL, 0x000000ffUL, 0, 0, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, maxcoin_regenhash, NULL, NULL, queue_maxcoin_kernel, sha256, NULL },
 
-  { "darkcoin-mod", ALGO_X11, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 10, 8 * 16 * 4194304, 0, darkcoin_regenhash, NULL, NULL, queue_darkcoin_mod_kernel, gen_hash, append_x11_compiler_options },
+  { "darkcoin-mod", ALGO_X11, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 10, 8 * 16 * 4194304, 0, darkcoin_regenhash, x11_midstate, NULL, queue_darkcoin_mod_kernel, gen_hash, append_x11_compiler_options, darkcoin_regenhash_batch },
 
   { "sibcoin-mod", ALGO_X11, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 11, 2 * 16 * 4194304, 0, sibcoin_regenhash, NULL, NULL, queue_sibcoin_mod_kernel, gen_hash, append_x11_compiler_options },
   
-  { "marucoin", ALGO_X13, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 0, 0, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, marucoin_regenhash, NULL, NULL, queue_sph_kernel, gen_hash, append_x13_compiler_options },
-  { "marucoin-mod", ALGO_X13, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 12, 8 * 16 * 4194304, 0, marucoin_regenhash, NULL, NULL, queue_marucoin_mod_kernel, gen_hash, append_x13_compiler_options },
-  { "marucoin-modold", ALGO_X13, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 10, 8 * 16 * 4194304, 0, marucoin_regenhash, NULL, NULL, queue_marucoin_mod_old_kernel, gen_hash, append_x13_compiler_options },
+  { "marucoin", ALGO_X13, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 0, 0, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, marucoin_regenhash, NULL, NULL, queue_sph_kernel, gen_hash, append_x13_compiler_options, marucoin_regenhash_batch },
+  { "marucoin-mod", ALGO_X13, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 12, 8 * 16 * 4194304, 0, marucoin_regenhash, x11_midstate, NULL, queue_marucoin_mod_kernel, gen_hash, append_x13_compiler_options, marucoin_regenhash_batch },
+  { "marucoin-modold", ALGO_X13, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 10, 8 * 16 * 4194304, 0, marucoin_regenhash, NULL, NULL, queue_marucoin_mod_old_kernel, gen_hash, append_x13_compiler_options, marucoin_regenhash_batch },
 
-  { "x14", ALGO_X14, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 13, 8 * 16 * 4194304, 0, x14_regenhash, NULL, NULL, queue_x14_kernel, gen_hash, append_x13_compiler_options },
-  { "x14old", ALGO_X14, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 10, 8 * 16 * 4194304, 0, x14_regenhash, NULL, NULL, queue_x14_old_kernel, gen_hash, append_x13_compiler_options },
+  { "x14", ALGO_X14, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 13, 8 * 16 * 4194304, 0, x14_regenhash, x11_midstate, NULL, queue_x14_kernel, gen_hash, append_x13_compiler_options, x14_regenhash_batch },
+  { "x14old", ALGO_X14, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 10, 8 * 16 * 4194304, 0, x14_regenhash, NULL, NULL, queue_x14_old_kernel, gen_hash, append_x13_compiler_options, x14_regenhash_batch },
 
-  { "bitblock", ALGO_X15, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 14, 4 * 16 * 4194304, 0, bitblock_regenhash, NULL, NULL, queue_bitblock_kernel, gen_hash, append_x13_compiler_options },
-  { "bitblockold", ALGO_X15, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 10, 4 * 16 * 4194304, 0, bitblock_regenhash, NULL, NULL, queue_bitblockold_kernel, gen_hash, append_x13_compiler_options },
+  { "bitblock", ALGO_X15, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 14, 4 * 16 * 4194304, 0, bitblock_regenhash, x11_midstate, NULL, queue_bitblock_kernel, gen_hash, append_x13_compiler_options, bitblock_regenhash_batch },
+  { "bitblockold", ALGO_X15, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 10, 4 * 16 * 4194304, 0, bitblock_regenhash, NULL, NULL, queue_bitblockold_kernel, gen_hash, append_x13_compiler_options, bitblock_regenhash_batch },
 
   { "talkcoin-mod", ALGO_NIST, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 4, 8 * 16 * 4194304, 0, talkcoin_regenhash, NULL, NULL, queue_talkcoin_mod_kernel, gen_hash, append_x11_compiler_options },
 
-  { "fresh", ALGO_FRESH, "", 1, 256, 256, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 4, 4 * 16 * 4194304, 0, fresh_regenhash, NULL, NULL, queue_fresh_kernel, gen_hash, NULL },
+  { "fresh", ALGO_FRESH, "", 1, 256, 256, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 4, 4 * 16 * 4194304, 0, fresh_regenhash, NULL, NULL, queue_fresh_kernel, gen_hash, append_table_compiler_options },
 
   { "lyra2re", ALGO_LYRA2RE, "", 1, 128, 128, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 4, 2 * 8 * 4194304, 0, lyra2re_regenhash, blake256_midstate, blake256_prepare_work, queue_lyra2re_kernel, gen_hash, NULL },
   { "lyra2rev2", ALGO_LYRA2REV2, "", 1, 256, 256, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 6, -1, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, lyra2rev2_regenhash, blake256_midstate, blake256_prepare_work, queue_lyra2rev2_kernel, gen_hash, append_neoscrypt_compiler_options },
 
   // kernels starting from this will have difficulty calculated by using fuguecoin algorithm
-#define A_FUGUE(a, b, c) \
-  { a, ALGO_FUGUE, "", 1, 256, 256, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 0, 0, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, b, NULL, NULL, queue_sph_kernel, c, NULL }
-  A_FUGUE("fuguecoin", fuguecoin_regenhash, sha256),
-  A_FUGUE("groestlcoin", groestlcoin_regenhash, sha256),
-  A_FUGUE("diamond", groestlcoin_regenhash, gen_hash),
+  { "fuguecoin", ALGO_FUGUE, "", 1, 256, 256, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 0, 0, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, fuguecoin_regenhash, fuguecoin_midstate, NULL, queue_fuguecoin_kernel, sha256, NULL },
+#define A_FUGUE(a, b, c, d) \
+  { a, ALGO_FUGUE, "", 1, 256, 256, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 0, 0, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, b, NULL, NULL, queue_sph_kernel, c, d }
+  A_FUGUE("groestlcoin", groestlcoin_regenhash, sha256, append_table_compiler_options),
+  A_FUGUE("diamond", groestlcoin_regenhash, gen_hash, append_table_compiler_options),
 #undef A_FUGUE
 
-  { "whirlcoin", ALGO_WHIRL, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 3, 8 * 16 * 4194304, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, whirlcoin_regenhash, NULL, NULL, queue_whirlcoin_kernel, sha256, NULL },
-  { "whirlpoolx", ALGO_WHIRLPOOLX, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000FFFFUL, 0, 0, 0, whirlpoolx_regenhash, NULL, NULL, queue_whirlpoolx_kernel, gen_hash, NULL },
+  { "whirlcoin", ALGO_WHIRL, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000ffffUL, 3, 8 * 16 * 4194304, CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, whirlcoin_regenhash, whirlcoin_midstate, NULL, queue_whirlcoin_kernel, sha256, NULL },
+  { "whirlpoolx", ALGO_WHIRLPOOLX, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x0000FFFFUL, 0, 0, 0, whirlpoolx_regenhash, whirlpoolx_midstate, NULL, queue_whirlpoolx_kernel, gen_hash, NULL },
 
   { "blake256r8",  ALGO_BLAKECOIN, "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x000000ffUL, 0, 128, 0, blakecoin_regenhash, blakecoin_midstate, blakecoin_prepare_work, queue_blake_kernel, sha256,   NULL },
   { "blake256r14", ALGO_BLAKE,     "", 1, 1, 1, 0, 0, 0xFF, 0xFFFFULL, 0x00000000UL, 0, 128, 0, blake256_regenhash, blake256_midstate, blake256_prepare_work, queue_blake_kernel, gen_hash, NULL },
@@ -1240,6 +1396,8 @@ void copy_algorithm_settings(algorithm_t* dest, const char* algo)
       dest->queue_kernel = src->queue_kernel;
       dest->gen_hash = src->gen_hash;
       dest->set_compile_options = src->set_compile_options;
+      dest->regenhash_batch = src->regenhash_batch;
+      dest->extra_kernel_counters = src->extra_kernel_counters;
       break;
     }
   }
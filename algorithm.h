@@ -79,6 +79,8 @@ typedef struct _algorithm_t {
   cl_int(*queue_kernel)(struct __clState *, struct _dev_blk_ctx *, cl_uint);
   void(*gen_hash)(const unsigned char *, unsigned int, unsigned char *);
   void(*set_compile_options)(struct _build_kernel_data *, struct cgpu_info *, struct _algorithm_t *);
+  void(*regenhash_batch)(struct work *, const uint32_t *, unsigned int, unsigned char (*)[32]); /* optional, several nonces of one work */
+  const int *extra_kernel_counters; /* optional, see algorithm_settings_t */
 } algorithm_t;
 
 typedef struct _algorithm_settings_t
@@ -103,6 +105,11 @@ typedef struct _algorithm_settings_t
 	cl_int   (*queue_kernel)(struct __clState *, struct _dev_blk_ctx *, cl_uint);
 	void     (*gen_hash)(const unsigned char *, unsigned int, unsigned char *);
 	void     (*set_compile_options)(build_kernel_data *, struct cgpu_info *, algorithm_t *);
+	void     (*regenhash_batch)(struct work *, const uint32_t *, unsigned int, unsigned char (*)[32]);
+	/* For each extra kernel, the buffer1 word counting the items it hashes,
+	 * or -1 to launch it over the whole range. Counters come in pairs, the
+	 * two sides of one branch, and are read back before the first side. */
+	const int *extra_kernel_counters;
 } algorithm_settings_t;
 
 /* Set default parameters based on name. */
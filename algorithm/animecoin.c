@@ -38,6 +38,8 @@
 #include "sph/sph_jh.h"
 #include "sph/sph_keccak.h" 
 
+#include "chainhash.h"
+
 #ifdef __APPLE_CC__
 static
 #endif
@@ -52,76 +54,76 @@ void animehash(void *state, const void *input)
     
     unsigned char hash[64];
 
-    sph_bmw512_init(&ctx_bmw);
+    CHAINHASH_INIT(&ctx_bmw, bmw512);
     // ZBMW;
     sph_bmw512 (&ctx_bmw, input, 80);
     sph_bmw512_close(&ctx_bmw, (void*) hash);
 
-    sph_blake512_init(&ctx_blake);
+    CHAINHASH_INIT(&ctx_blake, blake512);
     // ZBLAKE;
     sph_blake512 (&ctx_blake, (const void*) hash, 64);
     sph_blake512_close(&ctx_blake, (void*) hash);
     
     if (hash[0] & 0x8)
     {
-        sph_groestl512_init(&ctx_groestl);
+        CHAINHASH_INIT(&ctx_groestl, groestl512);
         // ZGROESTL;
         sph_groestl512 (&ctx_groestl, (const void*) hash, 64);
         sph_groestl512_close(&ctx_groestl, (void*) hash);
     }
     else
     {
-        sph_skein512_init(&ctx_skein);
+        CHAINHASH_INIT(&ctx_skein, skein512);
         // ZSKEIN;
         sph_skein512 (&ctx_skein, (const void*) hash, 64);
         sph_skein512_close(&ctx_skein, (void*) hash);
     }
     
-    sph_groestl512_init(&ctx_groestl);
+    CHAINHASH_INIT(&ctx_groestl, groestl512);
     // ZGROESTL;
     sph_groestl512 (&ctx_groestl, (const void*) hash, 64);
     sph_groestl512_close(&ctx_groestl, (void*) hash);
 
-    sph_jh512_init(&ctx_jh);
+    CHAINHASH_INIT(&ctx_jh, jh512);
     // ZJH;
     sph_jh512 (&ctx_jh, (const void*) hash, 64);
     sph_jh512_close(&ctx_jh, (void*) hash);
 
     if (hash[0] & 0x8)
     {
-        sph_blake512_init(&ctx_blake);
+        CHAINHASH_INIT(&ctx_blake, blake512);
         // ZBLAKE;
         sph_blake512 (&ctx_blake, (const void*) hash, 64);
         sph_blake512_close(&ctx_blake, (void*) hash);
     }
     else
     {
-        sph_bmw512_init(&ctx_bmw);
+        CHAINHASH_INIT(&ctx_bmw, bmw512);
         // ZBMW;
         sph_bmw512 (&ctx_bmw, (const void*) hash, 64);
         sph_bmw512_close(&ctx_bmw, (void*) hash);
     }
 
-    sph_keccak512_init(&ctx_keccak);
+    CHAINHASH_INIT(&ctx_keccak, keccak512);
     // ZKECCAK;
     sph_keccak512 (&ctx_keccak, (const void*) hash, 64);
     sph_keccak512_close(&ctx_keccak, (void*) hash);
 
-    sph_skein512_init(&ctx_skein);
+    CHAINHASH_INIT(&ctx_skein, skein512);
     // SKEIN;
     sph_skein512 (&ctx_skein, (const void*) hash, 64);
     sph_skein512_close(&ctx_skein, (void*) hash);
 
     if (hash[0] & 0x8)
     {
-        sph_keccak512_init(&ctx_keccak);
+        CHAINHASH_INIT(&ctx_keccak, keccak512);
         // ZKECCAK;
         sph_keccak512 (&ctx_keccak, (const void*) hash, 64);
         sph_keccak512_close(&ctx_keccak, (void*) hash);
     }
     else
     {
-        sph_jh512_init(&ctx_jh);
+        CHAINHASH_INIT(&ctx_jh, jh512);
         // ZJH;
         sph_jh512 (&ctx_jh, (const void*) hash, 64);
         sph_jh512_close(&ctx_jh, (void*) hash);
@@ -155,6 +157,71 @@ int animecoin_test(unsigned char *pdata, const unsigned char *ptarget, uint32_t
 	return 1;
 }
 
+/* The BMW-512 stage hashes the 80-byte header in one block, and the nonce
+ * only enters at message word 9.  Eleven of the sixteen first-round words
+ * do not use it, so they are computed here once per work; for the other
+ * five this stores the sum of the four terms without word 9. */
+#define SHL(x, n) ((x) << (n))
+#define SHR(x, n) ((x) >> (n))
+#define ROTL64(x, n) (((x) << (n)) | ((x) >> (64 - (n))))
+#define BMW_S0(x) (SHR(x, 1) ^ SHL(x, 3) ^ ROTL64(x, 4) ^ ROTL64(x, 37))
+#define BMW_S1(x) (SHR(x, 1) ^ SHL(x, 2) ^ ROTL64(x, 13) ^ ROTL64(x, 43))
+#define BMW_S2(x) (SHR(x, 2) ^ SHL(x, 1) ^ ROTL64(x, 19) ^ ROTL64(x, 53))
+#define BMW_S3(x) (SHR(x, 2) ^ SHL(x, 2) ^ ROTL64(x, 28) ^ ROTL64(x, 59))
+#define BMW_S4(x) (SHR(x, 1) ^ (x))
+
+void animecoin_midstate(struct work *work)
+{
+  static const uint64_t iv[16] = {
+    0x8081828384858687ULL, 0x88898A8B8C8D8E8FULL, 0x9091929394959697ULL, 0x98999A9B9C9D9E9FULL,
+    0xA0A1A2A3A4A5A6A7ULL, 0xA8A9AAABACADAEAFULL, 0xB0B1B2B3B4B5B6B7ULL, 0xB8B9BABBBCBDBEBFULL,
+    0xC0C1C2C3C4C5C6C7ULL, 0xC8C9CACBCCCDCECFULL, 0xD0D1D2D3D4D5D6D7ULL, 0xD8D9DADBDCDDDEDFULL,
+    0xE0E1E2E3E4E5E6E7ULL, 0xE8E9EAEBECEDEEEFULL, 0xF0F1F2F3F4F5F6F7ULL, 0xF8F9FAFBFCFDFEFFULL
+  };
+  const uint32_t *data = (const uint32_t *)work->data;
+  uint64_t w[16], q[16];
+  int i;
+
+  for (i = 0; i < 9; i++)
+    w[i] = (((uint64_t)be32toh(data[2 * i + 1]) << 32) | be32toh(data[2 * i])) ^ iv[i];
+  /* word 9 carries the nonce and is added on the GPU */
+  w[9] = 0;
+  w[10] = 0x80 ^ iv[10];
+  w[11] = iv[11];
+  w[12] = iv[12];
+  w[13] = iv[13];
+  w[14] = iv[14];
+  w[15] = 0x280 ^ iv[15];
+
+  q[0] = BMW_S0(w[5] - w[7] + w[10] + w[13] + w[14]) + iv[1];
+  q[1] = BMW_S1(w[6] - w[8] + w[11] + w[14] - w[15]) + iv[2];
+  q[2] = w[0] + w[7] - w[12] + w[15];
+  q[3] = BMW_S3(w[0] - w[1] + w[8] - w[10] + w[13]) + iv[4];
+  q[4] = w[1] + w[2] - w[11] - w[14];
+  q[5] = BMW_S0(w[3] - w[2] + w[10] - w[12] + w[15]) + iv[6];
+  q[6] = BMW_S1(w[4] - w[0] - w[3] - w[11] + w[13]) + iv[7];
+  q[7] = BMW_S2(w[1] - w[4] - w[5] - w[12] - w[14]) + iv[8];
+  q[8] = BMW_S3(w[2] - w[5] - w[6] + w[13] - w[15]) + iv[9];
+  q[9] = BMW_S4(w[0] - w[3] + w[6] - w[7] + w[14]) + iv[10];
+  q[10] = BMW_S0(w[8] - w[1] - w[4] - w[7] + w[15]) + iv[11];
+  q[11] = w[8] - w[0] - w[2] - w[5];
+  q[12] = w[1] + w[3] - w[6] + w[10];
+  q[13] = BMW_S3(w[2] + w[4] + w[7] + w[10] + w[11]) + iv[14];
+  q[14] = BMW_S4(w[3] - w[5] + w[8] - w[11] - w[12]) + iv[15];
+  q[15] = w[12] - w[4] - w[6] + w[13];
+
+  memcpy(work->precalc, q, sizeof(q));
+}
+
+#undef BMW_S4
+#undef BMW_S3
+#undef BMW_S2
+#undef BMW_S1
+#undef BMW_S0
+#undef ROTL64
+#undef SHR
+#undef SHL
+
 void animecoin_regenhash(struct work *work)
 {
         uint32_t data[20];
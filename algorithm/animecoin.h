@@ -6,5 +6,6 @@
 extern int animecoin_test(unsigned char *pdata, const unsigned char *ptarget,
 			uint32_t nonce);
 extern void animecoin_regenhash(struct work *work);
+extern void animecoin_midstate(struct work *work);
 
 #endif /* ANIMECOIN_H */
@@ -51,7 +51,8 @@
 #include "sph/sph_shabal.h"
 #include "sph/sph_whirlpool.h"
 
-/* Move init out of loop, so init once externally, and then use one single memcpy with that bigger memory block */
+#include "chainhash.h"
+
 typedef struct {
     sph_blake512_context    blake1;
     sph_bmw512_context      bmw1;
@@ -70,88 +71,89 @@ typedef struct {
     sph_whirlpool_context   whirlpool1;
 } Xhash_context_holder;
 
-static Xhash_context_holder base_contexts;
-
-
-void init_Bhash_contexts()
+/* The luffa, cubehash, shavite, simd, echo, hamsi, fugue, shabal and
+ * whirlpool stages, from the 64-byte keccak output */
+static void bitblock_tail(void *state, const void *input)
 {
-    sph_blake512_init(&base_contexts.blake1);
-    sph_bmw512_init(&base_contexts.bmw1);
-    sph_groestl512_init(&base_contexts.groestl1);
-    sph_skein512_init(&base_contexts.skein1);
-    sph_jh512_init(&base_contexts.jh1);
-    sph_keccak512_init(&base_contexts.keccak1);
-    sph_luffa512_init(&base_contexts.luffa1);
-    sph_cubehash512_init(&base_contexts.cubehash1);
-    sph_shavite512_init(&base_contexts.shavite1);
-    sph_simd512_init(&base_contexts.simd1);
-    sph_echo512_init(&base_contexts.echo1);
-    sph_hamsi512_init(&base_contexts.hamsi1);
-    sph_fugue512_init(&base_contexts.fugue1);
-    sph_shabal512_init(&base_contexts.shabal1);
-    sph_whirlpool_init(&base_contexts.whirlpool1);
-}
-
-#ifdef __APPLE_CC__
-static
-#endif
-void bitblockhash(void *state, const void *input)
-{
-    init_Bhash_contexts();
-
     Xhash_context_holder ctx;
 
     uint32_t hashA[16], hashB[16];
 
-    memcpy(&ctx, &base_contexts, sizeof(base_contexts));
-
-    sph_blake512 (&ctx.blake1, input, 80);
-    sph_blake512_close (&ctx.blake1, hashA);
-
-    sph_bmw512 (&ctx.bmw1, hashA, 64);
-    sph_bmw512_close(&ctx.bmw1, hashB);
-
-    sph_groestl512 (&ctx.groestl1, hashB, 64);
-    sph_groestl512_close(&ctx.groestl1, hashA);
-
-    sph_skein512 (&ctx.skein1, hashA, 64);
-    sph_skein512_close(&ctx.skein1, hashB);
-
-    sph_jh512 (&ctx.jh1, hashB, 64);
-    sph_jh512_close(&ctx.jh1, hashA);
-
-    sph_keccak512 (&ctx.keccak1, hashA, 64);
-    sph_keccak512_close(&ctx.keccak1, hashB);
+    memcpy(hashB, input, 64);
 
+    CHAINHASH_INIT(&ctx.luffa1, luffa512);
     sph_luffa512 (&ctx.luffa1, hashB, 64);
     sph_luffa512_close (&ctx.luffa1, hashA);
 
+    CHAINHASH_INIT(&ctx.cubehash1, cubehash512);
     sph_cubehash512 (&ctx.cubehash1, hashA, 64);
     sph_cubehash512_close(&ctx.cubehash1, hashB);
 
+    CHAINHASH_INIT(&ctx.shavite1, shavite512);
     sph_shavite512 (&ctx.shavite1, hashB, 64);
     sph_shavite512_close(&ctx.shavite1, hashA);
 
+    CHAINHASH_INIT(&ctx.simd1, simd512);
     sph_simd512 (&ctx.simd1, hashA, 64);
     sph_simd512_close(&ctx.simd1, hashB);
 
+    CHAINHASH_INIT(&ctx.echo1, echo512);
     sph_echo512 (&ctx.echo1, hashB, 64);
     sph_echo512_close(&ctx.echo1, hashA);
 
+    CHAINHASH_INIT(&ctx.hamsi1, hamsi512);
     sph_hamsi512 (&ctx.hamsi1, hashA, 64);
     sph_hamsi512_close(&ctx.hamsi1, hashB);
 
+    CHAINHASH_INIT(&ctx.fugue1, fugue512);
     sph_fugue512 (&ctx.fugue1, hashB, 64);
     sph_fugue512_close(&ctx.fugue1, hashA);
 
+    CHAINHASH_INIT(&ctx.shabal1, shabal512);
     sph_shabal512 (&ctx.shabal1, (const unsigned char*)hashA, 64);
     sph_shabal512_close(&ctx.shabal1, hashB);
 
+    CHAINHASH_INIT(&ctx.whirlpool1, whirlpool);
     sph_whirlpool (&ctx.whirlpool1, hashB, 64);
     sph_whirlpool_close(&ctx.whirlpool1, hashA);
 
     memcpy(state, hashA, 32);
+}
 
+#ifdef __APPLE_CC__
+static
+#endif
+void bitblockhash(void *state, const void *input)
+{
+    Xhash_context_holder ctx;
+
+    uint32_t hashA[16], hashB[16];
+
+    CHAINHASH_INIT(&ctx.blake1, blake512);
+    sph_blake512 (&ctx.blake1, input, 80);
+    sph_blake512_close (&ctx.blake1, hashA);
+
+    CHAINHASH_INIT(&ctx.bmw1, bmw512);
+    sph_bmw512 (&ctx.bmw1, hashA, 64);
+    sph_bmw512_close(&ctx.bmw1, hashB);
+
+    CHAINHASH_INIT(&ctx.groestl1, groestl512);
+    sph_groestl512 (&ctx.groestl1, hashB, 64);
+    sph_groestl512_close(&ctx.groestl1, hashA);
+
+    CHAINHASH_INIT(&ctx.skein1, skein512);
+    sph_skein512 (&ctx.skein1, hashA, 64);
+    sph_skein512_close(&ctx.skein1, hashB);
+
+    CHAINHASH_INIT(&ctx.jh1, jh512);
+    sph_jh512 (&ctx.jh1, hashB, 64);
+    sph_jh512_close(&ctx.jh1, hashA);
+
+    CHAINHASH_INIT(&ctx.keccak1, keccak512);
+    sph_keccak512 (&ctx.keccak1, hashA, 64);
+    sph_keccak512_close(&ctx.keccak1, hashB);
+
+    bitblock_tail(state, hashB);
 }
 
 static const uint32_t diff1targ = 0x0000ffff;
@@ -190,6 +192,13 @@ void bitblock_regenhash(struct work *work)
   bitblockhash(ohash, data);
 }
 
+/* Same hashes as bitblock_regenhash for several nonces of one work item */
+void bitblock_regenhash_batch(struct work *work, const uint32_t *nonces,
+                              unsigned int count, unsigned char (*hashes)[32])
+{
+  chainhash_x6_batch(work, nonces, count, hashes, bitblock_tail);
+}
+
 bool scanhash_bitblock(struct thr_info *thr, const unsigned char __maybe_unused *pmidstate,
          unsigned char *pdata, unsigned char __maybe_unused *phash1,
          unsigned char __maybe_unused *phash, const unsigned char *ptarget,
@@ -6,5 +6,7 @@
 extern int bitblock_test(unsigned char *pdata, const unsigned char *ptarget,
 			uint32_t nonce);
 extern void bitblock_regenhash(struct work *work);
+extern void bitblock_regenhash_batch(struct work *work, const uint32_t *nonces,
+			unsigned int count, unsigned char (*hashes)[32]);
 
 #endif /* BITBLOCK_H */
@@ -0,0 +1,105 @@
+#include "config.h"
+
+#include <pthread.h>
+#include <string.h>
+
+#include "miner.h"
+#include "algorithm/chainhash.h"
+#include "sph/sph_4way.h"
+
+#if defined(__GNUC__)
+#define CACHE_ALIGN __attribute__ ((aligned(64)))
+#elif defined(_MSC_VER)
+#define CACHE_ALIGN __declspec(align(64))
+#else
+#define CACHE_ALIGN
+#endif
+
+static pthread_once_t templates_once = PTHREAD_ONCE_INIT;
+static CACHE_ALIGN chainhash_templates templates;
+
+static void init_chainhash_templates(void)
+{
+	sph_blake256_init(&templates.blake256);
+	sph_blake512_init(&templates.blake512);
+	sph_bmw256_init(&templates.bmw256);
+	sph_bmw512_init(&templates.bmw512);
+	sph_groestl256_init(&templates.groestl256);
+	sph_groestl512_init(&templates.groestl512);
+	sph_skein256_init(&templates.skein256);
+	sph_skein512_init(&templates.skein512);
+	sph_jh512_init(&templates.jh512);
+	sph_keccak256_init(&templates.keccak256);
+	sph_keccak512_init(&templates.keccak512);
+	sph_luffa512_init(&templates.luffa512);
+	sph_cubehash256_init(&templates.cubehash256);
+	sph_cubehash512_init(&templates.cubehash512);
+	sph_shavite256_init(&templates.shavite256);
+	sph_shavite512_init(&templates.shavite512);
+	sph_simd512_init(&templates.simd512);
+	sph_echo512_init(&templates.echo512);
+	sph_hamsi256_init(&templates.hamsi256);
+	sph_hamsi512_init(&templates.hamsi512);
+	sph_fugue256_init(&templates.fugue256);
+	sph_fugue512_init(&templates.fugue512);
+	sph_shabal512_init(&templates.shabal512);
+	sph_whirlpool_init(&templates.whirlpool);
+	sph_whirlpool1_init(&templates.whirlpool1);
+	sph_gost512_init(&templates.gost512);
+	sph_panama_init(&templates.panama);
+	sph_sha256_init(&templates.sha256);
+	sph_sha512_init(&templates.sha512);
+	sph_ripemd160_init(&templates.ripemd160);
+}
+
+const chainhash_templates *get_chainhash_templates(void)
+{
+	pthread_once(&templates_once, init_chainhash_templates);
+	return &templates;
+}
+
+void chainhash_x6_batch(struct work *work, const uint32_t *nonces,
+	unsigned int count, unsigned char (*hashes)[32], chainhash_tail_fn tail)
+{
+	uint32_t data[SPH_4WAY_LANES][20];
+	uint32_t hashA[SPH_4WAY_LANES][16], hashB[SPH_4WAY_LANES][16];
+	void *dstA[SPH_4WAY_LANES], *dstB[SPH_4WAY_LANES];
+	const void *srcA[SPH_4WAY_LANES], *srcD[SPH_4WAY_LANES];
+	unsigned int i, l;
+
+	for (l = 0; l < SPH_4WAY_LANES; l++) {
+		be32enc_vect(data[l], (const uint32_t *)work->data, 19);
+		dstA[l] = hashA[l];
+		dstB[l] = hashB[l];
+		srcA[l] = hashA[l];
+		srcD[l] = data[l];
+	}
+
+	for (i = 0; i < count; i += SPH_4WAY_LANES) {
+		/* a short last group repeats its final nonce */
+		for (l = 0; l < SPH_4WAY_LANES; l++)
+			data[l][19] = htobe32(htole32(nonces[MIN(i + l, count - 1)]));
+
+		sph_blake512_4way(dstA, srcD, 80);
+		sph_bmw512_4way(dstB, srcA, 64);
+		for (l = 0; l < SPH_4WAY_LANES; l++) {
+			sph_groestl512_context ctx_groestl;
+
+			CHAINHASH_INIT(&ctx_groestl, groestl512);
+			sph_groestl512(&ctx_groestl, hashB[l], 64);
+			sph_groestl512_close(&ctx_groestl, hashA[l]);
+		}
+		sph_skein512_4way(dstB, srcA, 64);
+		for (l = 0; l < SPH_4WAY_LANES; l++) {
+			sph_jh512_context ctx_jh;
+
+			CHAINHASH_INIT(&ctx_jh, jh512);
+			sph_jh512(&ctx_jh, hashB[l], 64);
+			sph_jh512_close(&ctx_jh, hashA[l]);
+		}
+		sph_keccak512_4way(dstB, srcA, 64);
+
+		for (l = 0; l < SPH_4WAY_LANES && i + l < count; l++)
+			tail(hashes[i + l], hashB[l]);
+	}
+}
@@ -0,0 +1,88 @@
+#ifndef CHAINHASH_H
+#define CHAINHASH_H
+
+#include <stdint.h>
+
+#include "sph/sph_blake.h"
+#include "sph/sph_bmw.h"
+#include "sph/sph_groestl.h"
+#include "sph/sph_jh.h"
+#include "sph/sph_keccak.h"
+#include "sph/sph_skein.h"
+#include "sph/sph_luffa.h"
+#include "sph/sph_cubehash.h"
+#include "sph/sph_shavite.h"
+#include "sph/sph_simd.h"
+#include "sph/sph_echo.h"
+#include "sph/sph_hamsi.h"
+#include "sph/sph_fugue.h"
+#include "sph/sph_shabal.h"
+#include "sph/sph_whirlpool.h"
+#include "sph/sph_gost.h"
+#include "sph/sph_panama.h"
+#include "sph/sph_sha2.h"
+#include "sph/sph_ripemd.h"
+
+/*
+ * Freshly initialised sph contexts for every stage of the chained CPU
+ * hashes.  The set is built once, on first use, and never written again,
+ * so any thread may copy from it.  A hash copies only the stages it runs:
+ *
+ *	sph_blake512_context ctx_blake;
+ *
+ *	CHAINHASH_INIT(&ctx_blake, blake512);
+ *	sph_blake512(&ctx_blake, input, 80);
+ */
+typedef struct {
+	sph_blake256_context    blake256;
+	sph_blake512_context    blake512;
+	sph_bmw256_context      bmw256;
+	sph_bmw512_context      bmw512;
+	sph_groestl256_context  groestl256;
+	sph_groestl512_context  groestl512;
+	sph_skein256_context    skein256;
+	sph_skein512_context    skein512;
+	sph_jh512_context       jh512;
+	sph_keccak256_context   keccak256;
+	sph_keccak512_context   keccak512;
+	sph_luffa512_context    luffa512;
+	sph_cubehash256_context cubehash256;
+	sph_cubehash512_context cubehash512;
+	sph_shavite256_context  shavite256;
+	sph_shavite512_context  shavite512;
+	sph_simd512_context     simd512;
+	sph_echo512_context     echo512;
+	sph_hamsi256_context    hamsi256;
+	sph_hamsi512_context    hamsi512;
+	sph_fugue256_context    fugue256;
+	sph_fugue512_context    fugue512;
+	sph_shabal512_context   shabal512;
+	sph_whirlpool_context   whirlpool;
+	sph_whirlpool1_context  whirlpool1;
+	sph_gost512_context     gost512;
+	sph_panama_context      panama;
+	sph_sha256_context      sha256;
+	sph_sha512_context      sha512;
+	sph_ripemd160_context   ripemd160;
+} chainhash_templates;
+
+extern const chainhash_templates *get_chainhash_templates(void);
+
+#define CHAINHASH_INIT(ctx, name) \
+	(*(ctx) = get_chainhash_templates()->name)
+
+struct work;
+
+/*
+ * Batch regenhash for the X11 family.  Runs the blake, bmw, groestl,
+ * skein, jh and keccak stages the chains start with on four nonces of one
+ * work at a time, with the sph_4way.h versions of blake, bmw, skein and
+ * keccak, then calls tail() on each nonce's 64-byte keccak output to run
+ * the rest of the chain and write its 32-byte hash.
+ */
+typedef void (*chainhash_tail_fn)(void *state, const void *input);
+
+extern void chainhash_x6_batch(struct work *work, const uint32_t *nonces,
+	unsigned int count, unsigned char (*hashes)[32], chainhash_tail_fn tail);
+
+#endif /* CHAINHASH_H */
@@ -47,7 +47,8 @@
 #include "sph/sph_simd.h"
 #include "sph/sph_echo.h"
 
-/* Move init out of loop, so init once externally, and then use one single memcpy with that bigger memory block */
+#include "chainhash.h"
+
 typedef struct {
     sph_blake512_context    blake1;
     sph_bmw512_context      bmw1;
@@ -62,69 +63,71 @@ typedef struct {
     sph_echo512_context     echo1;
 } Xhash_context_holder;
 
-static Xhash_context_holder base_contexts;
+/* The luffa, cubehash, shavite, simd and echo stages, from the 64-byte
+ * keccak output */
+static void x11_tail(void *state, const void *input)
+{
+    Xhash_context_holder ctx;
+
+    uint32_t hashA[16], hashB[16];
 
+    memcpy(hashB, input, 64);
 
-static void init_Xhash_contexts()
-{
-    sph_blake512_init(&base_contexts.blake1);
-    sph_bmw512_init(&base_contexts.bmw1);
-    sph_groestl512_init(&base_contexts.groestl1);
-    sph_skein512_init(&base_contexts.skein1);
-    sph_jh512_init(&base_contexts.jh1);
-    sph_keccak512_init(&base_contexts.keccak1);
-    sph_luffa512_init(&base_contexts.luffa1);
-    sph_cubehash512_init(&base_contexts.cubehash1);
-    sph_shavite512_init(&base_contexts.shavite1);
-    sph_simd512_init(&base_contexts.simd1);
-    sph_echo512_init(&base_contexts.echo1);
+    CHAINHASH_INIT(&ctx.luffa1, luffa512);
+    sph_luffa512 (&ctx.luffa1, hashB, 64);
+    sph_luffa512_close (&ctx.luffa1, hashA);
+
+    CHAINHASH_INIT(&ctx.cubehash1, cubehash512);
+    sph_cubehash512 (&ctx.cubehash1, hashA, 64);
+    sph_cubehash512_close(&ctx.cubehash1, hashB);
+
+    CHAINHASH_INIT(&ctx.shavite1, shavite512);
+    sph_shavite512 (&ctx.shavite1, hashB, 64);
+    sph_shavite512_close(&ctx.shavite1, hashA);
+
+    CHAINHASH_INIT(&ctx.simd1, simd512);
+    sph_simd512 (&ctx.simd1, hashA, 64);
+    sph_simd512_close(&ctx.simd1, hashB);
+
+    CHAINHASH_INIT(&ctx.echo1, echo512);
+    sph_echo512 (&ctx.echo1, hashB, 64);
+    sph_echo512_close(&ctx.echo1, hashA);
+
+    memcpy(state, hashA, 32);
 }
 
 static void xhash(void *state, const void *input)
 {
-    init_Xhash_contexts();
-
     Xhash_context_holder ctx;
 
     uint32_t hashA[16], hashB[16];
     //blake-bmw-groestl-sken-jh-meccak-luffa-cubehash-shivite-simd-echo
-    memcpy(&ctx, &base_contexts, sizeof(base_contexts));
 
+    CHAINHASH_INIT(&ctx.blake1, blake512);
     sph_blake512 (&ctx.blake1, input, 80);
     sph_blake512_close (&ctx.blake1, hashA);
 
+    CHAINHASH_INIT(&ctx.bmw1, bmw512);
     sph_bmw512 (&ctx.bmw1, hashA, 64);
     sph_bmw512_close(&ctx.bmw1, hashB);
 
+    CHAINHASH_INIT(&ctx.groestl1, groestl512);
     sph_groestl512 (&ctx.groestl1, hashB, 64);
     sph_groestl512_close(&ctx.groestl1, hashA);
 
+    CHAINHASH_INIT(&ctx.skein1, skein512);
     sph_skein512 (&ctx.skein1, hashA, 64);
     sph_skein512_close(&ctx.skein1, hashB);
 
+    CHAINHASH_INIT(&ctx.jh1, jh512);
     sph_jh512 (&ctx.jh1, hashB, 64);
     sph_jh512_close(&ctx.jh1, hashA);
 
+    CHAINHASH_INIT(&ctx.keccak1, keccak512);
     sph_keccak512 (&ctx.keccak1, hashA, 64);
     sph_keccak512_close(&ctx.keccak1, hashB);
 
-    sph_luffa512 (&ctx.luffa1, hashB, 64);
-    sph_luffa512_close (&ctx.luffa1, hashA);
-
-    sph_cubehash512 (&ctx.cubehash1, hashA, 64);
-    sph_cubehash512_close(&ctx.cubehash1, hashB);
-
-    sph_shavite512 (&ctx.shavite1, hashB, 64);
-    sph_shavite512_close(&ctx.shavite1, hashA);
-
-    sph_simd512 (&ctx.simd1, hashA, 64);
-    sph_simd512_close(&ctx.simd1, hashB);
-
-    sph_echo512 (&ctx.echo1, hashB, 64);
-    sph_echo512_close(&ctx.echo1, hashA);
-
-    memcpy(state, hashA, 32);
-
+    x11_tail(state, hashB);
 }
 
 static const uint32_t diff1targ = 0x0000ffff;
@@ -163,6 +166,62 @@ void darkcoin_regenhash(struct work *work)
         xhash(ohash, data);
 }
 
+/* Same hashes as darkcoin_regenhash for several nonces of one work item */
+void darkcoin_regenhash_batch(struct work *work, const uint32_t *nonces,
+                              unsigned int count, unsigned char (*hashes)[32])
+{
+        chainhash_x6_batch(work, nonces, count, hashes, x11_tail);
+}
+
+/* Blake-512 stage of the split X11 family kernels: the 80-byte header
+ * fits one block and the nonce only enters at message word 9, so the
+ * column step of the first round (words 0-7) is the same for every nonce.
+ * Run it here once per work; the kernel picks up from the diagonal step. */
+#define X11_BLAKE_GB(m0, m1, c0, c1, a, b, c, d)   do { \
+    a = a + b + (m0 ^ c1); \
+    d = ROTR64(d ^ a, 32); \
+    c = c + d; \
+    b = ROTR64(b ^ c, 25); \
+    a = a + b + (m1 ^ c0); \
+    d = ROTR64(d ^ a, 16); \
+    c = c + d; \
+    b = ROTR64(b ^ c, 11); \
+  } while (0)
+#define ROTR64(x, n) (((x) >> (n)) | ((x) << (64 - (n))))
+
+void x11_midstate(struct work *work)
+{
+  static const uint64_t iv[8] = {
+    0x6A09E667F3BCC908ULL, 0xBB67AE8584CAA73BULL, 0x3C6EF372FE94F82BULL, 0xA54FF53A5F1D36F1ULL,
+    0x510E527FADE682D1ULL, 0x9B05688C2B3E6C1FULL, 0x1F83D9ABFB41BD6BULL, 0x5BE0CD19137E2179ULL
+  };
+  static const uint64_t cb[8] = {
+    0x243F6A8885A308D3ULL, 0x13198A2E03707344ULL, 0xA4093822299F31D0ULL, 0x082EFA98EC4E6C89ULL,
+    0x452821E638D01377ULL, 0xBE5466CF34E90C6CULL, 0xC0AC29B7C97C50DDULL, 0x3F84D5B5B5470917ULL
+  };
+  const uint32_t *data = (const uint32_t *)work->data;
+  uint64_t m[8], v[16];
+  int i;
+
+  for (i = 0; i < 8; i++)
+    m[i] = ((uint64_t)le32toh(data[2 * i]) << 32) | le32toh(data[2 * i + 1]);
+  for (i = 0; i < 8; i++) {
+    v[i] = iv[i];
+    v[8 + i] = cb[i];
+  }
+  /* bit counter of an 80-byte message */
+  v[12] ^= 80 << 3;
+  v[13] ^= 80 << 3;
+
+  for (i = 0; i < 4; i++)
+    X11_BLAKE_GB(m[2 * i], m[2 * i + 1], cb[2 * i], cb[2 * i + 1], v[i], v[4 + i], v[8 + i], v[12 + i]);
+
+  memcpy(work->precalc, v, sizeof(v));
+}
+
+#undef ROTR64
+#undef X11_BLAKE_GB
+
 bool scanhash_darkcoin(struct thr_info *thr, const unsigned char __maybe_unused *pmidstate,
 		     unsigned char *pdata, unsigned char __maybe_unused *phash1,
 		     unsigned char __maybe_unused *phash, const unsigned char *ptarget,
@@ -6,5 +6,8 @@
 extern int darkcoin_test(unsigned char *pdata, const unsigned char *ptarget,
 			uint32_t nonce);
 extern void darkcoin_regenhash(struct work *work);
+extern void darkcoin_regenhash_batch(struct work *work, const uint32_t *nonces,
+			unsigned int count, unsigned char (*hashes)[32]);
+extern void x11_midstate(struct work *work);
 
 #endif /* DARKCOIN_H */
@@ -39,7 +39,8 @@
 #include "sph/sph_simd.h"
 #include "sph/sph_echo.h"
 
-/* Move init out of loop, so init once externally, and then use one single memcpy with that bigger memory block */
+#include "chainhash.h"
+
 typedef struct {
   sph_shavite512_context  shavite1;
   sph_simd512_context     simd1;
@@ -49,43 +50,33 @@ typedef struct {
   sph_echo512_context     echo2;
 } FreshHash_context_holder;
 
-FreshHash_context_holder base_contexts;
-
-void init_freshHash_contexts()
-{
-  sph_shavite512_init(&base_contexts.shavite1);
-  sph_simd512_init(&base_contexts.simd1);
-  sph_echo512_init(&base_contexts.echo1);
-  sph_shavite512_init(&base_contexts.shavite2);
-  sph_simd512_init(&base_contexts.simd2);
-  sph_echo512_init(&base_contexts.echo2);
-}
-
 #ifdef __APPLE_CC__
 static
 #endif
 void freshHash(void *state, const void *input)
 {
-  init_freshHash_contexts();
-
   FreshHash_context_holder ctx;
 
   uint32_t hashA[16], hashB[16];
   //shavite-simd-shavite-simd-echo
-  memcpy(&ctx, &base_contexts, sizeof(base_contexts));
 
+  CHAINHASH_INIT(&ctx.shavite1, shavite512);
   sph_shavite512 (&ctx.shavite1, input, 80);
   sph_shavite512_close(&ctx.shavite1, hashA);
 
+  CHAINHASH_INIT(&ctx.simd1, simd512);
   sph_simd512 (&ctx.simd1, hashA, 64);
   sph_simd512_close(&ctx.simd1, hashB);
 
+  CHAINHASH_INIT(&ctx.shavite2, shavite512);
   sph_shavite512 (&ctx.shavite2,hashB, 64);
   sph_shavite512_close(&ctx.shavite2, hashA);
 
+  CHAINHASH_INIT(&ctx.simd2, simd512);
   sph_simd512 (&ctx.simd2, hashA, 64);
   sph_simd512_close(&ctx.simd2, hashB);
 
+  CHAINHASH_INIT(&ctx.echo1, echo512);
   sph_echo512 (&ctx.echo1, hashB, 64);
   sph_echo512_close(&ctx.echo1, hashA);
 
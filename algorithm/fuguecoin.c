@@ -69,6 +69,22 @@ int fuguecoin_test(unsigned char *pdata, const unsigned char *ptarget, uint32_t
 	return 1;
 }
 
+/* Fugue absorbs the header a word at a time, so everything up to the nonce
+ * can be absorbed here once per work.  The placeholder nonce only fills the
+ * context's partial word and is never mixed in; the kernel starts from the
+ * 30-word state and absorbs the real nonce itself. */
+void fuguecoin_midstate(struct work *work)
+{
+  sph_fugue256_context ctx;
+  uint32_t data[20];
+
+  be32enc_vect(data, (const uint32_t *)work->data, 19);
+  data[19] = 0;
+  sph_fugue256_init(&ctx);
+  sph_fugue256(&ctx, data, 80);
+  memcpy(work->precalc, ctx.S, 30 * sizeof(sph_u32));
+}
+
 void fuguecoin_regenhash(struct work *work)
 {
         uint32_t data[20];
@@ -6,5 +6,6 @@
 extern int fuguecoin_test(unsigned char *pdata, const unsigned char *ptarget,
 			uint32_t nonce);
 extern void fuguecoin_regenhash(struct work *work);
+extern void fuguecoin_midstate(struct work *work);
 
 #endif /* FUGUECOIN_H */
@@ -44,7 +44,8 @@
 #include "sph/sph_echo.h"
 #include "sph/sph_shavite.h"
 
-/* Move init out of loop, so init once externally, and then use one single memcpy with that bigger memory block */
+#include "chainhash.h"
+
 typedef struct {
     sph_blake512_context    blake1;
     sph_bmw512_context      bmw1;
@@ -59,24 +60,6 @@ typedef struct {
     sph_echo512_context     echo1;
 } Xhash_context_holder;
 
-static Xhash_context_holder base_contexts;
-
-
-static void init_Xhash_contexts()
-{
-    sph_blake512_init(&base_contexts.blake1);
-    sph_bmw512_init(&base_contexts.bmw1);
-    sph_groestl512_init(&base_contexts.groestl1);
-    sph_skein512_init(&base_contexts.skein1);
-    sph_jh512_init(&base_contexts.jh1);
-    sph_keccak512_init(&base_contexts.keccak1);
-    sph_luffa512_init(&base_contexts.luffa1);
-    sph_cubehash512_init(&base_contexts.cubehash1);
-    sph_shavite512_init(&base_contexts.shavite1);
-    sph_simd512_init(&base_contexts.simd1);
-    sph_echo512_init(&base_contexts.echo1);
-}
-
 #ifdef __APPLE_CC__
 static
 #endif
@@ -85,11 +68,11 @@ void inkhash(void *state, const void *input)
     uint32_t hash[16];
     sph_shavite512_context ctx_shavite;
 
-    sph_shavite512_init(&ctx_shavite);
+    CHAINHASH_INIT(&ctx_shavite, shavite512);
     sph_shavite512 (&ctx_shavite, input, 80);
     sph_shavite512_close(&ctx_shavite, hash);
 
-    sph_shavite512_init(&ctx_shavite);
+    CHAINHASH_INIT(&ctx_shavite, shavite512);
     sph_shavite512(&ctx_shavite, hash, 64);
     sph_shavite512_close(&ctx_shavite, hash);
 
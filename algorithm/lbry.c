@@ -8,6 +8,8 @@
 #include "sph/sph_sha2.h"
 #include "sph/sph_ripemd.h"
 
+#include "chainhash.h"
+
 typedef struct {
   sph_sha256_context  sha256;
   sph_sha512_context  sha512;
@@ -19,9 +21,9 @@ void lbryhash(void* output, const void* input)
   uint32_t hashA[16], hashB[16], hashC[16];
   lbryhash_context_holder ctx;
 
-  sph_sha256_init(&ctx.sha256);
-  sph_sha512_init(&ctx.sha512);
-  sph_ripemd160_init(&ctx.ripemd);
+  CHAINHASH_INIT(&ctx.sha256, sha256);
+  CHAINHASH_INIT(&ctx.sha512, sha512);
+  CHAINHASH_INIT(&ctx.ripemd, ripemd160);
 
   sph_sha256 (&ctx.sha256, input, 112);
   sph_sha256_close(&ctx.sha256, hashA);
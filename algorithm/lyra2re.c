@@ -36,6 +36,7 @@
 #include "sph/sph_groestl.h"
 #include "sph/sph_skein.h"
 #include "sph/sph_keccak.h" 
+#include "chainhash.h"
 #include "lyra2.h"
 
 void lyra2rehash(void *state, const void *input)
@@ -47,23 +48,23 @@ void lyra2rehash(void *state, const void *input)
 
     uint32_t hashA[8], hashB[8];
 
-    sph_blake256_init(&ctx_blake);
+    CHAINHASH_INIT(&ctx_blake, blake256);
     sph_blake256 (&ctx_blake, input, 80);
     sph_blake256_close (&ctx_blake, hashA);
 
-    sph_keccak256_init(&ctx_keccak);
+    CHAINHASH_INIT(&ctx_keccak, keccak256);
     sph_keccak256 (&ctx_keccak,hashA, 32);
     sph_keccak256_close(&ctx_keccak, hashB);
 
 	LYRA2(hashA, 32, hashB, 32, hashB, 32, 1, 8, 8);
 
 
-    sph_skein256_init(&ctx_skein);
+    CHAINHASH_INIT(&ctx_skein, skein256);
     sph_skein256 (&ctx_skein, hashA, 32);
     sph_skein256_close(&ctx_skein, hashB);
 
 
-    sph_groestl256_init(&ctx_groestl);
+    CHAINHASH_INIT(&ctx_groestl, groestl256);
     sph_groestl256 (&ctx_groestl, hashB, 32);
     sph_groestl256_close(&ctx_groestl, hashA);
 
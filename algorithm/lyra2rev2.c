@@ -38,6 +38,7 @@
 #include "sph/sph_keccak.h" 
 #include "sph/sph_bmw.h"
 #include "sph/sph_cubehash.h"
+#include "chainhash.h"
 #include "lyra2.h"
 
 void lyra2rev2hash(void *state, const void *input)
@@ -49,29 +50,29 @@ void lyra2rev2hash(void *state, const void *input)
     sph_cubehash256_context  ctx_cube;
     uint32_t hashA[8], hashB[8];
 
-    sph_blake256_init(&ctx_blake);
+    CHAINHASH_INIT(&ctx_blake, blake256);
     sph_blake256 (&ctx_blake, input, 80);
     sph_blake256_close (&ctx_blake, hashA);
 
-    sph_keccak256_init(&ctx_keccak);
+    CHAINHASH_INIT(&ctx_keccak, keccak256);
     sph_keccak256 (&ctx_keccak,hashA, 32);
     sph_keccak256_close(&ctx_keccak, hashB);
 
-	sph_cubehash256_init(&ctx_cube);
+	CHAINHASH_INIT(&ctx_cube, cubehash256);
 	sph_cubehash256(&ctx_cube, hashB, 32);
 	sph_cubehash256_close(&ctx_cube, hashA);
 
 	LYRA2(hashB, 32, hashA, 32, hashA, 32, 1, 4, 4);
 
-	sph_skein256_init(&ctx_skein);
+	CHAINHASH_INIT(&ctx_skein, skein256);
     sph_skein256 (&ctx_skein, hashB, 32);
     sph_skein256_close(&ctx_skein, hashA);
 
-	sph_cubehash256_init(&ctx_cube);
+	CHAINHASH_INIT(&ctx_cube, cubehash256);
 	sph_cubehash256(&ctx_cube, hashA, 32);
 	sph_cubehash256_close(&ctx_cube, hashB);
 
-    sph_bmw256_init(&ctx_bmw);
+    CHAINHASH_INIT(&ctx_bmw, bmw256);
     sph_bmw256 (&ctx_bmw, hashB, 32);
     sph_bmw256_close(&ctx_bmw, hashA);
 
@@ -6,5 +6,7 @@
 extern int marucoin_test(unsigned char *pdata, const unsigned char *ptarget,
 			uint32_t nonce);
 extern void marucoin_regenhash(struct work *work);
+extern void marucoin_regenhash_batch(struct work *work, const uint32_t *nonces,
+			unsigned int count, unsigned char (*hashes)[32]);
 
 #endif /* MARUCOIN_H */
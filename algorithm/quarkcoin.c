@@ -37,97 +37,121 @@
 #include "sph/sph_skein.h"
 #include "sph/sph_jh.h"
 #include "sph/sph_keccak.h" 
+#include "sph/sph_4way.h"
 
-#ifdef __APPLE_CC__
-static
-#endif
-void quarkhash(void *state, const void *input)
+#include "chainhash.h"
+
+/* The stages between the leading blake and bmw and the keccak and skein
+ * pair, on the 64-byte bmw output in place */
+static void quark_middle(unsigned char *hash)
 {
     sph_blake512_context     ctx_blake;
     sph_bmw512_context       ctx_bmw;
     sph_groestl512_context   ctx_groestl;
     sph_jh512_context        ctx_jh;
-    sph_keccak512_context    ctx_keccak;
     sph_skein512_context     ctx_skein;
-    
-    unsigned char hash[64];
-
-    sph_blake512_init(&ctx_blake);
-    // ZBLAKE;
-    sph_blake512 (&ctx_blake, input, 80);
-    sph_blake512_close(&ctx_blake, (void*) hash);
-    
-    sph_bmw512_init(&ctx_bmw);
-    // ZBMW;
-    sph_bmw512 (&ctx_bmw, (const void*) hash, 64);
-    sph_bmw512_close(&ctx_bmw, (void*) hash);
 
     if (hash[0] & 0x8)
     {
-        sph_groestl512_init(&ctx_groestl);
+        CHAINHASH_INIT(&ctx_groestl, groestl512);
         // ZGROESTL;
         sph_groestl512 (&ctx_groestl, (const void*) hash, 64);
         sph_groestl512_close(&ctx_groestl, (void*) hash);
     }
     else
     {
-        sph_skein512_init(&ctx_skein);
+        CHAINHASH_INIT(&ctx_skein, skein512);
         // ZSKEIN;
         sph_skein512 (&ctx_skein, (const void*) hash, 64);
         sph_skein512_close(&ctx_skein, (void*) hash);
     }
     
-    sph_groestl512_init(&ctx_groestl);
+    CHAINHASH_INIT(&ctx_groestl, groestl512);
     // ZGROESTL;
     sph_groestl512 (&ctx_groestl, (const void*) hash, 64);
     sph_groestl512_close(&ctx_groestl, (void*) hash);
 
-    sph_jh512_init(&ctx_jh);
+    CHAINHASH_INIT(&ctx_jh, jh512);
     // ZJH;
     sph_jh512 (&ctx_jh, (const void*) hash, 64);
     sph_jh512_close(&ctx_jh, (void*) hash);
 
     if (hash[0] & 0x8)
     {
-        sph_blake512_init(&ctx_blake);
+        CHAINHASH_INIT(&ctx_blake, blake512);
         // ZBLAKE;
         sph_blake512 (&ctx_blake, (const void*) hash, 64);
         sph_blake512_close(&ctx_blake, (void*) hash);
     }
     else
     {
-        sph_bmw512_init(&ctx_bmw);
+        CHAINHASH_INIT(&ctx_bmw, bmw512);
         // ZBMW;
         sph_bmw512 (&ctx_bmw, (const void*) hash, 64);
         sph_bmw512_close(&ctx_bmw, (void*) hash);
     }
+}
 
-    sph_keccak512_init(&ctx_keccak);
-    // ZKECCAK;
-    sph_keccak512 (&ctx_keccak, (const void*) hash, 64);
-    sph_keccak512_close(&ctx_keccak, (void*) hash);
-
-    sph_skein512_init(&ctx_skein);
-    // SKEIN;
-    sph_skein512 (&ctx_skein, (const void*) hash, 64);
-    sph_skein512_close(&ctx_skein, (void*) hash);
+/* The closing keccak or jh, on the 64-byte skein output */
+static void quark_last(void *state, const unsigned char *hash)
+{
+    sph_keccak512_context    ctx_keccak;
+    sph_jh512_context        ctx_jh;
+    unsigned char out[64];
 
     if (hash[0] & 0x8)
     {
-        sph_keccak512_init(&ctx_keccak);
+        CHAINHASH_INIT(&ctx_keccak, keccak512);
         // ZKECCAK;
         sph_keccak512 (&ctx_keccak, (const void*) hash, 64);
-        sph_keccak512_close(&ctx_keccak, (void*) hash);
+        sph_keccak512_close(&ctx_keccak, (void*) out);
     }
     else
     {
-        sph_jh512_init(&ctx_jh);
+        CHAINHASH_INIT(&ctx_jh, jh512);
         // ZJH;
         sph_jh512 (&ctx_jh, (const void*) hash, 64);
-        sph_jh512_close(&ctx_jh, (void*) hash);
+        sph_jh512_close(&ctx_jh, (void*) out);
     }
 
-    memcpy(state, hash, 32);
+    memcpy(state, out, 32);
+}
+
+#ifdef __APPLE_CC__
+static
+#endif
+void quarkhash(void *state, const void *input)
+{
+    sph_blake512_context     ctx_blake;
+    sph_bmw512_context       ctx_bmw;
+    sph_keccak512_context    ctx_keccak;
+    sph_skein512_context     ctx_skein;
+    
+    unsigned char hash[64];
+
+    CHAINHASH_INIT(&ctx_blake, blake512);
+    // ZBLAKE;
+    sph_blake512 (&ctx_blake, input, 80);
+    sph_blake512_close(&ctx_blake, (void*) hash);
+    
+    CHAINHASH_INIT(&ctx_bmw, bmw512);
+    // ZBMW;
+    sph_bmw512 (&ctx_bmw, (const void*) hash, 64);
+    sph_bmw512_close(&ctx_bmw, (void*) hash);
+
+    quark_middle(hash);
+
+    CHAINHASH_INIT(&ctx_keccak, keccak512);
+    // ZKECCAK;
+    sph_keccak512 (&ctx_keccak, (const void*) hash, 64);
+    sph_keccak512_close(&ctx_keccak, (void*) hash);
+
+    CHAINHASH_INIT(&ctx_skein, skein512);
+    // SKEIN;
+    sph_skein512 (&ctx_skein, (const void*) hash, 64);
+    sph_skein512_close(&ctx_skein, (void*) hash);
+
+    quark_last(state, hash);
 }
 
 static const uint32_t diff1targ = 0x0000ffff;
@@ -166,6 +190,44 @@ void quarkcoin_regenhash(struct work *work)
         quarkhash(ohash, data);
 }
 
+/* Same hashes as quarkcoin_regenhash for several nonces of one work item.
+ * The unconditional blake, bmw, keccak and skein stages take four nonces
+ * per call; the branches run one lane at a time. */
+void quarkcoin_regenhash_batch(struct work *work, const uint32_t *nonces,
+                               unsigned int count, unsigned char (*hashes)[32])
+{
+        uint32_t data[SPH_4WAY_LANES][20];
+        uint32_t hashA[SPH_4WAY_LANES][16], hashB[SPH_4WAY_LANES][16];
+        void *dstA[SPH_4WAY_LANES], *dstB[SPH_4WAY_LANES];
+        const void *srcA[SPH_4WAY_LANES], *srcB[SPH_4WAY_LANES], *srcD[SPH_4WAY_LANES];
+        unsigned int i, l;
+
+        for (l = 0; l < SPH_4WAY_LANES; l++) {
+                be32enc_vect(data[l], (const uint32_t *)work->data, 19);
+                dstA[l] = hashA[l];
+                dstB[l] = hashB[l];
+                srcA[l] = hashA[l];
+                srcB[l] = hashB[l];
+                srcD[l] = data[l];
+        }
+
+        for (i = 0; i < count; i += SPH_4WAY_LANES) {
+                /* a short last group repeats its final nonce */
+                for (l = 0; l < SPH_4WAY_LANES; l++)
+                        data[l][19] = htobe32(htole32(nonces[MIN(i + l, count - 1)]));
+
+                sph_blake512_4way(dstA, srcD, 80);
+                sph_bmw512_4way(dstB, srcA, 64);
+                for (l = 0; l < SPH_4WAY_LANES; l++)
+                        quark_middle((unsigned char *)hashB[l]);
+                sph_keccak512_4way(dstA, srcB, 64);
+                sph_skein512_4way(dstB, srcA, 64);
+
+                for (l = 0; l < SPH_4WAY_LANES && i + l < count; l++)
+                        quark_last(hashes[i + l], (const unsigned char *)hashB[l]);
+        }
+}
+
 bool scanhash_quarkcoin(struct thr_info *thr, const unsigned char __maybe_unused *pmidstate,
 		     unsigned char *pdata, unsigned char __maybe_unused *phash1,
 		     unsigned char __maybe_unused *phash, const unsigned char *ptarget,
@@ -41,7 +41,8 @@
 #include "sph/sph_simd.h"
 #include "sph/sph_echo.h"
 
-/* Move init out of loop, so init once externally, and then use one single memcpy with that bigger memory block */
+#include "chainhash.h"
+
 typedef struct {
     sph_luffa512_context    luffa1;
     sph_cubehash512_context cubehash1;
@@ -50,43 +51,33 @@ typedef struct {
     sph_echo512_context     echo1;
 } Qhash_context_holder;
 
-Qhash_context_holder base_contexts;
-
-
-void init_Qhash_contexts()
-{
-    sph_luffa512_init(&base_contexts.luffa1);
-    sph_cubehash512_init(&base_contexts.cubehash1);
-    sph_shavite512_init(&base_contexts.shavite1);
-    sph_simd512_init(&base_contexts.simd1);
-    sph_echo512_init(&base_contexts.echo1);
-}
-
 #ifdef __APPLE_CC__
 static
 #endif
 void qhash(void *state, const void *input)
 {
-    init_Qhash_contexts();
-    
     Qhash_context_holder ctx;
     
     uint32_t hashA[16], hashB[16];  
     //luffa-cubehash-shivite-simd-echo
-    memcpy(&ctx, &base_contexts, sizeof(base_contexts));
     
+    CHAINHASH_INIT(&ctx.luffa1, luffa512);
     sph_luffa512 (&ctx.luffa1, input, 80);
     sph_luffa512_close (&ctx.luffa1, hashA);    
         
+    CHAINHASH_INIT(&ctx.cubehash1, cubehash512);
     sph_cubehash512 (&ctx.cubehash1, hashA, 64);   
     sph_cubehash512_close(&ctx.cubehash1, hashB);  
     
+    CHAINHASH_INIT(&ctx.shavite1, shavite512);
     sph_shavite512 (&ctx.shavite1, hashB, 64);   
     sph_shavite512_close(&ctx.shavite1, hashA);  
     
+    CHAINHASH_INIT(&ctx.simd1, simd512);
     sph_simd512 (&ctx.simd1, hashA, 64);   
     sph_simd512_close(&ctx.simd1, hashB); 
     
+    CHAINHASH_INIT(&ctx.echo1, echo512);
     sph_echo512 (&ctx.echo1, hashB, 64);   
     sph_echo512_close(&ctx.echo1, hashA);    
 
@@ -48,7 +48,8 @@
 #include "sph/sph_echo.h"
 #include "sph/sph_gost.h"
 
-/* Move init out of loop, so init once externally, and then use one single memcpy with that bigger memory block */
+#include "chainhash.h"
+
 typedef struct {
     sph_blake512_context    blake1;
     sph_bmw512_context      bmw1;
@@ -64,69 +65,58 @@ typedef struct {
     sph_echo512_context     echo1;
 } Xhash_context_holder;
 
-static Xhash_context_holder base_contexts;
-
-
-static void init_Xhash_contexts()
-{
-    sph_blake512_init(&base_contexts.blake1);
-    sph_bmw512_init(&base_contexts.bmw1);
-    sph_groestl512_init(&base_contexts.groestl1);
-    sph_skein512_init(&base_contexts.skein1);
-    sph_jh512_init(&base_contexts.jh1);
-    sph_keccak512_init(&base_contexts.keccak1);
-    sph_gost512_init(&base_contexts.gost1);
-    sph_luffa512_init(&base_contexts.luffa1);
-    sph_cubehash512_init(&base_contexts.cubehash1);
-    sph_shavite512_init(&base_contexts.shavite1);
-    sph_simd512_init(&base_contexts.simd1);
-    sph_echo512_init(&base_contexts.echo1);
-}
-
-
 static inline void xhash(void *state, const void *input)
 {
-    init_Xhash_contexts();
-
     Xhash_context_holder ctx;
 
     uint32_t hashA[16], hashB[16];
     //blake-bmw-groestl-sken-jh-meccak-luffa-cubehash-shivite-simd-echo
-    memcpy(&ctx, &base_contexts, sizeof(base_contexts));
 
+    CHAINHASH_INIT(&ctx.blake1, blake512);
     sph_blake512 (&ctx.blake1, input, 80);
     sph_blake512_close (&ctx.blake1, hashA);
 
+    CHAINHASH_INIT(&ctx.bmw1, bmw512);
     sph_bmw512 (&ctx.bmw1, hashA, 64);
     sph_bmw512_close(&ctx.bmw1, hashB);
 
+    CHAINHASH_INIT(&ctx.groestl1, groestl512);
     sph_groestl512 (&ctx.groestl1, hashB, 64);
     sph_groestl512_close(&ctx.groestl1, hashA);
 
+    CHAINHASH_INIT(&ctx.skein1, skein512);
     sph_skein512 (&ctx.skein1, hashA, 64);
     sph_skein512_close(&ctx.skein1, hashB);
 
+    CHAINHASH_INIT(&ctx.jh1, jh512);
     sph_jh512 (&ctx.jh1, hashB, 64);
     sph_jh512_close(&ctx.jh1, hashA);
 
+    CHAINHASH_INIT(&ctx.keccak1, keccak512);
     sph_keccak512 (&ctx.keccak1, hashA, 64);
     sph_keccak512_close(&ctx.keccak1, hashB);
 
+    CHAINHASH_INIT(&ctx.gost1, gost512);
     sph_gost512 (&ctx.gost1, hashB, 64);
     sph_gost512_close(&ctx.gost1, hashA);
 
+    CHAINHASH_INIT(&ctx.luffa1, luffa512);
     sph_luffa512 (&ctx.luffa1, hashA, 64);
     sph_luffa512_close (&ctx.luffa1, hashB);
 
+    CHAINHASH_INIT(&ctx.cubehash1, cubehash512);
     sph_cubehash512 (&ctx.cubehash1, hashB, 64);
     sph_cubehash512_close(&ctx.cubehash1, hashA);
 
+    CHAINHASH_INIT(&ctx.shavite1, shavite512);
     sph_shavite512 (&ctx.shavite1, hashA, 64);
     sph_shavite512_close(&ctx.shavite1, hashB);
 
+    CHAINHASH_INIT(&ctx.simd1, simd512);
     sph_simd512 (&ctx.simd1, hashB, 64);
     sph_simd512_close(&ctx.simd1, hashA);
 
+    CHAINHASH_INIT(&ctx.echo1, echo512);
     sph_echo512 (&ctx.echo1, hashA, 64);
     sph_echo512_close(&ctx.echo1, hashB);
 
@@ -38,6 +38,8 @@
 #include "sph/sph_jh.h"
 #include "sph/sph_keccak.h" 
 
+#include "chainhash.h"
+
 #ifdef __APPLE_CC__
 static
 #endif
@@ -52,32 +54,32 @@ void sifhash(void *state, const void *input)
     
     unsigned char hash[64];
 
-    sph_blake512_init(&ctx_blake);
+    CHAINHASH_INIT(&ctx_blake, blake512);
     // ZBLAKE;
     sph_blake512 (&ctx_blake, input, 80);
     sph_blake512_close(&ctx_blake, (void*) hash);
     
-    sph_bmw512_init(&ctx_bmw);
+    CHAINHASH_INIT(&ctx_bmw, bmw512);
     // ZBMW;
     sph_bmw512 (&ctx_bmw, (const void*) hash, 64);
     sph_bmw512_close(&ctx_bmw, (void*) hash);
 
-    sph_groestl512_init(&ctx_groestl);
+    CHAINHASH_INIT(&ctx_groestl, groestl512);
     // ZGROESTL;
     sph_groestl512 (&ctx_groestl, (const void*) hash, 64);
     sph_groestl512_close(&ctx_groestl, (void*) hash);
 
-    sph_jh512_init(&ctx_jh);
+    CHAINHASH_INIT(&ctx_jh, jh512);
     // ZJH;
     sph_jh512 (&ctx_jh, (const void*) hash, 64);
     sph_jh512_close(&ctx_jh, (void*) hash);
 
-    sph_keccak512_init(&ctx_keccak);
+    CHAINHASH_INIT(&ctx_keccak, keccak512);
     // ZKECCAK;
     sph_keccak512 (&ctx_keccak, (const void*) hash, 64);
     sph_keccak512_close(&ctx_keccak, (void*) hash);
 
-    sph_skein512_init(&ctx_skein);
+    CHAINHASH_INIT(&ctx_skein, skein512);
     // SKEIN;
     sph_skein512 (&ctx_skein, (const void*) hash, 64);
     sph_skein512_close(&ctx_skein, (void*) hash);
@@ -37,7 +37,8 @@
 #include "sph/sph_keccak.h"
 #include "sph/sph_skein.h"
 
-/* Move init out of loop, so init once externally, and then use one single memcpy with that bigger memory block */
+#include "chainhash.h"
+
 typedef struct 
 {
   sph_blake512_context    blake1;
@@ -47,42 +48,33 @@ typedef struct
   sph_skein512_context    skein1;
 } Xhash_context_holder;
 
-static Xhash_context_holder base_contexts;
-
-void init_Nhash_contexts()
-{
-  sph_blake512_init(&base_contexts.blake1);
-  sph_groestl512_init(&base_contexts.groestl1);
-  sph_jh512_init(&base_contexts.jh1);
-  sph_keccak512_init(&base_contexts.keccak1);
-  sph_skein512_init(&base_contexts.skein1);
-}
-
 #ifdef __APPLE_CC__
 static
 #endif
 void talkhash(void *state, const void *input)
 {
-  init_Nhash_contexts();
-
   Xhash_context_holder ctx;
 
   uint32_t hashA[16], hashB[16];
   //blake-bmw-groestl-sken-jh-meccak-luffa-cubehash-shivite-simd-echo
-  memcpy(&ctx, &base_contexts, sizeof(base_contexts));
 
+  CHAINHASH_INIT(&ctx.blake1, blake512);
   sph_blake512 (&ctx.blake1, input, 80);
   sph_blake512_close (&ctx.blake1, hashA);
 
+  CHAINHASH_INIT(&ctx.groestl1, groestl512);
   sph_groestl512 (&ctx.groestl1, hashA, 64);
   sph_groestl512_close(&ctx.groestl1, hashB);
 
+  CHAINHASH_INIT(&ctx.jh1, jh512);
   sph_jh512 (&ctx.jh1, hashB, 64);
   sph_jh512_close(&ctx.jh1, hashA);
 
+  CHAINHASH_INIT(&ctx.keccak1, keccak512);
   sph_keccak512 (&ctx.keccak1, hashA, 64);
   sph_keccak512_close(&ctx.keccak1, hashB);
 
+  CHAINHASH_INIT(&ctx.skein1, skein512);
   sph_skein512 (&ctx.skein1, hashB, 64);
   sph_skein512_close(&ctx.skein1, hashA);
 
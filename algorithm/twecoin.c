@@ -39,6 +39,8 @@
 #include "sph/sph_hamsi.h"
 #include "sph/sph_panama.h"
 
+#include "chainhash.h"
+
 #ifdef __APPLE_CC__
 static
 #endif
@@ -52,19 +54,19 @@ void twehash(void *state, const void *input)
     unsigned char hash[4][64];
     memset(hash, 0, sizeof(hash));
 
-    sph_fugue256_init(&ctx_fugue);
+    CHAINHASH_INIT(&ctx_fugue, fugue256);
     sph_fugue256 (&ctx_fugue, input, 80);
     sph_fugue256_close(&ctx_fugue, &hash[0]);
         
-    sph_shavite256_init(&ctx_shavite);
+    CHAINHASH_INIT(&ctx_shavite, shavite256);
     sph_shavite256(&ctx_shavite, &hash[0], 64);
     sph_shavite256_close(&ctx_shavite, &hash[1]);
 
-    sph_hamsi256_init(&ctx_hamsi);
+    CHAINHASH_INIT(&ctx_hamsi, hamsi256);
     sph_hamsi256(&ctx_hamsi, &hash[1], 64);
     sph_hamsi256_close(&ctx_hamsi, &hash[2]);
 
-    sph_panama_init(&ctx_panama);
+    CHAINHASH_INIT(&ctx_panama, panama);
     sph_panama(&ctx_panama, &hash[2], 64);
     sph_panama_close(&ctx_panama, &hash[3]);
 
@@ -36,7 +36,8 @@
 
 #include "sph/sph_whirlpool.h"
 
-/* Move init out of loop, so init once externally, and then use one single memcpy with that bigger memory block */
+#include "chainhash.h"
+
 typedef struct {
   sph_whirlpool1_context whirlpool1;
   sph_whirlpool1_context whirlpool2;
@@ -44,38 +45,27 @@ typedef struct {
   sph_whirlpool1_context whirlpool4;
 } Whash_context_holder;
 
-Whash_context_holder base_contexts;
-
-
-void init_whirlcoin_hash_contexts()
-{
-  sph_whirlpool1_init(&base_contexts.whirlpool1);
-  sph_whirlpool1_init(&base_contexts.whirlpool2);
-  sph_whirlpool1_init(&base_contexts.whirlpool3);
-  sph_whirlpool1_init(&base_contexts.whirlpool4);
-}
-
 #ifdef __APPLE_CC__
 static
 #endif
 void whirlcoin_hash(void *state, const void *input)
 {
-  init_whirlcoin_hash_contexts();
-
   Whash_context_holder ctx;
   uint32_t hashA[16], hashB[16];
 
-  memcpy(&ctx, &base_contexts, sizeof(base_contexts));
-
+  CHAINHASH_INIT(&ctx.whirlpool1, whirlpool1);
   sph_whirlpool1(&ctx.whirlpool1, input, 80);
   sph_whirlpool1_close(&ctx.whirlpool1, hashA);
 
+  CHAINHASH_INIT(&ctx.whirlpool2, whirlpool1);
   sph_whirlpool1(&ctx.whirlpool2, hashA, 64);
   sph_whirlpool1_close(&ctx.whirlpool2, hashB);
 
+  CHAINHASH_INIT(&ctx.whirlpool3, whirlpool1);
   sph_whirlpool1(&ctx.whirlpool3, hashB, 64);
   sph_whirlpool1_close(&ctx.whirlpool3, hashA);
 
+  CHAINHASH_INIT(&ctx.whirlpool4, whirlpool1);
   sph_whirlpool1(&ctx.whirlpool4, hashA, 64);
   sph_whirlpool1_close(&ctx.whirlpool4, hashB);
 
@@ -107,6 +97,19 @@ int whirlcoin_test_old(unsigned char *pdata, const unsigned char *ptarget, uint3
 	return 1;
 }
 
+/* Whirlpool state after the first 64 bytes of the header, which the first
+ * kernel starts from instead of hashing them for every nonce */
+void whirlcoin_midstate(struct work *work)
+{
+  sph_whirlpool1_context ctx;
+  uint32_t data[16];
+
+  be32enc_vect(data, (const uint32_t *)work->data, 16);
+  CHAINHASH_INIT(&ctx, whirlpool1);
+  sph_whirlpool1(&ctx, data, 64);
+  memcpy(work->precalc, ctx.state, 64);
+}
+
 void whirlcoin_regenhash(struct work *work)
 {
   uint32_t data[20];
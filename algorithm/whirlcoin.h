@@ -4,6 +4,7 @@
 #include "miner.h"
 
 extern int whirlcoin_test(unsigned char *pdata, const unsigned char *ptarget, uint32_t nonce);
+extern void whirlcoin_midstate(struct work *work);
 extern void whirlcoin_regenhash(struct work *work);
 
 #endif /* W_H */
\ No newline at end of file
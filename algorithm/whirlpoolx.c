@@ -193,6 +193,35 @@ int whirlcoin_test(unsigned char *pdata, const unsigned char *ptarget, uint32_t
 	return 1;
 }
 
+/* Whirlpool state after the first 64 bytes of the header, passed to the
+ * kernel as its midstate */
+void whirlpoolx_midstate(struct work *work)
+{
+  uint64_t block[8], midblock[8], key[8] = { 0 }, tmp[8] = { 0 };
+  int i, x;
+
+  be32enc_vect((uint32_t *)block, (const uint32_t *)work->data, 16);
+  memcpy(midblock, block, 64);
+
+  // midblock = n, key = h
+  for (i = 0; i < 10; ++i) {
+    tmp[0] = WHIRLPOOL_ROUND_CONSTANTS[i];
+    whirlpool_round(key, tmp);
+    tmp[0] = 0;
+    whirlpool_round(midblock, tmp);
+
+    for (x = 0; x < 8; ++x) {
+      midblock[x] ^= key[x];
+    }
+  }
+
+  for (i = 0; i < 8; ++i) {
+    midblock[i] ^= block[i];
+  }
+
+  memcpy(work->precalc, midblock, 64);
+}
+
 void whirlpoolx_regenhash(struct work *work)
 {
     uint32_t data[20];
@@ -52,6 +52,7 @@ static uint64_t WHIRLPOOL_ROUND_CONSTANTS[32] = {
 };
 
 extern int whirlpoolx_test(unsigned char *pdata, const unsigned char *ptarget, uint32_t nonce);
+extern void whirlpoolx_midstate(struct work *work);
 extern void whirlpoolx_regenhash(struct work *work);
 extern void whirlpool_round(uint64_t block[8], const uint64_t key[8]);
 
@@ -6,5 +6,7 @@
 extern int x14_test(unsigned char *pdata, const unsigned char *ptarget,
 			uint32_t nonce);
 extern void x14_regenhash(struct work *work);
+extern void x14_regenhash_batch(struct work *work, const uint32_t *nonces,
+			unsigned int count, unsigned char (*hashes)[32]);
 
 #endif /* X14_H */
\ No newline at end of file
@@ -1468,6 +1468,8 @@ static void gpustatus(struct io_data *io_data, int gpu, bool isjson, bool precom
     root = api_add_int(root, "Accepted", &(cgpu->accepted), false);
     root = api_add_int(root, "Rejected", &(cgpu->rejected), false);
     root = api_add_int(root, "Hardware Errors", &(cgpu->hw_errors), false);
+    root = api_add_int(root, "Dropped Nonces", &(cgpu->result_overflows), false);
+    root = api_add_int(root, "Self Test Failures", &(cgpu->dev_selftest_count), false);
     root = api_add_utility(root, "Utility", &(cgpu->utility), false);
     root = api_add_string(root, "Intensity", intensity, false);
     root = api_add_int(root, "XIntensity", &(cgpu->xintensity), false);
@@ -1482,6 +1484,8 @@ static void gpustatus(struct io_data *io_data, int gpu, bool isjson, bool precom
     root = api_add_diff(root, "Difficulty Rejected", &(cgpu->diff_rejected), false);
     root = api_add_diff(root, "Last Share Difficulty", &(cgpu->last_share_diff), false);
     root = api_add_time(root, "Last Valid Work", &(cgpu->last_device_valid_work), false);
+    root = api_add_double(root, "Time To New Work", &(cgpu->new_work_time), false);
+    root = api_add_double(root, "Max Time To New Work", &(cgpu->new_work_time_max), false);
     double hwp = (cgpu->hw_errors + cgpu->diff1) ?
         (double)(cgpu->hw_errors) / (double)(cgpu->hw_errors + cgpu->diff1) : 0;
     root = api_add_percent(root, "Device Hardware%", &hwp, false);
@@ -2542,6 +2546,9 @@ void notifystatus(struct io_data *io_data, int device, struct cgpu_info *cgpu, b
       case REASON_DEV_COMMS_ERROR:
         reason = REASON_DEV_COMMS_ERROR_STR;
         break;
+      case REASON_DEV_SELFTEST:
+        reason = REASON_DEV_SELFTEST_STR;
+        break;
       default:
         reason = REASON_UNKNOWN_STR;
         break;
@@ -2565,6 +2572,7 @@ void notifystatus(struct io_data *io_data, int device, struct cgpu_info *cgpu, b
   root = api_add_int(root, "*Dev Thermal Cutoff", &(cgpu->dev_thermal_cutoff_count), false);
   root = api_add_int(root, "*Dev Comms Error", &(cgpu->dev_comms_error_count), false);
   root = api_add_int(root, "*Dev Throttle", &(cgpu->dev_throttle_count), false);
+  root = api_add_int(root, "*Dev Self Test", &(cgpu->dev_selftest_count), false);
 
   root = print_data(root, buf, isjson, isjson && (device > 0));
   io_add(io_data, buf);
@@ -215,6 +215,61 @@ char *set_thread_concurrency(const char *arg)
   return NULL;
 }
 
+char *set_dual_threads(const char *_arg)
+{
+  int i, val = 0, device = 0;
+  char *nextptr;
+  char *arg = (char *)alloca(strlen(_arg) + 1);
+  strcpy(arg, _arg);
+
+  nextptr = strtok(arg, ",");
+  if (nextptr == NULL)
+    return "Invalid parameters for set_dual_threads";
+
+  do {
+    val = atoi(nextptr);
+    if (val < 0 || val > 20)
+      return "Invalid value passed to set_dual_threads";
+
+    gpus[device++].dual_threads = val;
+  } while ((nextptr = strtok(NULL, ",")) != NULL);
+
+  if (device == 1) {
+    for (i = device; i < MAX_GPUDEVICES; i++)
+      gpus[i].dual_threads = gpus[0].dual_threads;
+  }
+
+  return NULL;
+}
+
+char *set_opencl_types(const char *_arg)
+{
+  cl_device_type types = 0;
+  char *nextptr;
+  char *arg = (char *)alloca(strlen(_arg) + 1);
+  strcpy(arg, _arg);
+
+  nextptr = strtok(arg, ",");
+  if (nextptr == NULL)
+    return "Invalid parameters for set_opencl_types";
+
+  do {
+    if (!strcasecmp(nextptr, "gpu"))
+      types |= CL_DEVICE_TYPE_GPU;
+    else if (!strcasecmp(nextptr, "cpu"))
+      types |= CL_DEVICE_TYPE_CPU;
+    else if (!strcasecmp(nextptr, "accelerator"))
+      types |= CL_DEVICE_TYPE_ACCELERATOR;
+    else if (!strcasecmp(nextptr, "all"))
+      types |= CL_DEVICE_TYPE_GPU | CL_DEVICE_TYPE_CPU | CL_DEVICE_TYPE_ACCELERATOR;
+    else
+      return "Invalid value passed to set_opencl_types";
+  } while ((nextptr = strtok(NULL, ",")) != NULL);
+
+  opt_opencl_types = types;
+  return NULL;
+}
+
 #ifdef HAVE_ADL
 /* This function allows us to map an adl device to an opencl device for when
  * simple enumeration has failed to match them. */
@@ -694,6 +749,9 @@ void print_ndevs(int *ndevs)
 struct cgpu_info gpus[MAX_GPUDEVICES]; /* Maximum number apparently possible */
 struct cgpu_info *cpus;
 
+/* Algorithms each mining thread keeps initialised besides its current one */
+int opt_switcher_cache = 2;
+
 /* In dynamic mode, only the first thread of each device will be in use.
  * This potentially could start a thread that was stopped with the start-stop
  * options if one were to disable dynamic from the menu on a paused GPU */
@@ -1032,6 +1090,18 @@ void manage_gpu(void)
 #endif
 
 static _clState *clStates[MAX_GPUDEVICES];
+static _clState *init_hot_state(struct thr_info *thr, char *name, size_t nameSize);
+
+/* Dual threads run the dual pool's algorithm, all others the device's */
+static algorithm_t *thread_algorithm(struct thr_info *thr)
+{
+  struct pool *pool;
+
+  if (thr->dual && (pool = dual_pool()))
+    return &pool->algorithm;
+
+  return &thr->cgpu->algorithm;
+}
 
 static void set_threads_hashes(unsigned int vectors, unsigned int compute_shaders, int64_t *hashes, size_t *globalThreads,
   unsigned int minthreads, __maybe_unused int *intensity, __maybe_unused int *xintensity,
@@ -1137,9 +1207,8 @@ select_cgpu:
     /* Lose this ram cause we may dereference in the dying thread! */
     //free(clState);
 
-    applog(LOG_INFO, "Reinit GPU thread %d", thr_id);
-    clStates[thr_id] = initCl(virtual_gpu, name, sizeof(name), &cgpu->algorithm);
-    if (!clStates[thr_id]) {
+    applog(LOG_INFO, "Reinit GPU thread %d virtual GPU %d", thr_id, virtual_gpu);
+    if (!init_hot_state(thr, name, sizeof(name))) {
       applog(LOG_ERR, "Failed to reinit GPU thread %d", thr_id);
       goto select_cgpu;
     }
@@ -1174,18 +1243,176 @@ out:
   return NULL;
 }
 
+/* The entry for GPU gpu in a comma separated per-device setting, or the
+ * only entry if there is just one. NULL if the setting doesn't cover the
+ * GPU, in which case it keeps its current value. */
+static const char *get_device_setting(const char *list, int gpu, char *buf, size_t size)
+{
+  const char *p = list, *end;
+  int i;
+
+  if (empty_string(list))
+    return NULL;
+
+  if (strchr(list, ',')) {
+    for (i = 0; i < gpu; i++) {
+      if (!(p = strchr(p, ',')))
+        return NULL;
+      p++;
+    }
+  }
+
+  end = strchr(p, ',');
+  snprintf(buf, size, "%.*s", (int)(end ? (size_t)(end - p) : strlen(p)), p);
+  return buf;
+}
+
+static bool pool_uses_gpu(struct pool *pool, int gpu)
+{
+  const char *devs = get_pool_setting(pool->devices, ((!empty_string(default_profile.devices))?default_profile.devices:"all"));
+  char *arg, *nextptr;
+  int val1, val2;
+  bool ret = false;
+
+  if (empty_string(devs) || !strcasecmp(devs, "*") || !strcasecmp(devs, "all"))
+    return true;
+
+  arg = strdup(devs);
+  for (nextptr = strtok(arg, ","); nextptr && !ret; nextptr = strtok(NULL, ",")) {
+    val1 = val2 = -1;
+    get_intrange(nextptr, &val1, &val2);
+    ret = (gpu >= val1 && gpu <= val2);
+  }
+  free(arg);
+
+  return ret;
+}
+
+/* Apply the kernel settings of pool selected by options (SWITCHER_APPLY_*)
+ * to cgpu, GPU gpu's entry in gpus[] or a copy of it. Each setting comes
+ * from the pool or else the default profile and is checked the way the
+ * set_* option parsers check it; a GPU the setting doesn't cover, or an
+ * invalid value, keeps the current one. */
+void apply_pool_gpu_settings(struct pool *pool, unsigned long options, int gpu, struct cgpu_info *cgpu)
+{
+  char buf[64];
+  const char *opt;
+  int val;
+
+  //lookup gap
+  if (opt_isset(options, SWITCHER_APPLY_LG) &&
+      (opt = get_device_setting(get_pool_setting(pool->lookup_gap, default_profile.lookup_gap), gpu, buf, sizeof(buf))))
+    cgpu->opt_lg = atoi(opt);
+
+  //raw intensity, xintensity, intensity or the basic intensity 8
+  if (opt_isset(options, SWITCHER_APPLY_RAWINT)) {
+    opt = get_device_setting(get_pool_setting(pool->rawintensity, default_profile.rawintensity), gpu, buf, sizeof(buf));
+    if (opt && (val = atoi(opt)) >= MIN_RAWINTENSITY && val <= MAX_RAWINTENSITY) {
+      cgpu->dynamic = false;
+      cgpu->intensity = cgpu->xintensity = 0;
+      cgpu->rawintensity = val;
+    }
+  }
+  else if (opt_isset(options, SWITCHER_APPLY_XINT)) {
+    opt = get_device_setting(get_pool_setting(pool->xintensity, default_profile.xintensity), gpu, buf, sizeof(buf));
+    if (opt && (val = atoi(opt)) >= MIN_XINTENSITY && val <= MAX_XINTENSITY) {
+      cgpu->dynamic = false;
+      cgpu->intensity = cgpu->rawintensity = 0;
+      cgpu->xintensity = val;
+    }
+  }
+  else if (opt_isset(options, SWITCHER_APPLY_INT)) {
+    opt = get_device_setting(get_pool_setting(pool->intensity, default_profile.intensity), gpu, buf, sizeof(buf));
+    if (opt && !strncasecmp(opt, "d", 1))
+      cgpu->dynamic = true;
+    else if (opt && (val = atoi(opt)) >= MIN_INTENSITY && val <= MAX_INTENSITY) {
+      cgpu->dynamic = false;
+      cgpu->intensity = val;
+      cgpu->xintensity = cgpu->rawintensity = 0;
+    }
+  }
+  else if (opt_isset(options, SWITCHER_APPLY_INT8)) {
+    cgpu->dynamic = false;
+    cgpu->intensity = 8;
+    cgpu->xintensity = cgpu->rawintensity = 0;
+  }
+
+  //shaders
+  if (opt_isset(options, SWITCHER_APPLY_SHADER) &&
+      (opt = get_device_setting(get_pool_setting(pool->shaders, default_profile.shaders), gpu, buf, sizeof(buf))))
+    cgpu->shaders = atoi(opt);
+
+  //thread-concurrency
+  if (opt_isset(options, SWITCHER_APPLY_TC)) {
+    // neoscrypt - if not specified set TC to 0 so that TC will be calculated by intensity settings
+    if (pool->algorithm.type == ALGO_NEOSCRYPT && empty_string(pool->thread_concurrency))
+      cgpu->opt_tc = 0;
+    else if ((opt = get_device_setting(get_pool_setting(pool->thread_concurrency, default_profile.thread_concurrency), gpu, buf, sizeof(buf))))
+      cgpu->opt_tc = (size_t)atol(opt);
+  }
+
+  //worksize
+  if (opt_isset(options, SWITCHER_APPLY_WORKSIZE) &&
+      (opt = get_device_setting(get_pool_setting(pool->worksize, default_profile.worksize), gpu, buf, sizeof(buf))) &&
+      (val = atoi(opt)) >= 1 && val <= 9999)
+    cgpu->work_size = val;
+}
+
+/* Build and cache the binaries pool needs on every GPU it mines with, so
+ * that switching to it only loads them. options are the settings the
+ * switcher applies for pool. Returns how many couldn't be built. */
+int precompile_pool_kernels(struct pool *pool, unsigned long options)
+{
+  struct cgpu_info cgpu;
+  char buf[64];
+  const char *opt;
+  int i, gpu, failed = 0;
+
+  if (empty_string(pool->algorithm.name))
+    return 0;
+
+  for (i = 0; i < nDevs; i++) {
+    if (!pool_uses_gpu(pool, i))
+      continue;
+
+    /* initCl works on the mapped GPU's settings */
+    gpu = gpus[i].virtual_gpu;
+    cgpu = gpus[gpu];
+    apply_pool_gpu_settings(pool, options, gpu, &cgpu);
+    /* the thread count sizes the buffers */
+    if ((opt = get_device_setting(get_pool_setting(pool->gpu_threads, default_profile.gpu_threads), gpu, buf, sizeof(buf))))
+      cgpu.threads = atoi(opt);
+
+    applog(LOG_DEBUG, "Precompiling %s for pool %d on GPU %d", pool->algorithm.name, pool->pool_no, i);
+    if (!precompileCl(gpu, &cgpu, &pool->algorithm)) {
+      applog(LOG_WARNING, "Failed to precompile %s for pool %d on GPU %d", pool->algorithm.name, pool->pool_no, i);
+      failed++;
+    }
+  }
+
+  return failed;
+}
+
 static void opencl_detect(void)
 {
   int i;
 
+  /* Load ADL while the OpenCL devices are enumerated, both can take a
+   * while. init_adl() below waits for it. */
+  if (!opt_noadl)
+    start_adl();
+
   nDevs = clDevicesNum();
   if (nDevs < 0) {
     applog(LOG_ERR, "clDevicesNum returned error, no GPUs usable");
     nDevs = 0;
   }
 
-  if (!nDevs)
+  if (!nDevs) {
+    if (!opt_noadl)
+      stop_adl();
     return;
+  }
 
   /* If opt_g_threads is not set, use default 1 thread */
   if (opt_g_threads == -1)
@@ -1209,6 +1436,8 @@ static void opencl_detect(void)
 #endif
     cgpu->virtual_gpu = i;
     cgpu->algorithm = default_profile.algorithm;
+    if (!cgpu->name && clDeviceName(i))
+      cgpu->name = strdup(clDeviceName(i));
     add_cgpu(cgpu);
   }
 
@@ -1258,13 +1487,226 @@ static void get_opencl_statline(char *buf, size_t bufsiz, struct cgpu_info *gpu)
     tailsprintf(buf, bufsiz, " I:%2d", gpu->intensity);
 }
 
+/* Self-test: at most SELFTEST_NONCES nonces hashed, fewer for algorithms
+ * whose CPU hash takes more than SELFTEST_CPU_BUDGET ms for them all. The
+ * device must return the SELFTEST_FINDS with the lowest hashes, with the
+ * whole test taking at most SELFTEST_BUDGET ms of the mining thread. */
+#define SELFTEST_NONCES 1024
+#define SELFTEST_FINDS 4
+#define SELFTEST_CPU_BUDGET 500
+#define SELFTEST_BUDGET 2000
+/* Seconds after thread start before the first self-test */
+#define SELFTEST_FIRST 60
+/* Consecutive failures that disable a device whose clock can't be lowered */
+#define SELFTEST_MAX_FAILS 3
+
+enum selftest_state {
+  SELFTEST_UNKNOWN,
+  SELFTEST_SUPPORTED,
+  SELFTEST_UNSUPPORTED,
+};
+
+/* Kernel files that always get a known-answer check before their first
+ * work, --gpu-selftest or not, because no other kernel computes their
+ * hash the same way: bitsliced Groestl-512, and Groestl-256 in lyra2re.
+ * A failure disables the device. */
+static const char *selftest_kernels[] = {
+  "groestlcoin-bitslice",
+  "myriadcoin-groestl-bitslice",
+  "lyra2re",
+  NULL
+};
+
+/* The known-answer check self-tests each kernel on SELFTEST_HEADERS fixed
+ * headers instead of the pool's work. Header k has byte i set to i * (130 k
+ * + 1) + 7 k and a zero nonce. The CPU hash of each, checked against the
+ * table first, decides which nonces the device must return. */
+#define SELFTEST_HEADERS 2
+
+static const struct {
+  const char *algorithm;
+  unsigned char hash[SELFTEST_HEADERS][32];
+} selftest_vectors[] = {
+  { "groestlcoin", {
+    { 0xf6,0x9f,0x37,0xa9,0xd6,0x8d,0x33,0x4f, 0x5d,0xa7,0xdf,0x7a,0xfb,0xf4,0xcd,0xe0,
+      0xb5,0x2a,0x1b,0xc4,0x59,0xb8,0xbb,0x73, 0xe0,0x1c,0x1c,0x7f,0xb0,0xd8,0xdd,0x61 },
+    { 0x77,0xcb,0x42,0xfd,0xfc,0x7c,0x4c,0x1c, 0x39,0xde,0xc7,0x7c,0x56,0xe5,0x6f,0x3a,
+      0x88,0x7c,0x5d,0xf3,0xce,0xdd,0xd3,0xe5, 0x82,0xa5,0x14,0x3b,0xa2,0x7f,0xf0,0x1e } } },
+  { "diamond", {
+    { 0xf6,0x9f,0x37,0xa9,0xd6,0x8d,0x33,0x4f, 0x5d,0xa7,0xdf,0x7a,0xfb,0xf4,0xcd,0xe0,
+      0xb5,0x2a,0x1b,0xc4,0x59,0xb8,0xbb,0x73, 0xe0,0x1c,0x1c,0x7f,0xb0,0xd8,0xdd,0x61 },
+    { 0x77,0xcb,0x42,0xfd,0xfc,0x7c,0x4c,0x1c, 0x39,0xde,0xc7,0x7c,0x56,0xe5,0x6f,0x3a,
+      0x88,0x7c,0x5d,0xf3,0xce,0xdd,0xd3,0xe5, 0x82,0xa5,0x14,0x3b,0xa2,0x7f,0xf0,0x1e } } },
+  { "myriadcoin-groestl", {
+    { 0x99,0x3b,0x90,0x00,0x87,0x12,0x56,0x61, 0x98,0x8e,0x50,0x67,0x58,0xbb,0x25,0x5d,
+      0xb9,0xe5,0xc5,0xd9,0x3f,0x61,0x5d,0x0c, 0x0c,0x65,0x59,0x4a,0xe7,0xd2,0x87,0x73 },
+    { 0x0f,0x8f,0xb4,0x47,0xbd,0x15,0xf1,0x94, 0x62,0x4a,0xc6,0x79,0x0e,0xdc,0xbb,0x08,
+      0x9b,0x14,0x85,0x06,0x7b,0x9b,0x68,0x4e, 0xdb,0x4e,0xcc,0xdd,0x6c,0xab,0x55,0x83 } } },
+  { "lyra2re", {
+    { 0x16,0x93,0xd9,0xcb,0xfa,0x60,0x24,0x0f, 0xd3,0x9b,0x51,0x56,0x37,0x59,0x81,0xae,
+      0xce,0x39,0x3b,0x97,0x8a,0xe8,0x47,0xa4, 0xf0,0x1e,0xf8,0xe0,0x6d,0x0c,0x19,0x04 },
+    { 0x43,0xc2,0x3a,0x04,0xaf,0x0f,0x47,0xf2, 0x83,0x1c,0x35,0x67,0x43,0xd5,0x8b,0xff,
+      0xea,0x1e,0xe1,0x7c,0x4b,0x42,0x70,0x9f, 0x23,0x44,0x6b,0xa0,0x66,0x49,0xb8,0x7c } } },
+  { NULL }
+};
+
 struct opencl_thread_data {
   cl_int(*queue_kernel_parameters)(_clState *, dev_blk_ctx *, cl_uint);
   uint32_t *res;
+  enum selftest_state selftest;
+  bool selftest_required;
+  time_t next_selftest;
+  int selftest_fails;
 };
 
+static bool selftest_required(algorithm_t *algorithm)
+{
+  const char *kernelfile = empty_string(algorithm->kernelfile) ? algorithm->name : algorithm->kernelfile;
+  int i;
+
+  for (i = 0; selftest_kernels[i]; i++)
+    if (!strcmp(kernelfile, selftest_kernels[i]))
+      return true;
+  return false;
+}
+
 static uint32_t *blank_res;
 
+/* Settings of a device that initCl builds a thread's state from */
+struct hot_settings {
+  int intensity, xintensity, rawintensity;
+  bool dynamic;
+  int threads;
+  size_t work_size;
+  int opt_lg;
+  size_t opt_tc;
+  size_t shaders;
+};
+
+/* An initialised algorithm of a mining thread. Each thread keeps a list of
+ * them, most recently used first; the first one is its clStates[] entry.
+ * Switching back to one of the others needs no initCl. */
+struct hot_state {
+  _clState *clState;
+  algorithm_t algorithm;
+  struct hot_settings settings;
+  struct hot_state *next;
+};
+
+static struct hot_state *hot_states[MAX_GPUDEVICES];
+
+static void get_hot_settings(struct cgpu_info *cgpu, struct hot_settings *settings)
+{
+  settings->intensity = cgpu->intensity;
+  settings->xintensity = cgpu->xintensity;
+  settings->rawintensity = cgpu->rawintensity;
+  settings->dynamic = cgpu->dynamic;
+  settings->threads = cgpu->threads;
+  settings->work_size = cgpu->work_size;
+  settings->opt_lg = cgpu->opt_lg;
+  settings->opt_tc = cgpu->opt_tc;
+  settings->shaders = cgpu->shaders;
+}
+
+static bool cmp_hot_settings(const struct hot_settings *a, const struct hot_settings *b)
+{
+  return (a->intensity == b->intensity && a->xintensity == b->xintensity && a->rawintensity == b->rawintensity &&
+          a->dynamic == b->dynamic && a->threads == b->threads && a->work_size == b->work_size &&
+          a->opt_lg == b->opt_lg && a->opt_tc == b->opt_tc && a->shaders == b->shaders);
+}
+
+/* Release every state of thread thr_id, the current one included */
+static void release_hot_states(int thr_id)
+{
+  struct hot_state *state;
+
+  while ((state = hot_states[thr_id])) {
+    hot_states[thr_id] = state->next;
+    release_cl_state(state->clState);
+    free(state);
+  }
+  clStates[thr_id] = NULL;
+}
+
+/* Release the kept states of thr_id, keeping the current one. Returns
+ * whether there were any. */
+static bool release_kept_states(int thr_id)
+{
+  struct hot_state *state, *current = hot_states[thr_id];
+  bool released = false;
+
+  if (!current)
+    return false;
+
+  while ((state = current->next)) {
+    current->next = state->next;
+    release_cl_state(state->clState);
+    free(state);
+    released = true;
+  }
+  return released;
+}
+
+/* Keep at most opt_switcher_cache states besides the current one. Those
+ * with scratch buffers over a quarter of the largest allocation are let go
+ * so that memory-hard algorithms don't starve the one that is mining. */
+static void trim_hot_states(int thr_id, struct cgpu_info *cgpu)
+{
+  struct hot_state **prev, *state;
+  int kept = 0;
+
+  if (!hot_states[thr_id])
+    return;
+
+  prev = &hot_states[thr_id]->next;
+  while ((state = *prev)) {
+    if (kept < opt_switcher_cache && state->clState->scratch_size <= cgpu->max_alloc / 4) {
+      kept++;
+      prev = &state->next;
+      continue;
+    }
+    applog(LOG_DEBUG, "Thread %d: releasing kept %s kernel", thr_id, state->algorithm.name);
+    *prev = state->next;
+    release_cl_state(state->clState);
+    free(state);
+  }
+}
+
+/* initCl for thr with its device's current algorithm and settings and make
+ * the result the thread's current state */
+static _clState *init_hot_state(struct thr_info *thr, char *name, size_t nameSize)
+{
+  struct cgpu_info *cgpu = thr->cgpu;
+  algorithm_t *algorithm = thread_algorithm(thr);
+  struct hot_state *state = (struct hot_state *)calloc(1, sizeof(struct hot_state));
+
+  if (unlikely(!state)) {
+    applog(LOG_ERR, "Failed to calloc in init_hot_state");
+    return NULL;
+  }
+
+  state->algorithm = *algorithm;
+  get_hot_settings(cgpu, &state->settings);
+  state->clState = initCl(cgpu->virtual_gpu, name, nameSize, algorithm);
+
+  /* The kept states may hold the memory it needs. The current one stays,
+   * the thread goes on with it if this fails. */
+  if (!state->clState && release_kept_states(thr->id)) {
+    applog(LOG_INFO, "Thread %d: released kept kernels, retrying", thr->id);
+    state->clState = initCl(cgpu->virtual_gpu, name, nameSize, algorithm);
+  }
+
+  if (!state->clState) {
+    free(state);
+    return NULL;
+  }
+
+  state->next = hot_states[thr->id];
+  hot_states[thr->id] = state;
+
+  return clStates[thr->id] = state->clState;
+}
+
 static bool opencl_thread_prepare(struct thr_info *thr)
 {
   char name[256];
@@ -1274,7 +1716,8 @@ static bool opencl_thread_prepare(struct thr_info *thr)
   int virtual_gpu = cgpu->virtual_gpu;
   int i = thr->id;
   static bool failmessage = false;
-  int buffersize = BUFFERSIZE;
+  /* Large enough to clear the result buffer of any algorithm */
+  int buffersize = RESULT_BUFFERSIZE(opt_result_slots);
 
   if (!blank_res)
     blank_res = (uint32_t *)calloc(buffersize, 1);
@@ -1286,8 +1729,7 @@ static bool opencl_thread_prepare(struct thr_info *thr)
   strcpy(name, "");
   applog(LOG_INFO, "Init GPU thread %i GPU %i virtual GPU %i", i, gpu, virtual_gpu);
 
-  clStates[i] = initCl(virtual_gpu, name, sizeof(name), &cgpu->algorithm);
-  if (!clStates[i]) {
+  if (!init_hot_state(thr, name, sizeof(name))) {
 #ifdef HAVE_CURSES
     if (use_curses)
       enable_curses();
@@ -1323,36 +1765,33 @@ static bool opencl_thread_prepare(struct thr_info *thr)
   return true;
 }
 
-static bool opencl_thread_init(struct thr_info *thr)
+/* Set up thrdata for thr's current state: its algorithm's kernel
+ * parameters and result buffer, a cleared output buffer and a fresh
+ * self-test schedule */
+static bool start_thread_state(struct thr_info *thr, struct opencl_thread_data *thrdata)
 {
-  const int thr_id = thr->id;
   struct cgpu_info *gpu = thr->cgpu;
-  struct opencl_thread_data *thrdata;
-  _clState *clState = clStates[thr_id];
-  cl_int status = 0;
-  thrdata = (struct opencl_thread_data *)calloc(1, sizeof(*thrdata));
-  thr->cgpu_data = thrdata;
-  int buffersize = BUFFERSIZE;
+  _clState *clState = clStates[thr->id];
+  int buffersize;
+  uint32_t *res;
+  cl_int status;
 
-  if (!thrdata) {
-    applog(LOG_ERR, "Failed to calloc in opencl_thread_init");
+  if (!clState)
     return false;
-  }
 
-  thrdata->queue_kernel_parameters = gpu->algorithm.queue_kernel;
-  thrdata->res = (uint32_t *)calloc(buffersize, 1);
-
-  if (!thrdata->res) {
-    free(thrdata);
-    applog(LOG_ERR, "Failed to calloc in opencl_thread_init");
+  buffersize = RESULT_BUFFERSIZE(clState->found_idx);
+  thrdata->queue_kernel_parameters = thread_algorithm(thr)->queue_kernel;
+  res = (uint32_t *)realloc(thrdata->res, buffersize);
+  if (!res) {
+    applog(LOG_ERR, "Failed to realloc in start_thread_state");
     return false;
   }
+  memset(res, 0, buffersize);
+  thrdata->res = res;
 
-  status |= clEnqueueWriteBuffer(clState->commandQueue, clState->outputBuffer, CL_TRUE, 0,
+  status = clEnqueueWriteBuffer(clState->commandQueue, clState->outputBuffer, CL_TRUE, 0,
     buffersize, blank_res, 0, NULL, NULL);
   if (unlikely(status != CL_SUCCESS)) {
-    free(thrdata->res);
-    free(thrdata);
     applog(LOG_ERR, "Error: clEnqueueWriteBuffer failed.");
     return false;
   }
@@ -1360,10 +1799,77 @@ static bool opencl_thread_init(struct thr_info *thr)
   gpu->status = LIFE_WELL;
 
   gpu->device_last_well = time(NULL);
+  thrdata->selftest = SELFTEST_UNKNOWN;
+  thrdata->selftest_fails = 0;
+  thrdata->next_selftest = gpu->device_last_well + SELFTEST_FIRST;
+  thrdata->selftest_required = selftest_required(thread_algorithm(thr));
+  if (thrdata->selftest_required)
+    thrdata->next_selftest = gpu->device_last_well;
 
   return true;
 }
 
+static bool opencl_thread_init(struct thr_info *thr)
+{
+  struct opencl_thread_data *thrdata;
+
+  thrdata = (struct opencl_thread_data *)calloc(1, sizeof(*thrdata));
+  thr->cgpu_data = thrdata;
+
+  if (!thrdata) {
+    applog(LOG_ERR, "Failed to calloc in opencl_thread_init");
+    return false;
+  }
+
+  if (!start_thread_state(thr, thrdata)) {
+    free(thrdata->res);
+    free(thrdata);
+    thr->cgpu_data = NULL;
+    return false;
+  }
+
+  return true;
+}
+
+/* Move thr to its device's new algorithm and settings between two works.
+ * A kept state that matches is made current again; otherwise a new one is
+ * initialised and the previous one kept. The thread, its other states and
+ * their contexts stay as they are. */
+static bool opencl_thread_switch(struct thr_info *thr)
+{
+  const int thr_id = thr->id;
+  struct cgpu_info *cgpu = thr->cgpu;
+  struct opencl_thread_data *thrdata = (struct opencl_thread_data *)thr->cgpu_data;
+  algorithm_t *algorithm = thread_algorithm(thr);
+  struct hot_state *state, **prev;
+  struct hot_settings settings;
+
+  if (!thrdata)
+    return false;
+
+  if (clStates[thr_id])
+    clFinish(clStates[thr_id]->commandQueue);
+
+  get_hot_settings(cgpu, &settings);
+  for (prev = &hot_states[thr_id]; (state = *prev); prev = &state->next)
+    if (cmp_algorithm(&state->algorithm, algorithm) && cmp_hot_settings(&state->settings, &settings))
+      break;
+
+  if (state) {
+    applog(LOG_DEBUG, "Thread %d: switching to kept %s kernel", thr_id, algorithm->name);
+    *prev = state->next;
+    state->next = hot_states[thr_id];
+    hot_states[thr_id] = state;
+    clStates[thr_id] = state->clState;
+  }
+  else if (!opencl_thread_prepare(thr))
+    return false;
+
+  trim_hot_states(thr_id, cgpu);
+
+  return start_thread_state(thr, thrdata);
+}
+
 static bool opencl_prepare_work(struct thr_info __maybe_unused *thr, struct work *work)
 {
   work->blk.work = work;
@@ -1373,6 +1879,302 @@ static bool opencl_prepare_work(struct thr_info __maybe_unused *thr, struct work
 }
 
 extern int opt_dynamic_interval;
+extern int opt_gpu_sublaunches;
+
+/* Enqueue the main and extra kernels over one range of nonces. The event of
+ * the last kernel is returned in ev when requested. Extra kernels with a
+ * counter only run over the items the kernels before them counted, at
+ * least one work group, so the queue waits for those counts here. */
+static cl_int opencl_enqueue_kernels(int thr_id, _clState *clState, size_t *offset, size_t *globalThreads,
+  size_t *localThreads, cl_event *ev)
+{
+  cl_uint counts[2] = { 0, 0 };
+  size_t threads[1];
+  cl_int status;
+  unsigned int i;
+  int c;
+
+  status = clEnqueueNDRangeKernel(clState->commandQueue, clState->kernel, 1, offset,
+    globalThreads, localThreads, 0, NULL, clState->n_extra_kernels ? NULL : ev);
+  /* Drivers only give buffers memory when they are first used, so a new
+   * state can run out at its first launch because of the kept ones */
+  if (status == CL_MEM_OBJECT_ALLOCATION_FAILURE && release_kept_states(thr_id)) {
+    applog(LOG_INFO, "Thread %d: releasing kept kernels and retrying launch", thr_id);
+    status = clEnqueueNDRangeKernel(clState->commandQueue, clState->kernel, 1, offset,
+      globalThreads, localThreads, 0, NULL, clState->n_extra_kernels ? NULL : ev);
+  }
+  if (unlikely(status != CL_SUCCESS)) {
+    applog(LOG_ERR, "Error %d: Enqueueing kernel onto command queue. (clEnqueueNDRangeKernel)", status);
+    return status;
+  }
+
+  for (i = 0; i < clState->n_extra_kernels; i++) {
+    threads[0] = globalThreads[0];
+    c = clState->extra_kernel_counters ? clState->extra_kernel_counters[i] : -1;
+    if (c >= 0) {
+      if (!(c & 1)) {
+        status = clEnqueueReadBuffer(clState->commandQueue, clState->buffer1, CL_TRUE, c * sizeof(cl_uint),
+          sizeof(counts), counts, 0, NULL, NULL);
+        if (unlikely(status != CL_SUCCESS)) {
+          applog(LOG_ERR, "Error %d: Reading branch counts. (clEnqueueReadBuffer)", status);
+          return status;
+        }
+      }
+      threads[0] = MIN(counts[c & 1], globalThreads[0]) + localThreads[0] - 1;
+      threads[0] = MAX(threads[0] - threads[0] % localThreads[0], localThreads[0]);
+    }
+
+    status = clEnqueueNDRangeKernel(clState->commandQueue, clState->extra_kernels[i], 1, offset,
+      threads, localThreads, 0, NULL, (i == clState->n_extra_kernels - 1) ? ev : NULL);
+    if (unlikely(status != CL_SUCCESS)) {
+      applog(LOG_ERR, "Error %d: Enqueueing kernel onto command queue. (clEnqueueNDRangeKernel)", status);
+      return status;
+    }
+  }
+
+  return CL_SUCCESS;
+}
+
+extern int opt_gpu_selftest;
+
+static inline uint64_t selftest_hash(struct work *work)
+{
+  return le64toh(((uint64_t *)work->hash)[3]);
+}
+
+/* Run a range of nonces of the current work on the device with a target
+ * so easy that a few of them are found, and compare the nonces returned
+ * with the answer computed on the CPU. The range is cut to whole work
+ * groups hashed within SELFTEST_CPU_BUDGET, since the CPU hash of some
+ * algorithms costs milliseconds. Returns 1 if the device passed, 0 if
+ * it failed and -1 on an OpenCL error; count is set to the number of
+ * nonces the device returned. */
+static int opencl_selftest(struct thr_info *thr, struct work *work, uint32_t *count)
+{
+  struct opencl_thread_data *thrdata = (struct opencl_thread_data *)thr->cgpu_data;
+  _clState *clState = clStates[thr->id];
+  uint32_t found = clState->found_idx;
+  int buffersize = RESULT_BUFFERSIZE(found);
+  size_t localThreads[1] = { clState->wsize };
+  size_t globalThreads[1];
+  uint64_t *hashes, best[SELFTEST_FINDS], target;
+  struct work *test, *cpu;
+  struct timeval tv_start, tv_end;
+  uint32_t nonce, expected = 0, i, j;
+  bool *seen;
+  cl_int status;
+  int ret = -1;
+
+  globalThreads[0] = SELFTEST_NONCES + localThreads[0] - 1;
+  globalThreads[0] -= globalThreads[0] % localThreads[0];
+
+  hashes = (uint64_t *)malloc(globalThreads[0] * sizeof(uint64_t));
+  seen = (bool *)calloc(globalThreads[0], sizeof(bool));
+  if (unlikely(!hashes || !seen)) {
+    applog(LOG_ERR, "Failed to malloc in opencl_selftest");
+    free(hashes);
+    free(seen);
+    return -1;
+  }
+
+  /* The answer: every nonce whose hash is at most the SELFTEST_FINDS-th
+   * lowest of the range */
+  cgtime(&tv_start);
+  cpu = copy_work(work);
+  for (i = 0; i < SELFTEST_FINDS; i++)
+    best[i] = UINT64_MAX;
+  for (nonce = 0; nonce < globalThreads[0]; nonce++) {
+    if (nonce && nonce % localThreads[0] == 0) {
+      cgtime(&tv_end);
+      if (ms_tdiff(&tv_end, &tv_start) > SELFTEST_CPU_BUDGET) {
+        globalThreads[0] = nonce;
+        break;
+      }
+    }
+    test_nonce(cpu, nonce);
+    hashes[nonce] = selftest_hash(cpu);
+    for (i = 0; i < SELFTEST_FINDS && hashes[nonce] >= best[i]; i++);
+    if (i < SELFTEST_FINDS) {
+      for (j = SELFTEST_FINDS - 1; j > i; j--)
+        best[j] = best[j - 1];
+      best[i] = hashes[nonce];
+    }
+  }
+  target = best[SELFTEST_FINDS - 1];
+  for (nonce = 0; nonce < globalThreads[0]; nonce++)
+    expected += hashes[nonce] <= target;
+
+  /* Kernels read the target from either work->target or work->device_target */
+  test = copy_work(work);
+  opencl_prepare_work(thr, test);
+  memset(test->target, 0xff, 32);
+  *(uint64_t *)(test->target + 24) = htole64(target);
+  memcpy(test->device_target, test->target, 32);
+
+  status = thrdata->queue_kernel_parameters(clState, &test->blk, globalThreads[0]);
+  if (unlikely(status != CL_SUCCESS)) {
+    applog(LOG_ERR, "Error: clSetKernelArg of all params failed.");
+    goto out;
+  }
+  status = opencl_enqueue_kernels(thr->id, clState, NULL, globalThreads, localThreads, NULL);
+  if (unlikely(status != CL_SUCCESS))
+    goto out;
+  clFinish(clState->commandQueue);
+
+  if (clState->svm_output)
+    status = read_svm_results(clState, thrdata->res, buffersize, found);
+  else {
+    status = clEnqueueReadBuffer(clState->commandQueue, clState->outputBuffer, CL_TRUE, 0,
+      buffersize, thrdata->res, 0, NULL, NULL);
+    if (status == CL_SUCCESS && thrdata->res[found])
+      status = clEnqueueWriteBuffer(clState->commandQueue, clState->outputBuffer, CL_TRUE, 0,
+        buffersize, blank_res, 0, NULL, NULL);
+  }
+  if (unlikely(status != CL_SUCCESS)) {
+    applog(LOG_ERR, "Error %d: reading self-test results failed.", status);
+    goto out;
+  }
+  cgtime(&tv_end);
+
+  ret = 1;
+  *count = thrdata->res[found];
+  if (*count != expected) {
+    applog(LOG_DEBUG, "GPU %d self-test returned %u nonces, expected %u",
+      thr->cgpu->device_id, *count, expected);
+    ret = 0;
+  }
+  for (i = 0; i < *count && i < found; i++) {
+    nonce = thrdata->res[i];
+    if (work->pool->algorithm.found_idx == 0x0F)
+      nonce = swab32(nonce);
+    if (nonce >= globalThreads[0] || seen[nonce] || hashes[nonce] > target) {
+      applog(LOG_DEBUG, "GPU %d self-test returned wrong nonce %08x", thr->cgpu->device_id, nonce);
+      ret = 0;
+      break;
+    }
+    seen[nonce] = true;
+  }
+  if (ms_tdiff(&tv_end, &tv_start) > SELFTEST_BUDGET) {
+    applog(LOG_DEBUG, "GPU %d self-test of %lu nonces took longer than %d ms", thr->cgpu->device_id,
+      (unsigned long)globalThreads[0], SELFTEST_BUDGET);
+    ret = 0;
+  }
+  memset(thrdata->res, 0, buffersize);
+
+out:
+  free(hashes);
+  free(seen);
+  free_work(cpu);
+  free_work(test);
+  return ret;
+}
+
+/* The known-answer check: the CPU hash of each fixed header is compared
+ * with selftest_vectors, where the algorithm has an entry, then the device
+ * is self-tested on the header. Returns 1 if both passed, 0 if either
+ * failed and -1 on an OpenCL error. */
+static int opencl_known_answer(struct thr_info *thr, struct work *work)
+{
+  algorithm_t *algorithm = thread_algorithm(thr);
+  struct work *kat;
+  uint32_t count = 0;
+  int i, j, k, ret = 1;
+
+  for (i = 0; selftest_vectors[i].algorithm; i++)
+    if (!strcmp(algorithm->name, selftest_vectors[i].algorithm))
+      break;
+
+  kat = copy_work(work);
+  for (k = 0; k < SELFTEST_HEADERS && ret > 0; k++) {
+    for (j = 0; j < 76; j++)
+      kat->data[j] = (unsigned char)(j * (130 * k + 1) + 7 * k);
+    memset(kat->data + 76, 0, 4);
+
+    if (selftest_vectors[i].algorithm) {
+      test_nonce(kat, 0);
+      if (memcmp(kat->hash, selftest_vectors[i].hash[k], 32)) {
+        applog(LOG_ERR, "CPU %s hash of known-answer header %d is wrong", algorithm->name, k);
+        ret = 0;
+        break;
+      }
+    }
+
+    ret = opencl_selftest(thr, kat, &count);
+    if (!ret)
+      applog(LOG_DEBUG, "GPU %d failed on known-answer header %d", thr->cgpu->device_id, k);
+  }
+  free_work(kat);
+
+  return ret;
+}
+
+/* Run the periodic self-test and back off a failing device: one engine
+ * clock step down where ADL allows it, otherwise disable the device after
+ * SELFTEST_MAX_FAILS failures in a row. The first run decides whether the
+ * kernel can be tested at all; kernels with a hardcoded minimum difficulty
+ * or their own nonce base never return the expected nonces. Kernels that
+ * require it get the known-answer check instead of their first self-test.
+ * Returns false on an OpenCL error. */
+static bool opencl_run_selftest(struct thr_info *thr, struct work *work)
+{
+  struct opencl_thread_data *thrdata = (struct opencl_thread_data *)thr->cgpu_data;
+  struct cgpu_info *gpu = thr->cgpu;
+  algorithm_t *algorithm = thread_algorithm(thr);
+  const char *kernelfile = empty_string(algorithm->kernelfile) ? algorithm->name : algorithm->kernelfile;
+  uint32_t count = 0;
+  int ret;
+
+  thrdata->next_selftest = time(NULL) + opt_gpu_selftest * 60;
+
+  if (thrdata->selftest_required) {
+    thrdata->selftest_required = false;
+    ret = opencl_known_answer(thr, work);
+    if (ret < 0)
+      return false;
+    if (!ret) {
+      applog(LOG_ERR, "GPU %d: %s kernel failed its known-answer check, disabling!",
+        gpu->device_id, kernelfile);
+      dev_error(gpu, REASON_DEV_SELFTEST);
+      gpu->deven = DEV_DISABLED;
+      return true;
+    }
+    applog(LOG_INFO, "GPU %d: %s kernel passed its known-answer check", gpu->device_id, kernelfile);
+    thrdata->selftest = SELFTEST_SUPPORTED;
+    return true;
+  }
+
+  ret = opencl_selftest(thr, work, &count);
+  if (ret < 0)
+    return false;
+
+  if (thrdata->selftest == SELFTEST_UNKNOWN) {
+    if (!ret) {
+      applog(LOG_NOTICE, "GPU %d: %s kernel didn't pass its first self-test, not testing it",
+        gpu->device_id, thread_algorithm(thr)->name);
+      thrdata->selftest = SELFTEST_UNSUPPORTED;
+      return true;
+    }
+    thrdata->selftest = SELFTEST_SUPPORTED;
+  }
+
+  if (ret) {
+    thrdata->selftest_fails = 0;
+    return true;
+  }
+
+  dev_error(gpu, REASON_DEV_SELFTEST);
+  if (gpu_backoff(gpu->device_id))
+    return true;
+
+  if (++thrdata->selftest_fails < SELFTEST_MAX_FAILS) {
+    applog(LOG_WARNING, "GPU %d failed self-test", gpu->device_id);
+    return true;
+  }
+
+  applog(LOG_ERR, "GPU %d failed %d self-tests in a row, disabling!", gpu->device_id, thrdata->selftest_fails);
+  gpu->deven = DEV_DISABLED;
+  return true;
+}
 
 static int64_t opencl_scanhash(struct thr_info *thr, struct work *work,
   int64_t __maybe_unused max_nonce)
@@ -1381,16 +2183,36 @@ static int64_t opencl_scanhash(struct thr_info *thr, struct work *work,
   struct opencl_thread_data *thrdata = (struct opencl_thread_data *)thr->cgpu_data;
   struct cgpu_info *gpu = thr->cgpu;
   _clState *clState = clStates[thr_id];
+  algorithm_t *algorithm = thread_algorithm(thr);
   const int dynamic_us = opt_dynamic_interval * 1000;
+  struct hot_state *state = hot_states[thr_id];
 
   cl_int status;
   size_t globalThreads[1];
   size_t localThreads[1] = { clState->wsize };
   size_t *p_global_work_offset = NULL;
   int64_t hashes;
-  int found = gpu->algorithm.found_idx;
-  int buffersize = BUFFERSIZE;
-  unsigned int i;
+  uint32_t found = clState->found_idx;
+  int buffersize = RESULT_BUFFERSIZE(found);
+  size_t launched, sublaunch, offset[1], subThreads[1];
+  cl_event ev, prev_ev = NULL;
+
+  if ((opt_gpu_selftest || thrdata->selftest_required) && thrdata->selftest != SELFTEST_UNSUPPORTED &&
+      time(NULL) >= thrdata->next_selftest) {
+    if (!opencl_run_selftest(thr, work))
+      return -1;
+    if (gpu->deven != DEV_ENABLED)
+      return 0;
+  }
+
+  /* Intensity set from the menu or the API applies to running threads
+   * too; the state's own copy is what dynamic intensity adjusts */
+  if (state && (state->settings.intensity != gpu->intensity || state->settings.xintensity != gpu->xintensity ||
+                state->settings.rawintensity != gpu->rawintensity)) {
+    state->settings.intensity = clState->intensity = gpu->intensity;
+    state->settings.xintensity = clState->xintensity = gpu->xintensity;
+    state->settings.rawintensity = clState->rawintensity = gpu->rawintensity;
+  }
 
   /* Windows' timer resolution is only 15ms so oversample 5x */
   if (gpu->dynamic && (++gpu->intervals * dynamic_us) > 70000) {
@@ -1400,19 +2222,19 @@ static int64_t opencl_scanhash(struct thr_info *thr, struct work *work,
     cgtime(&tv_gpuend);
     gpu_us = us_tdiff(&tv_gpuend, &gpu->tv_gpustart) / gpu->intervals;
     if (gpu_us > dynamic_us) {
-      if (gpu->intensity > MIN_INTENSITY)
-        --gpu->intensity;
+      if (clState->intensity > MIN_INTENSITY)
+        --clState->intensity;
     }
     else if (gpu_us < dynamic_us / 2) {
-      if (gpu->intensity < MAX_INTENSITY)
-        ++gpu->intensity;
+      if (clState->intensity < MAX_INTENSITY)
+        ++clState->intensity;
     }
     memcpy(&(gpu->tv_gpustart), &tv_gpuend, sizeof(struct timeval));
     gpu->intervals = 0;
   }
 
   set_threads_hashes(clState->vwidth, clState->compute_shaders, &hashes, globalThreads, localThreads[0],
-    &gpu->intensity, &gpu->xintensity, &gpu->rawintensity, &gpu->algorithm);
+    &clState->intensity, &clState->xintensity, &clState->rawintensity, algorithm);
   if (hashes > gpu->max_hashes)
     gpu->max_hashes = hashes;
 
@@ -1425,27 +2247,60 @@ static int64_t opencl_scanhash(struct thr_info *thr, struct work *work,
   if (clState->goffset)
     p_global_work_offset = (size_t *)&work->blk.nonce;
 
-  status = clEnqueueNDRangeKernel(clState->commandQueue, clState->kernel, 1, p_global_work_offset,
-    globalThreads, localThreads, 0, NULL, NULL);
-  if (unlikely(status != CL_SUCCESS)) {
-    applog(LOG_ERR, "Error %d: Enqueueing kernel onto command queue. (clEnqueueNDRangeKernel)", status);
-    return -1;
+  work_launched(thr, work);
+
+  /* Large batches are split into several launches so that a new block
+   * only waits for the launch in flight rather than the whole batch. One
+   * launch is kept queued ahead so the device never idles between them. */
+  sublaunch = globalThreads[0];
+  if (opt_gpu_sublaunches > 1 && p_global_work_offset) {
+    sublaunch = globalThreads[0] / opt_gpu_sublaunches;
+    sublaunch -= sublaunch % localThreads[0];
+    if (sublaunch < localThreads[0])
+      sublaunch = globalThreads[0];
   }
 
-  for (i = 0; i < clState->n_extra_kernels; i++) {
-    status = clEnqueueNDRangeKernel(clState->commandQueue, clState->extra_kernels[i], 1, p_global_work_offset,
-      globalThreads, localThreads, 0, NULL, NULL);
-    if (unlikely(status != CL_SUCCESS)) {
-      applog(LOG_ERR, "Error %d: Enqueueing kernel onto command queue. (clEnqueueNDRangeKernel)", status);
+  if (sublaunch == globalThreads[0]) {
+    status = opencl_enqueue_kernels(thr->id, clState, p_global_work_offset, globalThreads, localThreads, NULL);
+    if (unlikely(status != CL_SUCCESS))
       return -1;
+  }
+  else {
+    for (launched = 0; launched < globalThreads[0]; launched += subThreads[0]) {
+      offset[0] = work->blk.nonce + launched;
+      subThreads[0] = MIN(sublaunch, globalThreads[0] - launched);
+
+      status = opencl_enqueue_kernels(thr->id, clState, offset, subThreads, localThreads, &ev);
+      if (unlikely(status != CL_SUCCESS)) {
+        if (prev_ev)
+          clReleaseEvent(prev_ev);
+        return -1;
+      }
+      clFlush(clState->commandQueue);
+
+      if (prev_ev) {
+        clWaitForEvents(1, &prev_ev);
+        clReleaseEvent(prev_ev);
+      }
+      prev_ev = ev;
+
+      if (unlikely(thr->work_restart)) {
+        applog(LOG_DEBUG, "GPU %d abandoning batch after %lu of %lu threads", gpu->device_id,
+          (unsigned long)(launched + subThreads[0]), (unsigned long)globalThreads[0]);
+        hashes = hashes * (launched + subThreads[0]) / globalThreads[0];
+        break;
+      }
     }
+    clReleaseEvent(prev_ev);
   }
 
-  status = clEnqueueReadBuffer(clState->commandQueue, clState->outputBuffer, CL_FALSE, 0,
-    buffersize, thrdata->res, 0, NULL, NULL);
-  if (unlikely(status != CL_SUCCESS)) {
-    applog(LOG_ERR, "Error: clEnqueueReadBuffer failed error %d. (clEnqueueReadBuffer)", status);
-    return -1;
+  if (!clState->svm_output) {
+    status = clEnqueueReadBuffer(clState->commandQueue, clState->outputBuffer, CL_FALSE, 0,
+      buffersize, thrdata->res, 0, NULL, NULL);
+    if (unlikely(status != CL_SUCCESS)) {
+      applog(LOG_ERR, "Error: clEnqueueReadBuffer failed error %d. (clEnqueueReadBuffer)", status);
+      return -1;
+    }
   }
 
   /* The amount of work scanned can fluctuate when intensity changes
@@ -1456,17 +2311,28 @@ static int64_t opencl_scanhash(struct thr_info *thr, struct work *work,
   /* This finish flushes the readbuffer set with CL_FALSE in clEnqueueReadBuffer */
   clFinish(clState->commandQueue);
 
+  /* Results in shared virtual memory are read and cleared in place */
+  if (clState->svm_output) {
+    status = read_svm_results(clState, thrdata->res, buffersize, found);
+    if (unlikely(status != CL_SUCCESS)) {
+      applog(LOG_ERR, "Error %d: reading results from shared virtual memory failed.", status);
+      return -1;
+    }
+  }
+
   /* found entry is used as a counter to say how many nonces exist */
   if (thrdata->res[found]) {
     /* Clear the buffer again */
-    status = clEnqueueWriteBuffer(clState->commandQueue, clState->outputBuffer, CL_FALSE, 0,
-      buffersize, blank_res, 0, NULL, NULL);
-    if (unlikely(status != CL_SUCCESS)) {
-      applog(LOG_ERR, "Error: clEnqueueWriteBuffer failed.");
-      return -1;
+    if (!clState->svm_output) {
+      status = clEnqueueWriteBuffer(clState->commandQueue, clState->outputBuffer, CL_FALSE, 0,
+        buffersize, blank_res, 0, NULL, NULL);
+      if (unlikely(status != CL_SUCCESS)) {
+        applog(LOG_ERR, "Error: clEnqueueWriteBuffer failed.");
+        return -1;
+      }
     }
     applog(LOG_DEBUG, "GPU %d found something?", gpu->device_id);
-    postcalc_hash_async(thr, work, thrdata->res);
+    postcalc_hash_async(thr, work, thrdata->res, found);
 //	postcalc_hash(thr);
 //	submit_tested_work(thr, work);
 //	submit_work_async(work);
@@ -1482,34 +2348,9 @@ static int64_t opencl_scanhash(struct thr_info *thr, struct work *work,
 // Note: This function is not thread-safe (clStates modification not atomic)
 static void opencl_thread_shutdown(struct thr_info *thr)
 {
-  const int thr_id = thr->id;
-  _clState *clState = clStates[thr_id];
-  clStates[thr_id] = NULL;
-  unsigned int i;
-
-  if (clState) {
-    clFinish(clState->commandQueue);
-    clReleaseMemObject(clState->outputBuffer);
-    clReleaseMemObject(clState->CLbuffer0);
-	if (clState->buffer1)
-	clReleaseMemObject(clState->buffer1);
-	if (clState->buffer2)
-	clReleaseMemObject(clState->buffer2);
-	if (clState->buffer3)
-	clReleaseMemObject(clState->buffer3);
-    if (clState->padbuffer8)
-      clReleaseMemObject(clState->padbuffer8);
-    clReleaseKernel(clState->kernel);
-    for (i = 0; i < clState->n_extra_kernels; i++)
-      clReleaseKernel(clState->extra_kernels[i]);
-    clReleaseProgram(clState->program);
-    clReleaseCommandQueue(clState->commandQueue);
-    clReleaseContext(clState->context);
-    if (clState->extra_kernels)
-      free(clState->extra_kernels);
-    free(clState);
-  }
-  free(((struct opencl_thread_data *)thr->cgpu_data)->res);
+  release_hot_states(thr->id);
+  if (thr->cgpu_data)
+    free(((struct opencl_thread_data *)thr->cgpu_data)->res);
   free(thr->cgpu_data);
   thr->cgpu_data = NULL;
 }
@@ -1544,6 +2385,7 @@ struct device_drv opencl_drv = {
   /*.hw_error = */    NULL,
   /*.thread_shutdown = */   opencl_thread_shutdown,
   /*.thread_enable =*/    NULL,
+  /*.thread_switch = */   opencl_thread_switch,
   false,
   0,
   0
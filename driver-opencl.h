@@ -24,10 +24,19 @@ extern char *set_worksize(const char *arg);
 extern char *set_shaders(char *arg);
 extern char *set_lookup_gap(char *arg);
 extern char *set_thread_concurrency(const char *arg);
+extern char *set_dual_threads(const char *arg);
+extern char *set_opencl_types(const char *arg);
 void manage_gpu(void);
 extern void pause_dynamic_threads(int gpu);
+extern void apply_pool_gpu_settings(struct pool *pool, unsigned long options, int gpu, struct cgpu_info *cgpu);
+extern int precompile_pool_kernels(struct pool *pool, unsigned long options);
 
 extern int opt_platform_id;
+extern bool opt_all_platforms;
+extern cl_device_type opt_opencl_types;
+extern bool opt_svm;
+extern int opt_build_threads;
+extern int opt_switcher_cache;
 
 extern struct device_drv opencl_drv;
 
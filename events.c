@@ -40,14 +40,12 @@ event_t *events = NULL, *last_event = NULL;
 /***************************************************
  * Helper functions
  **************************************************/
-static void *cmd_thread(void *cmdp)
+static void cmd_task(void *cmdp)
 {
 	const char *cmd = (const char*)cmdp;
 
 	applog(LOG_DEBUG, "Executing command: %s", cmd);
 	system(cmd);
-
-	return NULL;
 }
 
 static void runcmd(const char *cmd)
@@ -55,8 +53,7 @@ static void runcmd(const char *cmd)
 	if (empty_string(cmd))
 		return;
 
-	pthread_t pth;
-	pthread_create(&pth, NULL, cmd_thread, (void*)cmd);
+	queue_task(TASK_HOUSEKEEPING, cmd_task, (void*)cmd);
 }
 
 /****************************************************
@@ -170,51 +170,45 @@ void precalc_hash(dev_blk_ctx *blk, uint32_t *state, uint32_t *data)
 struct pc_data {
   struct thr_info *thr;
   struct work *work;
-  uint32_t res[MAXBUFFERS];
-  pthread_t pth;
-  int found;
+  uint32_t found;
+  uint32_t res[];
 };
 
-static void *postcalc_hash(void *userdata)
+static void postcalc_hash(void *userdata)
 {
   struct pc_data *pcd = (struct pc_data *)userdata;
   struct thr_info *thr = pcd->thr;
   unsigned int entry = 0;
-
-  int found = thr->cgpu->algorithm.found_idx;
-
-  pthread_detach(pthread_self());
-
-  /* To prevent corrupt values in FOUND from trying to read beyond the
-   * end of the res[] array */
-  if (unlikely(pcd->res[found] & ~found)) {
-    applog(LOG_WARNING, "%s%d: invalid nonce count - HW error",
-      thr->cgpu->drv->name, thr->cgpu->device_id);
-    hw_errors++;
-    thr->cgpu->hw_errors++;
-    pcd->res[found] &= found;
+  uint32_t found = pcd->found;
+  uint32_t count = pcd->res[found];
+
+  /* The kernels keep counting finds once all slots are taken, so a count
+   * beyond the last slot is the number of nonces that were dropped */
+  if (unlikely(count > found)) {
+    applog(LOG_WARNING, "%s%d: result buffer overflow, %u nonces dropped",
+      thr->cgpu->drv->name, thr->cgpu->device_id, count - found);
+    thr->cgpu->result_overflows += count - found;
+    count = found;
   }
 
-  for (entry = 0; entry < pcd->res[found]; entry++) {
+  for (entry = 0; entry < count; entry++) {
     uint32_t nonce = pcd->res[entry];
-    if (found == 0x0F)
+    if (pcd->work->pool->algorithm.found_idx == 0x0F)
       nonce = swab32(nonce);
 
     applog(LOG_DEBUG, "[THR%d] OCL NONCE %08x (%lu) found in slot %d (found = %d)", thr->id, nonce, nonce, entry, found);
-    submit_nonce(thr, pcd->work, nonce);
+    pcd->res[entry] = nonce;
   }
+  submit_nonces(thr, pcd->work, pcd->res, count);
 
   discard_work(pcd->work);
   free(pcd);
-
-  return NULL;
 }
 
-void postcalc_hash_async(struct thr_info *thr, struct work *work, uint32_t *res)
+void postcalc_hash_async(struct thr_info *thr, struct work *work, uint32_t *res, uint32_t found)
 {
-	
-  struct pc_data *pcd = (struct pc_data *)malloc(sizeof(struct pc_data));
-  int buffersize;
+  size_t buffersize = RESULT_BUFFERSIZE(found);
+  struct pc_data *pcd = (struct pc_data *)malloc(sizeof(struct pc_data) + buffersize);
 
   if (unlikely(!pcd)) {
     applog(LOG_ERR, "Failed to malloc pc_data in postcalc_hash_async");
@@ -223,12 +217,8 @@ void postcalc_hash_async(struct thr_info *thr, struct work *work, uint32_t *res)
 
   pcd->thr = thr;
   pcd->work = copy_work(work);
-  buffersize = BUFFERSIZE;
-   memcpy(&pcd->res, res, buffersize);
+  pcd->found = found;
+  memcpy(pcd->res, res, buffersize);
 
-  if (pthread_create(&pcd->pth, NULL, postcalc_hash, (void *)pcd)) {
-    applog(LOG_ERR, "Failed to create postcalc_hash thread");
-    discard_work(pcd->work);
-    free(pcd);
-  }
+  queue_task(TASK_VERIFY, postcalc_hash, (void *)pcd);
 }
@@ -6,8 +6,12 @@
 #define MAXTHREADS (0xFFFFFFFEULL)
 #define MAXBUFFERS (0x100)
 #define BUFFERSIZE (sizeof(uint32_t) * MAXBUFFERS)
+/* Result buffer holding found slots followed by the nonce counter */
+#define RESULT_BUFFERSIZE(found) (sizeof(uint32_t) * ((found) + 1))
+
+extern int opt_result_slots;
 
 extern void precalc_hash(dev_blk_ctx *blk, uint32_t *state, uint32_t *data);
-extern void postcalc_hash_async(struct thr_info *thr, struct work *work, uint32_t *res);
+extern void postcalc_hash_async(struct thr_info *thr, struct work *work, uint32_t *res, uint32_t found);
 
 #endif /*FINDNONCE_H*/
@@ -46,6 +46,8 @@
  * @author   Thomas Pornin <thomas.pornin@cryptolog.com>
  */
 
+#include "tables.cl"
+
 #if AES_BIG_ENDIAN
 
 #define AESx(x)   ( ((SPH_C32(x) >> 24) & SPH_C32(0x000000FF)) \
@@ -53,28 +55,47 @@
                   | ((SPH_C32(x) <<  8) & SPH_C32(0x00FF0000)) \
                   | ((SPH_C32(x) << 24) & SPH_C32(0xFF000000)))
 
+#if AES_TABLES == TABLES_CONSTANT
+#define AES0      AES0_C
+#define AES1      AES1_C
+#define AES2      AES2_C
+#define AES3      AES3_C
+#else
 #define AES0      AES0_BE
 #define AES1      AES1_BE
 #define AES2      AES2_BE
 #define AES3      AES3_BE
+#endif
+
+#if AES_TABLES == TABLES_COMPACT
+#define AES_T0(x)   AES0[x]
+#define AES_T1(x)   rotate(AES0[x], 24U)
+#define AES_T2(x)   rotate(AES0[x], 16U)
+#define AES_T3(x)   rotate(AES0[x], 8U)
+#else
+#define AES_T0(x)   AES0[x]
+#define AES_T1(x)   AES1[x]
+#define AES_T2(x)   AES2[x]
+#define AES_T3(x)   AES3[x]
+#endif
 
 #define AES_ROUND_BE(X0, X1, X2, X3, K0, K1, K2, K3, Y0, Y1, Y2, Y3)   do { \
-    (Y0) = AES0[((X0) >> 24) & 0xFF] \
-      ^ AES1[((X1) >> 16) & 0xFF] \
-      ^ AES2[((X2) >> 8) & 0xFF] \
-      ^ AES3[(X3) & 0xFF] ^ (K0); \
-    (Y1) = AES0[((X1) >> 24) & 0xFF] \
-      ^ AES1[((X2) >> 16) & 0xFF] \
-      ^ AES2[((X3) >> 8) & 0xFF] \
-      ^ AES3[(X0) & 0xFF] ^ (K1); \
-    (Y2) = AES0[((X2) >> 24) & 0xFF] \
-      ^ AES1[((X3) >> 16) & 0xFF] \
-      ^ AES2[((X0) >> 8) & 0xFF] \
-      ^ AES3[(X1) & 0xFF] ^ (K2); \
-    (Y3) = AES0[((X3) >> 24) & 0xFF] \
-      ^ AES1[((X0) >> 16) & 0xFF] \
-      ^ AES2[((X1) >> 8) & 0xFF] \
-      ^ AES3[(X2) & 0xFF] ^ (K3); \
+    (Y0) = AES_T0(((X0) >> 24) & 0xFF) \
+      ^ AES_T1(((X1) >> 16) & 0xFF) \
+      ^ AES_T2(((X2) >> 8) & 0xFF) \
+      ^ AES_T3((X3) & 0xFF) ^ (K0); \
+    (Y1) = AES_T0(((X1) >> 24) & 0xFF) \
+      ^ AES_T1(((X2) >> 16) & 0xFF) \
+      ^ AES_T2(((X3) >> 8) & 0xFF) \
+      ^ AES_T3((X0) & 0xFF) ^ (K1); \
+    (Y2) = AES_T0(((X2) >> 24) & 0xFF) \
+      ^ AES_T1(((X3) >> 16) & 0xFF) \
+      ^ AES_T2(((X0) >> 8) & 0xFF) \
+      ^ AES_T3((X1) & 0xFF) ^ (K2); \
+    (Y3) = AES_T0(((X3) >> 24) & 0xFF) \
+      ^ AES_T1(((X0) >> 16) & 0xFF) \
+      ^ AES_T2(((X1) >> 8) & 0xFF) \
+      ^ AES_T3((X2) & 0xFF) ^ (K3); \
   } while (0)
 
 #define AES_ROUND_NOKEY_BE(X0, X1, X2, X3, Y0, Y1, Y2, Y3) \
@@ -83,28 +104,47 @@
 #else
 
 #define AESx(x)   SPH_C32(x)
+#if AES_TABLES == TABLES_CONSTANT
+#define AES0      AES0_C
+#define AES1      AES1_C
+#define AES2      AES2_C
+#define AES3      AES3_C
+#else
 #define AES0      AES0_LE
 #define AES1      AES1_LE
 #define AES2      AES2_LE
 #define AES3      AES3_LE
+#endif
+
+#if AES_TABLES == TABLES_COMPACT
+#define AES_T0(x)   AES0[x]
+#define AES_T1(x)   rotate(AES0[x], 8U)
+#define AES_T2(x)   rotate(AES0[x], 16U)
+#define AES_T3(x)   rotate(AES0[x], 24U)
+#else
+#define AES_T0(x)   AES0[x]
+#define AES_T1(x)   AES1[x]
+#define AES_T2(x)   AES2[x]
+#define AES_T3(x)   AES3[x]
+#endif
 
 #define AES_ROUND_LE(X0, X1, X2, X3, K0, K1, K2, K3, Y0, Y1, Y2, Y3)   do { \
-    (Y0) = AES0[(X0) & 0xFF] \
-      ^ AES1[((X1) >> 8) & 0xFF] \
-      ^ AES2[((X2) >> 16) & 0xFF] \
-      ^ AES3[((X3) >> 24) & 0xFF] ^ (K0); \
-    (Y1) = AES0[(X1) & 0xFF] \
-      ^ AES1[((X2) >> 8) & 0xFF] \
-      ^ AES2[((X3) >> 16) & 0xFF] \
-      ^ AES3[((X0) >> 24) & 0xFF] ^ (K1); \
-    (Y2) = AES0[(X2) & 0xFF] \
-      ^ AES1[((X3) >> 8) & 0xFF] \
-      ^ AES2[((X0) >> 16) & 0xFF] \
-      ^ AES3[((X1) >> 24) & 0xFF] ^ (K2); \
-    (Y3) = AES0[(X3) & 0xFF] \
-      ^ AES1[((X0) >> 8) & 0xFF] \
-      ^ AES2[((X1) >> 16) & 0xFF] \
-      ^ AES3[((X2) >> 24) & 0xFF] ^ (K3); \
+    (Y0) = AES_T0((X0) & 0xFF) \
+      ^ AES_T1(((X1) >> 8) & 0xFF) \
+      ^ AES_T2(((X2) >> 16) & 0xFF) \
+      ^ AES_T3(((X3) >> 24) & 0xFF) ^ (K0); \
+    (Y1) = AES_T0((X1) & 0xFF) \
+      ^ AES_T1(((X2) >> 8) & 0xFF) \
+      ^ AES_T2(((X3) >> 16) & 0xFF) \
+      ^ AES_T3(((X0) >> 24) & 0xFF) ^ (K1); \
+    (Y2) = AES_T0((X2) & 0xFF) \
+      ^ AES_T1(((X3) >> 8) & 0xFF) \
+      ^ AES_T2(((X0) >> 16) & 0xFF) \
+      ^ AES_T3(((X1) >> 24) & 0xFF) ^ (K2); \
+    (Y3) = AES_T0((X3) & 0xFF) \
+      ^ AES_T1(((X0) >> 8) & 0xFF) \
+      ^ AES_T2(((X1) >> 16) & 0xFF) \
+      ^ AES_T3(((X2) >> 24) & 0xFF) ^ (K3); \
   } while (0)
 
 #define AES_ROUND_NOKEY_LE(X0, X1, X2, X3, Y0, Y1, Y2, Y3) \
@@ -386,4 +426,28 @@ __constant static const sph_u32 AES3_C[256] = {
   AESx(0x7BCBB0B0), AESx(0xA8FC5454), AESx(0x6DD6BBBB), AESx(0x2C3A1616)
 };
 
+/*
+ * Copy the tables needed by the selected placement to local memory.  Must
+ * be invoked at kernel scope, by every work item of the work-group.
+ */
+#if AES_TABLES == TABLES_CONSTANT
+#define AES_TABLES_LOAD()
+#elif AES_TABLES == TABLES_COMPACT
+#define AES_TABLES_LOAD() \
+  __local sph_u32 AES0[256]; \
+  for (int i = get_local_id(0); i < 256; i += get_local_size(0)) \
+    AES0[i] = AES0_C[i]; \
+  barrier(CLK_LOCAL_MEM_FENCE)
+#else
+#define AES_TABLES_LOAD() \
+  __local sph_u32 AES0[256], AES1[256], AES2[256], AES3[256]; \
+  for (int i = get_local_id(0); i < 256; i += get_local_size(0)) { \
+    AES0[i] = AES0_C[i]; \
+    AES1[i] = AES1_C[i]; \
+    AES2[i] = AES2_C[i]; \
+    AES3[i] = AES3_C[i]; \
+  } \
+  barrier(CLK_LOCAL_MEM_FENCE)
+#endif
+
 #endif
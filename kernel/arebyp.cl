@@ -53,9 +53,18 @@ __constant uint N[] = {
 	0x00100000U
 };
 
-/* Backwards compatibility, if NFACTOR not defined, default to 10 for scrypt */
-#ifndef NFACTOR
-#define NFACTOR 10
+/* NFACTOR and CONCURRENT_THREADS are baked in when defined at build time,
+ * otherwise they come from the nfactor and concurrent_threads arguments so
+ * one binary serves every N-factor and thread concurrency */
+#ifdef NFACTOR
+#define SCRYPT_NF NFACTOR
+#else
+#define SCRYPT_NF nfactor
+#endif
+#ifdef CONCURRENT_THREADS
+#define SCRYPT_TC CONCURRENT_THREADS
+#else
+#define SCRYPT_TC concurrent_threads
 #endif
 
 
@@ -877,11 +886,11 @@ void salsa(uint4 B[8])
 wrong lookup gap!
 #endif
 
-void scrypt_core(uint4 X[8], __global uint4*restrict lookup)
+void scrypt_core(uint4 X[8], __global uint4*restrict lookup, const uint nfactor, const uint concurrent_threads)
 {
   const uint zSIZE = 8;
-  const uint ySIZE = N[NFACTOR] / 2;
-  const uint xSIZE = CONCURRENT_THREADS;
+  const uint ySIZE = N[SCRYPT_NF] / 2;
+  const uint xSIZE = SCRYPT_TC;
   uint4 V[8];
   uint x = get_global_id(0) % xSIZE;
   uint z;
@@ -904,11 +913,11 @@ void scrypt_core(uint4 X[8], __global uint4*restrict lookup)
   //------------------------------------------------------------------------------------------------------------
   uint cotmp = x * zSIZE;
   progress = 0;
-  for (i = 0; i < N[NFACTOR] + (N[NFACTOR] / LOOKUP_GAP) + 42; i++)
+  for (i = 0; i < N[SCRYPT_NF] + (N[SCRYPT_NF] / LOOKUP_GAP) + 42; i++)
     {
-        //if (progress < 2 * N[NFACTOR])
+        //if (progress < 2 * N[SCRYPT_NF])
 		{
-			y = X[7].x & (N[NFACTOR]-1);
+			y = X[7].x & (N[SCRYPT_NF]-1);
 			CO = cotmp + (y / LOOKUP_GAP) * (xSIZE)  * zSIZE;
 
 			state = ((progress & 1) << 1) | (y & 1);
@@ -925,7 +934,7 @@ void scrypt_core(uint4 X[8], __global uint4*restrict lookup)
 					V[z] ^= X[z];
 			}
 			salsa(V);
-			ushort cond  = (state != 1) && (progress < 2 * N[NFACTOR]);
+			ushort cond  = (state != 1) && (progress < 2 * N[SCRYPT_NF]);
 			if (cond)
 			{
 #pragma unroll
@@ -945,13 +954,17 @@ void scrypt_core(uint4 X[8], __global uint4*restrict lookup)
 
 
 
-#define SCRYPT_FOUND (0xFF)
-#define SETFOUND(Xnonce) output[output[SCRYPT_FOUND]++] = Xnonce
+#ifndef FOUND_IDX
+  #define FOUND_IDX (0xFF)
+#endif
+#define SCRYPT_FOUND FOUND_IDX
+#define SETFOUND(Xnonce) { uint slot = atomic_inc(output + SCRYPT_FOUND); if (slot < SCRYPT_FOUND) output[slot] = Xnonce; }
 
 __attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
 __kernel void search(__global const uint4 * restrict input,
 volatile __global uint*restrict output, __global uint4*restrict padcache,
-const uint4 midstate0, const uint4 midstate16, const uint target)
+const uint4 midstate0, const uint4 midstate16, const uint target,
+const uint nfactor, const uint concurrent_threads)
 {
 	uint4 X[8];
 	uint4 tstate0, tstate1, ostate0, ostate1;
@@ -979,7 +992,7 @@ const uint4 midstate0, const uint4 midstate16, const uint target)
 		SHA256(X+rotl(i,1U),X+rotl(i,1U)+1, pad0, pad1, (uint4)(K[84], 0U, 0U, 0U), (uint4)(0U, 0U, 0U, K[88]));
 	}
 	shittify(X);
-	scrypt_core(X,padcache);
+	scrypt_core(X,padcache, nfactor, concurrent_threads);
 	unshittify(X);
 
 	SHA256(&tmp0,&tmp1, X[0], X[1], X[2], X[3]);
@@ -2,6 +2,10 @@
 
 #define SPH_ROTR32(v,n) rotate((uint)(v),(uint)(32-(n)))
 
+#ifndef FOUND_IDX
+  #define FOUND_IDX (0xFF)
+#endif
+
 __attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
 __kernel void search(
 	volatile __global uint * restrict output,
@@ -153,5 +157,5 @@ __kernel void search(
 
 	if(pre7 ^ V7 ^ VF)
 		return;
-	output[output[0xFF]++] = nonce;
+	{ uint slot = atomic_inc(output + FOUND_IDX); if (slot < FOUND_IDX) output[slot] = nonce; }
 }
\ No newline at end of file
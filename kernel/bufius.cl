@@ -53,9 +53,18 @@ __constant uint N[] = {
   0x00100000U
 };
 
-/* Backwards compatibility, if NFACTOR not defined, default to 10 for scrypt */
-#ifndef NFACTOR
-#define NFACTOR 10
+/* NFACTOR and CONCURRENT_THREADS are baked in when defined at build time,
+ * otherwise they come from the nfactor and concurrent_threads arguments so
+ * one binary serves every N-factor and thread concurrency */
+#ifdef NFACTOR
+#define SCRYPT_NF NFACTOR
+#else
+#define SCRYPT_NF nfactor
+#endif
+#ifdef CONCURRENT_THREADS
+#define SCRYPT_TC CONCURRENT_THREADS
+#else
+#define SCRYPT_TC concurrent_threads
 #endif
 
 __constant uint K[] = {
@@ -609,12 +618,12 @@ void salsa(uint4 B[8])
 }
 
 
-__constant uint COy=CONCURRENT_THREADS*8;
-void scrypt_core(uint4 X[8], __global uint4* const restrict lookup)
+void scrypt_core(uint4 X[8], __global uint4* const restrict lookup, const uint nfactor, const uint concurrent_threads)
 {
+  const uint COy         = SCRYPT_TC*8;
   const uint lookup_bits = popcount((uint)(LOOKUP_GAP-1U));
-  const uint write_loop  = N[NFACTOR-lookup_bits];
-  const uint COx         = rotl((uint)(get_global_id(0)%CONCURRENT_THREADS), 3U);
+  const uint write_loop  = N[SCRYPT_NF-lookup_bits];
+  const uint COx         = rotl((uint)(get_global_id(0)%SCRYPT_TC), 3U);
   uint CO                = COx;
   uint i, j, z, additional_salsa;
   uint4 V[8];
@@ -638,8 +647,8 @@ void scrypt_core(uint4 X[8], __global uint4* const restrict lookup)
 
   // read lookup table from memory and compute
 #pragma unroll 1
-  for (i=0; i<N[NFACTOR]; ++i) {
-    j = mul24((X[7].x & (N[NFACTOR]-LOOKUP_GAP)), (uint)(CONCURRENT_THREADS));
+  for (i=0; i<N[SCRYPT_NF]; ++i) {
+    j = mul24((X[7].x & (N[SCRYPT_NF]-LOOKUP_GAP)), (uint)(SCRYPT_TC));
     CO = COx + rotl(j, 3U-lookup_bits);
     additional_salsa = mod2(X[7].x, LOOKUP_GAP);
 
@@ -663,8 +672,11 @@ void scrypt_core(uint4 X[8], __global uint4* const restrict lookup)
 
 
 #pragma OPENCL EXTENSION cl_khr_global_int32_base_atomics : enable
-#define SCRYPT_FOUND (0xFF)
-#define SETFOUND(Xnonce) output[atomic_add(&output[SCRYPT_FOUND], 1)] = Xnonce;
+#ifndef FOUND_IDX
+  #define FOUND_IDX (0xFF)
+#endif
+#define SCRYPT_FOUND FOUND_IDX
+#define SETFOUND(Xnonce) { uint slot = atomic_inc(output + SCRYPT_FOUND); if (slot < SCRYPT_FOUND) output[slot] = Xnonce; }
 
 __attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
 __attribute__((max_work_group_size(WORKSIZE, 1, 1)))
@@ -672,7 +684,8 @@ __kernel void search(__global const uint4 * const restrict input,
            volatile __global uint* const restrict output,
            __global uint4* const restrict padcache,
            const uint4 midstate0, const uint4 midstate16,
-           const uint target)
+           const uint target,
+           const uint nfactor, const uint concurrent_threads)
 {
   uint4 X[8];
   uint4 tstate0, tstate1, ostate0, ostate1, tmp0, tmp1;
@@ -699,7 +712,7 @@ __kernel void search(__global const uint4 * const restrict input,
     SHA256(&X[rotl(i, 1U)], &X[rotl(i, 1U)+1], pad0, pad1, (uint4)(K[84], 0U, 0U, 0U), (uint4)(0U, 0U, 0U, K[88]));
   }
 
-  scrypt_core(X, padcache);
+  scrypt_core(X, padcache, nfactor, concurrent_threads);
 
   SHA256(&tmp0,&tmp1, X[0], X[1], X[2], X[3]);
   SHA256(&tmp0,&tmp1, X[4], X[5], X[6], X[7]);
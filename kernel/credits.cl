@@ -206,6 +206,10 @@ static __constant uint8 pad_state =
 
 
 
+#ifndef FOUND_IDX
+  #define FOUND_IDX (0xFF)
+#endif
+
 __attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
 __kernel void search(__global const uchar* restrict input, __global uint* restrict output,const ulong target, uint8 midstate )
 {
@@ -226,7 +230,7 @@ __kernel void search(__global const uchar* restrict input, __global uint* restri
 	state1 = sha256_Transform(in,H256);
 
 if (SWAP64(state1.s67) <= target)  
-		output[atomic_inc(output + 0xFF)] = nonce;
+		{ uint slot = atomic_inc(output + FOUND_IDX); if (slot < FOUND_IDX) output[slot] = nonce; }
 
 }
 
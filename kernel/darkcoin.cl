@@ -69,6 +69,7 @@ typedef long sph_s64;
 #define SPH_SIMD_NOCOPY 0
 #define SPH_KECCAK_NOCOPY 0
 #define SPH_SMALL_FOOTPRINT_GROESTL 0
+#define GROESTL_TABLES_DEFAULT TABLES_CONSTANT
 #define SPH_GROESTL_BIG_ENDIAN 0
 #define SPH_CUBEHASH_UNROLL 0
 #define SPH_COMPACT_BLAKE_64 0
@@ -98,6 +99,10 @@ typedef long sph_s64;
   #define DEC64BE(x) SWAP8(*(const __global sph_u64 *) (x));
 #endif
 
+#ifndef FOUND_IDX
+  #define FOUND_IDX (0xFF)
+#endif
+
 __attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
 __kernel void search(__global unsigned char* block, volatile __global uint* output, const ulong target)
 {
@@ -108,17 +113,8 @@ __kernel void search(__global unsigned char* block, volatile __global uint* outp
     ulong h8[8];
   } hash;
 
-  __local sph_u32 AES0[256], AES1[256], AES2[256], AES3[256];
-  int init = get_local_id(0);
-  int step = get_local_size(0);
-  for (int i = init; i < 256; i += step)
-  {
-    AES0[i] = AES0_C[i];
-    AES1[i] = AES1_C[i];
-    AES2[i] = AES2_C[i];
-    AES3[i] = AES3_C[i];
-  }
-  barrier(CLK_LOCAL_MEM_FENCE);
+  AES_TABLES_LOAD();
+  GROESTL_TABLES_LOAD();
 
   // blake
   {
@@ -725,7 +721,7 @@ __kernel void search(__global unsigned char* block, volatile __global uint* outp
 
     bool result = (Vb11 <= target);
     if (result)
-      output[output[0xFF]++] = SWAP4(gid);
+      { uint slot = atomic_inc(output + FOUND_IDX); if (slot < FOUND_IDX) output[slot] = SWAP4(gid); }
   }
 }
 
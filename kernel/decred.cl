@@ -26,6 +26,10 @@
 #define ROTR8(v) as_uint(as_uchar4(v).yzwx)
 #endif
 
+#ifndef FOUND_IDX
+  #define FOUND_IDX (0xFF)
+#endif
+
 __attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
 __kernel void search(
 	volatile __global uint * restrict output,
@@ -157,5 +161,5 @@ __kernel void search(
 	if (pre7 ^ V7 ^ VF) return;
 
 	/* Push this share */
-	output[output[0xFF]++] = M3;
+	{ uint slot = atomic_inc(output + FOUND_IDX); if (slot < FOUND_IDX) output[slot] = M3; }
 }
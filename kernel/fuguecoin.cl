@@ -74,8 +74,12 @@ typedef long sph_s64;
   #define DEC32BE(x) SWAP4(*(const __global sph_u32 *) (x))
 #endif
 
+#ifndef FOUND_IDX
+  #define FOUND_IDX (0xFF)
+#endif
+
 __attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
-__kernel void search(__global unsigned char* input, volatile __global uint* output, const ulong target)
+__kernel void search(__global const uint* state, volatile __global uint* output, const ulong target)
 {
   uint gid = get_global_id(0);
 
@@ -92,14 +96,13 @@ __kernel void search(__global unsigned char* input, volatile __global uint* outp
   }
   barrier(CLK_GLOBAL_MEM_FENCE);
 
-  sph_u32 S00 = 0, S01 = 0, S02 = 0, S03 = 0, S04 = 0, S05 = 0, S06 = 0, S07 = 0, S08 = 0, S09 = 0; \
-  sph_u32 S10 = 0, S11 = 0, S12 = 0, S13 = 0, S14 = 0, S15 = 0, S16 = 0, S17 = 0, S18 = 0, S19 = 0; \
-  sph_u32 S20 = 0, S21 = 0, S22 = IV256[0], S23 = IV256[1], S24 = IV256[2], S25 = IV256[3], S26 = IV256[4], S27 = IV256[5], S28 = IV256[6], S29 = IV256[7];
-
-  FUGUE256_5(DEC32BE(input + 0x0), DEC32BE(input + 0x4), DEC32BE(input + 0x8), DEC32BE(input + 0xc), DEC32BE(input + 0x10));
-  FUGUE256_5(DEC32BE(input + 0x14), DEC32BE(input + 0x18), DEC32BE(input + 0x1c), DEC32BE(input + 0x20), DEC32BE(input + 0x24));
-  FUGUE256_5(DEC32BE(input + 0x28), DEC32BE(input + 0x2c), DEC32BE(input + 0x30), DEC32BE(input + 0x34), DEC32BE(input + 0x38));
-  FUGUE256_4(DEC32BE(input + 0x3c), DEC32BE(input + 0x40), DEC32BE(input + 0x44), DEC32BE(input + 0x48));
+  // the host absorbed the first 19 header words, see fuguecoin_midstate()
+  sph_u32 S00 = state[0], S01 = state[1], S02 = state[2], S03 = state[3], S04 = state[4];
+  sph_u32 S05 = state[5], S06 = state[6], S07 = state[7], S08 = state[8], S09 = state[9];
+  sph_u32 S10 = state[10], S11 = state[11], S12 = state[12], S13 = state[13], S14 = state[14];
+  sph_u32 S15 = state[15], S16 = state[16], S17 = state[17], S18 = state[18], S19 = state[19];
+  sph_u32 S20 = state[20], S21 = state[21], S22 = state[22], S23 = state[23], S24 = state[24];
+  sph_u32 S25 = state[25], S26 = state[26], S27 = state[27], S28 = state[28], S29 = state[29];
 
   TIX2(SWAP4(gid), S06, S07, S14, S16, S00);
   CMIX30(S03, S04, S05, S07, S08, S09, S18, S19, S20);
@@ -223,7 +226,7 @@ __kernel void search(__global unsigned char* input, volatile __global uint* outp
 
   bool result = ((((sph_u64) SWAP4(S19) << 32) | SWAP4(S18)) <= target);
   if (result)
-    output[output[0xFF]++] = SWAP4(gid);
+    { uint slot = atomic_inc(output + FOUND_IDX); if (slot < FOUND_IDX) output[slot] = SWAP4(gid); }
 }
 
 #endif // FUGUECOIN_CL
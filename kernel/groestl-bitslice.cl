@@ -0,0 +1,408 @@
+/* Bitsliced Groestl-512, four work items per state.
+ *
+ * ==========================(LICENSE BEGIN)============================
+ *
+ * Copyright (c) 2014  phm
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * ===========================(LICENSE END)=============================
+ */
+
+#ifndef GROESTL_BITSLICE_CL
+#define GROESTL_BITSLICE_CL
+
+// The 8x16 byte state is split by rows: lane l (local id & 3) of a quad
+// holds rows 2l and 2l+1.  It keeps them as eight bit planes, where bit p
+// of every byte goes to plane p, the row 2l byte of column c to bit c and
+// the row 2l+1 byte to bit 16+c.  SubBytes is then a boolean circuit over
+// the planes and ShiftBytes a rotation within each 16-bit half.  Only
+// MixBytes needs the other rows, which are swapped through 32 uints of
+// local memory per quad.  There are no lookup tables.
+
+#if (WORKSIZE % 4) != 0
+  #error "groestl-bitslice.cl needs a worksize divisible by 4"
+#endif
+
+#define GROESTL_BS_LANE (get_local_id(0) & 3)
+
+__constant uint groestl_bs_shift_p[8] = { 0, 1, 2, 3, 4, 5, 6, 11 };
+__constant uint groestl_bs_shift_q[8] = { 1, 3, 5, 11, 0, 2, 4, 6 };
+
+// Byte (j << 4) ^ r goes into every column j of row 0 (P) or row 7 (Q),
+// so planes 4..7 of the round constant follow the column number.
+__constant uint groestl_bs_column_bits[4] = { 0xAAAA, 0xCCCC, 0xF0F0, 0xFF00 };
+
+// AES S-box computed over GF((2^4)^2), checked against all 256 inputs.
+void groestl_bs_sbox(uint *x)
+{
+  uint t0 = x[5] ^ x[7];
+  uint t1 = x[4] ^ x[6];
+  uint t2 = x[2] ^ x[3];
+  uint t3 = t0 ^ t2;
+  uint t4 = x[0] ^ t0;
+  uint t5 = t1 ^ t3;
+  uint t6 = x[3] ^ x[4];
+  uint t7 = x[5] ^ t1;
+  uint t8 = x[1] ^ x[7];
+  uint t9 = t1 ^ t8;
+  uint t10 = t0 ^ t3;
+  uint t11 = t9 ^ t10;
+  uint t12 = t7 ^ t10;
+  uint t13 = t4 ^ t5;
+  uint t14 = x[2] ^ t6;
+  uint t15 = t4 & t7;
+  uint t16 = x[2] & t7;
+  uint t17 = t5 & t7;
+  uint t18 = t6 & t7;
+  uint t19 = t4 & t9;
+  uint t20 = t16 ^ t19;
+  uint t21 = x[2] & t9;
+  uint t22 = t17 ^ t21;
+  uint t23 = t5 & t9;
+  uint t24 = t18 ^ t23;
+  uint t25 = t6 & t9;
+  uint t26 = t3 & t4;
+  uint t27 = t22 ^ t26;
+  uint t28 = x[2] & t3;
+  uint t29 = t24 ^ t28;
+  uint t30 = t3 & t5;
+  uint t31 = t25 ^ t30;
+  uint t32 = t3 & t6;
+  uint t33 = t0 & t4;
+  uint t34 = t29 ^ t33;
+  uint t35 = x[2] & t0;
+  uint t36 = t31 ^ t35;
+  uint t37 = t0 & t5;
+  uint t38 = t32 ^ t37;
+  uint t39 = t0 & t6;
+  uint t40 = t27 ^ t39;
+  uint t41 = t34 ^ t39;
+  uint t42 = t20 ^ t38;
+  uint t43 = t38 ^ t40;
+  uint t44 = t15 ^ t36;
+  uint t45 = t36 ^ t42;
+  uint t46 = t3 ^ t13;
+  uint t47 = t44 ^ t46;
+  uint t48 = t5 ^ t11;
+  uint t49 = t45 ^ t48;
+  uint t50 = t9 ^ t14;
+  uint t51 = t43 ^ t50;
+  uint t52 = t6 ^ t12;
+  uint t53 = t41 ^ t52;
+  uint t54 = t47 ^ t51;
+  uint t55 = t49 ^ t53;
+  uint t56 = t54 ^ t55;
+  uint t57 = t51 ^ t53;
+  uint t58 = t47 ^ t49;
+  uint t59 = t54 & t56;
+  uint t60 = t54 & t55;
+  uint t61 = t54 & t57;
+  uint t62 = t53 & t54;
+  uint t63 = t51 & t56;
+  uint t64 = t60 ^ t63;
+  uint t65 = t51 & t55;
+  uint t66 = t61 ^ t65;
+  uint t67 = t51 & t57;
+  uint t68 = t62 ^ t67;
+  uint t69 = t51 & t53;
+  uint t70 = t55 & t56;
+  uint t71 = t66 ^ t70;
+  uint t72 = t55 ^ t68;
+  uint t73 = t55 & t57;
+  uint t74 = t69 ^ t73;
+  uint t75 = t53 & t55;
+  uint t76 = t53 & t56;
+  uint t77 = t72 ^ t76;
+  uint t78 = t74 ^ t75;
+  uint t79 = t53 & t57;
+  uint t80 = t75 ^ t79;
+  uint t81 = t53 ^ t71;
+  uint t82 = t53 ^ t77;
+  uint t83 = t64 ^ t80;
+  uint t84 = t80 ^ t81;
+  uint t85 = t59 ^ t78;
+  uint t86 = t78 ^ t83;
+  uint t87 = t58 & t85;
+  uint t88 = t57 & t85;
+  uint t89 = t49 & t85;
+  uint t90 = t53 & t85;
+  uint t91 = t58 & t86;
+  uint t92 = t88 ^ t91;
+  uint t93 = t57 & t86;
+  uint t94 = t89 ^ t93;
+  uint t95 = t49 & t86;
+  uint t96 = t90 ^ t95;
+  uint t97 = t53 & t86;
+  uint t98 = t58 & t84;
+  uint t99 = t94 ^ t98;
+  uint t100 = t57 & t84;
+  uint t101 = t96 ^ t100;
+  uint t102 = t49 & t84;
+  uint t103 = t97 ^ t102;
+  uint t104 = t53 & t84;
+  uint t105 = t58 & t82;
+  uint t106 = t101 ^ t105;
+  uint t107 = t57 & t82;
+  uint t108 = t103 ^ t107;
+  uint t109 = t49 & t82;
+  uint t110 = t104 ^ t109;
+  uint t111 = t53 & t82;
+  uint t112 = t99 ^ t111;
+  uint t113 = t106 ^ t111;
+  uint t114 = t92 ^ t110;
+  uint t115 = t110 ^ t112;
+  uint t116 = t87 ^ t108;
+  uint t117 = t108 ^ t114;
+  uint t118 = t7 & t116;
+  uint t119 = t7 & t117;
+  uint t120 = t7 & t115;
+  uint t121 = t7 & t113;
+  uint t122 = t9 & t116;
+  uint t123 = t119 ^ t122;
+  uint t124 = t9 & t117;
+  uint t125 = t120 ^ t124;
+  uint t126 = t9 & t115;
+  uint t127 = t121 ^ t126;
+  uint t128 = t9 & t113;
+  uint t129 = t3 & t116;
+  uint t130 = t125 ^ t129;
+  uint t131 = t3 & t117;
+  uint t132 = t127 ^ t131;
+  uint t133 = t3 & t115;
+  uint t134 = t128 ^ t133;
+  uint t135 = t3 & t113;
+  uint t136 = t0 & t116;
+  uint t137 = t132 ^ t136;
+  uint t138 = t0 & t117;
+  uint t139 = t134 ^ t138;
+  uint t140 = t0 & t115;
+  uint t141 = t135 ^ t140;
+  uint t142 = t0 & t113;
+  uint t143 = t130 ^ t142;
+  uint t144 = t137 ^ t142;
+  uint t145 = t123 ^ t141;
+  uint t146 = t141 ^ t143;
+  uint t147 = t118 ^ t139;
+  uint t148 = t139 ^ t145;
+  uint t149 = t4 ^ t7;
+  uint t150 = x[2] ^ t9;
+  uint t151 = t3 ^ t5;
+  uint t152 = t0 ^ t6;
+  uint t153 = t116 & t149;
+  uint t154 = t117 & t149;
+  uint t155 = t115 & t149;
+  uint t156 = t113 & t149;
+  uint t157 = t116 & t150;
+  uint t158 = t154 ^ t157;
+  uint t159 = t117 & t150;
+  uint t160 = t155 ^ t159;
+  uint t161 = t115 & t150;
+  uint t162 = t156 ^ t161;
+  uint t163 = t113 & t150;
+  uint t164 = t116 & t151;
+  uint t165 = t160 ^ t164;
+  uint t166 = t117 & t151;
+  uint t167 = t162 ^ t166;
+  uint t168 = t115 & t151;
+  uint t169 = t163 ^ t168;
+  uint t170 = t113 & t151;
+  uint t171 = t116 & t152;
+  uint t172 = t167 ^ t171;
+  uint t173 = t117 & t152;
+  uint t174 = t169 ^ t173;
+  uint t175 = t115 & t152;
+  uint t176 = t170 ^ t175;
+  uint t177 = t113 & t152;
+  uint t178 = t165 ^ t177;
+  uint t179 = t172 ^ t177;
+  uint t180 = t158 ^ t176;
+  uint t181 = t176 ^ t178;
+  uint t182 = t153 ^ t174;
+  uint t183 = t174 ^ t180;
+  uint t184 = t148 ^ t182;
+  uint t185 = t181 ^ t183;
+  uint t186 = t179 ^ t184;
+  uint t187 = t147 ^ t186;
+  uint t188 = t144 ^ t146;
+  uint t189 = t181 ^ t182;
+  uint t190 = t146 ^ t189;
+  uint t191 = t185 ^ t187;
+  uint t192 = t146 ^ t186;
+  uint t193 = t181 ^ t184;
+  uint t194 = t183 ^ t187;
+  uint t195 = t148 ^ t179;
+  uint t196 = t185 ^ t195;
+  uint t197 = t188 ^ t196;
+  uint t198 = t147 ^ t188;
+  x[0] = ~t190;
+  x[1] = ~t191;
+  x[2] = t192;
+  x[3] = t193;
+  x[4] = t194;
+  x[5] = ~t197;
+  x[6] = ~t198;
+  x[7] = t185;
+}
+
+// Multiplication by 02 modulo x^8 + x^4 + x^3 + x + 1.
+#define GROESTL_BS_XTIME(o, a) do { \
+    uint hi = (a)[7]; \
+    (o)[7] = (a)[6]; \
+    (o)[6] = (a)[5]; \
+    (o)[5] = (a)[4]; \
+    (o)[4] = (a)[3] ^ hi; \
+    (o)[3] = (a)[2] ^ hi; \
+    (o)[2] = (a)[1]; \
+    (o)[1] = (a)[0] ^ hi; \
+    (o)[0] = hi; \
+  } while (0)
+
+// Row r moves left by shift[r] columns, i.e. its bits rotate right.
+uint groestl_bs_rotate(uint v, uint lo, uint hi)
+{
+  uint a = v & 0xFFFF, b = v >> 16;
+
+  a = ((a >> lo) | (a << (16 - lo))) & 0xFFFF;
+  b = ((b >> hi) | (b << (16 - hi))) & 0xFFFF;
+  return a | (b << 16);
+}
+
+// Row i becomes sum(k) c[k] * row[i + k] with c = 02 02 03 04 05 03 05 07,
+// grouped by the bits of c as s1 + 02 * (s2 + 02 * s4).  wN holds rows
+// 2l+N and 2l+N+1.
+void groestl_bs_mix(uint *x, __local uint *xchg)
+{
+  uint lane = GROESTL_BS_LANE;
+  uint s1[8], s2[8], s4[8], t[8];
+
+  for (int p = 0; p < 8; p++)
+    xchg[p * 4 + lane] = x[p];
+  barrier(CLK_LOCAL_MEM_FENCE);
+
+  for (int p = 0; p < 8; p++) {
+    uint w0 = xchg[p * 4 + lane];
+    uint w2 = xchg[p * 4 + ((lane + 1) & 3)];
+    uint w4 = xchg[p * 4 + ((lane + 2) & 3)];
+    uint w6 = xchg[p * 4 + ((lane + 3) & 3)];
+    uint w1 = (w0 >> 16) | (w2 << 16);
+    uint w3 = (w2 >> 16) | (w4 << 16);
+    uint w5 = (w4 >> 16) | (w6 << 16);
+    uint w7 = (w6 >> 16) | (w0 << 16);
+
+    s1[p] = w2 ^ w4 ^ w5 ^ w6 ^ w7;
+    s2[p] = w0 ^ w1 ^ w2 ^ w5 ^ w7;
+    s4[p] = w3 ^ w4 ^ w6 ^ w7;
+  }
+  barrier(CLK_LOCAL_MEM_FENCE);
+
+  GROESTL_BS_XTIME(t, s4);
+  for (int p = 0; p < 8; p++)
+    s2[p] ^= t[p];
+  GROESTL_BS_XTIME(t, s2);
+  for (int p = 0; p < 8; p++)
+    x[p] = s1[p] ^ t[p];
+}
+
+void groestl_bs_perm(uint *x, __local uint *xchg, bool q)
+{
+  uint lane = GROESTL_BS_LANE;
+  __constant uint *shift = q ? groestl_bs_shift_q : groestl_bs_shift_p;
+  uint lo = shift[2 * lane], hi = shift[2 * lane + 1];
+  uint row = q ? ((lane == 3) ? 0xFFFF0000 : 0) : ((lane == 0) ? 0xFFFF : 0);
+  uint inv = q ? 0xFFFFFFFF : 0;
+
+  for (uint r = 0; r < 14; r++) {
+    for (int p = 0; p < 4; p++)
+      x[p] ^= inv ^ (((r >> p) & 1) ? row : 0);
+    for (int p = 4; p < 8; p++)
+      x[p] ^= inv ^ ((groestl_bs_column_bits[p - 4] * 0x10001) & row);
+    groestl_bs_sbox(x);
+    for (int p = 0; p < 8; p++)
+      x[p] = groestl_bs_rotate(x[p], lo, hi);
+    groestl_bs_mix(x, xchg);
+  }
+}
+
+// Columns are little endian ulongs, as in groestl.cl.
+void groestl_bs_load(uint *x, const ulong *col)
+{
+  uint lane = GROESTL_BS_LANE;
+
+  for (int p = 0; p < 8; p++)
+    x[p] = 0;
+  for (int c = 0; c < 16; c++) {
+    uint v = (uint)(col[c] >> (16 * lane));
+    for (int p = 0; p < 8; p++)
+      x[p] |= (((v >> p) & 1) << c) | (((v >> (8 + p)) & 1) << (16 + c));
+  }
+}
+
+void groestl_bs_store(ulong *col, const uint *x, __local uint *xchg)
+{
+  uint lane = GROESTL_BS_LANE;
+  __local ushort *rows = (__local ushort *)xchg;
+
+  for (int c = 0; c < 16; c++) {
+    uint v = 0;
+    for (int p = 0; p < 8; p++)
+      v |= (((x[p] >> c) & 1) << p) | (((x[p] >> (16 + c)) & 1) << (8 + p));
+    rows[c * 4 + lane] = (ushort)v;
+  }
+  barrier(CLK_LOCAL_MEM_FENCE);
+  for (int c = 0; c < 16; c++)
+    col[c] = ((__local ulong *)xchg)[c];
+  barrier(CLK_LOCAL_MEM_FENCE);
+}
+
+// Groestl-512 of one padded 128 byte block m, given as 16 column ulongs.
+// Every lane of the quad gets the 64 byte result in h.  xchg is the
+// quad's 16 ulongs of local memory.
+void groestl512_bs(ulong *h, const ulong *m, __local uint *xchg)
+{
+  uint lane = GROESTL_BS_LANE;
+  uint g[8], q[8];
+  ulong col[16];
+
+  // IV: 512 in the last two bytes, i.e. bit 1 of row 6 in column 15
+  uint iv = (lane == 3) ? 0x8000 : 0;
+
+  groestl_bs_load(q, m);
+  for (int p = 0; p < 8; p++)
+    g[p] = q[p];
+  g[1] ^= iv;
+  groestl_bs_perm(g, xchg, false);
+  groestl_bs_perm(q, xchg, true);
+  for (int p = 0; p < 8; p++)
+    q[p] ^= g[p];
+  q[1] ^= iv;
+
+  for (int p = 0; p < 8; p++)
+    g[p] = q[p];
+  groestl_bs_perm(g, xchg, false);
+  for (int p = 0; p < 8; p++)
+    g[p] ^= q[p];
+
+  groestl_bs_store(col, g, xchg);
+  for (int u = 0; u < 8; u++)
+    h[u] = col[u + 8];
+}
+
+#endif // GROESTL_BITSLICE_CL
@@ -30,6 +30,32 @@
  * @author   Thomas Pornin <thomas.pornin@cryptolog.com>
  */
 
+#include "tables.cl"
+
+/*
+ * Tables used by the round macros: the __constant tables themselves, or
+ * the __local copies made by GROESTL_TABLES_LOAD().
+ */
+#if GROESTL_TABLES == TABLES_CONSTANT
+#define GROESTL_T0  T0
+#define GROESTL_T1  T1
+#define GROESTL_T2  T2
+#define GROESTL_T3  T3
+#define GROESTL_T4  T4
+#define GROESTL_T5  T5
+#define GROESTL_T6  T6
+#define GROESTL_T7  T7
+#else
+#define GROESTL_T0  T0_L
+#define GROESTL_T1  T1_L
+#define GROESTL_T2  T2_L
+#define GROESTL_T3  T3_L
+#define GROESTL_T4  T4_L
+#define GROESTL_T5  T5_L
+#define GROESTL_T6  T6_L
+#define GROESTL_T7  T7_L
+#endif
+
 /*
  * Apparently, the 32-bit-only version is not faster than the 64-bit
  * version unless using the "small footprint" code on a 32-bit machine.
@@ -1159,30 +1185,43 @@ __constant static const sph_u64 T7[] = {
 
 #endif
 
-#if SPH_SMALL_FOOTPRINT_GROESTL
+#if GROESTL_TABLES == TABLES_COMPACT
+
+#define RBTT(d, a, b0, b1, b2, b3, b4, b5, b6, b7)   do { \
+    t[d] = GROESTL_T0[B64_0(a[b0])] \
+      ^ R64(GROESTL_T0[B64_1(a[b1])],  8) \
+      ^ R64(GROESTL_T0[B64_2(a[b2])], 16) \
+      ^ R64(GROESTL_T0[B64_3(a[b3])], 24) \
+      ^ R64(GROESTL_T0[B64_4(a[b4])], 32) \
+      ^ R64(GROESTL_T0[B64_5(a[b5])], 40) \
+      ^ R64(GROESTL_T0[B64_6(a[b6])], 48) \
+      ^ R64(GROESTL_T0[B64_7(a[b7])], 56); \
+  } while (0)
+
+#elif SPH_SMALL_FOOTPRINT_GROESTL
 
 #define RBTT(d, a, b0, b1, b2, b3, b4, b5, b6, b7)   do { \
-    t[d] = T0[B64_0(a[b0])] \
-      ^ R64(T0[B64_1(a[b1])],  8) \
-      ^ R64(T0[B64_2(a[b2])], 16) \
-      ^ R64(T0[B64_3(a[b3])], 24) \
-      ^ T4[B64_4(a[b4])] \
-      ^ R64(T4[B64_5(a[b5])],  8) \
-      ^ R64(T4[B64_6(a[b6])], 16) \
-      ^ R64(T4[B64_7(a[b7])], 24); \
+    t[d] = GROESTL_T0[B64_0(a[b0])] \
+      ^ R64(GROESTL_T0[B64_1(a[b1])],  8) \
+      ^ R64(GROESTL_T0[B64_2(a[b2])], 16) \
+      ^ R64(GROESTL_T0[B64_3(a[b3])], 24) \
+      ^ GROESTL_T4[B64_4(a[b4])] \
+      ^ R64(GROESTL_T4[B64_5(a[b5])],  8) \
+      ^ R64(GROESTL_T4[B64_6(a[b6])], 16) \
+      ^ R64(GROESTL_T4[B64_7(a[b7])], 24); \
   } while (0)
 
 #else
 
 #define RBTT(d, a, b0, b1, b2, b3, b4, b5, b6, b7)   do { \
-    t[d] = T0[B64_0(a[b0])] \
-      ^ T1[B64_1(a[b1])] \
-      ^ T2[B64_2(a[b2])] \
-      ^ T3[B64_3(a[b3])] \
-      ^ T4[B64_4(a[b4])] \
-      ^ T5[B64_5(a[b5])] \
-      ^ T6[B64_6(a[b6])] \
-      ^ T7[B64_7(a[b7])]; \
+    t[d] = GROESTL_T0[B64_0(a[b0])] \
+      ^ GROESTL_T1[B64_1(a[b1])] \
+      ^ GROESTL_T2[B64_2(a[b2])] \
+      ^ GROESTL_T3[B64_3(a[b3])] \
+      ^ GROESTL_T4[B64_4(a[b4])] \
+      ^ GROESTL_T5[B64_5(a[b5])] \
+      ^ GROESTL_T6[B64_6(a[b6])] \
+      ^ GROESTL_T7[B64_7(a[b7])]; \
   } while (0)
 
 #endif
@@ -1430,30 +1469,43 @@ __constant static const sph_u64 T7[] = {
     } \
   } while (0)
 
-#if SPH_SMALL_FOOTPRINT_GROESTL
+#if GROESTL_TABLES == TABLES_COMPACT
+
+#define RSTT(d, a, b0, b1, b2, b3, b4, b5, b6, b7)   do { \
+		t[d] = GROESTL_T0[B64_0(a[b0])] \
+			^ R64(GROESTL_T0[B64_1(a[b1])],  8) \
+			^ R64(GROESTL_T0[B64_2(a[b2])], 16) \
+			^ R64(GROESTL_T0[B64_3(a[b3])], 24) \
+			^ R64(GROESTL_T0[B64_4(a[b4])], 32) \
+			^ R64(GROESTL_T0[B64_5(a[b5])], 40) \
+			^ R64(GROESTL_T0[B64_6(a[b6])], 48) \
+			^ R64(GROESTL_T0[B64_7(a[b7])], 56); \
+	} while (0)
+
+#elif SPH_SMALL_FOOTPRINT_GROESTL
 
 #define RSTT(d, a, b0, b1, b2, b3, b4, b5, b6, b7)   do { \
-		t[d] = T0[B64_0(a[b0])] \
-			^ R64(T0[B64_1(a[b1])],  8) \
-			^ R64(T0[B64_2(a[b2])], 16) \
-			^ R64(T0[B64_3(a[b3])], 24) \
-			^ T4[B64_4(a[b4])] \
-			^ R64(T4[B64_5(a[b5])],  8) \
-			^ R64(T4[B64_6(a[b6])], 16) \
-			^ R64(T4[B64_7(a[b7])], 24); \
+		t[d] = GROESTL_T0[B64_0(a[b0])] \
+			^ R64(GROESTL_T0[B64_1(a[b1])],  8) \
+			^ R64(GROESTL_T0[B64_2(a[b2])], 16) \
+			^ R64(GROESTL_T0[B64_3(a[b3])], 24) \
+			^ GROESTL_T4[B64_4(a[b4])] \
+			^ R64(GROESTL_T4[B64_5(a[b5])],  8) \
+			^ R64(GROESTL_T4[B64_6(a[b6])], 16) \
+			^ R64(GROESTL_T4[B64_7(a[b7])], 24); \
 	} while (0)
 
 #else
 
 #define RSTT(d, a, b0, b1, b2, b3, b4, b5, b6, b7)   do { \
-		t[d] = T0[B64_0(a[b0])] \
-			^ T1[B64_1(a[b1])] \
-			^ T2[B64_2(a[b2])] \
-			^ T3[B64_3(a[b3])] \
-			^ T4[B64_4(a[b4])] \
-			^ T5[B64_5(a[b5])] \
-			^ T6[B64_6(a[b6])] \
-			^ T7[B64_7(a[b7])]; \
+		t[d] = GROESTL_T0[B64_0(a[b0])] \
+			^ GROESTL_T1[B64_1(a[b1])] \
+			^ GROESTL_T2[B64_2(a[b2])] \
+			^ GROESTL_T3[B64_3(a[b3])] \
+			^ GROESTL_T4[B64_4(a[b4])] \
+			^ GROESTL_T5[B64_5(a[b5])] \
+			^ GROESTL_T6[B64_6(a[b6])] \
+			^ GROESTL_T7[B64_7(a[b7])]; \
 	} while (0)
 
 #endif
@@ -1550,3 +1602,40 @@ __constant static const sph_u64 T7[] = {
 	} while (0)
 
 #endif
+
+/*
+ * Copy the tables needed by the selected placement to local memory.  Must
+ * be invoked at kernel scope, by every work item of the work-group.
+ */
+#if GROESTL_TABLES == TABLES_CONSTANT
+#define GROESTL_TABLES_LOAD()
+#elif GROESTL_TABLES == TABLES_COMPACT
+#define GROESTL_TABLES_LOAD() \
+  __local sph_u64 T0_L[256]; \
+  for (int i = get_local_id(0); i < 256; i += get_local_size(0)) \
+    T0_L[i] = T0[i]; \
+  barrier(CLK_LOCAL_MEM_FENCE)
+#elif SPH_SMALL_FOOTPRINT_GROESTL
+#define GROESTL_TABLES_LOAD() \
+  __local sph_u64 T0_L[256], T4_L[256]; \
+  for (int i = get_local_id(0); i < 256; i += get_local_size(0)) { \
+    T0_L[i] = T0[i]; \
+    T4_L[i] = T4[i]; \
+  } \
+  barrier(CLK_LOCAL_MEM_FENCE)
+#else
+#define GROESTL_TABLES_LOAD() \
+  __local sph_u64 T0_L[256], T1_L[256], T2_L[256], T3_L[256]; \
+  __local sph_u64 T4_L[256], T5_L[256], T6_L[256], T7_L[256]; \
+  for (int i = get_local_id(0); i < 256; i += get_local_size(0)) { \
+    T0_L[i] = T0[i]; \
+    T1_L[i] = T1[i]; \
+    T2_L[i] = T2[i]; \
+    T3_L[i] = T3[i]; \
+    T4_L[i] = T4[i]; \
+    T5_L[i] = T5[i]; \
+    T6_L[i] = T6[i]; \
+    T7_L[i] = T7[i]; \
+  } \
+  barrier(CLK_LOCAL_MEM_FENCE)
+#endif
@@ -0,0 +1,54 @@
+/*
+ * GroestlCoin kernel implementation using bitsliced Groestl-512.
+ *
+ * Drop-in kernelfile for groestlcoin and diamond.  Each quad of work items
+ * hashes the four nonces of its members one after the other, so launch
+ * geometry and kernel arguments are the same as for groestlcoin.cl.  The
+ * worksize must be a multiple of 4.
+ */
+
+#ifndef GROESTLCOIN_BITSLICE_CL
+#define GROESTLCOIN_BITSLICE_CL
+
+#include "groestl-bitslice.cl"
+
+#define SWAP4(x) as_uint(as_uchar4(x).wzyx)
+
+#ifndef FOUND_IDX
+  #define FOUND_IDX (0xFF)
+#endif
+
+__attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
+__kernel void search(__global unsigned char* block, volatile __global uint* output, const ulong target)
+{
+  __local ulong xchg_all[WORKSIZE * 4];
+  __local uint *xchg = (__local uint *)(xchg_all + (get_local_id(0) >> 2) * 16);
+  uint lane = GROESTL_BS_LANE;
+  uint quad = get_global_id(0) - lane;
+  ulong m[16], hash[8];
+
+  for (uint n = 0; n < 4; n++) {
+    uint gid = quad + n;
+
+    for (int u = 0; u < 10; u++)
+      m[u] = ((const __global ulong *)block)[u];
+    m[9] &= 0x00000000FFFFFFFF;
+    m[9] |= ((ulong)gid << 32);
+    m[10] = 0x80;
+    m[11] = m[12] = m[13] = m[14] = 0;
+    m[15] = 0x100000000000000;
+    groestl512_bs(hash, m, xchg);
+
+    for (int u = 0; u < 8; u++)
+      m[u] = hash[u];
+    m[8] = 0x80;
+    m[9] = m[10] = m[11] = m[12] = m[13] = m[14] = 0;
+    m[15] = 0x100000000000000;
+    groestl512_bs(hash, m, xchg);
+
+    if (lane == n && hash[3] <= target)
+      { uint slot = atomic_inc(output + FOUND_IDX); if (slot < FOUND_IDX) output[slot] = SWAP4(gid); }
+  }
+}
+
+#endif // GROESTLCOIN_BITSLICE_CL
@@ -1440,6 +1440,10 @@ __constant static const ulong T7_G[] = {
 	} while (0)
 
 
+#ifndef FOUND_IDX
+  #define FOUND_IDX (0xFF)
+#endif
+
 __attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
 __kernel void search(__global unsigned char* block, volatile __global uint* output, const ulong target) {
   __local ulong T2[256], T3[256], T4[256], T5[256], T6[256], T7[256];
@@ -1847,7 +1851,7 @@ round:
   goto perm;
 
 end:
-  if ((g[3 + 8] ^ m[3]) <= target) output[output[0xFF]++] = as_uint(as_uchar4(gid).wzyx);
+  if ((g[3 + 8] ^ m[3]) <= target) { uint slot = atomic_inc(output + FOUND_IDX); if (slot < FOUND_IDX) output[slot] = as_uint(as_uchar4(gid).wzyx); }
 }
 
 #endif
@@ -87,6 +87,10 @@ typedef long sph_s64;
                     q[i+12] + SPH_ROTL64(q[i+13], 53) + (SHR(q[i+14],1) ^ q[i+14]) + (SHR(q[i+15],2) ^ q[i+15])
 
 // __attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
+#ifndef FOUND_IDX
+  #define FOUND_IDX (0xFF)
+#endif
+
 __kernel void search(__global unsigned char* block, volatile __global uint* output, const ulong target)
 {
   uint gid = get_global_id(0);
@@ -96,17 +100,7 @@ __kernel void search(__global unsigned char* block, volatile __global uint* outp
     ulong h8[8];
   } hash;
 
-  __local sph_u32 AES0[256], AES1[256], AES2[256], AES3[256];
-  int init = get_local_id(0);
-  int step = get_local_size(0);
-  for (int i = init; i < 256; i += step)
-  {
-    AES0[i] = AES0_C[i];
-    AES1[i] = AES1_C[i];
-    AES2[i] = AES2_C[i];
-    AES3[i] = AES3_C[i];
-  }
-  barrier(CLK_LOCAL_MEM_FENCE);
+  AES_TABLES_LOAD();
 
   // shavite
   {
@@ -230,7 +224,7 @@ __kernel void search(__global unsigned char* block, volatile __global uint* outp
 
   bool result = (hash.h8[3] <= target);
   if (result)
-    output[output[0xFF]++] = SWAP4(gid);
+    { uint slot = atomic_inc(output + FOUND_IDX); if (slot < FOUND_IDX) output[slot] = SWAP4(gid); }
 }
 
 #endif // INKCOIN_CL
\ No newline at end of file
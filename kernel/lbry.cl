@@ -6,6 +6,10 @@
 #define SWAP64(x)    as_ulong(as_uchar8(x).s76543210)
 
 
+#ifndef FOUND_IDX
+  #define FOUND_IDX (0xFF)
+#endif
+
 __attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
 __kernel void search(__global const uint *input, __global uint8 *ctx)
 {
@@ -175,5 +179,5 @@ __kernel void search2(__global uint8 *ctx, __global uint *output, ulong target)
   outbuf.s7 = SWAP32(outbuf.s7);
 
   if(as_ulong(outbuf.s67) <= target)
-    output[atomic_inc(output+0xFF)] = SWAP32(gid);
+    { uint slot = atomic_inc(output + FOUND_IDX); if (slot < FOUND_IDX) output[slot] = SWAP32(gid); }
 }
@@ -144,6 +144,10 @@ typedef union {
   ulong h8[8];
 } hash_t;
 
+#ifndef FOUND_IDX
+  #define FOUND_IDX (0xFF)
+#endif
+
 __attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
 __kernel void search(
 	 __global hash_t* hashes,
@@ -463,7 +467,7 @@ barrier(CLK_LOCAL_MEM_FENCE);
 
 	bool result = ( state[7] <= target);
 	if (result) {
-		output[atomic_inc(output + 0xFF)] = SWAP4(gid);
+		{ uint slot = atomic_inc(output + FOUND_IDX); if (slot < FOUND_IDX) output[slot] = SWAP4(gid); }
 	}
 }
 
@@ -0,0 +1,8 @@
+/*
+ * Lyra2REv2 kernel with the Lyra2 stage shared by four work items per
+ * hash.  Select it with kernelfile "lyra2rev2-coop"; the worksize must be
+ * a multiple of 4.
+ */
+
+#define LYRA2_COOPERATIVE
+#include "lyra2rev2.cl"
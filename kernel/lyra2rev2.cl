@@ -91,6 +91,9 @@ static inline sph_u64 ror64(sph_u64 vw, unsigned a) {
 #define memshift 3
 #include "blake256.cl"
 #include "lyra2v2.cl"
+#ifdef LYRA2_COOPERATIVE
+#include "lyra2v2-coop.cl"
+#endif
 #include "keccak1600.cl"
 #include "skein256.cl"
 #include "cubehash.cl"
@@ -117,6 +120,10 @@ typedef union {
   ulong h8[4];
 } hash_t;
 
+#ifndef FOUND_IDX
+  #define FOUND_IDX (0xFF)
+#endif
+
 __attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
 __kernel void search(
 	 __global uchar* hashes,
@@ -279,6 +286,79 @@ __kernel void search2(__global uchar* hashes)
 /// lyra2 algo 
 
 
+#ifdef LYRA2_COOPERATIVE
+
+// Each quad of work items hashes the four nonces of its members one after
+// the other, so the launch geometry is the same as for the plain kernel.
+__constant ulong lyra_init_c[4] = { 0x6a09e667f3bcc908UL, 0xbb67ae8584caa73bUL, 0x3c6ef372fe94f82bUL, 0xa54ff53a5f1d36f1UL };
+__constant ulong lyra_init_d[4] = { 0x510e527fade682d1UL, 0x9b05688c2b3e6c1fUL, 0x1f83d9abfb41bd6bUL, 0x5be0cd19137e2179UL };
+__constant ulong lyra_pad_a[4] = { 0x20, 0x20, 0x20, 0x01 };
+__constant ulong lyra_pad_b[4] = { 0x04, 0x04, 0x80, 0x0100000000000000 };
+
+__attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
+__kernel void search3(__global uchar* hashes,__global uchar* matrix )
+{
+  __local ulong xchg_all[WORKSIZE * 3];
+  __local ulong *xchg = xchg_all + (get_local_id(0) & ~3U) * 3;
+  uint lane = LYRA_LANE;
+  uint quad = get_global_id(0) - lane;
+
+  for (uint h = 0; h < 4; h++)
+  {
+    uint item = (quad + h) % MAX_GLOBAL_THREADS;
+    __global hash_t *hash = (__global hash_t *)(hashes + (4 * sizeof(ulong) * item));
+    __global ulong *DMatrix = (__global ulong *)(matrix + (4 * memshift * 4 * 4 * 8 * item));
+    ulong a, b, c, d;
+
+    a = b = hash->h8[lane]; //password
+    c = lyra_init_c[lane];
+    d = lyra_init_d[lane];
+    for (int i = 0; i < 12; i++) { round_lyra_lane(a, b, c, d); }
+
+    a ^= lyra_pad_a[lane];
+    b ^= lyra_pad_b[lane];
+
+    for (int i = 0; i < 12; i++) { round_lyra_lane(a, b, c, d); }
+
+    uint ps1 = (memshift * 3);
+    for (int i = 0; i < 4; i++)
+    {
+      uint s1 = ps1 - memshift * i;
+      DM(s1) = a;
+      DM(s1 + 1) = b;
+      DM(s1 + 2) = c;
+
+      round_lyra_lane(a, b, c, d);
+    }
+
+    reduceDuplexf_lane(&a, &b, &c, &d, DMatrix, xchg);
+
+    reduceDuplexRowSetupf_lane(1, 0, 2, &a, &b, &c, &d, DMatrix, xchg);
+    reduceDuplexRowSetupf_lane(2, 1, 3, &a, &b, &c, &d, DMatrix, xchg);
+
+    uint rowa;
+    uint prev = 3;
+    for (uint i = 0; i < 4; i++) {
+      rowa = lyra_row_lane(xchg, a);
+      reduceDuplexRowf_lane(prev, rowa, i, &a, &b, &c, &d, DMatrix, xchg);
+      prev = i;
+    }
+
+    uint shift = (memshift * 4 * rowa);
+
+    a ^= DM(shift);
+    b ^= DM(shift + 1);
+    c ^= DM(shift + 2);
+
+    for (int i = 0; i < 12; i++)
+      round_lyra_lane(a, b, c, d);
+
+    hash->h8[lane] = a;
+  }
+}
+
+#else
+
 __attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
 __kernel void search3(__global uchar* hashes,__global uchar* matrix )
 {
@@ -349,6 +429,8 @@ barrier(CLK_LOCAL_MEM_FENCE);
 
 }
 
+#endif // LYRA2_COOPERATIVE
+
 //skein256
 
 __attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
@@ -516,7 +598,7 @@ __kernel void search6(__global uchar* hashes, __global uint* output, const ulong
 
 	bool result = ( ((ulong*)final_s)[7] <= target);
 	if (result) {
-		output[atomic_inc(output + 0xFF)] = SWAP4(gid);
+		{ uint slot = atomic_inc(output + FOUND_IDX); if (slot < FOUND_IDX) output[slot] = SWAP4(gid); }
 	}
 
 }
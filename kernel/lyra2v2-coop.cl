@@ -0,0 +1,178 @@
+/*
+* Lyra2 kernel implementation, four work items per hash.
+*
+* ==========================(LICENSE BEGIN)============================
+* Copyright (c) 2014 djm34
+*
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+* ===========================(LICENSE END)=============================
+*
+* @author   djm34
+*/
+
+// The sponge state of lyra2v2.cl is four ulong4 rows s[0..3].  Here lane
+// l (local id & 3) of a quad holds column l of it, s[0..3].l, in a, b, c
+// and d.  Matrix blocks are three rows, so a lane owns the same column of
+// every block and the quad reads and writes 32 contiguous bytes at a time.
+// Lanes swap values through 12 ulongs of local memory per quad.
+
+#if (WORKSIZE % 4) != 0
+  #error "lyra2v2-coop.cl needs a worksize divisible by 4"
+#endif
+
+#define LYRA_LANE (get_local_id(0) & 3)
+#define DM(i) DMatrix[(i) * 4 + lane]
+
+// Diagonal step: lane l works on s[0].l, s[1].l+1, s[2].l+2, s[3].l+3.
+#define round_lyra_lane(a, b, c, d) \
+  do { \
+    G(a, b, c, d); \
+    lyra_shuffle(xchg, &b, &c, &d, 1, 2, 3); \
+    G(a, b, c, d); \
+    lyra_shuffle(xchg, &b, &c, &d, 3, 2, 1); \
+  } while (0)
+
+void lyra_shuffle(__local ulong *xchg, ulong *b, ulong *c, ulong *d, uint nb, uint nc, uint nd)
+{
+  uint lane = LYRA_LANE;
+
+  xchg[lane] = *b;
+  xchg[4 + lane] = *c;
+  xchg[8 + lane] = *d;
+  barrier(CLK_LOCAL_MEM_FENCE);
+  *b = xchg[(lane + nb) & 3];
+  *c = xchg[4 + ((lane + nc) & 3)];
+  *d = xchg[8 + ((lane + nd) & 3)];
+  barrier(CLK_LOCAL_MEM_FENCE);
+}
+
+// Value of a held by lane 0, i.e. s[0].x.
+uint lyra_row_lane(__local ulong *xchg, ulong a)
+{
+  uint row;
+
+  xchg[LYRA_LANE] = a;
+  barrier(CLK_LOCAL_MEM_FENCE);
+  row = (uint)xchg[0] & 3;
+  barrier(CLK_LOCAL_MEM_FENCE);
+  return row;
+}
+
+// t[k] ^= s[k - 1] over the 12 ulongs of a block, with s[-1] = s[11].  For
+// lane l the previous ulong sits in lane l - 1; lane 0 takes it from lane
+// 3, one block row up.
+void lyra_rotate_xor(__local ulong *xchg, ulong *t0, ulong *t1, ulong *t2, ulong a, ulong b, ulong c)
+{
+  uint lane = LYRA_LANE;
+  uint src = (lane + 3) & 3;
+
+  xchg[lane] = a;
+  xchg[4 + lane] = b;
+  xchg[8 + lane] = c;
+  barrier(CLK_LOCAL_MEM_FENCE);
+  *t0 ^= xchg[(lane ? 0 : 8) + src];
+  *t1 ^= xchg[(lane ? 4 : 0) + src];
+  *t2 ^= xchg[(lane ? 8 : 4) + src];
+  barrier(CLK_LOCAL_MEM_FENCE);
+}
+
+void reduceDuplexf_lane(ulong *a, ulong *b, ulong *c, ulong *d, __global ulong *DMatrix, __local ulong *xchg)
+{
+  uint lane = LYRA_LANE;
+  uint ps2 = (memshift * 3 + memshift * 4);
+
+  for (int i = 0; i < 4; i++)
+  {
+    uint s1 = i * memshift;
+    uint s2 = ps2 - i * memshift;
+    ulong t0 = DM(s1), t1 = DM(s1 + 1), t2 = DM(s1 + 2);
+
+    *a ^= t0; *b ^= t1; *c ^= t2;
+    round_lyra_lane(*a, *b, *c, *d);
+    DM(s2) = t0 ^ *a;
+    DM(s2 + 1) = t1 ^ *b;
+    DM(s2 + 2) = t2 ^ *c;
+  }
+}
+
+void reduceDuplexRowSetupf_lane(uint rowIn, uint rowInOut, uint rowOut, ulong *a, ulong *b, ulong *c, ulong *d, __global ulong *DMatrix, __local ulong *xchg)
+{
+  uint lane = LYRA_LANE;
+  uint ps1 = (memshift * 4 * rowIn);
+  uint ps2 = (memshift * 4 * rowInOut);
+  uint ps3 = (memshift * 3 + memshift * 4 * rowOut);
+
+  for (int i = 0; i < 4; i++)
+  {
+    uint s1 = ps1 + i * memshift;
+    uint s2 = ps2 + i * memshift;
+    uint s3 = ps3 - i * memshift;
+    ulong t0 = DM(s1), t1 = DM(s1 + 1), t2 = DM(s1 + 2);
+    ulong u0 = DM(s2), u1 = DM(s2 + 1), u2 = DM(s2 + 2);
+
+    *a ^= t0 + u0; *b ^= t1 + u1; *c ^= t2 + u2;
+    round_lyra_lane(*a, *b, *c, *d);
+    DM(s3) = t0 ^ *a;
+    DM(s3 + 1) = t1 ^ *b;
+    DM(s3 + 2) = t2 ^ *c;
+
+    lyra_rotate_xor(xchg, &u0, &u1, &u2, *a, *b, *c);
+    DM(s2) = u0;
+    DM(s2 + 1) = u1;
+    DM(s2 + 2) = u2;
+  }
+}
+
+void reduceDuplexRowf_lane(uint rowIn, uint rowInOut, uint rowOut, ulong *a, ulong *b, ulong *c, ulong *d, __global ulong *DMatrix, __local ulong *xchg)
+{
+  uint lane = LYRA_LANE;
+  uint ps1 = (memshift * 4 * rowIn);
+  uint ps2 = (memshift * 4 * rowInOut);
+  uint ps3 = (memshift * 4 * rowOut);
+
+  for (int i = 0; i < 4; i++)
+  {
+    uint s1 = ps1 + i * memshift;
+    uint s2 = ps2 + i * memshift;
+    uint s3 = ps3 + i * memshift;
+    ulong u0 = DM(s2), u1 = DM(s2 + 1), u2 = DM(s2 + 2);
+
+    *a ^= DM(s1) + u0; *b ^= DM(s1 + 1) + u1; *c ^= DM(s1 + 2) + u2;
+    round_lyra_lane(*a, *b, *c, *d);
+
+    lyra_rotate_xor(xchg, &u0, &u1, &u2, *a, *b, *c);
+
+    if (rowInOut != rowOut) {
+      DM(s2) = u0;
+      DM(s2 + 1) = u1;
+      DM(s2 + 2) = u2;
+      DM(s3) ^= *a;
+      DM(s3 + 1) ^= *b;
+      DM(s3 + 2) ^= *c;
+    }
+    else {
+      DM(s2) = u0 ^ *a;
+      DM(s2 + 1) = u1 ^ *b;
+      DM(s2 + 2) = u2 ^ *c;
+    }
+  }
+}
@@ -117,8 +117,11 @@ __kernel void search(__global const uint2*restrict in, __global uint*restrict ou
 
   keccak_block_noabsorb(ARGS_25(&state));
 
-#define FOUND (0x0F)
-#define SETFOUND(Xnonce) output[output[FOUND]++] = Xnonce
+#ifndef FOUND_IDX
+  #define FOUND_IDX (0x0F)
+#endif
+#define FOUND FOUND_IDX
+#define SETFOUND(Xnonce) { uint slot = atomic_inc(output + FOUND); if (slot < FOUND) output[slot] = Xnonce; }
 
   if ((state3.y & 0xFFFFFFF0U) == 0)
   {
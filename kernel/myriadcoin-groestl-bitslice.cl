@@ -0,0 +1,8 @@
+/*
+ * Myriadcoin-groestl kernel with the bitsliced Groestl-512 from
+ * groestl-bitslice.cl.  Select it with kernelfile
+ * "myriadcoin-groestl-bitslice"; the worksize must be a multiple of 4.
+ */
+
+#define GROESTL_BITSLICE
+#include "myriadcoin-groestl.cl"
@@ -67,7 +67,11 @@ typedef long sph_s64;
 #define SPH_SIMD_NOCOPY 0
 #define SPH_CUBEHASH_UNROLL 0
 
+#ifdef GROESTL_BITSLICE
+#include "groestl-bitslice.cl"
+#else
 #include "groestl.cl"
+#endif
 
 #define SWAP4(x) as_uint(as_uchar4(x).wzyx)
 #define SWAP8(x) as_ulong(as_uchar8(x).s76543210)
@@ -132,6 +136,10 @@ typedef long sph_s64;
 #define RD14 (S1(W12) + W7 + S0(W15) + W14)
 #define RD15 (S1(W13) + W8 + S0(W0) + W15)
 
+#ifndef FOUND_IDX
+  #define FOUND_IDX (0xFF)
+#endif
+
 __attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
 __kernel void search(__global unsigned char* block, volatile __global uint* output, const ulong target)
 {
@@ -142,37 +150,31 @@ __kernel void search(__global unsigned char* block, volatile __global uint* outp
     ulong h8[8];
   } hash;
 
-#if !SPH_SMALL_FOOTPRINT_GROESTL
-  __local sph_u64 T0_C[256], T1_C[256], T2_C[256], T3_C[256];
-  __local sph_u64 T4_C[256], T5_C[256], T6_C[256], T7_C[256];
-#else
-  __local sph_u64 T0_C[256], T4_C[256];
-#endif
-  int init = get_local_id(0);
-  int step = get_local_size(0);
-
-  for (int i = init; i < 256; i += step)
-  {
-    T0_C[i] = T0[i];
-    T4_C[i] = T4[i];
-#if !SPH_SMALL_FOOTPRINT_GROESTL
-    T1_C[i] = T1[i];
-    T2_C[i] = T2[i];
-    T3_C[i] = T3[i];
-    T5_C[i] = T5[i];
-    T6_C[i] = T6[i];
-    T7_C[i] = T7[i];
-#endif
+#ifdef GROESTL_BITSLICE
+  // The quad hashes the nonces of its members in turn and every lane keeps
+  // its own for the sha256 below.
+  __local ulong xchg_all[WORKSIZE * 4];
+  __local uint *xchg = (__local uint *)(xchg_all + (get_local_id(0) >> 2) * 16);
+  uint lane = GROESTL_BS_LANE;
+  ulong m[16], h[8];
+
+  for (int u = 0; u < 10; u++)
+    m[u] = DEC64E(block + u * 8);
+  m[10] = 0x80;
+  m[11] = m[12] = m[13] = m[14] = 0;
+  m[15] = 0x100000000000000;
+
+  for (uint n = 0; n < 4; n++) {
+    m[9] &= 0x00000000FFFFFFFF;
+    m[9] |= ((ulong)(gid - lane + n) << 32);
+    groestl512_bs(h, m, xchg);
+    if (n == lane) {
+      for (int u = 0; u < 8; u++)
+        hash.h8[u] = ENC64E(h[u]);
+    }
   }
-  barrier(CLK_LOCAL_MEM_FENCE);    // groestl
-#define T0 T0_C
-#define T1 T1_C
-#define T2 T2_C
-#define T3 T3_C
-#define T4 T4_C
-#define T5 T5_C
-#define T6 T6_C
-#define T7 T7_C
+#else
+  GROESTL_TABLES_LOAD();
 
 
   sph_u64 H[16];
@@ -230,6 +232,7 @@ __kernel void search(__global unsigned char* block, volatile __global uint* outp
   for (unsigned int u = 0; u < 8; u ++)
     hash.h8[u] = ENC64E(H[u + 8]);
     barrier(CLK_GLOBAL_MEM_FENCE);
+#endif // GROESTL_BITSLICE
 
   uint temp1;
   uint W0 = SWAP32(hash.h4[0x0]);
@@ -417,7 +420,7 @@ __kernel void search(__global unsigned char* block, volatile __global uint* outp
 
   bool result = (hash.h8[3] <= target);
   if (result)
-    output[output[0xFF]++] = SWAP4(gid);
+    { uint slot = atomic_inc(output + FOUND_IDX); if (slot < FOUND_IDX) output[slot] = SWAP4(gid); }
 }
 
 #endif // MYRIADCOIN_GROESTL_CL
\ No newline at end of file
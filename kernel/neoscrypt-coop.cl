@@ -0,0 +1,8 @@
+/*
+ * NeoScrypt kernel with the SMix stage shared by four work items per
+ * hash.  Select it with kernelfile "neoscrypt-coop"; the worksize must be
+ * a multiple of 4.
+ */
+
+#define NEOSCRYPT_COOPERATIVE
+#include "neoscrypt.cl"
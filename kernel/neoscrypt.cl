@@ -804,7 +804,7 @@ void fastkdf2(const uchar password[80], const uchar salt[256],  __global uint* r
 		XORBytes(outbuf, B + bufidx, A, 32);
 	}*/
 	
-	if(((uint *)outbuf)[7] <= target) output[atomic_add(output + 0xFF, 1)] = get_global_id(0);
+	if(((uint *)outbuf)[7] <= target) { uint slot = atomic_inc(output + FOUND_IDX); if (slot < FOUND_IDX) output[slot] = get_global_id(0); }
 
 }
 
@@ -1327,6 +1327,40 @@ void SMix_Chacha(uint16 X[4], __global uint16 *V)
 #define SALSA_PERM		(uint16)(4, 9, 14, 3, 8, 13, 2, 7, 12, 1, 6, 11, 0, 5, 10, 15)
 #define SALSA_INV_PERM	(uint16)(12, 9, 6, 3, 0, 13, 10, 7, 4, 1, 14, 11, 8, 5, 2, 15)
 
+#ifndef FOUND_IDX
+  #define FOUND_IDX (0xFF)
+#endif
+
+#ifdef NEOSCRYPT_COOPERATIVE
+#include "neoscrypt_smix_coop.cl"
+
+// Each quad of work items runs the SMix of its four members one after the
+// other; the KDF stages stay per item.  Entry i block j of member h of
+// quad q is at 16 * (((i * 4 + j) * 4 + h) * (gs / 4) + q) uints, the same
+// 32KB per work item as the plain kernel.
+__attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
+__kernel void search(__global const uchar* restrict input, __global uint* restrict output, __global uchar *padcache, const uint target)
+{
+	__local uint neo_local[(WORKSIZE / 4) * NEO_QUAD_WORDS];
+	__local uint *quad = neo_local + (get_local_id(0) >> 2) * NEO_QUAD_WORDS;
+	const uint quads = get_global_size(0) >> 2;
+	const uint q = (get_global_id(0) >> 2) % quads;
+	uint16 X[4];
+	uchar data[PASSWORD_LEN];
+
+	((ulong8 *)data)[0] = ((__global const ulong8 *)input)[0];
+	((ulong *)data)[8] = ((__global const ulong *)input)[8];
+	((uint *)data)[18] = ((__global const uint *)input)[18];
+	((uint *)data)[19] = get_global_id(0);
+
+	fastkdf1(data, (uchar *)X);
+
+	for (uint h = 0; h < 4; h++)
+		neoscrypt_smix_coop((uint *)X, (__global uint *)padcache + (h * quads + q) * 16, quads * 64, quad, h);
+
+	fastkdf2(data, (uchar *)X, output, target);
+}
+#else
 __attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
 __kernel void search(__global const uchar* restrict input, __global uint* restrict output, __global uchar *padcache, const uint target)
 {
@@ -1392,6 +1426,7 @@ __kernel void search(__global const uchar* restrict input, __global uint* restri
 	fastkdf2(data, (uchar *)X, output, target);
 	#endif
 }
+#endif // NEOSCRYPT_COOPERATIVE
 
 
 /*
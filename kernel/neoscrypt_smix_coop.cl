@@ -0,0 +1,188 @@
+// NeoScrypt(128, 2, 1) SMix with four work items per hash.
+//
+// Lane l (local id & 3) of a quad holds four words of each of the four
+// 16-word blocks, the words of one quarter-round: for Salsa20 those of its
+// column quarter-round, words 5l, 5l+4, 5l+8 and 5l+12 (mod 16), and for
+// ChaCha20 words l, l+4, l+8 and l+12.  Between the column and the
+// row/diagonal half of a double round the lanes pass b, c and d along the
+// quad through local memory.  A lane keeps the same words of every
+// scratchpad entry, so the quad reads and writes 64 contiguous bytes at a
+// time.
+//
+// Per quad this needs NEO_QUAD_WORDS words of local memory: the 64-word
+// state being handed in and out, two 12-word exchange areas used in turn,
+// so one barrier per exchange is enough, and the scratchpad index.
+
+#if (WORKSIZE % 4) != 0
+  #error "neoscrypt-coop needs a worksize divisible by 4"
+#endif
+
+#define NEO_LANE (get_local_id(0) & 3)
+#define NEO_XCHG 64
+#define NEO_IDX (64 + 2 * 12)
+#define NEO_QUAD_WORDS (64 + 2 * 12 + 1)
+
+// Word k of lane l within a block
+#define NEO_SALSA_WORD(l, k) ((5 * (l) + 4 * (k)) & 15)
+#define NEO_CHACHA_WORD(l, k) ((l) + 4 * (k))
+
+#define NEO_SALSA_QR(a, b, c, d) do { \
+    b ^= rotate(a + d, 7U); \
+    c ^= rotate(b + a, 9U); \
+    d ^= rotate(c + b, 13U); \
+    a ^= rotate(d + c, 18U); \
+  } while (0)
+
+#define NEO_CHACHA_QR(a, b, c, d) do { \
+    a += b; d = rotate(d ^ a, 16U); \
+    c += d; b = rotate(b ^ c, 12U); \
+    a += b; d = rotate(d ^ a, 8U); \
+    c += d; b = rotate(b ^ c, 7U); \
+  } while (0)
+
+// Salsa20 words move the same way into and out of the row round: a lane
+// takes the d of the next lane as b, the c of the one after as c and the b
+// of the previous lane as d.
+void neo_salsa_shuffle(__local uint *xchg, uint *b, uint *c, uint *d)
+{
+  uint lane = NEO_LANE;
+
+  xchg[lane] = *b;
+  xchg[4 + lane] = *c;
+  xchg[8 + lane] = *d;
+  barrier(CLK_LOCAL_MEM_FENCE);
+  *b = xchg[8 + ((lane + 1) & 3)];
+  *c = xchg[4 + ((lane + 2) & 3)];
+  *d = xchg[(lane + 3) & 3];
+}
+
+// ChaCha20 rotates b, c and d by n, 2 and 4 - n lanes
+void neo_chacha_shuffle(__local uint *xchg, uint *b, uint *c, uint *d, uint n)
+{
+  uint lane = NEO_LANE;
+
+  xchg[lane] = *b;
+  xchg[4 + lane] = *c;
+  xchg[8 + lane] = *d;
+  barrier(CLK_LOCAL_MEM_FENCE);
+  *b = xchg[(lane + n) & 3];
+  *c = xchg[4 + ((lane + 2) & 3)];
+  *d = xchg[8 + ((lane + 4 - n) & 3)];
+}
+
+// Salsa20/20 or ChaCha20/20 of the block whose four lane words are in w
+void neo_mix_lane(uint *w, __local uint *quad, bool chacha)
+{
+  uint a = w[0], b = w[1], c = w[2], d = w[3];
+
+  for (int i = 0; i < 10; i++) {
+    if (chacha) {
+      NEO_CHACHA_QR(a, b, c, d);
+      neo_chacha_shuffle(quad + NEO_XCHG, &b, &c, &d, 1);
+      NEO_CHACHA_QR(a, b, c, d);
+      neo_chacha_shuffle(quad + NEO_XCHG + 12, &b, &c, &d, 3);
+    }
+    else {
+      NEO_SALSA_QR(a, b, c, d);
+      neo_salsa_shuffle(quad + NEO_XCHG, &b, &c, &d);
+      NEO_SALSA_QR(a, b, c, d);
+      neo_salsa_shuffle(quad + NEO_XCHG + 12, &b, &c, &d);
+    }
+  }
+
+  w[0] += a;
+  w[1] += b;
+  w[2] += c;
+  w[3] += d;
+}
+
+// neoscrypt_blkmix_salsa/chacha on the lane's words of the four blocks
+void neo_blkmix_lane(uint *x, __local uint *quad, bool chacha)
+{
+  uint k, t;
+
+  for (k = 0; k < 4; k++)
+    x[k] ^= x[12 + k];
+  neo_mix_lane(x, quad, chacha);
+  for (k = 0; k < 4; k++)
+    x[4 + k] ^= x[k];
+  neo_mix_lane(x + 4, quad, chacha);
+  for (k = 0; k < 4; k++)
+    x[8 + k] ^= x[4 + k];
+  neo_mix_lane(x + 8, quad, chacha);
+  for (k = 0; k < 4; k++)
+    x[12 + k] ^= x[8 + k];
+  neo_mix_lane(x + 12, quad, chacha);
+
+  for (k = 0; k < 4; k++) {
+    t = x[4 + k];
+    x[4 + k] = x[8 + k];
+    x[8 + k] = t;
+  }
+}
+
+// SMix over the lane's words.  Entry i block j of the hash lives at
+// V[(i * 4 + j) * stride], four words per lane.
+void neo_smix_lane(uint *x, __global uint *V, uint stride, __local uint *quad, bool chacha)
+{
+  uint lane = NEO_LANE;
+  uint i, j, k, idx;
+
+  for (i = 0; i < 128; i++) {
+    for (j = 0; j < 4; j++)
+      for (k = 0; k < 4; k++)
+        V[(i * 4 + j) * stride + lane * 4 + k] = x[j * 4 + k];
+    neo_blkmix_lane(x, quad, chacha);
+  }
+
+  for (i = 0; i < 128; i++) {
+    // word 0 of block 3, the a of lane 0 in both layouts
+    if (!lane)
+      quad[NEO_IDX] = x[12];
+    barrier(CLK_LOCAL_MEM_FENCE);
+    idx = quad[NEO_IDX] & 0x7F;
+    for (j = 0; j < 4; j++)
+      for (k = 0; k < 4; k++)
+        x[j * 4 + k] ^= V[(idx * 4 + j) * stride + lane * 4 + k];
+    neo_blkmix_lane(x, quad, chacha);
+  }
+}
+
+// Replaces the 64-word X of quad member h with SMix_Salsa(X) ^ SMix_Chacha(X),
+// the quad working on it together.  Every lane of the quad must call this
+// for the same h.
+void neoscrypt_smix_coop(uint *X, __global uint *V, uint stride, __local uint *quad, uint h)
+{
+  uint lane = NEO_LANE;
+  uint s[16], c[16];
+  uint j, k;
+
+  if (lane == h)
+    for (j = 0; j < 64; j++)
+      quad[j] = X[j];
+  barrier(CLK_LOCAL_MEM_FENCE);
+
+  for (j = 0; j < 4; j++)
+    for (k = 0; k < 4; k++) {
+      s[j * 4 + k] = quad[j * 16 + NEO_SALSA_WORD(lane, k)];
+      c[j * 4 + k] = quad[j * 16 + NEO_CHACHA_WORD(lane, k)];
+    }
+
+  neo_smix_lane(s, V, stride, quad, false);
+  neo_smix_lane(c, V, stride, quad, true);
+
+  // The state area was last read before the first exchange barrier
+  for (j = 0; j < 4; j++)
+    for (k = 0; k < 4; k++)
+      quad[j * 16 + NEO_SALSA_WORD(lane, k)] = s[j * 4 + k];
+  barrier(CLK_LOCAL_MEM_FENCE);
+  for (j = 0; j < 4; j++)
+    for (k = 0; k < 4; k++)
+      quad[j * 16 + NEO_CHACHA_WORD(lane, k)] ^= c[j * 4 + k];
+  barrier(CLK_LOCAL_MEM_FENCE);
+
+  if (lane == h)
+    for (j = 0; j < 64; j++)
+      X[j] = quad[j];
+  barrier(CLK_LOCAL_MEM_FENCE);
+}
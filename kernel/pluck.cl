@@ -370,8 +370,18 @@ in[15] = 0x200;
 }
 
 
+#ifndef FOUND_IDX
+  #define FOUND_IDX (0xFF)
+#endif
+
+/* MAX_GLOBAL_THREADS is baked in when defined at build time, otherwise it
+ * comes from the max_global_threads argument */
+#ifndef MAX_GLOBAL_THREADS
+#define MAX_GLOBAL_THREADS max_global_threads
+#endif
+
 __attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
-__kernel void search(__global const uchar* restrict input, __global uint* restrict output, __global uchar *padcache, const uint target)
+__kernel void search(__global const uchar* restrict input, __global uint* restrict output, __global uchar *padcache, const uint target, const uint max_global_threads)
 {
 
 	__global uchar *hashbuffer = (__global uchar *)(padcache + (1024*128 * (get_global_id(0) % MAX_GLOBAL_THREADS)));
@@ -452,7 +462,7 @@ __kernel void search(__global const uchar* restrict input, __global uint* restri
 	} // main loop
 
 	
-	if( ((__global uint *)hashbuffer)[7] <= (target)) {output[atomic_inc(output + 0xFF)] = SWAP32(get_global_id(0));
+	if( ((__global uint *)hashbuffer)[7] <= (target)) {{ uint slot = atomic_inc(output + FOUND_IDX); if (slot < FOUND_IDX) output[slot] = SWAP32(get_global_id(0)); }
 //printf("gpu hashbuffer %08x nonce %08x\n",((__global uint *)hashbuffer)[7] ,SWAP32(get_global_id(0)));
 }
 
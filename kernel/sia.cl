@@ -56,6 +56,10 @@ __constant static const uchar blake2b_sigma[12][16] = {
 	{ 0,  1,  2,  3,  4,  5,  6,  7,  8,  9,  10, 11, 12, 13, 14, 15 } ,
 	{ 14, 10, 4,  8,  9,  15, 13, 6,  1,  12, 0,  2,  11, 7,  5,  3  } };
 
+#ifndef FOUND_IDX
+  #define FOUND_IDX (0xFF)
+#endif
+
 __kernel void search(__global unsigned char* block, volatile __global uint* output, const ulong target) {
 	sph_u32 gid = get_global_id(0);
 
@@ -116,5 +120,5 @@ __kernel void search(__global unsigned char* block, volatile __global uint* outp
 
 	bool result = (SWAP8(0x6a09e667f2bdc928 ^ v[0] ^ v[8]) <= target);
 	if (result)
-		output[output[0xFF]++] = SWAP4(gid);
+		{ uint slot = atomic_inc(output + FOUND_IDX); if (slot < FOUND_IDX) output[slot] = SWAP4(gid); }
 }
@@ -125,6 +125,10 @@ typedef union {
   ulong h8[8];
 } hash_t;
 
+#ifndef FOUND_IDX
+  #define FOUND_IDX (0xFF)
+#endif
+
 __attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
 __kernel void search(__global unsigned char* block, __global hash_t* hashes)
 {
@@ -458,37 +462,7 @@ __kernel void search2(__global hash_t* hashes)
   uint gid = get_global_id(0);
   __global hash_t *hash = &(hashes[gid-get_global_offset(0)]);
 
-#if !SPH_SMALL_FOOTPRINT_GROESTL
-  __local sph_u64 T0_C[256], T1_C[256], T2_C[256], T3_C[256];
-  __local sph_u64 T4_C[256], T5_C[256], T6_C[256], T7_C[256];
-#else
-  __local sph_u64 T0_C[256], T4_C[256];
-#endif
-  int init = get_local_id(0);
-  int step = get_local_size(0);
-
-  _Pragma("unroll") for (int i = init; i < 256; i += step)
-  {
-    T0_C[i] = T0[i];
-    T4_C[i] = T4[i];
-#if !SPH_SMALL_FOOTPRINT_GROESTL
-    T1_C[i] = T1[i];
-    T2_C[i] = T2[i];
-    T3_C[i] = T3[i];
-    T5_C[i] = T5[i];
-    T6_C[i] = T6[i];
-    T7_C[i] = T7[i];
-#endif
-  }
-  barrier(CLK_LOCAL_MEM_FENCE);    // groestl
-#define T0 T0_C
-#define T1 T1_C
-#define T2 T2_C
-#define T3 T3_C
-#define T4 T4_C
-#define T5 T5_C
-#define T6 T6_C
-#define T7 T7_C
+  GROESTL_TABLES_LOAD();
 
 
   sph_u64 H[16];
@@ -877,20 +851,7 @@ __kernel void search9(__global hash_t* hashes)
   uint gid = get_global_id(0);
   __global hash_t *hash = &(hashes[gid-get_global_offset(0)]);
 
-  __local sph_u32 AES0[256], AES1[256], AES2[256], AES3[256];
-
-  int init = get_local_id(0);
-  int step = get_local_size(0);
-
-  _Pragma("unroll") for (int i = init; i < 256; i += step)
-  {
-  AES0[i] = AES0_C[i];
-  AES1[i] = AES1_C[i];
-  AES2[i] = AES2_C[i];
-  AES3[i] = AES3_C[i];
-  }
-
-  barrier(CLK_LOCAL_MEM_FENCE);
+  AES_TABLES_LOAD();
 
   // shavite
   // IV
@@ -1086,20 +1047,7 @@ __kernel void search11(__global hash_t* hashes, __global uint* output, const ulo
   uint gid = get_global_id(0);
   __global hash_t *hash = &(hashes[gid-get_global_offset(0)]);
 
-  __local sph_u32 AES0[256], AES1[256], AES2[256], AES3[256];
-
-  int init = get_local_id(0);
-  int step = get_local_size(0);
-
-  _Pragma("unroll") for (int i = init; i < 256; i += step)
-  {
-  AES0[i] = AES0_C[i];
-  AES1[i] = AES1_C[i];
-  AES2[i] = AES2_C[i];
-  AES3[i] = AES3_C[i];
-  }
-
-  barrier(CLK_LOCAL_MEM_FENCE);
+  AES_TABLES_LOAD();
 
   // copies hashes to "hash"
   // echo
@@ -1163,7 +1111,7 @@ __kernel void search11(__global hash_t* hashes, __global uint* output, const ulo
   bool result = (Vb11 <= target);
 
   if (result)
-  output[atomic_inc(output+0xFF)] = SWAP4(gid);
+  { uint slot = atomic_inc(output + FOUND_IDX); if (slot < FOUND_IDX) output[slot] = SWAP4(gid); }
 }
 
 #endif// SIBCOIN_MOD_CL
\ No newline at end of file
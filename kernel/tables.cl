@@ -0,0 +1,64 @@
+#ifndef TABLES_CL
+#define TABLES_CL
+
+/*
+ * Lookup table placement for the AES (echo, shavite), Groestl and
+ * Whirlpool kernels.
+ *
+ * TABLES_CONSTANT  read every table straight from __constant memory.
+ * TABLES_LOCAL     copy every table to __local memory once per work-group.
+ * TABLES_COMPACT   copy only the first table to __local memory and derive
+ *                  the others from it with rotates.
+ *
+ * TABLE_PLACEMENT (usually passed by the host with -D) selects the strategy
+ * for all three families.  AES_TABLES, GROESTL_TABLES and WHIRLPOOL_TABLES
+ * override it for one family.  If neither is set, a kernel that defines
+ * <family>_TABLES_DEFAULT before its first include gets that, everything
+ * else gets TABLES_LOCAL.
+ *
+ * Kernels call AES_TABLES_LOAD(), GROESTL_TABLES_LOAD() or
+ * WHIRLPOOL_TABLES_LOAD() at kernel scope before the first round; the
+ * macros expand to nothing for TABLES_CONSTANT.
+ */
+
+#define TABLES_CONSTANT 0
+#define TABLES_LOCAL    1
+#define TABLES_COMPACT  2
+
+#ifndef AES_TABLES
+  #if defined(TABLE_PLACEMENT)
+    #define AES_TABLES TABLE_PLACEMENT
+  #elif defined(AES_TABLES_DEFAULT)
+    #define AES_TABLES AES_TABLES_DEFAULT
+  #else
+    #define AES_TABLES TABLES_LOCAL
+  #endif
+#endif
+
+#ifndef GROESTL_TABLES
+  #if defined(TABLE_PLACEMENT)
+    #define GROESTL_TABLES TABLE_PLACEMENT
+  #elif defined(GROESTL_TABLES_DEFAULT)
+    #define GROESTL_TABLES GROESTL_TABLES_DEFAULT
+  #else
+    #define GROESTL_TABLES TABLES_LOCAL
+  #endif
+#endif
+
+#ifndef WHIRLPOOL_TABLES
+  #if defined(TABLE_PLACEMENT)
+    #define WHIRLPOOL_TABLES TABLE_PLACEMENT
+  #elif defined(WHIRLPOOL_TABLES_DEFAULT)
+    #define WHIRLPOOL_TABLES WHIRLPOOL_TABLES_DEFAULT
+  #else
+    #define WHIRLPOOL_TABLES TABLES_LOCAL
+  #endif
+#endif
+
+#if (AES_TABLES < TABLES_CONSTANT) || (AES_TABLES > TABLES_COMPACT) \
+  || (GROESTL_TABLES < TABLES_CONSTANT) || (GROESTL_TABLES > TABLES_COMPACT) \
+  || (WHIRLPOOL_TABLES < TABLES_CONSTANT) || (WHIRLPOOL_TABLES > TABLES_COMPACT)
+  #error "table placement must be 0 (constant), 1 (local) or 2 (compact)"
+#endif
+
+#endif // TABLES_CL
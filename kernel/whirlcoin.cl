@@ -1203,6 +1203,10 @@ void whirlpool_round(sph_u64* n, sph_u64* h){
     }
 }
 
+#ifndef FOUND_IDX
+  #define FOUND_IDX (0xFF)
+#endif
+
 __attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
 __kernel void search(__global unsigned char* block, __global hash_t* hashes)
 {
@@ -1214,27 +1218,16 @@ __kernel void search(__global unsigned char* block, __global hash_t* hashes)
     sph_u64 h[8];
     sph_u64 state[8];
 
-    h[0] = h[1] = h[2] = h[3] = h[4] = h[5] = h[6] = h[7] = 0;
-
-    n[0] =  h[0] ^ DEC64LE(block +    0);
-    n[1] =  h[1] ^ DEC64LE(block +    8);
-    n[2] =  h[2] ^ DEC64LE(block +   16);
-    n[3] =  h[3] ^ DEC64LE(block +   24);
-    n[4] =  h[4] ^ DEC64LE(block +   32);
-    n[5] =  h[5] ^ DEC64LE(block +   40);
-    n[6] =  h[6] ^ DEC64LE(block +   48);
-    n[7] =  h[7] ^ DEC64LE(block +   56);
-
-    whirlpool_round(n, h);
-
-    h[0] = state[0] = n[0] ^ DEC64LE(block +   0);
-    h[1] = state[1] = n[1] ^ DEC64LE(block +   8);
-    h[2] = state[2] = n[2] ^ DEC64LE(block +   16);
-    h[3] = state[3] = n[3] ^ DEC64LE(block +   24);
-    h[4] = state[4] = n[4] ^ DEC64LE(block +   32);
-    h[5] = state[5] = n[5] ^ DEC64LE(block +   40);
-    h[6] = state[6] = n[6] ^ DEC64LE(block +   48);
-    h[7] = state[7] = n[7] ^ DEC64LE(block +   56);
+    // the first 64 bytes of block hold the state after the first message
+    // block, precomputed on the host as it doesn't depend on the nonce
+    h[0] = state[0] = DEC64LE(block +   0);
+    h[1] = state[1] = DEC64LE(block +   8);
+    h[2] = state[2] = DEC64LE(block +   16);
+    h[3] = state[3] = DEC64LE(block +   24);
+    h[4] = state[4] = DEC64LE(block +   32);
+    h[5] = state[5] = DEC64LE(block +   40);
+    h[6] = state[6] = DEC64LE(block +   48);
+    h[7] = state[7] = DEC64LE(block +   56);
 
 
     n[0] = DEC64LE(block +  64);
@@ -1352,7 +1345,7 @@ __kernel void search3(__global hash_t* hashes, __global uint* output, const ulon
 
     bool result = (hash->h8[3] <= target);
     if (result)
-        output[atomic_inc(output+0xFF)] = SWAP4(gid);
+        { uint slot = atomic_inc(output + FOUND_IDX); if (slot < FOUND_IDX) output[slot] = SWAP4(gid); }
 }
 
 #endif // W_CL
\ No newline at end of file
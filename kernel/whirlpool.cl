@@ -46,8 +46,20 @@
  * @author   Thomas Pornin <thomas.pornin@cryptolog.com>
  */
 
+#include "tables.cl"
+
 #if SPH_64
 
+/*
+ * Table prefix for ROUND_KSCHED() and ROUND_WENC(): the __constant tables
+ * themselves, or the __local copies made by WHIRLPOOL_TABLES_LOAD().
+ */
+#if WHIRLPOOL_TABLES == TABLES_CONSTANT
+#define WHIRLPOOL_T  plain_T
+#else
+#define WHIRLPOOL_T  LT
+#endif
+
 /* ====================================================================== */
 /*
  * Constants for plain WHIRLPOOL (current version).
@@ -1125,6 +1137,20 @@ __constant static const sph_u64 plain_RC[10] = {
 
 #define BYTE(x, n)     ((unsigned)((x) >> (8 * (n))) & 0xFF)
 
+#if WHIRLPOOL_TABLES == TABLES_COMPACT
+
+#define ROUND_ELT(table, in, i0, i1, i2, i3, i4, i5, i6, i7) \
+	(table ## 0[BYTE(in ## i0, 0)] \
+	^ SPH_ROTL64(table ## 0[BYTE(in ## i1, 1)], 8) \
+	^ SPH_ROTL64(table ## 0[BYTE(in ## i2, 2)], 16) \
+	^ SPH_ROTL64(table ## 0[BYTE(in ## i3, 3)], 24) \
+	^ SPH_ROTL64(table ## 0[BYTE(in ## i4, 4)], 32) \
+	^ SPH_ROTL64(table ## 0[BYTE(in ## i5, 5)], 40) \
+	^ SPH_ROTL64(table ## 0[BYTE(in ## i6, 6)], 48) \
+	^ SPH_ROTL64(table ## 0[BYTE(in ## i7, 7)], 56))
+
+#else
+
 #define ROUND_ELT(table, in, i0, i1, i2, i3, i4, i5, i6, i7) \
 	(table ## 0[BYTE(in ## i0, 0)] \
 	^ table ## 1[BYTE(in ## i1, 1)] \
@@ -1135,6 +1161,8 @@ __constant static const sph_u64 plain_RC[10] = {
 	^ table ## 6[BYTE(in ## i6, 6)] \
 	^ table ## 7[BYTE(in ## i7, 7)])
 
+#endif
+
 #define ROUND(table, in, out, c0, c1, c2, c3, c4, c5, c6, c7)   do { \
 		out ## 0 = ROUND_ELT(table, in, 0, 7, 6, 5, 4, 3, 2, 1) ^ c0; \
 		out ## 1 = ROUND_ELT(table, in, 1, 0, 7, 6, 5, 4, 3, 2) ^ c1; \
@@ -1164,4 +1192,33 @@ __constant static const sph_u64 plain_RC[10] = {
 		dst ## 7 = src ## 7; \
 	} while (0)
 
+/*
+ * Copy the tables needed by the selected placement to local memory.  Must
+ * be invoked at kernel scope, by every work item of the work-group.
+ */
+#if WHIRLPOOL_TABLES == TABLES_CONSTANT
+#define WHIRLPOOL_TABLES_LOAD()
+#elif WHIRLPOOL_TABLES == TABLES_COMPACT
+#define WHIRLPOOL_TABLES_LOAD() \
+	__local sph_u64 LT0[256]; \
+	for (int i = get_local_id(0); i < 256; i += get_local_size(0)) \
+		LT0[i] = plain_T0[i]; \
+	barrier(CLK_LOCAL_MEM_FENCE)
+#else
+#define WHIRLPOOL_TABLES_LOAD() \
+	__local sph_u64 LT0[256], LT1[256], LT2[256], LT3[256]; \
+	__local sph_u64 LT4[256], LT5[256], LT6[256], LT7[256]; \
+	for (int i = get_local_id(0); i < 256; i += get_local_size(0)) { \
+		LT0[i] = plain_T0[i]; \
+		LT1[i] = plain_T1[i]; \
+		LT2[i] = plain_T2[i]; \
+		LT3[i] = plain_T3[i]; \
+		LT4[i] = plain_T4[i]; \
+		LT5[i] = plain_T5[i]; \
+		LT6[i] = plain_T6[i]; \
+		LT7[i] = plain_T7[i]; \
+	} \
+	barrier(CLK_LOCAL_MEM_FENCE)
+#endif
+
 #endif
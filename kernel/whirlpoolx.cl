@@ -150,6 +150,10 @@ __constant static const ulong ROUND_CONSTANTS[10] =
 	values of the block data, indexes 8 and 9, when indexed 64 bits at a time. Those are input0 and input1.
 */
 
+#ifndef FOUND_IDX
+  #define FOUND_IDX (0xFF)
+#endif
+
 __attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
 __kernel void search(const ulong8 midstate, const ulong input0, const ulong input1, __global uint *output, const ulong target)
 {
@@ -309,7 +313,7 @@ __kernel void search(const ulong8 midstate, const ulong input0, const ulong inpu
 		Therefore, explicit OpenCL cast to uchar4, reverse bytes, and explicit cast back to uint should be quicker, not that it matters much.
 	*/
 	
-	if((midstate.s3 ^ n.s3 ^ midstate.s5 ^ n.s5) <= target) output[atomic_inc(output+0xFF)] = as_uint(as_uchar4(gid).s3210);
+	if((midstate.s3 ^ n.s3 ^ midstate.s5 ^ n.s5) <= target) { uint slot = atomic_inc(output + FOUND_IDX); if (slot < FOUND_IDX) output[slot] = as_uint(as_uchar4(gid).s3210); }
 }
 
 #endif	// WHIRLPOOLX_CL
\ No newline at end of file
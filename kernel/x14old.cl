@@ -119,6 +119,10 @@ typedef union {
     ulong h8[8];
 } hash_t;
 
+#ifndef FOUND_IDX
+  #define FOUND_IDX (0xFF)
+#endif
+
 __attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
 __kernel void search(__global unsigned char* block, __global hash_t* hashes)
 {
@@ -241,32 +245,7 @@ __kernel void search2(__global hash_t* hashes)
     uint gid = get_global_id(0);
     __global hash_t *hash = &(hashes[gid-get_global_offset(0)]);
 
-    __local sph_u64 T0_L[256], T1_L[256], T2_L[256], T3_L[256], T4_L[256], T5_L[256], T6_L[256], T7_L[256];
-
-    int init = get_local_id(0);
-    int step = get_local_size(0);
-
-    for (int i = init; i < 256; i += step)
-    {
-        T0_L[i] = T0[i];
-        T1_L[i] = T1[i];
-        T2_L[i] = T2[i];
-        T3_L[i] = T3[i];
-        T4_L[i] = T4[i];
-        T5_L[i] = T5[i];
-        T6_L[i] = T6[i];
-        T7_L[i] = T7[i];
-    }
-    barrier(CLK_LOCAL_MEM_FENCE);
-
-#define T0 T0_L
-#define T1 T1_L
-#define T2 T2_L
-#define T3 T3_L
-#define T4 T4_L
-#define T5 T5_L
-#define T6 T6_L
-#define T7 T7_L
+    GROESTL_TABLES_LOAD();
 
     // groestl
 
@@ -588,20 +567,7 @@ __kernel void search8(__global hash_t* hashes)
 {
     uint gid = get_global_id(0);
     __global hash_t *hash = &(hashes[gid-get_global_offset(0)]);
-    __local sph_u32 AES0[256], AES1[256], AES2[256], AES3[256];
-
-    int init = get_local_id(0);
-    int step = get_local_size(0);
-
-    for (int i = init; i < 256; i += step)
-    {
-        AES0[i] = AES0_C[i];
-        AES1[i] = AES1_C[i];
-        AES2[i] = AES2_C[i];
-        AES3[i] = AES3_C[i];
-    }
-
-    barrier(CLK_LOCAL_MEM_FENCE);
+    AES_TABLES_LOAD();
 
     // shavite
     // IV
@@ -789,20 +755,10 @@ __kernel void search10(__global hash_t* hashes, __global uint* output, const ulo
     uint offset = get_global_offset(0);
     hash_t hash;
 
-    __local sph_u32 AES0[256], AES1[256], AES2[256], AES3[256];
-
     int init = get_local_id(0);
     int step = get_local_size(0);
 
-    for (int i = init; i < 256; i += step)
-    {
-        AES0[i] = AES0_C[i];
-        AES1[i] = AES1_C[i];
-        AES2[i] = AES2_C[i];
-        AES3[i] = AES3_C[i];
-    }
-
-    barrier(CLK_LOCAL_MEM_FENCE);
+    AES_TABLES_LOAD();
 
     #ifdef INPUT_BIG_LOCAL
       __local sph_u32 T512_L[1024];
@@ -1077,7 +1033,7 @@ __kernel void search10(__global hash_t* hashes, __global uint* output, const ulo
 
     bool result = (hash.h8[3] <= target);
     if (result)
-      output[atomic_inc(output+0xFF)] = SWAP4(gid);
+      { uint slot = atomic_inc(output + FOUND_IDX); if (slot < FOUND_IDX) output[slot] = SWAP4(gid); }
 
     barrier(CLK_GLOBAL_MEM_FENCE);
 }
@@ -0,0 +1,8 @@
+/*
+ * yescrypt kernel with the pwxform stage shared by four work items per
+ * hash.  Select it with kernelfile "yescrypt-coop"; the worksize must be
+ * a multiple of 4.
+ */
+
+#define YESCRYPT_COOPERATIVE
+#include "yescrypt.cl"
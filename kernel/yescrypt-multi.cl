@@ -34,6 +34,10 @@
 
 #include "yescrypt_essential.cl"
 
+#ifndef FOUND_IDX
+  #define FOUND_IDX (0xFF)
+#endif
+
 __attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
 __kernel void search(__global const uchar* restrict input, __global uint* restrict output, __global uchar *padcache, __global uchar* buff1, __global uchar* buff2, __global uchar* buff3, const uint target)
 {
@@ -309,6 +313,6 @@ __kernel void search4(__global const uchar* restrict input, __global uint* restr
 
 
 	if (SWAP32(res.s7) <= (target)) 
-		output[atomic_inc(output + 0xFF)] = (nonce);
+		{ uint slot = atomic_inc(output + FOUND_IDX); if (slot < FOUND_IDX) output[slot] = (nonce); }
 	
 }
@@ -33,12 +33,27 @@
 #endif
 
 #include "yescrypt_essential.cl"
+#ifdef YESCRYPT_COOPERATIVE
+#include "yescrypt_coop.cl"
+#endif
+
+
+#ifndef FOUND_IDX
+  #define FOUND_IDX (0xFF)
+#endif
 
+/* MAX_GLOBAL_THREADS is baked in when defined at build time, otherwise it
+ * comes from the max_global_threads argument */
+#ifndef MAX_GLOBAL_THREADS
+#define MAX_GLOBAL_THREADS max_global_threads
+#endif
 
 __attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
-__kernel void search(__global const uchar* restrict input, __global uint* restrict output, __global uchar *padcache, __global uchar* buff1, __global uchar* buff2, const uint target)
+__kernel void search(__global const uchar* restrict input, __global uint* restrict output, __global uchar *padcache, __global uchar* buff1, __global uchar* buff2, const uint target, const uint max_global_threads)
 {
-
+#ifdef YESCRYPT_COOPERATIVE
+	__local ulong yes_local[(WORKSIZE / 4) * YES_QUAD_WORDS];
+#endif
 	__global ulong16 *hashbuffer = (__global ulong16 *)(padcache + (2048 * 128 * sizeof(ulong)* (get_global_id(0) % MAX_GLOBAL_THREADS)));
 	__global ulong16 *prevstate = (__global ulong16 *)(buff1 + (64 * 128 * sizeof(ulong)*(get_global_id(0) % MAX_GLOBAL_THREADS)));
 	__global ulong16 *Bdev = (__global ulong16 *)(buff2 + (8 * 128 * sizeof(ulong)* (get_global_id(0) % MAX_GLOBAL_THREADS)));
@@ -139,6 +154,18 @@ __kernel void search(__global const uchar* restrict input, __global uint* restri
 	}
 
 
+#ifdef YESCRYPT_COOPERATIVE
+	// The quad runs the pwxform stage of its four members in turn
+	for (uint h = 0; h < 4; h++)
+	{
+		uint member = ((get_global_id(0) & ~3U) + h) % MAX_GLOBAL_THREADS;
+
+		yescrypt_pwxform_coop((__global ulong16 *)(padcache + (2048 * 128 * sizeof(ulong) * member)),
+			(__global ulong16 *)(buff1 + (64 * 128 * sizeof(ulong) * member)),
+			(__global ulong16 *)(buff2 + (8 * 128 * sizeof(ulong) * member)),
+			yes_local + (get_local_id(0) >> 2) * YES_QUAD_WORDS);
+	}
+#else
 	for (int i = 0; i<8; i++)
 		hashbuffer[i] = Bdev[i];
 
@@ -188,6 +215,7 @@ __kernel void search(__global const uchar* restrict input, __global uint* restri
 		blockmix_pwxform((__global ulong8*)Bdev, prevstate);
 		////
 	}
+#endif
 
 
 
@@ -247,7 +275,7 @@ __kernel void search(__global const uchar* restrict input, __global uint* restri
 
 
 	if (SWAP32(res.s7) <= (target))
-		output[atomic_inc(output + 0xFF)] = (nonce);
+		{ uint slot = atomic_inc(output + FOUND_IDX); if (slot < FOUND_IDX) output[slot] = (nonce); }
 
 }
 
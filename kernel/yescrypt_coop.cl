@@ -0,0 +1,121 @@
+// yescrypt pwxform stage with four work items per hash.
+//
+// pwxform works on 16-byte lanes that never mix inside a 64-byte block, and
+// the XOR chain of blockmix_pwxform only links a lane to the same lane of
+// the previous block.  Lane l (local id & 3) of a quad therefore keeps the
+// 16 bytes at offset 16 * l of all 16 blocks in registers and runs its
+// pwxform rounds alone.  Only the closing Salsa20/8 needs the whole last
+// block: the lanes put it in local memory and each computes it.  The quad
+// reads and writes 64 contiguous bytes of the scratchpad at a time.
+//
+// Per quad this needs YES_QUAD_WORDS ulongs of local memory, two 8-ulong
+// blocks used in turn, so one barrier per blockmix is enough.
+
+#if (WORKSIZE % 4) != 0
+  #error "yescrypt-coop needs a worksize divisible by 4"
+#endif
+
+#define YES_LANE (get_local_id(0) & 3)
+#define YES_QUAD_WORDS (2 * 8)
+
+// block_pwxform_long_old on one 16-byte lane
+ulong2 yes_pwxform_lane(ulong2 vec, __global ulong16 *prevstate)
+{
+	for (int i = 0; i < 6; i++)
+	{
+		ulong2 p0, p1;
+		uint2 x = as_uint2((vec.x >> 4) & 0x000000FF000000FF);
+		p0 = ((__global ulong2*)(prevstate))[x.x];
+		vec = madd4long3(as_uint4(vec), p0);
+		p1 = ((__global ulong2*)(prevstate + 32))[x.y];
+		vec ^= p1;
+	}
+	return vec;
+}
+
+// blockmix_pwxform on the lane's 16 bytes of each block; returns the first
+// word of the last block, which the callers index the scratchpad with
+uint yes_blockmix_lane(ulong2 *x, __global ulong16 *prevstate, __local ulong *quad, uint *flip)
+{
+	__local ulong *blk = quad + 8 * *flip;
+	uint lane = YES_LANE;
+	ulong8 b;
+
+	x[0] ^= x[15];
+	x[0] = yes_pwxform_lane(x[0], prevstate);
+	for (int i = 1; i < 16; i++)
+	{
+		x[i] ^= x[i - 1];
+		x[i] = yes_pwxform_lane(x[i], prevstate);
+	}
+
+	blk[2 * lane] = x[15].x;
+	blk[2 * lane + 1] = x[15].y;
+	barrier(CLK_LOCAL_MEM_FENCE);
+	b = (ulong8)(blk[0], blk[1], blk[2], blk[3], blk[4], blk[5], blk[6], blk[7]);
+	*flip ^= 1;
+
+	b = salsa20_8(as_uint16(b));
+	x[15] = (lane == 0) ? b.s01 : (lane == 1) ? b.s23 : (lane == 2) ? b.s45 : b.s67;
+	return as_uint2(b.s0).x;
+}
+
+// Runs the 2048-block fill and the 684 mixing passes of the search kernel
+// for quad member h, whose state, S-boxes and scratchpad are Bdev,
+// prevstate and hashbuffer.  Bdev is read and written back in place.
+// Every lane of the quad must call this for the same h.
+void yescrypt_pwxform_coop(__global ulong16 *hashbuffer, __global ulong16 *prevstate, __global ulong16 *Bdev, __local ulong *quad)
+{
+	__global ulong2 *hb = (__global ulong2 *)hashbuffer;
+	__global ulong2 *B = (__global ulong2 *)Bdev;
+	uint lane = YES_LANE;
+	uint flip = 0;
+	ulong2 x[16];
+	uint i, j, k, n, w;
+
+	// The member wrote Bdev and prevstate itself
+	barrier(CLK_GLOBAL_MEM_FENCE);
+
+	for (k = 0; k < 16; k++)
+		x[k] = B[k * 4 + lane];
+
+	for (k = 0; k < 16; k++)
+		hb[k * 4 + lane] = x[k];
+	yes_blockmix_lane(x, prevstate, quad, &flip);
+	for (k = 0; k < 16; k++)
+		hb[64 + k * 4 + lane] = x[k];
+	w = yes_blockmix_lane(x, prevstate, quad, &flip);
+
+	n = 1;
+	for (i = 2; i < 2048; i++)
+	{
+		for (k = 0; k < 16; k++)
+			hb[64 * i + k * 4 + lane] = x[k];
+
+		if ((i & (i - 1)) == 0) n = n << 1;
+
+		j = (w & (n - 1)) + i - n;
+		for (k = 0; k < 16; k++)
+			x[k] ^= hb[64 * j + k * 4 + lane];
+
+		w = yes_blockmix_lane(x, prevstate, quad, &flip);
+	}
+
+	for (uint z = 0; z < 684; z++)
+	{
+		j = w & 2047;
+
+		for (k = 0; k < 16; k++)
+			x[k] ^= hb[64 * j + k * 4 + lane];
+
+		if (z < 682)
+			for (k = 0; k < 16; k++)
+				hb[64 * j + k * 4 + lane] = x[k];
+
+		w = yes_blockmix_lane(x, prevstate, quad, &flip);
+	}
+
+	for (k = 0; k < 16; k++)
+		B[k * 4 + lane] = x[k];
+	barrier(CLK_GLOBAL_MEM_FENCE);
+}
@@ -53,9 +53,18 @@ __constant uint N[] = {
   0x00100000U
 };
 
-/* Backwards compatibility, if NFACTOR not defined, default to 10 for scrypt */
-#ifndef NFACTOR
-#define NFACTOR 10
+/* NFACTOR and CONCURRENT_THREADS are baked in when defined at build time,
+ * otherwise they come from the nfactor and concurrent_threads arguments so
+ * one binary serves every N-factor and thread concurrency */
+#ifdef NFACTOR
+#define SCRYPT_NF NFACTOR
+#else
+#define SCRYPT_NF nfactor
+#endif
+#ifdef CONCURRENT_THREADS
+#define SCRYPT_TC CONCURRENT_THREADS
+#else
+#define SCRYPT_TC concurrent_threads
 #endif
 
 __constant uint ES[2] = { 0x00FF00FF, 0xFF00FF00 };
@@ -785,15 +794,15 @@ void salsa(uint4 B[8])
 #define Coord(x,y,z) x+y*(x ## SIZE)+z*(y ## SIZE)*(x ## SIZE)
 #define CO Coord(z,x,y)
 
-void scrypt_core(uint4 X[8], __global uint4*restrict lookup)
+void scrypt_core(uint4 X[8], __global uint4*restrict lookup, const uint nfactor, const uint concurrent_threads)
 {
   shittify(X);
   const uint zSIZE = 8;
-  const uint ySIZE = (N[NFACTOR]/LOOKUP_GAP+(N[NFACTOR]%LOOKUP_GAP>0));
-  const uint xSIZE = CONCURRENT_THREADS;
+  const uint ySIZE = (N[SCRYPT_NF]/LOOKUP_GAP+(N[SCRYPT_NF]%LOOKUP_GAP>0));
+  const uint xSIZE = SCRYPT_TC;
   uint x = get_global_id(0)%xSIZE;
 
-  for(uint y=0; y<(N[NFACTOR]/LOOKUP_GAP); ++y)
+  for(uint y=0; y<(N[SCRYPT_NF]/LOOKUP_GAP); ++y)
   {
 
     for(uint z=0; z<zSIZE; ++z)
@@ -801,9 +810,9 @@ void scrypt_core(uint4 X[8], __global uint4*restrict lookup)
     for(uint i=0; i<LOOKUP_GAP; ++i)
       salsa(X);
   }
-  for (uint i=0; i<N[NFACTOR]; ++i)
+  for (uint i=0; i<N[SCRYPT_NF]; ++i)
   {
-    uint j = X[7].x & (N[NFACTOR]-1);
+    uint j = X[7].x & (N[SCRYPT_NF]-1);
     uint y = (j/LOOKUP_GAP);
 
     if (j&1)
@@ -826,13 +835,17 @@ void scrypt_core(uint4 X[8], __global uint4*restrict lookup)
   unshittify(X);
 }
 
-#define FOUND (0xFF)
-#define SETFOUND(Xnonce) output[output[FOUND]++] = Xnonce
+#ifndef FOUND_IDX
+  #define FOUND_IDX (0xFF)
+#endif
+#define FOUND FOUND_IDX
+#define SETFOUND(Xnonce) { uint slot = atomic_inc(output + FOUND); if (slot < FOUND) output[slot] = Xnonce; }
 
 __attribute__((reqd_work_group_size(WORKSIZE, 1, 1)))
 __kernel void search(__global const uint4 * restrict input,
 volatile __global uint*restrict output, __global uint4*restrict padcache,
-const uint4 midstate0, const uint4 midstate16, const uint target)
+const uint4 midstate0, const uint4 midstate16, const uint target,
+const uint nfactor, const uint concurrent_threads)
 {
   uint gid = get_global_id(0);
   uint4 X[8];
@@ -859,7 +872,7 @@ const uint4 midstate0, const uint4 midstate16, const uint target)
     SHA256(&pad0,&pad1, data, (uint4)(i+1,K[84],0,0), (uint4)(0,0,0,0), (uint4)(0,0,0, K[87]));
     SHA256(X+i*2,X+i*2+1, pad0, pad1, (uint4)(K[84], 0U, 0U, 0U), (uint4)(0U, 0U, 0U, K[88]));
   }
-  scrypt_core(X,padcache);
+  scrypt_core(X,padcache, nfactor, concurrent_threads);
   SHA256(&tmp0,&tmp1, X[0], X[1], X[2], X[3]);
   SHA256(&tmp0,&tmp1, X[4], X[5], X[6], X[7]);
   SHA256_fixed(&tmp0,&tmp1);
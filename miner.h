@@ -362,6 +362,15 @@ enum switcher_mode {
 
 extern int opt_switchmode;
 
+/* Lookup table placement for the AES, Groestl and Whirlpool kernels,
+ * passed to them as TABLE_PLACEMENT (see kernel/tables.cl) */
+enum table_placement {
+  TABLES_DEFAULT = -1,
+  TABLES_CONSTANT,
+  TABLES_LOCAL,
+  TABLES_COMPACT
+};
+
 enum switcher_options {
   SWITCHER_APPLY_NONE = 0x00,
   SWITCHER_APPLY_ALGO = 0x01,
@@ -442,6 +451,10 @@ struct device_drv {
   void (*hw_error)(struct thr_info *);
   void (*thread_shutdown)(struct thr_info *);
   void (*thread_enable)(struct thr_info *);
+  /* Move a thread to its device's new algorithm and settings without
+   * shutting it down. NULL if the driver needs a full shutdown and prepare
+   * instead. */
+  bool (*thread_switch)(struct thr_info *);
 
   /* What should be zeroed in this device when global zero stats is sent */
   void (*zero_stats)(struct cgpu_info *);
@@ -471,6 +484,7 @@ enum dev_reason {
   REASON_DEV_THERMAL_CUTOFF,
   REASON_DEV_COMMS_ERROR,
   REASON_DEV_THROTTLE,
+  REASON_DEV_SELFTEST,
 };
 
 #define REASON_NONE     "None"
@@ -484,6 +498,7 @@ enum dev_reason {
 #define REASON_DEV_THERMAL_CUTOFF_STR "Device reached thermal cutoff"
 #define REASON_DEV_COMMS_ERROR_STR  "Device comms error"
 #define REASON_DEV_THROTTLE_STR   "Device throttle"
+#define REASON_DEV_SELFTEST_STR   "Device failed self-test"
 #define REASON_UNKNOWN_STR    "Unknown reason - code bug"
 
 #define MIN_SEC_UNSET 99999999
@@ -540,6 +555,7 @@ struct cgpu_info {
   struct timeval last_message_tv;
 
   int threads;
+  int dual_threads;
   struct thr_info **thr;
 
   int64_t max_hashes;
@@ -558,8 +574,8 @@ struct cgpu_info {
   cl_ulong max_alloc;
   algorithm_t algorithm;
 
-  int opt_lg, lookup_gap;
-  size_t opt_tc, thread_concurrency;
+  int opt_lg;
+  size_t opt_tc;
   size_t shaders;
   struct timeval tv_gpustart;
   int intervals;
@@ -590,6 +606,14 @@ struct cgpu_info {
   double last_share_diff;
   time_t last_device_valid_work;
 
+  /* Seconds from a work restart to the first launch on the new work */
+  double new_work_time;
+  double new_work_time_max;
+  int new_work_restarts;
+
+  /* Nonces lost because a batch found more than the result buffer holds */
+  int result_overflows;
+
   time_t device_last_well;
   time_t device_last_not_well;
   enum dev_reason device_not_well_reason;
@@ -603,6 +627,7 @@ struct cgpu_info {
   int dev_thermal_cutoff_count;
   int dev_comms_error_count;
   int dev_throttle_count;
+  int dev_selftest_count;
 
   struct sgminer_stats sgminer_stats;
 
@@ -638,10 +663,13 @@ struct thr_info {
   bool  pause;
   bool  paused;
   bool  getwork;
+  bool  dual;
+  bool  dual_thread; /* set up to mine the dual pool */
   double  rolling;
 
   bool  work_restart;
   bool  work_update;
+  struct timeval tv_restart; /* under stats_lock */
 };
 
 struct string_elist {
@@ -1077,6 +1105,9 @@ extern bool opt_work_update;
 extern bool opt_protocol;
 extern bool have_longpoll;
 extern char *opt_kernel_path;
+extern char *opt_kernel_cache;
+extern int opt_kernel_cache_size;
+extern bool opt_kernel_link;
 extern char *opt_socks_proxy;
 
 #if defined(unix) || defined(__APPLE__)
@@ -1125,6 +1156,7 @@ extern bool opt_blake_compact;
 extern bool opt_luffa_parallel;
 extern int opt_hamsi_expand_big;
 extern bool opt_hamsi_short;
+extern int opt_table_placement;
 
 #if LOCK_TRACKING
 extern pthread_mutex_t lockstat_lock;
@@ -1188,6 +1220,9 @@ extern int set_memoryclock(int gpu, int iMemoryClock);
 extern void api(int thr_id);
 
 extern struct pool *current_pool(void);
+extern struct pool *dual_pool(void);
+extern void work_launched(struct thr_info *thr, struct work *work);
+extern int opt_dual_pool;
 extern int enabled_pools;
 extern void get_intrange(char *arg, int *val1, int *val2);
 extern char *set_devices(char *arg);
@@ -1392,7 +1427,6 @@ struct pool {
   struct thread_q *getwork_q;
 
   pthread_t longpoll_thread;
-  pthread_t test_thread;
   bool testing;
 
   int curls;
@@ -1473,6 +1507,8 @@ struct pool {
 struct work {
   unsigned char data[256];
   unsigned char midstate[32];
+  /* nonce-independent state for kernels that need more than a midstate */
+  unsigned char precalc[128];
   unsigned char target[32];
   unsigned char hash[32];
 
@@ -1549,6 +1585,7 @@ extern void inc_hw_errors(struct thr_info *thr);
 extern bool test_nonce(struct work *work, uint32_t nonce);
 extern bool submit_tested_work(struct thr_info *thr, struct work *work);
 extern bool submit_nonce(struct thr_info *thr, struct work *work, uint32_t nonce);
+extern unsigned int submit_nonces(struct thr_info *thr, struct work *work, const uint32_t *nonces, unsigned int count);
 extern struct work *get_work(struct thr_info *thr, const int thr_id);
 extern void _wlog(const char *str);
 extern void _wlogprint(const char *str);
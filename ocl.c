@@ -46,6 +46,10 @@
 #include "miner.h"
 
 int opt_platform_id = -1;
+bool opt_all_platforms = false;
+cl_device_type opt_opencl_types = CL_DEVICE_TYPE_GPU;
+bool opt_svm = false;
+int opt_build_threads = 0;
 
 bool get_opencl_platform(int preferred_platform_id, cl_platform_id *platform) {
   cl_int status;
@@ -92,21 +96,54 @@ out:
 }
 
 
-int clDevicesNum(void) {
-  cl_int status;
-  char pbuff[256];
-  cl_uint numDevices;
-  cl_platform_id platform = NULL;
-  int ret = -1;
+/* AMD's PCIe topology query from cl_ext.h, which not every SDK ships */
+#ifndef CL_DEVICE_TOPOLOGY_AMD
+#define CL_DEVICE_TOPOLOGY_AMD 0x4037
+#define CL_DEVICE_TOPOLOGY_TYPE_PCIE_AMD 1
+typedef union {
+  struct { cl_uint type; cl_uint data[5]; } raw;
+  struct { cl_uint type; cl_char unused[17]; cl_char bus; cl_char device; cl_char function; } pcie;
+} cl_device_topology_amd;
+#endif
 
-  if (!get_opencl_platform(opt_platform_id, &platform)) {
-    goto out;
-  }
+#define PCI_VENDOR_AMD 0x1002
+
+/* OpenCL devices usable for mining, across all selected platforms. The
+ * index into this table is the device number used everywhere else. What
+ * initCl needs to know about a device is queried once while enumerating;
+ * caps_ok is false if any of it couldn't be read. */
+typedef struct _opencl_device {
+  cl_platform_id platform;
+  cl_device_id device;
+  cl_device_type type;
+  cl_uint vendor_id;
+  /* PCI bus of AMD GPUs that report it, -1 otherwise */
+  int pci_bus;
+
+  bool caps_ok;
+  char name[256];
+  char device_id[1024];
+  float opencl_version;
+  cl_uint preferred_vwidth;
+  size_t max_work_size;
+  cl_uint compute_units;
+  size_t compute_shaders;
+  cl_ulong max_alloc;
+  cl_ulong global_mem;
+} opencl_device;
+
+static opencl_device *opencl_devices;
+static int opencl_devices_num = -1;
+
+static void log_opencl_platform(cl_platform_id platform)
+{
+  char pbuff[256];
+  cl_int status;
 
   status = clGetPlatformInfo(platform, CL_PLATFORM_VENDOR, sizeof(pbuff), pbuff, NULL);
   if (status != CL_SUCCESS) {
     applog(LOG_ERR, "Error %d: Getting Platform Info. (clGetPlatformInfo)", status);
-    goto out;
+    return;
   }
 
   applog(LOG_INFO, "CL Platform vendor: %s", pbuff);
@@ -116,614 +153,960 @@ int clDevicesNum(void) {
   status = clGetPlatformInfo(platform, CL_PLATFORM_VERSION, sizeof(pbuff), pbuff, NULL);
   if (status == CL_SUCCESS)
     applog(LOG_INFO, "CL Platform version: %s", pbuff);
-  status = clGetDeviceIDs(platform, CL_DEVICE_TYPE_GPU, 0, NULL, &numDevices);
-  if (status != CL_SUCCESS) {
-    applog(LOG_INFO, "Error %d: Getting Device IDs (num)", status);
-    goto out;
-  }
-  applog(LOG_INFO, "Platform devices: %d", numDevices);
-  if (numDevices) {
-    unsigned int j;
-    cl_device_id *devices = (cl_device_id *)malloc(numDevices*sizeof(cl_device_id));
-
-    clGetDeviceIDs(platform, CL_DEVICE_TYPE_GPU, numDevices, devices, NULL);
-    for (j = 0; j < numDevices; j++) {
-      clGetDeviceInfo(devices[j], CL_DEVICE_NAME, sizeof(pbuff), pbuff, NULL);
-      applog(LOG_INFO, "\t%i\t%s", j, pbuff);
-    }
-    free(devices);
-  }
+}
 
-  ret = numDevices;
-out:
-  return ret;
+/* cl_nv_device_attribute_query, not in every cl_ext.h */
+#ifndef CL_DEVICE_COMPUTE_CAPABILITY_MAJOR_NV
+#define CL_DEVICE_COMPUTE_CAPABILITY_MAJOR_NV 0x4000
+#define CL_DEVICE_COMPUTE_CAPABILITY_MINOR_NV 0x4001
+#endif
+
+/* CUDA cores per multiprocessor by compute capability, from the CUDA C
+ * Programming Guide's table of arithmetic instruction throughput. 0 for
+ * generations it doesn't list. */
+static cl_uint nvidia_cores_per_mp(cl_uint major, cl_uint minor)
+{
+  switch (major) {
+    case 1: return 8;                           // Tesla
+    case 2: return (minor >= 1) ? 48 : 32;      // Fermi
+    case 3: return 192;                         // Kepler
+    case 5: return 128;                         // Maxwell
+    case 6: return (minor == 0) ? 64 : 128;     // Pascal
+    case 7: return 64;                          // Volta, Turing
+    case 8: return (minor == 0) ? 64 : 128;     // Ampere, Ada
+    case 9: return 128;                         // Hopper
+    default: return 0;
+  }
 }
 
-static cl_int create_opencl_context(cl_context *context, cl_platform_id *platform)
+/* Number of work-items the device keeps in flight at once, used to scale
+ * xintensity. GPUs are modelled by their SIMD width per compute unit, CPUs
+ * and accelerators by their integer vector width per core. */
+static size_t get_compute_shaders(cl_device_id device, cl_device_type type, size_t compute_units, cl_uint vector_width)
 {
-  cl_context_properties cps[3] = { CL_CONTEXT_PLATFORM, (cl_context_properties)*platform, 0 };
-  cl_int status;
+  cl_uint major, minor, cores;
 
-  *context = clCreateContextFromType(cps, CL_DEVICE_TYPE_GPU, NULL, NULL, &status);
-  return status;
+  if (!(type & CL_DEVICE_TYPE_GPU))
+    return compute_units * (vector_width ? vector_width : 1);
+
+  // NVIDIA drivers report the compute capability, which fixes the number
+  // of CUDA cores per multiprocessor
+  if (clGetDeviceInfo(device, CL_DEVICE_COMPUTE_CAPABILITY_MAJOR_NV, sizeof(major), &major, NULL) == CL_SUCCESS &&
+      clGetDeviceInfo(device, CL_DEVICE_COMPUTE_CAPABILITY_MINOR_NV, sizeof(minor), &minor, NULL) == CL_SUCCESS &&
+      (cores = nvidia_cores_per_mp(major, minor)))
+    return compute_units * cores;
+
+  // AMD architechture got 64 compute shaders per compute unit.
+  // Source: http://www.amd.com/us/Documents/GCN_Architecture_whitepaper.pdf
+  return compute_units << 6;
 }
 
-static float get_opencl_version(cl_device_id device)
+static float get_opencl_version(const char *devoclver)
 {
   /* Check for OpenCL >= 1.0 support, needed for global offset parameter usage. */
-  char devoclver[1024];
-  char *find;
+  const char *find;
   float version = 1.0;
-  cl_int status;
 
-  status = clGetDeviceInfo(device, CL_DEVICE_VERSION, 1024, (void *)devoclver, NULL);
-  if (status != CL_SUCCESS) {
-    quit(1, "Failed to clGetDeviceInfo when trying to get CL_DEVICE_VERSION");
-  }
   find = strstr(devoclver, "OpenCL 1.0");
   if (!find) {
     version = 1.1;
     find = strstr(devoclver, "OpenCL 1.1");
-    if (!find)
+    if (!find) {
       version = 1.2;
+      find = strstr(devoclver, "OpenCL ");
+      if (find && find[7] >= '2' && find[7] <= '9')
+        version = 2.0;
+    }
   }
   return version;
 }
 
-static cl_int create_opencl_command_queue(cl_command_queue *command_queue, cl_context *context, cl_device_id *device, cl_command_queue_properties cq_properties)
+/* Everything about the OpenCL stack a kernel binary depends on besides
+ * its sources and compiler options */
+static void get_device_id(cl_platform_id platform, cl_device_id device, const char *devname, char *buf, size_t size)
 {
-  cl_int status;
-  *command_queue = clCreateCommandQueue(*context, *device,
-    cq_properties, &status);
-  if (status != CL_SUCCESS) /* Try again without OOE enable */
-    *command_queue = clCreateCommandQueue(*context, *device, 0, &status);
-  return status;
+  char info[256];
+  size_t len;
+
+  snprintf(buf, size, "%s", devname);
+  if (clGetPlatformInfo(platform, CL_PLATFORM_NAME, sizeof(info), info, NULL) == CL_SUCCESS) {
+    len = strlen(buf);
+    snprintf(buf + len, size - len, "|%s", info);
+  }
+  if (clGetPlatformInfo(platform, CL_PLATFORM_VERSION, sizeof(info), info, NULL) == CL_SUCCESS) {
+    len = strlen(buf);
+    snprintf(buf + len, size - len, "|%s", info);
+  }
+  if (clGetDeviceInfo(device, CL_DRIVER_VERSION, sizeof(info), info, NULL) == CL_SUCCESS) {
+    len = strlen(buf);
+    snprintf(buf + len, size - len, "|%s", info);
+  }
+  if (clGetDeviceInfo(device, CL_DEVICE_VERSION, sizeof(info), info, NULL) == CL_SUCCESS) {
+    len = strlen(buf);
+    snprintf(buf + len, size - len, "|%s", info);
+  }
 }
 
-_clState *initCl(unsigned int gpu, char *name, size_t nameSize, algorithm_t *algorithm)
+/* Fill in the capabilities of dev, logging what initCl used to log for
+ * every mining thread */
+static bool get_device_caps(opencl_device *dev)
 {
-  cl_int status = 0;
-	size_t compute_units = 0;
-	cl_platform_id platform = NULL;
-	struct cgpu_info *cgpu = &gpus[gpu];
-	_clState *clState = (_clState *)calloc(1, sizeof(_clState));
-	cl_uint preferred_vwidth, numDevices = clDevicesNum();
-	cl_device_id *devices = (cl_device_id *)alloca(numDevices * sizeof(cl_device_id));
-	build_kernel_data *build_data = (build_kernel_data *)alloca(sizeof(struct _build_kernel_data));
-	char **pbuff = (char **)alloca(sizeof(char *) * numDevices), filename[256];
+  char info[1024];
+  cl_int status;
 
-  // sanity check
-  if (!get_opencl_platform(opt_platform_id, &platform)) {
-    return NULL;
+  status = clGetDeviceInfo(dev->device, CL_DEVICE_NAME, sizeof(dev->name), dev->name, NULL);
+  if (status != CL_SUCCESS) {
+    applog(LOG_ERR, "Error %d: Failed to clGetDeviceInfo when trying to get CL_DEVICE_NAME", status);
+    return false;
   }
 
-  if (numDevices <= 0) {
-    return NULL;
+  status = clGetDeviceInfo(dev->device, CL_DEVICE_VERSION, sizeof(info), info, NULL);
+  if (status != CL_SUCCESS) {
+    applog(LOG_ERR, "Error %d: Failed to clGetDeviceInfo when trying to get CL_DEVICE_VERSION", status);
+    return false;
   }
+  dev->opencl_version = get_opencl_version(info);
 
-  if (gpu >= numDevices) {
-    applog(LOG_ERR, "Invalid GPU %i", gpu);
-    return NULL;
+  status = clGetDeviceInfo(dev->device, CL_DEVICE_PREFERRED_VECTOR_WIDTH_INT, sizeof(cl_uint), (void *)&dev->preferred_vwidth, NULL);
+  if (status != CL_SUCCESS) {
+    applog(LOG_ERR, "Error %d: Failed to clGetDeviceInfo when trying to get CL_DEVICE_PREFERRED_VECTOR_WIDTH_INT", status);
+    return false;
   }
+  applog(LOG_DEBUG, "Preferred vector width reported %d", (int)dev->preferred_vwidth);
 
+  status = clGetDeviceInfo(dev->device, CL_DEVICE_MAX_WORK_GROUP_SIZE, sizeof(size_t), (void *)&dev->max_work_size, NULL);
+  if (status != CL_SUCCESS) {
+    applog(LOG_ERR, "Error %d: Failed to clGetDeviceInfo when trying to get CL_DEVICE_MAX_WORK_GROUP_SIZE", status);
+    return false;
+  }
+  applog(LOG_DEBUG, "Max work group size reported %d", (int)dev->max_work_size);
 
-  /* Now, get the device list data */
+  status = clGetDeviceInfo(dev->device, CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(cl_uint), (void *)&dev->compute_units, NULL);
+  if (status != CL_SUCCESS) {
+    applog(LOG_ERR, "Error %d: Failed to clGetDeviceInfo when trying to get CL_DEVICE_MAX_COMPUTE_UNITS", status);
+    return false;
+  }
+  dev->compute_shaders = get_compute_shaders(dev->device, dev->type, dev->compute_units, dev->preferred_vwidth);
 
-  status = clGetDeviceIDs(platform, CL_DEVICE_TYPE_GPU, numDevices, devices, NULL);
+  status = clGetDeviceInfo(dev->device, CL_DEVICE_MAX_MEM_ALLOC_SIZE, sizeof(cl_ulong), (void *)&dev->max_alloc, NULL);
   if (status != CL_SUCCESS) {
-    applog(LOG_ERR, "Error %d: Getting Device IDs (list)", status);
-    return NULL;
+    applog(LOG_ERR, "Error %d: Failed to clGetDeviceInfo when trying to get CL_DEVICE_MAX_MEM_ALLOC_SIZE", status);
+    return false;
   }
+  applog(LOG_DEBUG, "Max mem alloc size is %lu", (long unsigned int)dev->max_alloc);
 
-  applog(LOG_INFO, "List of devices:");
+  status = clGetDeviceInfo(dev->device, CL_DEVICE_GLOBAL_MEM_SIZE, sizeof(cl_ulong), (void *)&dev->global_mem, NULL);
+  if (status != CL_SUCCESS) {
+    applog(LOG_ERR, "Error %d: Failed to clGetDeviceInfo when trying to get CL_DEVICE_GLOBAL_MEM_SIZE", status);
+    return false;
+  }
+  applog(LOG_DEBUG, "Global mem size is %lu", (long unsigned int)dev->global_mem);
 
-  for (int i = 0; i < numDevices; ++i)	{
-    size_t tmpsize;
-    if (clGetDeviceInfo(devices[i], CL_DEVICE_NAME, 0, NULL, &tmpsize) != CL_SUCCESS) {
-      applog(LOG_ERR, "Error while getting the length of the name for GPU #%d.", i);
-      return NULL;
-    }
+  get_device_id(dev->platform, dev->device, dev->name, dev->device_id, sizeof(dev->device_id));
+  return true;
+}
 
-    // Does the size include the NULL terminator? Who knows, just add one, it's faster than looking it up.
-    pbuff[i] = (char *)alloca(sizeof(char) * (tmpsize + 1));
-    if (clGetDeviceInfo(devices[i], CL_DEVICE_NAME, sizeof(char) * tmpsize, pbuff[i], NULL) != CL_SUCCESS) {
-      applog(LOG_ERR, "Error while attempting to get device information.");
-		  return NULL;
-    }
+/* PCI bus the AMD driver reports for a GPU, which is how ADL tells its
+ * adapters apart */
+static int get_pci_bus(opencl_device *dev)
+{
+  cl_device_topology_amd topology;
+
+  if (dev->vendor_id != PCI_VENDOR_AMD || !(dev->type & CL_DEVICE_TYPE_GPU))
+    return -1;
+  if (clGetDeviceInfo(dev->device, CL_DEVICE_TOPOLOGY_AMD, sizeof(topology), &topology, NULL) != CL_SUCCESS ||
+      topology.raw.type != CL_DEVICE_TOPOLOGY_TYPE_PCIE_AMD)
+    return -1;
+  return (unsigned char)topology.pcie.bus;
+}
 
-    applog(LOG_INFO, "\t%i\t%s", i, pbuff[i]);
-	}
-	
-	applog(LOG_INFO, "Selected %d: %s", gpu, pbuff[gpu]);
-  strncpy(name, pbuff[gpu], nameSize);
-  
-  status = create_opencl_context(&clState->context, &platform);
-  if (status != CL_SUCCESS) {
-    applog(LOG_ERR, "Error %d: Creating Context. (clCreateContextFromType)", status);
-    return NULL;
+/* Append the devices of the selected types on a platform to the table */
+static bool add_opencl_platform_devices(cl_platform_id platform)
+{
+  cl_uint numDevices = 0;
+  cl_device_id *devices;
+  opencl_device *tmp;
+  cl_int status;
+  unsigned int j;
+
+  log_opencl_platform(platform);
+
+  status = clGetDeviceIDs(platform, opt_opencl_types, 0, NULL, &numDevices);
+  if (status == CL_DEVICE_NOT_FOUND)
+    numDevices = 0;
+  else if (status != CL_SUCCESS) {
+    applog(LOG_INFO, "Error %d: Getting Device IDs (num)", status);
+    return false;
   }
+  applog(LOG_INFO, "Platform devices: %d", numDevices);
+  if (!numDevices)
+    return true;
 
-  status = create_opencl_command_queue(&clState->commandQueue, &clState->context, &devices[gpu], cgpu->algorithm.cq_properties);
+  devices = (cl_device_id *)alloca(numDevices * sizeof(cl_device_id));
+  status = clGetDeviceIDs(platform, opt_opencl_types, numDevices, devices, NULL);
   if (status != CL_SUCCESS) {
-    applog(LOG_ERR, "Error %d: Creating Command Queue. (clCreateCommandQueue)", status);
-    return NULL;
+    applog(LOG_ERR, "Error %d: Getting Device IDs (list)", status);
+    return false;
   }
 
-  status = clGetDeviceInfo(devices[gpu], CL_DEVICE_PREFERRED_VECTOR_WIDTH_INT, sizeof(cl_uint), (void *)&preferred_vwidth, NULL);
-  if (status != CL_SUCCESS) {
-    applog(LOG_ERR, "Error %d: Failed to clGetDeviceInfo when trying to get CL_DEVICE_PREFERRED_VECTOR_WIDTH_INT", status);
-    return NULL;
+  tmp = (opencl_device *)realloc(opencl_devices, (opencl_devices_num + numDevices) * sizeof(opencl_device));
+  if (!tmp) {
+    applog(LOG_ERR, "Failed to realloc opencl_devices");
+    return false;
+  }
+  opencl_devices = tmp;
+
+  for (j = 0; j < numDevices; j++) {
+    opencl_device *dev = &opencl_devices[opencl_devices_num++];
+
+    dev->platform = platform;
+    dev->device = devices[j];
+    if (clGetDeviceInfo(devices[j], CL_DEVICE_TYPE, sizeof(cl_device_type), &dev->type, NULL) != CL_SUCCESS)
+      dev->type = CL_DEVICE_TYPE_GPU;
+    if (clGetDeviceInfo(devices[j], CL_DEVICE_VENDOR_ID, sizeof(cl_uint), &dev->vendor_id, NULL) != CL_SUCCESS)
+      dev->vendor_id = 0;
+    dev->pci_bus = get_pci_bus(dev);
+
+    dev->name[0] = '\0';
+    dev->caps_ok = get_device_caps(dev);
+    applog(LOG_INFO, "\t%i\t%s", opencl_devices_num - 1, dev->name);
   }
-  applog(LOG_DEBUG, "Preferred vector width reported %d", preferred_vwidth);
 
-  status = clGetDeviceInfo(devices[gpu], CL_DEVICE_MAX_WORK_GROUP_SIZE, sizeof(size_t), (void *)&clState->max_work_size, NULL);
-  if (status != CL_SUCCESS) {
-    applog(LOG_ERR, "Error %d: Failed to clGetDeviceInfo when trying to get CL_DEVICE_MAX_WORK_GROUP_SIZE", status);
-    return NULL;
+  return true;
+}
+
+/* Enumerate the mining devices once; later calls return the same table so
+ * device numbers stay stable for the life of the process. */
+int clDevicesNum(void) {
+  cl_platform_id *platforms;
+  cl_platform_id platform = NULL;
+  cl_uint numPlatforms;
+  cl_int status;
+  unsigned int i;
+
+  if (opencl_devices_num >= 0)
+    return opencl_devices_num;
+
+  if (!opt_all_platforms) {
+    if (!get_opencl_platform(opt_platform_id, &platform))
+      return -1;
+
+    opencl_devices_num = 0;
+    if (!add_opencl_platform_devices(platform)) {
+      opencl_devices_num = -1;
+      return -1;
+    }
+    return opencl_devices_num;
   }
-  applog(LOG_DEBUG, "Max work group size reported %d", (int)(clState->max_work_size));
 
-  status = clGetDeviceInfo(devices[gpu], CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(size_t), (void *)&compute_units, NULL);
-  if (status != CL_SUCCESS) {
-    applog(LOG_ERR, "Error %d: Failed to clGetDeviceInfo when trying to get CL_DEVICE_MAX_COMPUTE_UNITS", status);
-    return NULL;
+  status = clGetPlatformIDs(0, NULL, &numPlatforms);
+  if (status != CL_SUCCESS || !numPlatforms) {
+    applog(LOG_ERR, "Error %d: clGetPlatformsIDs failed (no OpenCL SDK installed?)", status);
+    return -1;
   }
-  // AMD architechture got 64 compute shaders per compute unit.
-  // Source: http://www.amd.com/us/Documents/GCN_Architecture_whitepaper.pdf
-  clState->compute_shaders = compute_units << 6;
-  applog(LOG_INFO, "Maximum work size for this GPU (%d) is %d.", gpu, clState->max_work_size);
-	applog(LOG_INFO, "Your GPU (#%d) has %d compute units, and all AMD cards in the 7 series or newer (GCN cards) \
-		have 64 shaders per compute unit - this means it has %d shaders.", gpu, compute_units, clState->compute_shaders);
 
-  status = clGetDeviceInfo(devices[gpu], CL_DEVICE_MAX_MEM_ALLOC_SIZE, sizeof(cl_ulong), (void *)&cgpu->max_alloc, NULL);
+  platforms = (cl_platform_id *)alloca(numPlatforms * sizeof(cl_platform_id));
+  status = clGetPlatformIDs(numPlatforms, platforms, NULL);
   if (status != CL_SUCCESS) {
-    applog(LOG_ERR, "Error %d: Failed to clGetDeviceInfo when trying to get CL_DEVICE_MAX_MEM_ALLOC_SIZE", status);
-    return NULL;
+    applog(LOG_ERR, "Error %d: Getting Platform Ids. (clGetPlatformsIDs)", status);
+    return -1;
   }
-  applog(LOG_DEBUG, "Max mem alloc size is %lu", (long unsigned int)(cgpu->max_alloc));
 
-  /* Create binary filename based on parameters passed to opencl
-   * compiler to ensure we only load a binary that matches what
-   * would have otherwise created. The filename is:
-   * name + g + lg + lookup_gap + tc + thread_concurrency + nf + nfactor + w + work_size + l + sizeof(long) + .bin
-   */
+  opencl_devices_num = 0;
+  for (i = 0; i < numPlatforms; i++)
+    add_opencl_platform_devices(platforms[i]);
 
-  sprintf(filename, "%s.cl", (!empty_string(cgpu->algorithm.kernelfile) ? cgpu->algorithm.kernelfile : cgpu->algorithm.name));
-  applog(LOG_DEBUG, "Using source file %s", filename);
+  return opencl_devices_num;
+}
 
-  /* For some reason 2 vectors is still better even if the card says
-   * otherwise, and many cards lie about their max so use 256 as max
-   * unless explicitly set on the command line. Tahiti prefers 1 */
-  if (strstr(name, "Tahiti"))
-    preferred_vwidth = 1;
-  else if (preferred_vwidth > 2)
-    preferred_vwidth = 2;
+/* Name of an enumerated device, NULL if there's no such device */
+const char *clDeviceName(unsigned int gpu)
+{
+  if ((int)gpu >= opencl_devices_num || !opencl_devices[gpu].name[0])
+    return NULL;
+  return opencl_devices[gpu].name;
+}
 
-  /* All available kernels only support vector 1 */
-  cgpu->vwidth = 1;
+/* Whether an enumerated device is an AMD GPU, which ADL may monitor. bus
+ * is set to its PCI bus, or -1 if the driver doesn't report it. */
+bool clDeviceAMDGPU(unsigned int gpu, int *bus)
+{
+  opencl_device *dev;
+
+  *bus = -1;
+  if ((int)gpu >= opencl_devices_num)
+    return false;
+  dev = &opencl_devices[gpu];
+  *bus = dev->pci_bus;
+  return dev->vendor_id == PCI_VENDOR_AMD && (dev->type & CL_DEVICE_TYPE_GPU);
+}
 
-  /* Vectors are hard-set to 1 above. */
-  if (likely(cgpu->vwidth))
-    clState->vwidth = cgpu->vwidth;
+static cl_int create_opencl_context(cl_context *context, cl_platform_id *platform, cl_device_id *device)
+{
+  cl_context_properties cps[3] = { CL_CONTEXT_PLATFORM, (cl_context_properties)*platform, 0 };
+  cl_int status;
+
+  *context = clCreateContext(cps, 1, device, NULL, NULL, &status);
+  return status;
+}
+
+static cl_int create_opencl_command_queue(cl_command_queue *command_queue, cl_context *context, cl_device_id *device, cl_command_queue_properties cq_properties)
+{
+  cl_int status;
+  *command_queue = clCreateCommandQueue(*context, *device,
+    cq_properties, &status);
+  if (status != CL_SUCCESS) /* Try again without OOE enable */
+    *command_queue = clCreateCommandQueue(*context, *device, 0, &status);
+  return status;
+}
+
+/* Device memory each work-item needs in the scratchpad (padbuffer8) and in
+ * buffer1-3 for algorithms with rw_buffer_size < 0. The scrypt family sizes
+ * its scratchpad with the lookup gap and needs nothing else. */
+static void get_item_memory(algorithm_t *algorithm, int lookup_gap, size_t *pad, size_t *buf1, size_t *buf2, size_t *buf3)
+{
+  *buf1 = *buf2 = *buf3 = 0;
+
+  switch (algorithm->type) {
+  case ALGO_NEOSCRYPT:
+    *pad = NEOSCRYPT_SCRATCHBUF_SIZE;
+    break;
+  case ALGO_PLUCK:
+    *pad = PLUCK_SCRATCHBUF_SIZE;
+    break;
+  case ALGO_YESCRYPT:
+  case ALGO_YESCRYPT_MULTI:
+    *pad = YESCRYPT_SCRATCHBUF_SIZE;
+    *buf1 = PLUCK_SECBUF_SIZE;
+    *buf2 = 128 * 8 * 8;
+    *buf3 = 8 * 8 * 4;
+    break;
+  case ALGO_LYRA2REV2:
+    *pad = LYRA_SCRATCHBUF_SIZE;
+    *buf1 = 4 * 8; // matrix
+    break;
+  default:
+    *pad = 128 * (algorithm->n / lookup_gap + (algorithm->n % lookup_gap > 0));
+    break;
+  }
+}
+
+/* Largest number of work-items whose buffers fit on the device: every
+ * buffer must fit in a single allocation and together they must fit in
+ * this thread's share of global memory, keeping 1/16th back for the
+ * runtime and the small input/output buffers. */
+static size_t max_fitting_items(struct cgpu_info *cgpu, cl_ulong global_mem, size_t pad, size_t buf1, size_t buf2, size_t buf3)
+{
+  cl_ulong share = (global_mem - (global_mem >> 4)) / (cgpu->threads > 0 ? cgpu->threads : 1);
+  cl_ulong items = cgpu->max_alloc / pad;
+
+  if (buf1 && cgpu->max_alloc / buf1 < items)
+    items = cgpu->max_alloc / buf1;
+  if (buf2 && cgpu->max_alloc / buf2 < items)
+    items = cgpu->max_alloc / buf2;
+  if (buf3 && cgpu->max_alloc / buf3 < items)
+    items = cgpu->max_alloc / buf3;
+  if (global_mem && share / (pad + buf1 + buf2 + buf3) < items)
+    items = share / (pad + buf1 + buf2 + buf3);
+
+  return (size_t)items;
+}
+
+/* Pick the thread concurrency when it wasn't set by the user. Memory-hard
+ * kernels with one scratchpad per work-item run as many items as the
+ * intensity asks for, and the intensity is lowered when that doesn't fit.
+ * The scrypt family sizes TC from memory and shaders instead, raising the
+ * lookup gap if memory can't hold one item per shader. */
+static size_t plan_thread_concurrency(unsigned int gpu, struct cgpu_info *cgpu, _clState *clState, algorithm_t *algorithm, cl_ulong global_mem)
+{
+  size_t pad, buf1, buf2, buf3, max_items;
+  size_t glob_thread_count;
+  long max_int;
+  unsigned char type = 0;
+
+  if (algorithm->rw_buffer_size >= 0) {
+    // buffers don't depend on TC, size it like an N-sized scrypt pad
+    max_items = cgpu->max_alloc / (128 * algorithm->n);
+  }
   else {
-    clState->vwidth = preferred_vwidth;
-    cgpu->vwidth = preferred_vwidth;
+    get_item_memory(algorithm, clState->lookup_gap, &pad, &buf1, &buf2, &buf3);
+    max_items = max_fitting_items(cgpu, global_mem, pad, buf1, buf2, buf3);
   }
 
-  clState->goffset = true;
+  if (algorithm->rw_buffer_size >= 0 || (algorithm->type != ALGO_NEOSCRYPT && algorithm->type != ALGO_PLUCK &&
+      algorithm->type != ALGO_YESCRYPT && algorithm->type != ALGO_YESCRYPT_MULTI &&
+      algorithm->type != ALGO_LYRA2REV2)) {
+    size_t thread_concurrency;
+
+    // trade compute for memory while the user left the lookup gap alone
+    while (algorithm->rw_buffer_size < 0 && !cgpu->opt_lg && cgpu->shaders && max_items < cgpu->shaders && clState->lookup_gap < 4 &&
+           strcmp(algorithm->name, "zuikkis") != 0) {
+      clState->lookup_gap <<= 1;
+      get_item_memory(algorithm, clState->lookup_gap, &pad, &buf1, &buf2, &buf3);
+      max_items = max_fitting_items(cgpu, global_mem, pad, buf1, buf2, buf3);
+      applog(LOG_DEBUG, "GPU %d: raising lookup gap to %d to fit memory", gpu, clState->lookup_gap);
+    }
 
-  clState->wsize = (cgpu->work_size && cgpu->work_size <= clState->max_work_size) ? cgpu->work_size : 256;
+    thread_concurrency = (max_items >= 128) ? ((max_items >> 6) - 1) << 6 : 64;
+    if (cgpu->shaders && thread_concurrency > cgpu->shaders) {
+      thread_concurrency -= thread_concurrency % cgpu->shaders;
 
-  if (!cgpu->opt_lg) {
-    applog(LOG_DEBUG, "GPU %d: selecting lookup gap of 2", gpu);
-    cgpu->lookup_gap = 2;
+      if (thread_concurrency > cgpu->shaders * 5) {
+        thread_concurrency = cgpu->shaders * 5;
+      }
+    }
+    applog(LOG_DEBUG, "GPU %d: selecting thread concurrency of %d", gpu, (int)thread_concurrency);
+    return thread_concurrency;
   }
-  else
-    cgpu->lookup_gap = cgpu->opt_lg;
 
-  if ((strcmp(cgpu->algorithm.name, "zuikkis") == 0) && (cgpu->lookup_gap != 2)) {
-    applog(LOG_WARNING, "Kernel zuikkis only supports lookup-gap = 2 (currently %d), forcing.", cgpu->lookup_gap);
-    cgpu->lookup_gap = 2;
+  // determine which intensity type to use
+  if (clState->rawintensity > 0) {
+    glob_thread_count = clState->rawintensity;
+    max_int = glob_thread_count;
+    type = 2;
   }
-
-  if ((strcmp(cgpu->algorithm.name, "bufius") == 0) && ((cgpu->lookup_gap != 2) && (cgpu->lookup_gap != 4) && (cgpu->lookup_gap != 8))) {
-    applog(LOG_WARNING, "Kernel bufius only supports lookup-gap of 2, 4 or 8 (currently %d), forcing to 2", cgpu->lookup_gap);
-    cgpu->lookup_gap = 2;
+  else if (clState->xintensity > 0) {
+    glob_thread_count = clState->compute_shaders * ((algorithm->xintensity_shift) ? (1UL << (algorithm->xintensity_shift + clState->xintensity)) : clState->xintensity);
+    max_int = clState->xintensity;
+    type = 1;
+  }
+  else {
+    glob_thread_count = 1UL << (algorithm->intensity_shift + clState->intensity);
+    max_int = ((cgpu->dynamic) ? MAX_INTENSITY : clState->intensity);
   }
 
-  // neoscrypt TC
-  if (cgpu->algorithm.type == ALGO_NEOSCRYPT && !cgpu->opt_tc) {
-    size_t glob_thread_count;
-    long max_int;
-    unsigned char type = 0;
+  glob_thread_count = ((glob_thread_count < cgpu->work_size) ? cgpu->work_size : glob_thread_count);
 
-    // determine which intensity type to use
-    if (cgpu->rawintensity > 0) {
-      glob_thread_count = cgpu->rawintensity;
-      max_int = glob_thread_count;
-      type = 2;
-    }
-    else if (cgpu->xintensity > 0) {
-      glob_thread_count = clState->compute_shaders * ((cgpu->algorithm.xintensity_shift) ? (1UL << (cgpu->algorithm.xintensity_shift + cgpu->xintensity)) : cgpu->xintensity);
-      max_int = cgpu->xintensity;
-      type = 1;
-    }
-    else {
-      glob_thread_count = 1UL << (cgpu->algorithm.intensity_shift + cgpu->intensity);
-      max_int = ((cgpu->dynamic) ? MAX_INTENSITY : cgpu->intensity);
-    }
+  // if the buffers for this many items don't fit... reduce to max
+  if (glob_thread_count > max_items) {
+
+    /* Selected intensity will not run on this GPU. Not enough memory.
+     * Adapt the memory setting. */
+    // depending on intensity type used, reduce the intensity until it fits
+    switch (type) {
+      //raw intensity
+    case 2:
+      glob_thread_count = max_items;
+      clState->rawintensity = glob_thread_count;
+      break;
+
+      //x intensity
+    case 1:
+      max_int = max_items / clState->compute_shaders;
 
-    glob_thread_count = ((glob_thread_count < cgpu->work_size) ? cgpu->work_size : glob_thread_count);
-
-    // if TC * scratchbuf size is too big for memory... reduce to max
-    if ((glob_thread_count * NEOSCRYPT_SCRATCHBUF_SIZE) >= (uint64_t)cgpu->max_alloc) {
-
-      /* Selected intensity will not run on this GPU. Not enough memory.
-       * Adapt the memory setting. */
-      // depending on intensity type used, reduce the intensity until it fits into the GPU max_alloc
-      switch (type) {
-        //raw intensity
-      case 2:
-        while ((glob_thread_count * NEOSCRYPT_SCRATCHBUF_SIZE) > (uint64_t)cgpu->max_alloc) {
-          --glob_thread_count;
-        }
-
-        max_int = glob_thread_count;
-        cgpu->rawintensity = glob_thread_count;
-        break;
-
-        //x intensity
-      case 1:
-        glob_thread_count = cgpu->max_alloc / NEOSCRYPT_SCRATCHBUF_SIZE;
-        max_int = glob_thread_count / clState->compute_shaders;
-
-        while (max_int && ((clState->compute_shaders * (1UL << max_int)) > glob_thread_count)) {
-          --max_int;
-        }
-
-        /* Check if max_intensity is >0. */
-        if (max_int < MIN_XINTENSITY) {
-          applog(LOG_ERR, "GPU %d: Max xintensity is below minimum.", gpu);
-          max_int = MIN_XINTENSITY;
-        }
-
-        cgpu->xintensity = max_int;
-        glob_thread_count = clState->compute_shaders * (1UL << max_int);
-        break;
-
-      default:
-        glob_thread_count = cgpu->max_alloc / NEOSCRYPT_SCRATCHBUF_SIZE;
-        while (max_int && ((1UL << max_int) & glob_thread_count) == 0) {
-          --max_int;
-        }
-
-        /* Check if max_intensity is >0. */
-        if (max_int < MIN_INTENSITY) {
-          applog(LOG_ERR, "GPU %d: Max intensity is below minimum.", gpu);
-          max_int = MIN_INTENSITY;
-        }
-
-        cgpu->intensity = max_int;
-        glob_thread_count = 1UL << max_int;
-        break;
+      while (max_int && ((clState->compute_shaders * (1UL << max_int)) > max_items)) {
+        --max_int;
       }
+
+      /* Check if max_intensity is >0. */
+      if (max_int < MIN_XINTENSITY) {
+        applog(LOG_ERR, "GPU %d: Max xintensity is below minimum.", gpu);
+        max_int = MIN_XINTENSITY;
+      }
+
+      clState->xintensity = max_int;
+      glob_thread_count = clState->compute_shaders * (1UL << max_int);
+      break;
+
+    default:
+      while (max_int && ((1UL << max_int) & max_items) == 0) {
+        --max_int;
+      }
+
+      /* Check if max_intensity is >0. */
+      if (max_int < MIN_INTENSITY) {
+        applog(LOG_ERR, "GPU %d: Max intensity is below minimum.", gpu);
+        max_int = MIN_INTENSITY;
+      }
+
+      clState->intensity = max_int;
+      glob_thread_count = 1UL << max_int;
+      break;
     }
+  }
+
+  applog(LOG_DEBUG, "GPU %d: computing max. global thread count to %u", gpu, (unsigned)glob_thread_count);
 
-    // TC is glob thread count
-    cgpu->thread_concurrency = glob_thread_count;
+  // TC is glob thread count
+  return glob_thread_count;
+}
+
+#ifdef CL_VERSION_2_0
+/* Put the block header and the result buffer in shared virtual memory so
+ * the host can fill and read them in place. CLbuffer0 and outputBuffer are
+ * still created, on top of the SVM allocations, so kernel arguments are set
+ * the same way either way. */
+static bool init_svm(_clState *clState, cl_device_id device, size_t headersize, size_t outputsize)
+{
+  cl_device_svm_capabilities caps = 0;
+  cl_svm_mem_flags flags = 0;
 
-    applog(LOG_DEBUG, "GPU %d: computing max. global thread count to %u", gpu, (unsigned)(cgpu->thread_concurrency));
+  if (clGetDeviceInfo(device, CL_DEVICE_SVM_CAPABILITIES, sizeof(caps), &caps, NULL) != CL_SUCCESS)
+    return false;
 
+  if (caps & CL_DEVICE_SVM_FINE_GRAIN_BUFFER) {
+    clState->svm_fine_grain = true;
+    flags = CL_MEM_SVM_FINE_GRAIN_BUFFER;
+  }
+  else if (!(caps & CL_DEVICE_SVM_COARSE_GRAIN_BUFFER))
+    return false;
+
+  clState->svm_header = clSVMAlloc(clState->context, CL_MEM_READ_ONLY | flags, headersize, 0);
+  clState->svm_output = clSVMAlloc(clState->context, CL_MEM_READ_WRITE | flags, outputsize, 0);
+  if (!clState->svm_header || !clState->svm_output) {
+    release_svm(clState);
+    return false;
   }
 
-  // pluck TC
-  else if (cgpu->algorithm.type == ALGO_PLUCK && !cgpu->opt_tc) {
-    size_t glob_thread_count;
-    long max_int;
-    unsigned char type = 0;
+  return true;
+}
 
-    // determine which intensity type to use
-    if (cgpu->rawintensity > 0) {
-      glob_thread_count = cgpu->rawintensity;
-      max_int = glob_thread_count;
-      type = 2;
-    }
-    else if (cgpu->xintensity > 0) {
-      glob_thread_count = clState->compute_shaders * ((cgpu->algorithm.xintensity_shift) ? (1UL << (cgpu->algorithm.xintensity_shift + cgpu->xintensity)) : cgpu->xintensity);
-      max_int = cgpu->xintensity;
-      type = 1;
-    }
-    else {
-      glob_thread_count = 1UL << (cgpu->algorithm.intensity_shift + cgpu->intensity);
-      max_int = ((cgpu->dynamic) ? MAX_INTENSITY : cgpu->intensity);
-    }
+/* Coarse-grained SVM must be mapped around host access. Both calls block,
+ * so nothing queued after them can overtake the host access even on an
+ * out-of-order queue. */
+static cl_int map_svm(_clState *clState, void *ptr, size_t size, cl_map_flags flags)
+{
+  if (clState->svm_fine_grain)
+    return CL_SUCCESS;
+  return clEnqueueSVMMap(clState->commandQueue, CL_TRUE, flags, ptr, size, 0, NULL, NULL);
+}
 
-    glob_thread_count = ((glob_thread_count < cgpu->work_size) ? cgpu->work_size : glob_thread_count);
-
-    // if TC * scratchbuf size is too big for memory... reduce to max
-    if ((glob_thread_count * PLUCK_SCRATCHBUF_SIZE) >= (uint64_t)cgpu->max_alloc) {
-
-      /* Selected intensity will not run on this GPU. Not enough memory.
-      * Adapt the memory setting. */
-      // depending on intensity type used, reduce the intensity until it fits into the GPU max_alloc
-      switch (type) {
-        //raw intensity
-      case 2:
-        while ((glob_thread_count * PLUCK_SCRATCHBUF_SIZE) > (uint64_t)cgpu->max_alloc) {
-          --glob_thread_count;
-        }
-
-        max_int = glob_thread_count;
-        cgpu->rawintensity = glob_thread_count;
-        break;
-
-        //x intensity
-      case 1:
-        glob_thread_count = cgpu->max_alloc / PLUCK_SCRATCHBUF_SIZE;
-        max_int = glob_thread_count / clState->compute_shaders;
-
-        while (max_int && ((clState->compute_shaders * (1UL << max_int)) > glob_thread_count)) {
-          --max_int;
-        }
-
-        /* Check if max_intensity is >0. */
-        if (max_int < MIN_XINTENSITY) {
-          applog(LOG_ERR, "GPU %d: Max xintensity is below minimum.", gpu);
-          max_int = MIN_XINTENSITY;
-        }
-
-        cgpu->xintensity = max_int;
-        glob_thread_count = clState->compute_shaders * (1UL << max_int);
-        break;
-
-      default:
-        glob_thread_count = cgpu->max_alloc / PLUCK_SCRATCHBUF_SIZE;
-        while (max_int && ((1UL << max_int) & glob_thread_count) == 0) {
-          --max_int;
-        }
-
-        /* Check if max_intensity is >0. */
-        if (max_int < MIN_INTENSITY) {
-          applog(LOG_ERR, "GPU %d: Max intensity is below minimum.", gpu);
-          max_int = MIN_INTENSITY;
-        }
-
-        cgpu->intensity = max_int;
-        glob_thread_count = 1UL << max_int;
-        break;
-      }
-    }
+static cl_int unmap_svm(_clState *clState, void *ptr)
+{
+  cl_event event;
+  cl_int status;
+
+  if (clState->svm_fine_grain)
+    return CL_SUCCESS;
+  status = clEnqueueSVMUnmap(clState->commandQueue, ptr, 0, NULL, &event);
+  if (status != CL_SUCCESS)
+    return status;
+  status = clWaitForEvents(1, &event);
+  clReleaseEvent(event);
+  return status;
+}
+#endif
+
+void release_svm(_clState *clState)
+{
+#ifdef CL_VERSION_2_0
+  if (clState->svm_header)
+    clSVMFree(clState->context, clState->svm_header);
+  if (clState->svm_output)
+    clSVMFree(clState->context, clState->svm_output);
+#endif
+  clState->svm_header = clState->svm_output = NULL;
+}
 
-    // TC is glob thread count
-    cgpu->thread_concurrency = glob_thread_count;
+/* Release clState and whatever initCl got to create in it */
+void release_cl_state(_clState *clState)
+{
+  unsigned int i;
 
-    applog(LOG_DEBUG, "GPU %d: computing max. global thread count to %u", gpu, (unsigned)(cgpu->thread_concurrency));
+  if (clState->commandQueue)
+    clFinish(clState->commandQueue);
+  if (clState->outputBuffer)
+    clReleaseMemObject(clState->outputBuffer);
+  if (clState->CLbuffer0)
+    clReleaseMemObject(clState->CLbuffer0);
+  release_svm(clState);
+  if (clState->buffer1)
+    clReleaseMemObject(clState->buffer1);
+  if (clState->buffer2)
+    clReleaseMemObject(clState->buffer2);
+  if (clState->buffer3)
+    clReleaseMemObject(clState->buffer3);
+  if (clState->padbuffer8)
+    clReleaseMemObject(clState->padbuffer8);
+  if (clState->kernel)
+    clReleaseKernel(clState->kernel);
+  for (i = 0; clState->extra_kernels && i < clState->n_extra_kernels; i++)
+    if (clState->extra_kernels[i])
+      clReleaseKernel(clState->extra_kernels[i]);
+  if (clState->program)
+    clReleaseProgram(clState->program);
+  if (clState->commandQueue)
+    clReleaseCommandQueue(clState->commandQueue);
+  if (clState->context)
+    clReleaseContext(clState->context);
+  if (clState->extra_kernels)
+    free(clState->extra_kernels);
+  free(clState);
+}
+
+/* Upload the first size bytes of cldata to CLbuffer0 before a launch */
+cl_int write_header(_clState *clState, size_t size)
+{
+#ifdef CL_VERSION_2_0
+  if (clState->svm_header) {
+    cl_int status = map_svm(clState, clState->svm_header, size, CL_MAP_WRITE);
+    if (status != CL_SUCCESS)
+      return status;
+    memcpy(clState->svm_header, clState->cldata, size);
+    return unmap_svm(clState, clState->svm_header);
   }
+#endif
+  return clEnqueueWriteBuffer(clState->commandQueue, clState->CLbuffer0, true, 0, size, clState->cldata, 0, NULL, NULL);
+}
 
-  // Yescrypt TC
-  else if ((cgpu->algorithm.type == ALGO_YESCRYPT ||
-            algorithm->type == ALGO_YESCRYPT_MULTI) && !cgpu->opt_tc) {
-    size_t glob_thread_count;
-    long max_int;
-    unsigned char type = 0;
+/* Copy the SVM result buffer to res and clear it if anything was found.
+ * Only call this once the queue has finished. */
+cl_int read_svm_results(_clState *clState, uint32_t *res, size_t size, int found)
+{
+#ifdef CL_VERSION_2_0
+  uint32_t *output = (uint32_t *)clState->svm_output;
+  cl_int status = map_svm(clState, output, size, CL_MAP_READ | CL_MAP_WRITE);
+
+  if (status != CL_SUCCESS)
+    return status;
+  if (output[found]) {
+    memcpy(res, output, size);
+    memset(output, 0, size);
+  }
+  return unmap_svm(clState, output);
+#else
+  return CL_INVALID_VALUE;
+#endif
+}
 
-      // determine which intensity type to use
-    if (cgpu->rawintensity > 0) {
-      glob_thread_count = cgpu->rawintensity;
-      max_int = glob_thread_count;
-      type = 2;
-    }
-    else if (cgpu->xintensity > 0) {
-      glob_thread_count = clState->compute_shaders * ((cgpu->algorithm.xintensity_shift) ? (1UL << (cgpu->algorithm.xintensity_shift + cgpu->xintensity)) : cgpu->xintensity);
-      max_int = cgpu->xintensity;
-      type = 1;
-    }
-    else {
-      glob_thread_count = 1UL << (cgpu->algorithm.intensity_shift + cgpu->intensity);
-      max_int = ((cgpu->dynamic) ? MAX_INTENSITY : cgpu->intensity);
-    }
+/* Kernel binaries being built, by binary filename. The filename covers the
+ * source, the compiler options and the device model, so threads that would
+ * build the same binary wait for the first one and load the file it saves. */
+struct kernel_build {
+  char binary_filename[512];
+  struct kernel_build *next;
+};
 
-    glob_thread_count = ((glob_thread_count < cgpu->work_size) ? cgpu->work_size : glob_thread_count);
-
-    // if TC * scratchbuf size is too big for memory... reduce to max
-    if ((glob_thread_count * YESCRYPT_SCRATCHBUF_SIZE) >= (uint64_t)cgpu->max_alloc) {
-
-      /* Selected intensity will not run on this GPU. Not enough memory.
-      * Adapt the memory setting. */
-      // depending on intensity type used, reduce the intensity until it fits into the GPU max_alloc
-      switch (type) {
-        //raw intensity
-      case 2:
-        while ((glob_thread_count * YESCRYPT_SCRATCHBUF_SIZE) > (uint64_t)cgpu->max_alloc) {
-          --glob_thread_count;
-        }
-
-        max_int = glob_thread_count;
-        cgpu->rawintensity = glob_thread_count;
-        break;
-
-        //x intensity
-      case 1:
-        glob_thread_count = cgpu->max_alloc / YESCRYPT_SCRATCHBUF_SIZE;
-        max_int = glob_thread_count / clState->compute_shaders;
-
-        while (max_int && ((clState->compute_shaders * (1UL << max_int)) > glob_thread_count)) {
-          --max_int;
-        }
-
-        /* Check if max_intensity is >0. */
-        if (max_int < MIN_XINTENSITY) {
-          applog(LOG_ERR, "GPU %d: Max xintensity is below minimum.", gpu);
-          max_int = MIN_XINTENSITY;
-        }
-
-        cgpu->xintensity = max_int;
-        glob_thread_count = clState->compute_shaders * (1UL << max_int);
-        break;
-
-      default:
-        glob_thread_count = cgpu->max_alloc / YESCRYPT_SCRATCHBUF_SIZE;
-        while (max_int && ((1UL << max_int) & glob_thread_count) == 0) {
-          --max_int;
-        }
-
-        /* Check if max_intensity is >0. */
-        if (max_int < MIN_INTENSITY) {
-          applog(LOG_ERR, "GPU %d: Max intensity is below minimum.", gpu);
-          max_int = MIN_INTENSITY;
-        }
-
-        cgpu->intensity = max_int;
-        glob_thread_count = 1UL << max_int;
-        break;
-      }
-    }
+static struct kernel_build *kernel_builds;
+static int kernel_builds_running;
+static pthread_mutex_t kernel_build_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t kernel_build_cond = PTHREAD_COND_INITIALIZER;
+
+static struct kernel_build *find_kernel_build(const char *binary_filename)
+{
+  struct kernel_build *build;
+
+  for (build = kernel_builds; build; build = build->next)
+    if (!strcmp(build->binary_filename, binary_filename))
+      return build;
+  return NULL;
+}
+
+static int max_kernel_builds(void)
+{
+  if (opt_build_threads > 0)
+    return opt_build_threads;
+#ifdef _SC_NPROCESSORS_ONLN
+  if (sysconf(_SC_NPROCESSORS_ONLN) > 0)
+    return (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+  return 4;
+}
 
-    // TC is glob thread count
-    cgpu->thread_concurrency = glob_thread_count;
+/* Build a binary that couldn't be loaded, unless another thread is already
+ * building it, in which case wait and load that one. At most
+ * max_kernel_builds() builds run at a time. */
+static cl_program build_shared_kernel(build_kernel_data *data, const char *filename)
+{
+  struct kernel_build *build, **prev;
+  cl_program program;
+  bool waited;
+
+retry:
+  waited = false;
+  mutex_lock(&kernel_build_lock);
+  while (find_kernel_build(data->binary_filename) || kernel_builds_running >= max_kernel_builds()) {
+    if (find_kernel_build(data->binary_filename))
+      waited = true;
+    pthread_cond_wait(&kernel_build_cond, &kernel_build_lock);
+  }
 
-    applog(LOG_DEBUG, "GPU %d: computing max. global thread count to %u", gpu, (unsigned)(cgpu->thread_concurrency));
+  if (waited) {
+    mutex_unlock(&kernel_build_lock);
+    if ((program = load_opencl_binary_kernel(data)))
+      return program;
+    /* The other build failed or couldn't be saved */
+    goto retry;
   }
 
-  // Lyra2re v2 TC
-  else if (cgpu->algorithm.type == ALGO_LYRA2REV2 && !cgpu->opt_tc) {
-    size_t glob_thread_count;
-    long max_int;
-    unsigned char type = 0;
+  build = (struct kernel_build *)calloc(1, sizeof(struct kernel_build));
+  if (unlikely(!build)) {
+    mutex_unlock(&kernel_build_lock);
+    applog(LOG_ERR, "Failed to calloc kernel_build");
+    return NULL;
+  }
+  strcpy(build->binary_filename, data->binary_filename);
+  build->next = kernel_builds;
+  kernel_builds = build;
+  kernel_builds_running++;
+  mutex_unlock(&kernel_build_lock);
+
+  applog(LOG_NOTICE, "Building binary %s", data->binary_filename);
+  program = opt_kernel_link ? build_linked_kernel(data) : NULL;
+  if (!program)
+    program = build_opencl_kernel(data, filename);
+
+  // If it doesn't work, oh well, build it again next run
+  if (program)
+    save_opencl_kernel(data, program);
+
+  mutex_lock(&kernel_build_lock);
+  for (prev = &kernel_builds; *prev != build; prev = &(*prev)->next);
+  *prev = build->next;
+  kernel_builds_running--;
+  pthread_cond_broadcast(&kernel_build_cond);
+  mutex_unlock(&kernel_build_lock);
+  free(build);
+
+  return program;
+}
 
-    // determine which intensity type to use
-    if (cgpu->rawintensity > 0) {
-      glob_thread_count = cgpu->rawintensity;
-      max_int = glob_thread_count;
-      type = 2;
-    }
-    else if (cgpu->xintensity > 0) {
-      glob_thread_count = clState->compute_shaders * ((cgpu->algorithm.xintensity_shift) ? (1UL << (cgpu->algorithm.xintensity_shift + cgpu->xintensity)) : cgpu->xintensity);
-      max_int = cgpu->xintensity;
-      type = 1;
-    }
-    else {
-      glob_thread_count = 1UL << (cgpu->algorithm.intensity_shift + cgpu->intensity);
-      max_int = ((cgpu->dynamic) ? MAX_INTENSITY : cgpu->intensity);
-    }
+/* Device limits the settings of a mining thread are planned around */
+static bool get_device_limits(unsigned int gpu, struct cgpu_info *cgpu, _clState *clState, cl_uint *preferred_vwidth, cl_ulong *global_mem)
+{
+  opencl_device *dev = &opencl_devices[gpu];
 
-    glob_thread_count = ((glob_thread_count < cgpu->work_size) ? cgpu->work_size : glob_thread_count);
-
-    // if TC * scratchbuf size is too big for memory... reduce to max
-    if ((glob_thread_count * LYRA_SCRATCHBUF_SIZE) >= (uint64_t)cgpu->max_alloc) {
-
-      /* Selected intensity will not run on this GPU. Not enough memory.
-      * Adapt the memory setting. */
-      // depending on intensity type used, reduce the intensity until it fits into the GPU max_alloc
-      switch (type) {
-        //raw intensity
-      case 2:
-        while ((glob_thread_count * LYRA_SCRATCHBUF_SIZE) > (uint64_t)cgpu->max_alloc) {
-          --glob_thread_count;
-        }
-
-        max_int = glob_thread_count;
-        cgpu->rawintensity = glob_thread_count;
-        break;
-
-        //x intensity
-      case 1:
-        glob_thread_count = cgpu->max_alloc / LYRA_SCRATCHBUF_SIZE;
-        max_int = glob_thread_count / clState->compute_shaders;
-
-        while (max_int && ((clState->compute_shaders * (1UL << max_int)) > glob_thread_count)) {
-          --max_int;
-        }
-
-        /* Check if max_intensity is >0. */
-        if (max_int < MIN_XINTENSITY) {
-          applog(LOG_ERR, "GPU %d: Max xintensity is below minimum.", gpu);
-          max_int = MIN_XINTENSITY;
-        }
-
-        cgpu->xintensity = max_int;
-        glob_thread_count = clState->compute_shaders * (1UL << max_int);
-        break;
-
-      default:
-        glob_thread_count = cgpu->max_alloc / LYRA_SCRATCHBUF_SIZE;
-        while (max_int && ((1UL << max_int) & glob_thread_count) == 0) {
-          --max_int;
-        }
-
-        /* Check if max_intensity is >0. */
-        if (max_int < MIN_INTENSITY) {
-          applog(LOG_ERR, "GPU %d: Max intensity is below minimum.", gpu);
-          max_int = MIN_INTENSITY;
-        }
-
-        cgpu->intensity = max_int;
-        glob_thread_count = 1UL << max_int;
-        break;
-      }
-    }
+  if (!dev->caps_ok) {
+    applog(LOG_ERR, "Device #%d could not be queried when it was detected", gpu);
+    return false;
+  }
+
+  *preferred_vwidth = dev->preferred_vwidth;
+  clState->max_work_size = dev->max_work_size;
+  clState->compute_shaders = dev->compute_shaders;
+  applog(LOG_INFO, "Maximum work size for this GPU (%d) is %d.", gpu, (int)clState->max_work_size);
+  applog(LOG_INFO, "Device #%d has %d compute units, modelled as %d shaders.", gpu, (int)dev->compute_units, (int)clState->compute_shaders);
+
+  cgpu->max_alloc = dev->max_alloc;
+  *global_mem = dev->global_mem;
+
+  return true;
+}
+
+/* Plan the work size, lookup gap, thread concurrency and intensity of
+ * clState for algorithm from cgpu's settings and fill in build_data, including the binary filename, the
+ * same way for mining threads and for precompiled binaries */
+static void set_kernel_build_data(unsigned int gpu, struct cgpu_info *cgpu, _clState *clState, algorithm_t *algorithm,
+                                  cl_device_id *device, const char *devname, cl_ulong global_mem,
+                                  build_kernel_data *build_data, char *filename)
+{
+  /* Create binary filename based on parameters passed to opencl
+   * compiler to ensure we only load a binary that matches what
+   * would have otherwise created. The filename is:
+   * name + g + lg + lookup_gap + tc + thread_concurrency + nf + nfactor + w + work_size + l + sizeof(long) + .bin
+   */
+
+  sprintf(filename, "%s.cl", (!empty_string(algorithm->kernelfile) ? algorithm->kernelfile : algorithm->name));
+  applog(LOG_DEBUG, "Using source file %s", filename);
+
+  clState->goffset = true;
 
-    // TC is glob thread count
-    cgpu->thread_concurrency = glob_thread_count;
+  clState->wsize = (cgpu->work_size && cgpu->work_size <= clState->max_work_size) ? cgpu->work_size : 256;
 
-    applog(LOG_DEBUG, "GPU %d: computing max. global thread count to %u", gpu, (unsigned)(cgpu->thread_concurrency));
+  clState->intensity = cgpu->intensity;
+  clState->xintensity = cgpu->xintensity;
+  clState->rawintensity = cgpu->rawintensity;
+
+  if (!cgpu->opt_lg) {
+    applog(LOG_DEBUG, "GPU %d: selecting lookup gap of 2", gpu);
+    clState->lookup_gap = 2;
   }
-  else if (!cgpu->opt_tc) {
-    unsigned int sixtyfours;
+  else
+    clState->lookup_gap = cgpu->opt_lg;
 
-    sixtyfours = cgpu->max_alloc / 131072 / 64 / (algorithm->n / 1024) - 1;
-    cgpu->thread_concurrency = sixtyfours * 64;
-    if (cgpu->shaders && cgpu->thread_concurrency > cgpu->shaders) {
-      cgpu->thread_concurrency -= cgpu->thread_concurrency % cgpu->shaders;
+  if ((strcmp(algorithm->name, "zuikkis") == 0) && (clState->lookup_gap != 2)) {
+    applog(LOG_WARNING, "Kernel zuikkis only supports lookup-gap = 2 (currently %d), forcing.", clState->lookup_gap);
+    clState->lookup_gap = 2;
+  }
 
-      if (cgpu->thread_concurrency > cgpu->shaders * 5) {
-        cgpu->thread_concurrency = cgpu->shaders * 5;
-      }
-    }
-    applog(LOG_DEBUG, "GPU %d: selecting thread concurrency of %d", gpu, (int)(cgpu->thread_concurrency));
+  if ((strcmp(algorithm->name, "bufius") == 0) && ((clState->lookup_gap != 2) && (clState->lookup_gap != 4) && (clState->lookup_gap != 8))) {
+    applog(LOG_WARNING, "Kernel bufius only supports lookup-gap of 2, 4 or 8 (currently %d), forcing to 2", clState->lookup_gap);
+    clState->lookup_gap = 2;
+  }
+
+  if (!cgpu->opt_tc) {
+    clState->thread_concurrency = (cl_uint)plan_thread_concurrency(gpu, cgpu, clState, algorithm, global_mem);
   }
   else {
-    cgpu->thread_concurrency = cgpu->opt_tc;
+    clState->thread_concurrency = (cl_uint)cgpu->opt_tc;
   }
 
+  // passed to kernels that take these at run time instead of build time
+  clState->nfactor = algorithm->nfactor;
+
   build_data->context = clState->context;
-  build_data->device = &devices[gpu];
+  build_data->device = device;
 
   // Build information
   strcpy(build_data->source_filename, filename);
-	strcpy(build_data->platform, name);
-	strcpy(build_data->sgminer_path, sgminer_path);
+  snprintf(build_data->platform, sizeof(build_data->platform), "%s", devname);
+  strcpy(build_data->sgminer_path, sgminer_path);
 
   build_data->kernel_path = (*opt_kernel_path) ? opt_kernel_path : NULL;
   build_data->work_size = clState->wsize;
-  build_data->opencl_version = get_opencl_version(devices[gpu]);
+  build_data->lookup_gap = clState->lookup_gap;
+  build_data->thread_concurrency = clState->thread_concurrency;
+
+  /* Kernels using the default result layout get the configured number of
+   * result slots, others keep their own */
+  clState->found_idx = (algorithm->found_idx == MAXBUFFERS - 1) ? (uint32_t)opt_result_slots : algorithm->found_idx;
+  build_data->found_idx = clState->found_idx;
+  build_data->opencl_version = opencl_devices[gpu].opencl_version;
 
   strcpy(build_data->binary_filename, filename);
-	build_data->binary_filename[strlen(filename) - 3] = 0x00;		// And one NULL terminator, cutting off the .cl suffix.
-	strcat(build_data->binary_filename, pbuff[gpu]);
+  build_data->binary_filename[strlen(filename) - 3] = 0x00;		// And one NULL terminator, cutting off the .cl suffix.
+  strcat(build_data->binary_filename, devname);
 
   if (clState->goffset) {
     strcat(build_data->binary_filename, "g");
   }
 
   set_base_compiler_options(build_data);
+  if (clState->found_idx != algorithm->found_idx) {
+    char buf[16];
+
+    sprintf(buf, "r%u", clState->found_idx);
+    strcat(build_data->binary_filename, buf);
+  }
   if (algorithm->set_compile_options) {
     algorithm->set_compile_options(build_data, cgpu, algorithm);
   }
 
   strcat(build_data->binary_filename, ".bin");
+
+  set_kernel_cache_filename(build_data, opencl_devices[gpu].device_id);
   applog(LOG_DEBUG, "Using binary file %s", build_data->binary_filename);
+}
+
+/* Build and save algorithm's binary for GPU gpu unless it is already
+ * cached. cgpu is a copy of gpus[gpu] with the settings the binary is for
+ * and is the only thing changed; the device keeps mining meanwhile. */
+bool precompileCl(unsigned int gpu, struct cgpu_info *cgpu, algorithm_t *algorithm)
+{
+  _clState *clState;
+  build_kernel_data *build_data;
+  cl_platform_id platform;
+  cl_device_id device;
+  cl_uint preferred_vwidth;
+  cl_ulong global_mem = 0;
+  cl_program program;
+  cl_int status;
+  char filename[256];
+  bool ret = false;
+
+  if ((int)gpu >= clDevicesNum())
+    return false;
+
+  device = opencl_devices[gpu].device;
+  platform = opencl_devices[gpu].platform;
+
+  clState = (_clState *)calloc(1, sizeof(_clState));
+  build_data = (build_kernel_data *)calloc(1, sizeof(build_kernel_data));
+  if (unlikely(!clState || !build_data)) {
+    applog(LOG_ERR, "Failed to calloc in precompileCl");
+    goto out;
+  }
+
+  if (!get_device_limits(gpu, cgpu, clState, &preferred_vwidth, &global_mem))
+    goto out;
+
+  status = create_opencl_context(&clState->context, &platform, &device);
+  if (status != CL_SUCCESS) {
+    applog(LOG_ERR, "Error %d: Creating Context. (clCreateContext)", status);
+    goto out;
+  }
+
+  set_kernel_build_data(gpu, cgpu, clState, algorithm, &device, opencl_devices[gpu].name, global_mem, build_data, filename);
+
+  if (access(build_data->binary_filename, R_OK) == 0) {
+    applog(LOG_DEBUG, "GPU %d: %s is already cached", gpu, build_data->binary_filename);
+    ret = true;
+  }
+  else if ((program = build_shared_kernel(build_data, filename))) {
+    clReleaseProgram(program);
+    ret = true;
+  }
+  clReleaseContext(clState->context);
+
+out:
+  free(build_data);
+  free(clState);
+  return ret;
+}
+
+_clState *initCl(unsigned int gpu, char *name, size_t nameSize, algorithm_t *algorithm)
+{
+  cl_int status = 0;
+	cl_platform_id platform = NULL;
+	struct cgpu_info *cgpu = &gpus[gpu];
+	_clState *clState = (_clState *)calloc(1, sizeof(_clState));
+	int numDevices = clDevicesNum();
+	cl_uint preferred_vwidth;
+	cl_device_id device;
+	build_kernel_data *build_data = (build_kernel_data *)alloca(sizeof(struct _build_kernel_data));
+	char filename[256];
+	cl_ulong global_mem = 0;
+
+  // sanity check
+  if (numDevices <= 0 || !clState) {
+    free(clState);
+    return NULL;
+  }
+
+  if ((int)gpu >= numDevices) {
+    applog(LOG_ERR, "Invalid GPU %i", gpu);
+    free(clState);
+    return NULL;
+  }
+
+  device = opencl_devices[gpu].device;
+  platform = opencl_devices[gpu].platform;
+
+	applog(LOG_INFO, "Selected %d: %s", gpu, opencl_devices[gpu].name);
+  strncpy(name, opencl_devices[gpu].name, nameSize);
+  
+  status = create_opencl_context(&clState->context, &platform, &device);
+  if (status != CL_SUCCESS) {
+    applog(LOG_ERR, "Error %d: Creating Context. (clCreateContext)", status);
+    goto fail;
+  }
+
+  status = create_opencl_command_queue(&clState->commandQueue, &clState->context, &device, algorithm->cq_properties);
+  if (status != CL_SUCCESS) {
+    applog(LOG_ERR, "Error %d: Creating Command Queue. (clCreateCommandQueue)", status);
+    goto fail;
+  }
+
+  if (!get_device_limits(gpu, cgpu, clState, &preferred_vwidth, &global_mem))
+    goto fail;
+
+  /* For some reason 2 vectors is still better even if the card says
+   * otherwise, and many cards lie about their max so use 256 as max
+   * unless explicitly set on the command line. Tahiti prefers 1 */
+  if (strstr(name, "Tahiti"))
+    preferred_vwidth = 1;
+  else if (preferred_vwidth > 2)
+    preferred_vwidth = 2;
+
+  /* All available kernels only support vector 1 */
+  cgpu->vwidth = 1;
+
+  /* Vectors are hard-set to 1 above. */
+  if (likely(cgpu->vwidth))
+    clState->vwidth = cgpu->vwidth;
+  else {
+    clState->vwidth = preferred_vwidth;
+    cgpu->vwidth = preferred_vwidth;
+  }
+
+  set_kernel_build_data(gpu, cgpu, clState, algorithm, &device, opencl_devices[gpu].name, global_mem, build_data, filename);
+
 
   // Load program from file or build it if it doesn't exist
   if (!(clState->program = load_opencl_binary_kernel(build_data))) {
-    applog(LOG_NOTICE, "Building binary %s", build_data->binary_filename);
-
-    if (!(clState->program = build_opencl_kernel(build_data, filename))) {
-      return NULL;
+    if (!(clState->program = build_shared_kernel(build_data, filename))) {
+      goto fail;
     }
-
-	// If it doesn't work, oh well, build it again next run
-    save_opencl_kernel(build_data, clState->program);
   }
 
   // Load kernels
@@ -734,22 +1117,27 @@ _clState *initCl(unsigned int gpu, char *name, size_t nameSize, algorithm_t *alg
   clState->kernel = clCreateKernel(clState->program, "search", &status);
   if (status != CL_SUCCESS) {
     applog(LOG_ERR, "Error %d: Creating Kernel from program. (clCreateKernel)", status);
-    return NULL;
+    goto fail;
   }
 
   clState->n_extra_kernels = algorithm->n_extra_kernels;
+  clState->extra_kernel_counters = algorithm->extra_kernel_counters;
   if (clState->n_extra_kernels > 0) {
     unsigned int i;
     char kernel_name[9]; // max: search99 + 0x0
 
-    clState->extra_kernels = (cl_kernel *)malloc(sizeof(cl_kernel)* clState->n_extra_kernels);
+    clState->extra_kernels = (cl_kernel *)calloc(clState->n_extra_kernels, sizeof(cl_kernel));
+    if (!clState->extra_kernels) {
+      applog(LOG_ERR, "Failed to calloc in initCl");
+      goto fail;
+    }
 
     for (i = 0; i < clState->n_extra_kernels; i++) {
       snprintf(kernel_name, 9, "%s%d", "search", i + 1);
       clState->extra_kernels[i] = clCreateKernel(clState->program, kernel_name, &status);
       if (status != CL_SUCCESS) {
         applog(LOG_ERR, "Error %d: Creating ExtraKernel #%d from program. (clCreateKernel)", status, i);
-        return NULL;
+        goto fail;
       }
     }
   }
@@ -762,64 +1150,34 @@ _clState *initCl(unsigned int gpu, char *name, size_t nameSize, algorithm_t *alg
   if (algorithm->type == ALGO_CRE) readbufsize = 168;
   else if (algorithm->type == ALGO_DECRED) readbufsize = 192;
   else if (algorithm->type == ALGO_LBRY) readbufsize = 112;
+  /* header plus the first-block state from x11_midstate() or animecoin_midstate() */
+  else if (algorithm->type == ALGO_X11 || algorithm->type == ALGO_X13 ||
+           algorithm->type == ALGO_X14 || algorithm->type == ALGO_X15 ||
+           algorithm->type == ALGO_QUARK) readbufsize = 208;
 
   if (algorithm->rw_buffer_size < 0) {
-    // calc buffer size for neoscrypt
-    if (algorithm->type == ALGO_NEOSCRYPT) {
-      /* The scratch/pad-buffer needs 32kBytes memory per thread. */
-      bufsize = NEOSCRYPT_SCRATCHBUF_SIZE * cgpu->thread_concurrency;
-
-      /* This is the input buffer. For neoscrypt this is guaranteed to be
-       * 80 bytes only. */
-      readbufsize = 80;
-
-      applog(LOG_DEBUG, "Neoscrypt buffer sizes: %lu RW, %lu R", (unsigned long)bufsize, (unsigned long)readbufsize);
-      // scrypt/n-scrypt
-    }
-    else if (algorithm->type == ALGO_PLUCK) {
-      /* The scratch/pad-buffer needs 32kBytes memory per thread. */
-      bufsize = PLUCK_SCRATCHBUF_SIZE * cgpu->thread_concurrency;
-
-      /* This is the input buffer. For pluck this is guaranteed to be
-      * 80 bytes only. */
+    size_t pad;
+
+    get_item_memory(algorithm, clState->lookup_gap, &pad, &buf1size, &buf2size, &buf3size);
+    bufsize = pad * clState->thread_concurrency;
+    buf1size *= clState->thread_concurrency;
+    buf2size *= clState->thread_concurrency;
+    buf3size *= clState->thread_concurrency;
+
+    /* This is the input buffer. For the scrypt-like algorithms other than
+     * scrypt itself this is guaranteed to be 80 bytes only. */
+    if (algorithm->type == ALGO_NEOSCRYPT || algorithm->type == ALGO_PLUCK ||
+        algorithm->type == ALGO_YESCRYPT || algorithm->type == ALGO_YESCRYPT_MULTI ||
+        algorithm->type == ALGO_LYRA2REV2)
       readbufsize = 80;
 
-      applog(LOG_DEBUG, "pluck buffer sizes: %lu RW, %lu R", (unsigned long)bufsize, (unsigned long)readbufsize);
-      // scrypt/n-scrypt
-    }
-    else if (algorithm->type == ALGO_YESCRYPT || algorithm->type == ALGO_YESCRYPT_MULTI) {
-      /* The scratch/pad-buffer needs 32kBytes memory per thread. */
-      bufsize = YESCRYPT_SCRATCHBUF_SIZE * cgpu->thread_concurrency;
-      buf1size = PLUCK_SECBUF_SIZE * cgpu->thread_concurrency;
-      buf2size = 128 * 8 * 8 * cgpu->thread_concurrency;
-      buf3size= 8 * 8 * 4 * cgpu->thread_concurrency;
-      /* This is the input buffer. For yescrypt this is guaranteed to be
-      * 80 bytes only. */
-      readbufsize = 80;
-
-      applog(LOG_DEBUG, "yescrypt buffer sizes: %lu RW, %lu R", (unsigned long)bufsize, (unsigned long)readbufsize);
-      // scrypt/n-scrypt
-    }
-    else if (algorithm->type == ALGO_LYRA2REV2) {
-      /* The scratch/pad-buffer needs 32kBytes memory per thread. */
-      bufsize = LYRA_SCRATCHBUF_SIZE * cgpu->thread_concurrency;
-      buf1size = 4* 8 * cgpu->thread_concurrency; //matrix
-
-      /* This is the input buffer. For yescrypt this is guaranteed to be
-      * 80 bytes only. */
-      readbufsize = 80;
-
-      applog(LOG_DEBUG, "lyra2REv2 buffer sizes: %lu RW, %lu RW", (unsigned long)bufsize, (unsigned long)buf1size);
-      // scrypt/n-scrypt
-    }
-    else {
-      size_t ipt = (algorithm->n / cgpu->lookup_gap + (algorithm->n % cgpu->lookup_gap > 0));
-      bufsize = 128 * ipt * cgpu->thread_concurrency;
-      applog(LOG_DEBUG, "Scrypt buffer sizes: %lu RW, %lu R", (unsigned long)bufsize, (unsigned long)readbufsize);
-    }
+    applog(LOG_DEBUG, "%s buffer sizes: %lu RW, %lu/%lu/%lu extra RW, %lu R", algorithm->name, (unsigned long)bufsize,
+      (unsigned long)buf1size, (unsigned long)buf2size, (unsigned long)buf3size, (unsigned long)readbufsize);
   }
   else {
     bufsize = (size_t)algorithm->rw_buffer_size;
+    buf1size = bufsize; // we don't need that much just tired...
+    buf2size = buf3size = 0;
     applog(LOG_DEBUG, "Buffer sizes: %lu RW, %lu R", (unsigned long)bufsize, (unsigned long)readbufsize);
   }
 
@@ -838,39 +1196,27 @@ _clState *initCl(unsigned int gpu, char *name, size_t nameSize, algorithm_t *alg
       applog(LOG_WARNING, "Your settings come to %lu", (unsigned long)bufsize);
     }
 
-    if (algorithm->type == ALGO_YESCRYPT || algorithm->type == ALGO_YESCRYPT_MULTI) {
-      // need additionnal buffers
+    if (buf1size > 0) {
       clState->buffer1 = clCreateBuffer(clState->context, CL_MEM_READ_WRITE, buf1size, NULL, &status);
       if (status != CL_SUCCESS && !clState->buffer1) {
         applog(LOG_DEBUG, "Error %d: clCreateBuffer (buffer1), decrease TC or increase LG", status);
-        return NULL;
+        goto fail;
       }
+    }
 
+    if (buf2size > 0) {
       clState->buffer2 = clCreateBuffer(clState->context, CL_MEM_READ_WRITE, buf2size, NULL, &status);
       if (status != CL_SUCCESS && !clState->buffer2) {
         applog(LOG_DEBUG, "Error %d: clCreateBuffer (buffer2), decrease TC or increase LG", status);
-        return NULL;
+        goto fail;
       }
+    }
 
+    if (buf3size > 0) {
       clState->buffer3 = clCreateBuffer(clState->context, CL_MEM_READ_WRITE, buf3size, NULL, &status);
       if (status != CL_SUCCESS && !clState->buffer3) {
         applog(LOG_DEBUG, "Error %d: clCreateBuffer (buffer3), decrease TC or increase LG", status);
-        return NULL;
-      }
-    }
-    else if (algorithm->type == ALGO_LYRA2REV2) {
-      // need additionnal buffers
-      clState->buffer1 = clCreateBuffer(clState->context, CL_MEM_READ_WRITE, buf1size, NULL, &status);
-      if (status != CL_SUCCESS && !clState->buffer1) {
-        applog(LOG_DEBUG, "Error %d: clCreateBuffer (buffer1), decrease TC or increase LG", status);
-        return NULL;
-      }
-    }
-    else {
-      clState->buffer1 = clCreateBuffer(clState->context, CL_MEM_READ_WRITE, bufsize, NULL, &status); // we don't need that much just tired...
-      if (status != CL_SUCCESS && !clState->buffer1) {
-        applog(LOG_DEBUG, "Error %d: clCreateBuffer (buffer1), decrease TC or increase LG", status);
-        return NULL;
+        goto fail;
       }
     }
 
@@ -880,24 +1226,43 @@ _clState *initCl(unsigned int gpu, char *name, size_t nameSize, algorithm_t *alg
     clState->padbuffer8 = clCreateBuffer(clState->context, CL_MEM_READ_WRITE, bufsize, NULL, &status);
     if (status != CL_SUCCESS && !clState->padbuffer8) {
       applog(LOG_ERR, "Error %d: clCreateBuffer (padbuffer8), decrease TC or increase LG", status);
-      return NULL;
+      goto fail;
     }
   }
+  clState->scratch_size = bufsize + buf1size + buf2size + buf3size;
+
+#ifdef CL_VERSION_2_0
+  if (opt_svm) {
+    if (build_data->opencl_version < 2.0)
+      applog(LOG_INFO, "GPU %d: OpenCL 2.0 not supported, using device buffers", gpu);
+    else if (!init_svm(clState, device, readbufsize, RESULT_BUFFERSIZE(clState->found_idx)))
+      applog(LOG_INFO, "GPU %d: shared virtual memory not available, using device buffers", gpu);
+    else
+      applog(LOG_INFO, "GPU %d: using %s-grained shared virtual memory for header and results",
+        gpu, clState->svm_fine_grain ? "fine" : "coarse");
+  }
+#endif
 
   applog(LOG_DEBUG, "Using read buffer sized %lu", (unsigned long)readbufsize);
-  clState->CLbuffer0 = clCreateBuffer(clState->context, CL_MEM_READ_ONLY, readbufsize, NULL, &status);
+  clState->CLbuffer0 = clCreateBuffer(clState->context, CL_MEM_READ_ONLY | (clState->svm_header ? CL_MEM_USE_HOST_PTR : 0),
+    readbufsize, clState->svm_header, &status);
   if (status != CL_SUCCESS) {
     applog(LOG_ERR, "Error %d: clCreateBuffer (CLbuffer0)", status);
-    return NULL;
+    goto fail;
   }
 
-  applog(LOG_DEBUG, "Using output buffer sized %lu", BUFFERSIZE);
-  clState->outputBuffer = clCreateBuffer(clState->context, CL_MEM_WRITE_ONLY, BUFFERSIZE, NULL, &status);
+  applog(LOG_DEBUG, "Using output buffer sized %lu", (unsigned long)RESULT_BUFFERSIZE(clState->found_idx));
+  clState->outputBuffer = clCreateBuffer(clState->context, CL_MEM_READ_WRITE | (clState->svm_output ? CL_MEM_USE_HOST_PTR : 0),
+    RESULT_BUFFERSIZE(clState->found_idx), clState->svm_output, &status);
   if (status != CL_SUCCESS) {
     applog(LOG_ERR, "Error %d: clCreateBuffer (outputBuffer)", status);
-    return NULL;
+    goto fail;
   }
 
   return clState;
+
+fail:
+  release_cl_state(clState);
+  return NULL;
 }
 
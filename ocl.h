@@ -8,6 +8,8 @@ typedef struct __clState {
   cl_kernel kernel;
   cl_kernel *extra_kernels;
   size_t n_extra_kernels;
+  /* algorithm->extra_kernel_counters, NULL to launch them all in full */
+  const int *extra_kernel_counters;
   cl_command_queue commandQueue;
   cl_program program;
   cl_mem outputBuffer;
@@ -23,9 +25,32 @@ typedef struct __clState {
   size_t max_work_size;
   size_t wsize;
   size_t compute_shaders;
+  uint32_t found_idx;
+  cl_uint nfactor;
+  cl_uint thread_concurrency;
+  /* Planned by initCl for this state's algorithm. Dual threads share their
+   * cgpu with threads mining another algorithm so these can't live there */
+  int lookup_gap;
+  int intensity, xintensity, rawintensity;
+  /* Bytes in padbuffer8 and buffer1-3 */
+  size_t scratch_size;
+  /* OpenCL 2.0 shared virtual memory behind CLbuffer0 and outputBuffer,
+   * NULL when they are plain device buffers */
+  void *svm_header;
+  void *svm_output;
+  bool svm_fine_grain;
 } _clState;
 
 extern int clDevicesNum(void);
+extern const char *clDeviceName(unsigned int gpu);
+extern bool clDeviceAMDGPU(unsigned int gpu, int *bus);
+struct cgpu_info;
+
 extern _clState *initCl(unsigned int gpu, char *name, size_t nameSize, algorithm_t *algorithm);
+extern bool precompileCl(unsigned int gpu, struct cgpu_info *cgpu, algorithm_t *algorithm);
+extern cl_int write_header(_clState *clState, size_t size);
+extern cl_int read_svm_results(_clState *clState, uint32_t *res, size_t size, int found);
+extern void release_svm(_clState *clState);
+extern void release_cl_state(_clState *clState);
 
 #endif /* OCL_H */
@@ -1,72 +1,115 @@
+#include <sys/types.h>
 #include <sys/stat.h>
 #include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <utime.h>
+#ifndef WIN32
+#include <sys/mman.h>
+#endif
 
 #include "miner.h"
 #include "binary_kernel.h"
 
-cl_program load_opencl_binary_kernel(build_kernel_data *data)
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+/* Load a cached binary, building it for the device unless it is a
+ * compiled object that is only going to be linked */
+static cl_program load_opencl_binary(build_kernel_data *data, bool build)
 {
-  FILE *binaryfile = NULL;
+  struct stat binary_stat;
   size_t binary_size;
-  char **binaries = (char **)calloc(MAX_GPUDEVICES * 4, sizeof(char *));
+  unsigned char *binary = NULL;
+  bool mapped = false;
   cl_int status;
   cl_program program;
   cl_program ret = NULL;
+  int fd;
 
-  binaryfile = fopen(data->binary_filename, "rb");
-  if (!binaryfile) {
+  fd = open(data->binary_filename, O_RDONLY | O_BINARY);
+  if (fd < 0) {
     applog(LOG_DEBUG, "No binary found, generating from source");
     goto out;
-  } else {
-    struct stat binary_stat;
+  }
 
-    if (unlikely(stat(data->binary_filename, &binary_stat))) {
-      applog(LOG_DEBUG, "Unable to stat binary, generating from source");
-      goto out;
-    }
-    if (!binary_stat.st_size)
-      goto out;
+  if (unlikely(fstat(fd, &binary_stat))) {
+    applog(LOG_DEBUG, "Unable to stat binary, generating from source");
+    goto out;
+  }
+  if (!binary_stat.st_size)
+    goto out;
+  binary_size = binary_stat.st_size;
 
-    binary_size = binary_stat.st_size;
-    binaries[0] = (char *)calloc(binary_size, 1);
-    if (unlikely(!binaries[0])) {
+#ifndef WIN32
+  /* Map the binary rather than copying it; cache entries are only ever
+   * replaced by rename, never rewritten in place */
+  binary = (unsigned char *)mmap(NULL, binary_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (binary == MAP_FAILED)
+    binary = NULL;
+  else
+    mapped = true;
+#endif
+  if (!binary) {
+    binary = (unsigned char *)calloc(binary_size, 1);
+    if (unlikely(!binary)) {
       quit(1, "Unable to calloc binaries");
     }
 
-    if (fread(binaries[0], 1, binary_size, binaryfile) != binary_size) {
-      applog(LOG_ERR, "Unable to fread binary");
-      goto out;
-    }
-
-    program = clCreateProgramWithBinary(data->context, 1, data->device, &binary_size, (const unsigned char **)binaries, &status, NULL);
-    if (status != CL_SUCCESS) {
-      applog(LOG_ERR, "Error %d: Loading Binary into cl_program (clCreateProgramWithBinary)", status);
+    if (read(fd, binary, binary_size) != (ssize_t)binary_size) {
+      applog(LOG_ERR, "Unable to read binary");
       goto out;
     }
+  }
 
-    applog(LOG_DEBUG, "Loaded binary image %s", data->binary_filename);
+  program = clCreateProgramWithBinary(data->context, 1, data->device, &binary_size, (const unsigned char **)&binary, &status, NULL);
+  if (status != CL_SUCCESS) {
+    applog(LOG_ERR, "Error %d: Loading Binary into cl_program (clCreateProgramWithBinary)", status);
+    goto out;
+  }
 
-    /* create a cl program executable for all the devices specified */
-    status = clBuildProgram(program, 1, data->device, NULL, NULL, NULL);
-    if (status != CL_SUCCESS) {
-      applog(LOG_ERR, "Error %d: Building Program (clBuildProgram)", status);
-      size_t log_size;
-      status = clGetProgramBuildInfo(program, *data->device, CL_PROGRAM_BUILD_LOG, 0, NULL, &log_size);
+  applog(LOG_DEBUG, "Loaded binary image %s", data->binary_filename);
 
-      char *sz_log = (char *)malloc(log_size + 1);
-      status = clGetProgramBuildInfo(program, *data->device, CL_PROGRAM_BUILD_LOG, log_size, sz_log, NULL);
-      sz_log[log_size] = '\0';
-      applog(LOG_ERR, "%s", sz_log);
-      free(sz_log);
-      clReleaseProgram(program);
-      goto out;
-    }
+  /* create a cl program executable for all the devices specified */
+  status = build ? clBuildProgram(program, 1, data->device, NULL, NULL, NULL) : CL_SUCCESS;
+  if (status != CL_SUCCESS) {
+    applog(LOG_ERR, "Error %d: Building Program (clBuildProgram)", status);
+    size_t log_size;
+    status = clGetProgramBuildInfo(program, *data->device, CL_PROGRAM_BUILD_LOG, 0, NULL, &log_size);
 
-    ret = program;
+    char *sz_log = (char *)malloc(log_size + 1);
+    status = clGetProgramBuildInfo(program, *data->device, CL_PROGRAM_BUILD_LOG, log_size, sz_log, NULL);
+    sz_log[log_size] = '\0';
+    applog(LOG_ERR, "%s", sz_log);
+    free(sz_log);
+    clReleaseProgram(program);
+    goto out;
   }
+
+  /* Mark the entry as recently used for cache eviction */
+  utime(data->binary_filename, NULL);
+
+  ret = program;
 out:
-  if (binaryfile) fclose(binaryfile);
-  if (binaries[0]) free(binaries[0]);
-  if (binaries) free(binaries);
+#ifndef WIN32
+  if (mapped)
+    munmap(binary, binary_size);
+  else
+#endif
+  if (binary)
+    free(binary);
+  if (fd >= 0)
+    close(fd);
   return ret;
 }
+
+cl_program load_opencl_binary_kernel(build_kernel_data *data)
+{
+  return load_opencl_binary(data, true);
+}
+
+cl_program load_opencl_binary_object(build_kernel_data *data)
+{
+  return load_opencl_binary(data, false);
+}
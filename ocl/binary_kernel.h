@@ -10,5 +10,6 @@
 #include "build_kernel.h"
 
 cl_program load_opencl_binary_kernel(build_kernel_data *data);
+cl_program load_opencl_binary_object(build_kernel_data *data);
 
 #endif /* BINARY_KERNEL_H */
@@ -1,9 +1,15 @@
 #include <stdio.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <unistd.h>
 
 #include "miner.h"
+#include "sha2.h"
 #include "build_kernel.h"
+#include "binary_kernel.h"
 
-static char *file_contents(const char *filename, int *length)
+static char *find_file_contents(const char *filename, int *length, bool required)
 {
   char *fullpath = (char *)alloca(PATH_MAX);
   void *buffer;
@@ -34,7 +40,8 @@ static char *file_contents(const char *filename, int *length)
   }
 
   if (!f) {
-    applog(LOG_ERR, "Unable to open %s for reading!", filename);
+    if (required)
+      applog(LOG_ERR, "Unable to open %s for reading!", filename);
     return NULL;
   }
 
@@ -52,6 +59,121 @@ static char *file_contents(const char *filename, int *length)
   return (char*)buffer;
 }
 
+static char *file_contents(const char *filename, int *length)
+{
+  return find_file_contents(filename, length, true);
+}
+
+#define MAX_SOURCE_FILES 64
+
+/* Hash a kernel source and, recursively, every file it #includes that can
+ * be found on the kernel search path. Includes inside #if blocks are
+ * hashed whether or not they're used, which only costs a rebuild. */
+static void hash_source_file(sha256_ctx *ctx, const char *filename, char **seen, int *nseen)
+{
+  char *source, *line, *next, *name, *end, c;
+  int i, length;
+
+  for (i = 0; i < *nseen; i++)
+    if (!strcmp(seen[i], filename))
+      return;
+  if (*nseen == MAX_SOURCE_FILES)
+    return;
+  seen[(*nseen)++] = strdup(filename);
+
+  if (!(source = find_file_contents(filename, &length, false)))
+    return;
+  sha256_update(ctx, (const unsigned char *)filename, strlen(filename) + 1);
+  sha256_update(ctx, (const unsigned char *)source, length);
+
+  for (line = source; line; line = next) {
+    next = strchr(line, '\n');
+    if (next)
+      next++;
+
+    while (*line == ' ' || *line == '\t')
+      line++;
+    if (strncmp(line, "#include", 8))
+      continue;
+    name = line + 8;
+    while (*name == ' ' || *name == '\t')
+      name++;
+    if (*name != '"' && *name != '<')
+      continue;
+    end = strpbrk(++name, "\">\n");
+    if (!end || *end == '\n')
+      continue;
+    c = *end;
+    *end = '\0';
+    hash_source_file(ctx, name, seen, nseen);
+    *end = c;
+  }
+
+  free(source);
+}
+
+/* Name the binary after a hash of everything that goes into it: the
+ * source and its includes, the compiler options without the -I search
+ * paths, and the platform, driver and device versions in device_id. The
+ * readable name from initCl is kept in front, and the file goes to
+ * --kernel-cache if set. Identical rigs sharing a cache directory end up
+ * with identical names, while a changed kernel or driver update misses. */
+void set_kernel_cache_filename(build_kernel_data *data, const char *device_id)
+{
+  sha256_ctx ctx;
+  unsigned char digest[SHA256_DIGEST_SIZE];
+  char *seen[MAX_SOURCE_FILES], *options, *p, *q;
+  char name[sizeof(data->binary_filename)];
+  int i, nseen = 0;
+
+  snprintf(data->device_id, sizeof(data->device_id), "%s", device_id);
+  sha256_init(&ctx);
+  hash_source_file(&ctx, data->source_filename, seen, &nseen);
+  for (i = 0; i < nseen; i++)
+    free(seen[i]);
+
+  options = strdup(data->compiler_options);
+  while ((p = strstr(options, "-I \""))) {
+    q = strchr(p + 4, '"');
+    q = q ? q + 1 : p + strlen(p);
+    memmove(p, q, strlen(q) + 1);
+  }
+  sha256_update(&ctx, (const unsigned char *)options, strlen(options) + 1);
+  free(options);
+  sha256_update(&ctx, (const unsigned char *)device_id, strlen(device_id) + 1);
+  sha256_final(&ctx, digest);
+
+  /* Drop the .bin suffix, then append the first 64 bits of the hash */
+  strcpy(name, data->binary_filename);
+  if ((p = strstr(name, ".bin")) && !p[4])
+    *p = '\0';
+  if (opt_kernel_cache && *opt_kernel_cache)
+    snprintf(data->binary_filename, sizeof(data->binary_filename), "%s/%s-", opt_kernel_cache, name);
+  else
+    snprintf(data->binary_filename, sizeof(data->binary_filename), "%s-", name);
+  p = data->binary_filename + strlen(data->binary_filename);
+  for (i = 0; i < 8 && p + 2 < data->binary_filename + sizeof(data->binary_filename) - 4; i++, p += 2)
+    sprintf(p, "%02x", digest[i]);
+  strcat(data->binary_filename, ".bin");
+}
+
+static void print_build_log(int prio, cl_program program, cl_device_id device)
+{
+  size_t log_size;
+  char *sz_log;
+
+  if (clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_LOG, 0, NULL, &log_size) != CL_SUCCESS)
+    return;
+  sz_log = (char *)malloc(log_size + 1);
+  if (unlikely(!sz_log))
+    return;
+  if (clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_LOG, log_size, sz_log, NULL) == CL_SUCCESS) {
+    sz_log[log_size] = '\0';
+    applogsiz(prio, log_size, "%s", sz_log);
+  }
+  free(sz_log);
+}
+
 // This should NOT be in here! -- Wolf9466
 void set_base_compiler_options(build_kernel_data *data)
 {
@@ -60,6 +182,9 @@ void set_base_compiler_options(build_kernel_data *data)
       data->sgminer_path, data->sgminer_path, (int)data->work_size);
   applog(LOG_DEBUG, "Setting worksize to %d", (int)(data->work_size));
 
+  sprintf(buf, " -D FOUND_IDX=%u", data->found_idx);
+  strcat(data->compiler_options, buf);
+
   sprintf(buf, "w%dl%d", (int)data->work_size, (int)sizeof(long));
   strcat(data->binary_filename, buf);
   
@@ -95,15 +220,8 @@ cl_program build_opencl_kernel(build_kernel_data *data, const char *filename)
   status = clBuildProgram(program, 1, data->device, data->compiler_options, NULL, NULL);
 
   if (status != CL_SUCCESS) {
-    size_t log_size;
     applog(LOG_ERR, "Error %d: Building Program (clBuildProgram)", status);
-    status = clGetProgramBuildInfo(program, *data->device, CL_PROGRAM_BUILD_LOG, 0, NULL, &log_size);
-
-    char *sz_log = (char *)malloc(log_size + 1);
-    status = clGetProgramBuildInfo(program, *data->device, CL_PROGRAM_BUILD_LOG, log_size, sz_log, NULL);
-    sz_log[log_size] = '\0';
-    applogsiz(LOG_ERR, log_size, "%s", sz_log);
-    free(sz_log);
+    print_build_log(LOG_ERR, program, *data->device);
     goto out;
   }
 
@@ -113,8 +231,206 @@ out:
   return ret;
 }
 
+#ifdef CL_VERSION_1_2
+/* Kernels that link their leading stages from a module compiled on its
+ * own. Compiled with define set, the kernel leaves out its copy of the
+ * module, so the module is compiled once per device and set of compiler
+ * options and shared by every kernel listed with it. */
+static const struct kernel_module {
+  const char *kernel;
+  const char *module;
+  const char *define;
+} kernel_modules[] = {
+  { "darkcoin-mod.cl", "x11-stages.cl", "X11_STAGES_LINKED" },
+  { "marucoin-mod.cl", "x11-stages.cl", "X11_STAGES_LINKED" },
+  { "x14.cl", "x11-stages.cl", "X11_STAGES_LINKED" },
+  { "bitblock.cl", "x11-stages.cl", "X11_STAGES_LINKED" },
+};
+
+static const struct kernel_module *find_kernel_module(const char *filename)
+{
+  const char *name = strrchr(filename, '/');
+  unsigned int i;
+
+  name = name ? name + 1 : filename;
+  for (i = 0; i < sizeof(kernel_modules) / sizeof(kernel_modules[0]); i++)
+    if (!strcmp(kernel_modules[i].kernel, name))
+      return &kernel_modules[i];
+  return NULL;
+}
+
+static cl_program compile_opencl_source(build_kernel_data *data, const char *filename, const char *options)
+{
+  int pl;
+  char *source = file_contents(filename, &pl);
+  size_t sourceSize[] = {(size_t)pl};
+  cl_int status;
+  cl_program program = NULL;
+
+  if (!source)
+    return NULL;
+
+  program = clCreateProgramWithSource(data->context, 1, (const char **)&source, sourceSize, &status);
+  free(source);
+  if (status != CL_SUCCESS) {
+    applog(LOG_ERR, "Error %d: Loading %s into cl_program (clCreateProgramWithSource)", status, filename);
+    return NULL;
+  }
+
+  applog(LOG_DEBUG, "CompilerOptions: %s", options);
+  status = clCompileProgram(program, 1, data->device, options, 0, NULL, NULL, NULL, NULL);
+  if (status != CL_SUCCESS) {
+    applog(LOG_WARNING, "Error %d: Compiling %s (clCompileProgram)", status, filename);
+    print_build_log(LOG_DEBUG, program, *data->device);
+    clReleaseProgram(program);
+    return NULL;
+  }
+
+  return program;
+}
+
+/* Load the compiled module from the cache, or compile and save it */
+static cl_program get_module_object(build_kernel_data *data, const char *module)
+{
+  build_kernel_data *mod;
+  cl_program program;
+  char *p;
+
+  mod = (build_kernel_data *)malloc(sizeof(build_kernel_data));
+  if (unlikely(!mod))
+    return NULL;
+  memcpy(mod, data, sizeof(build_kernel_data));
+  snprintf(mod->source_filename, sizeof(mod->source_filename), "%s", module);
+  snprintf(mod->binary_filename, sizeof(mod->binary_filename), "%s", module);
+  if ((p = strstr(mod->binary_filename, ".cl")) && !p[3])
+    *p = '\0';
+  strcat(mod->binary_filename, ".bin");
+  set_kernel_cache_filename(mod, data->device_id);
+
+  if (!(program = load_opencl_binary_object(mod))) {
+    applog(LOG_NOTICE, "Compiling module %s", mod->binary_filename);
+    if ((program = compile_opencl_source(mod, mod->source_filename, mod->compiler_options)))
+      save_opencl_kernel(mod, program);
+  }
+
+  free(mod);
+  return program;
+}
+#endif
+
+/* Build a kernel that shares a module with others by compiling it without
+ * the module and linking the two. Returns NULL if the kernel has no module,
+ * the platform can't link (OpenCL < 1.2) or anything fails, in which case
+ * the caller should build it with build_opencl_kernel(). */
+cl_program build_linked_kernel(build_kernel_data *data)
+{
+#ifdef CL_VERSION_1_2
+  const struct kernel_module *km = find_kernel_module(data->source_filename);
+  char options[sizeof(data->compiler_options) + 64];
+  cl_program programs[2] = { NULL, NULL };
+  cl_program program = NULL;
+  cl_int status;
+
+  if (!km || data->opencl_version < 1.2)
+    return NULL;
+
+  if (!(programs[1] = get_module_object(data, km->module)))
+    goto out;
+
+  snprintf(options, sizeof(options), "%s -D %s", data->compiler_options, km->define);
+  if (!(programs[0] = compile_opencl_source(data, data->source_filename, options)))
+    goto out;
+
+  program = clLinkProgram(data->context, 1, data->device, NULL, 2, programs, NULL, NULL, &status);
+  if (status != CL_SUCCESS) {
+    applog(LOG_WARNING, "Error %d: Linking %s with %s (clLinkProgram)", status, data->source_filename, km->module);
+    if (program) {
+      print_build_log(LOG_DEBUG, program, *data->device);
+      clReleaseProgram(program);
+    }
+    program = NULL;
+  }
+
+out:
+  if (programs[0]) clReleaseProgram(programs[0]);
+  if (programs[1]) clReleaseProgram(programs[1]);
+  if (!program)
+    applog(LOG_WARNING, "Unable to link %s, building it in one piece", data->source_filename);
+  return program;
+#else
+  return NULL;
+#endif
+}
+
+struct cache_entry {
+  char path[512];
+  off_t size;
+  time_t mtime;
+};
+
+/* Delete the least recently used binaries in --kernel-cache until the .bin
+ * files there fit in --kernel-cache-size MB, never deleting keep. Loading a
+ * binary touches it, so its mtime is its last use. */
+static void evict_kernel_cache(const char *keep)
+{
+  struct cache_entry *entries = NULL, *entry;
+  int i, oldest, n = 0, size = 0;
+  uint64_t total = 0, limit;
+  struct dirent *ent;
+  struct stat st;
+  size_t len;
+  DIR *dir;
+
+  if (!opt_kernel_cache || !*opt_kernel_cache || opt_kernel_cache_size <= 0)
+    return;
+  limit = (uint64_t)opt_kernel_cache_size << 20;
+
+  if (!(dir = opendir(opt_kernel_cache)))
+    return;
+  while ((ent = readdir(dir))) {
+    len = strlen(ent->d_name);
+    if (len < 4 || strcmp(ent->d_name + len - 4, ".bin"))
+      continue;
+    if (n == size) {
+      size = size ? size * 2 : 64;
+      entries = (struct cache_entry *)realloc(entries, size * sizeof(struct cache_entry));
+      if (unlikely(!entries))
+        break;
+    }
+    entry = &entries[n];
+    snprintf(entry->path, sizeof(entry->path), "%s/%s", opt_kernel_cache, ent->d_name);
+    if (stat(entry->path, &st) || !S_ISREG(st.st_mode))
+      continue;
+    entry->size = st.st_size;
+    entry->mtime = st.st_mtime;
+    total += st.st_size;
+    n++;
+  }
+  closedir(dir);
+
+  while (entries && total > limit) {
+    oldest = -1;
+    for (i = 0; i < n; i++) {
+      if (entries[i].size < 0 || !strcmp(entries[i].path, keep))
+        continue;
+      if (oldest < 0 || entries[i].mtime < entries[oldest].mtime)
+        oldest = i;
+    }
+    if (oldest < 0)
+      break;
+
+    applog(LOG_INFO, "Removing %s from the kernel cache", entries[oldest].path);
+    if (!remove(entries[oldest].path))
+      total -= entries[oldest].size;
+    entries[oldest].size = -1;
+  }
+
+  free(entries);
+}
+
 bool save_opencl_kernel(build_kernel_data *data, cl_program program)
 {
+  char hostname[64], tmpname[sizeof(data->binary_filename) + 96];
   cl_uint slot, cpnd = 0;
   size_t *binary_sizes = (size_t *)calloc(MAX_GPUDEVICES * 4, sizeof(size_t));
   char **binaries = NULL;
@@ -165,19 +481,46 @@ bool save_opencl_kernel(build_kernel_data *data, cl_program program)
     goto out;
   }
 
-  /* Save the binary to be loaded next time */
-  binaryfile = fopen(data->binary_filename, "wb");
+  /* Save the binary to be loaded next time. It is written under a name
+   * unique to this host and process and renamed into place, so other
+   * threads and hosts sharing the cache never load a partial file. */
+  if (gethostname(hostname, sizeof(hostname)))
+    strcpy(hostname, "localhost");
+  hostname[sizeof(hostname) - 1] = '\0';
+  snprintf(tmpname, sizeof(tmpname), "%s.%s.%d.tmp", data->binary_filename, hostname, (int)getpid());
+  binaryfile = fopen(tmpname, "wb");
   if (!binaryfile) {
     /* Not fatal, just means we build it again next time */
-    applog(LOG_DEBUG, "Unable to create file %s", data->binary_filename);
+    applog(LOG_DEBUG, "Unable to create file %s", tmpname);
     goto out;
-  } else {
-    if (unlikely(fwrite(binaries[slot], 1, binary_sizes[slot], binaryfile) != binary_sizes[slot])) {
-      applog(LOG_ERR, "Unable to fwrite to binaryfile");
-      goto out;
-    }
+  }
+  /* Only a binary that is known to be complete on disk is renamed into
+   * place */
+  if (unlikely(fwrite(binaries[slot], 1, binary_sizes[slot], binaryfile) != binary_sizes[slot])) {
+    applog(LOG_ERR, "Unable to fwrite to %s", tmpname);
     fclose(binaryfile);
+    unlink(tmpname);
+    goto out;
   }
+  if (unlikely(fflush(binaryfile) || fsync(fileno(binaryfile)))) {
+    applog(LOG_ERR, "Unable to flush %s", tmpname);
+    fclose(binaryfile);
+    unlink(tmpname);
+    goto out;
+  }
+  if (unlikely(fclose(binaryfile))) {
+    applog(LOG_ERR, "Unable to close %s", tmpname);
+    unlink(tmpname);
+    goto out;
+  }
+  if (rename(tmpname, data->binary_filename)) {
+    /* Windows won't replace a file another host has just saved */
+    applog(LOG_DEBUG, "Unable to rename %s to %s", tmpname, data->binary_filename);
+    unlink(tmpname);
+    goto out;
+  }
+
+  evict_kernel_cache(data->binary_filename);
 
   ret = true;
 out:
@@ -11,8 +11,9 @@
 
 typedef struct _build_kernel_data {
   char source_filename[255];
-  char binary_filename[255];
+  char binary_filename[512];
   char compiler_options[512];
+  char device_id[1024];
 
   cl_context context;
   cl_device_id *device;
@@ -22,11 +23,16 @@ typedef struct _build_kernel_data {
   char sgminer_path[255];
   const char *kernel_path;
   size_t work_size;
+  int lookup_gap;
+  size_t thread_concurrency;
+  uint32_t found_idx;
   float opencl_version;
 } build_kernel_data;
 
 cl_program build_opencl_kernel(build_kernel_data *data, const char *filename);
+cl_program build_linked_kernel(build_kernel_data *data);
 bool save_opencl_kernel(build_kernel_data *data, cl_program program);
 void set_base_compiler_options(build_kernel_data *data);
+void set_kernel_cache_filename(build_kernel_data *data, const char *device_id);
 
 #endif /* BUILD_KERNEL_H */
@@ -106,7 +106,16 @@ time_t last_getwork;
 int nDevs;
 int opt_dynamic_interval = 7;
 int opt_g_threads = -1;
+int opt_dual_pool = -1;
+int opt_gpu_selftest = 0;
+int opt_gpu_sublaunches = 1;
+int opt_result_slots = MAXBUFFERS - 1;
+static int opt_device_diff_divisor = 0;
+static int opt_device_diff_sample = 16;
 bool opt_restart = true;
+static bool opt_precompile = true;
+static bool opt_compile_only = false;
+static char *opt_compile_algorithms = NULL;
 int opt_vote = 0;
 
 /*****************************************
@@ -117,6 +126,7 @@ int opt_keccak_unroll = 0;
 bool opt_hamsi_short = false;
 bool opt_blake_compact = false;
 bool opt_luffa_parallel = false;
+int opt_table_placement = TABLES_DEFAULT;
 
 struct list_head scan_devices;
 bool devices_enabled[MAX_DEVICES];
@@ -169,6 +179,9 @@ int opt_tcp_keepalive;
 double opt_diff_mult = 0.0;
 
 char *opt_kernel_path;
+char *opt_kernel_cache;
+int opt_kernel_cache_size = 0;
+bool opt_kernel_link = true;
 char *sgminer_path;
 
 #define QUIET (opt_quiet || opt_realquiet)
@@ -226,6 +239,7 @@ static void apply_initial_gpu_settings(struct pool *pool);
 static unsigned long compare_pool_settings(struct pool *oldpool, struct pool *newpool);
 static void apply_switcher_options(unsigned long options, struct pool *pool);
 static void restart_mining_threads(unsigned int new_n_threads);
+static void prepare_mining_threads(struct thr_info **thrs, int count, bool do_switch);
 static void probe_pools(void);
 static bool test_pool(struct pool *pool);
 
@@ -547,8 +561,10 @@ struct pool *add_pool(void)
   pool->xintensity = strdup(buf);
   pool->rawintensity = strdup(buf);
 
+  cg_wlock(&control_lock);
   pools = (struct pool **)realloc(pools, sizeof(struct pool *) * (total_pools + 2));
   pools[total_pools++] = pool;
+  cg_wunlock(&control_lock);
   mutex_init(&pool->pool_lock);
   if (unlikely(pthread_cond_init(&pool->cr_cond, NULL)))
     quit(1, "Failed to pthread_cond_init in add_pool");
@@ -598,6 +614,15 @@ struct pool *current_pool(void)
   return pool;
 }
 
+/* The pool mined concurrently by dual threads, or NULL if dual mining is off */
+struct pool *dual_pool(void)
+{
+  if (opt_dual_pool < 0 || opt_dual_pool >= total_pools)
+    return NULL;
+
+  return pools[opt_dual_pool];
+}
+
 /* Pool variant of test and set */
 static bool pool_tset(struct pool *pool, bool *var)
 {
@@ -646,6 +671,11 @@ char *set_int_1_to_65535(const char *arg, int *i)
   return set_int_range(arg, i, 1, 65535);
 }
 
+static char *set_result_slots(const char *arg, int *i)
+{
+  return set_int_range(arg, i, MAXBUFFERS - 1, 0xFFFF);
+}
+
 char *set_int_0_to_10(const char *arg, int *i)
 {
   return set_int_range(arg, i, 0, 10);
@@ -995,6 +1025,12 @@ void remove_pool(struct pool *pool)
       other->prio--;
   }
 
+  /* Dual mining stops with its pool and follows it when renumbered */
+  if (pool->pool_no == opt_dual_pool)
+    opt_dual_pool = -1;
+  else if (opt_dual_pool == last_pool)
+    opt_dual_pool = pool->pool_no;
+
   if (pool->pool_no < last_pool) {
     /* Swap the last pool for this one */
     (pools[last_pool])->pool_no = pool->pool_no;
@@ -1041,6 +1077,22 @@ static char *set_switcher_mode(char *arg)
   return NULL;
 }
 
+static char *set_table_placement(char *arg)
+{
+  if (!strcasecmp(arg, "default"))
+    opt_table_placement = TABLES_DEFAULT;
+  else if (!strcasecmp(arg, "constant"))
+    opt_table_placement = TABLES_CONSTANT;
+  else if (!strcasecmp(arg, "local"))
+    opt_table_placement = TABLES_LOCAL;
+  else if (!strcasecmp(arg, "compact"))
+    opt_table_placement = TABLES_COMPACT;
+  else
+    return "Invalid value passed to table-placement";
+
+  return NULL;
+}
+
 static char *set_quota(char *arg)
 {
   char *semicolon = strchr(arg, ';'), *url;
@@ -1369,6 +1421,12 @@ struct opt_table opt_config_table[] = {
   OPT_WITHOUT_ARG("--blake-compact",
       opt_set_bool, &opt_blake_compact,
       "Set SPH_COMPACT_BLAKE64 for Xn derived algorithms (Can give better hashrate for some GPUs)"),
+  OPT_WITH_ARG("--compile-algorithm",
+      opt_set_charp, NULL, &opt_compile_algorithms,
+      "Comma separated algorithms --compile-only also builds, with the default profile's settings"),
+  OPT_WITHOUT_ARG("--compile-only",
+      opt_set_bool, &opt_compile_only,
+      "Build the kernels of all pools and profiles for the enabled GPUs, then exit"),
 #ifdef HAVE_CURSES
   OPT_WITHOUT_ARG("--compact",
       opt_set_bool, &opt_compact,
@@ -1389,6 +1447,12 @@ struct opt_table opt_config_table[] = {
   OPT_WITH_ARG("--device|-d",
       set_default_devices, NULL, NULL,
       "Select device to use, one value, range and/or comma separated (e.g. 0-2,4) default: all"),
+  OPT_WITH_ARG("--device-diff-divisor",
+      set_int_0_to_9999, opt_show_intval, &opt_device_diff_divisor,
+      "Hash on the device at the pool difficulty divided by this value, 0 to ramp up from difficulty 1"),
+  OPT_WITH_ARG("--device-diff-sample",
+      set_int_0_to_9999, opt_show_intval, &opt_device_diff_sample,
+      "With --device-diff-divisor, hash every Nth work at the low difficulty to check for hardware errors, 0 never"),
   OPT_WITHOUT_ARG("--disable-rejecting",
       opt_set_bool, &opt_disable_pool,
       "Automatically disable pools that continually reject shares"),
@@ -1422,15 +1486,39 @@ struct opt_table opt_config_table[] = {
   OPT_WITH_ARG("--failover-switch-delay",
       set_int_1_to_65535, opt_show_intval, &opt_fail_switch_delay,
       "Delay in seconds before switching back to a failed pool"),
+  OPT_WITH_ARG("--dual-pool",
+      set_int_0_to_9999, opt_show_intval, &opt_dual_pool,
+      "Pool number to mine concurrently on each GPU's dual threads"),
+  OPT_WITH_ARG("--dual-threads",
+      set_dual_threads, NULL, NULL,
+      "Number of each GPU's threads that mine the dual pool - one value or comma separated list (e.g. 1,0,1)"),
   OPT_WITHOUT_ARG("--fix-protocol",
       opt_set_bool, &opt_fix_protocol,
       "Do not redirect to a different getwork protocol (eg. stratum)"),
   OPT_WITH_ARG("--gpu-dyninterval",
       set_int_1_to_65535, opt_show_intval, &opt_dynamic_interval,
       "Set the refresh interval in ms for GPUs using dynamic intensity"),
+  OPT_WITH_ARG("--gpu-result-slots",
+      set_result_slots, opt_show_intval, &opt_result_slots,
+      "Number of nonces each GPU batch can return before further finds are dropped (255 - 65535)"),
+  OPT_WITH_ARG("--gpu-selftest",
+      set_int_0_to_9999, opt_show_intval, &opt_gpu_selftest,
+      "Minutes between known-answer self-tests of each GPU, 0 to disable"),
+  OPT_WITH_ARG("--gpu-sublaunches",
+      set_int_1_to_65535, opt_show_intval, &opt_gpu_sublaunches,
+      "Split each GPU batch into this many kernel launches so it can be abandoned on a new block"),
+  OPT_WITHOUT_ARG("--gpu-svm",
+      opt_set_bool, &opt_svm,
+      "Keep block header and results in OpenCL 2.0 shared virtual memory where supported"),
   OPT_WITH_ARG("--gpu-platform",
       set_int_0_to_9999, opt_show_intval, &opt_platform_id,
       "Select OpenCL platform ID to use for GPU mining"),
+  OPT_WITHOUT_ARG("--gpu-all-platforms",
+      opt_set_bool, &opt_all_platforms,
+      "Mine on the devices of every OpenCL platform instead of a single one"),
+  OPT_WITH_ARG("--gpu-types",
+      set_opencl_types, NULL, NULL,
+      "Comma separated OpenCL device types to mine on: gpu, cpu, accelerator or all"),
 #ifndef HAVE_ADL
   // gpu-threads can only be set per-card if ADL is available
   OPT_WITH_ARG("--gpu-threads|-g",
@@ -1504,6 +1592,15 @@ struct opt_table opt_config_table[] = {
       set_default_rawintensity, NULL, NULL,
       "Raw intensity of GPU scanning (" MIN_RAWINTENSITY_STR " to "
         MAX_RAWINTENSITY_STR "), overrides --intensity|-I and --xintensity|-X."),
+  OPT_WITH_ARG("--kernel-build-threads",
+      set_int_0_to_9999, opt_show_intval, &opt_build_threads,
+      "Number of kernel binaries to build at the same time, 0 for one per CPU"),
+  OPT_WITH_ARG("--kernel-cache",
+      opt_set_charp, opt_show_charp, &opt_kernel_cache,
+      "Directory to keep compiled kernel binaries in, can be shared between hosts"),
+  OPT_WITH_ARG("--kernel-cache-size",
+      set_int_0_to_9999, opt_show_intval, &opt_kernel_cache_size,
+      "Maximum size of the kernel cache directory in MB, 0 for no limit"),
   OPT_WITH_ARG("--kernel-path|-K",
       opt_set_charp, opt_show_charp, &opt_kernel_path,
       "Specify a path to where kernel files are"),
@@ -1544,6 +1641,12 @@ struct opt_table opt_config_table[] = {
   OPT_WITHOUT_ARG("--no-adl",
       opt_set_bool, &opt_noadl, opt_hidden),
 #endif
+  OPT_WITHOUT_ARG("--no-kernel-link",
+      opt_set_invbool, &opt_kernel_link,
+      "Build every kernel from its full source instead of linking shared modules"),
+  OPT_WITHOUT_ARG("--no-kernel-precompile",
+      opt_set_invbool, &opt_precompile,
+      "Do not build the kernels of other pools in the background"),
   OPT_WITHOUT_ARG("--no-pool-disable",
       opt_set_invbool, &opt_disable_pool,
       opt_hidden),
@@ -1747,6 +1850,9 @@ struct opt_table opt_config_table[] = {
   OPT_WITH_ARG("--state|--pool-state",
       set_pool_state, NULL, NULL,
       "Specify pool state at startup (default: enabled)"),
+  OPT_WITH_ARG("--switcher-cache",
+      set_int_0_to_9999, opt_show_intval, &opt_switcher_cache,
+      "Number of other algorithms each GPU thread keeps initialised for fast switching"),
   OPT_WITH_ARG("--switcher-mode",
       set_switcher_mode, NULL, NULL,
       "Algorithm/gpu settings switcher mode."),
@@ -1755,6 +1861,9 @@ struct opt_table opt_config_table[] = {
       opt_set_bool, &use_syslog,
       "Use system log for output messages (default: standard error)"),
 #endif
+  OPT_WITH_ARG("--table-placement",
+      set_table_placement, NULL, NULL,
+      "Set lookup table placement for AES, Groestl and Whirlpool kernels: default|constant|local|compact"),
 #if defined(HAVE_LIBCURL) && defined(CURL_HAS_KEEPALIVE)
   OPT_WITH_ARG("--tcp-keepalive",
       set_int_0_to_9999, opt_show_intval, &opt_tcp_keepalive,
@@ -2277,6 +2386,9 @@ static bool getwork_decode(json_t *res_val, struct work *work)
       if (work->pool->algorithm.calc_midstate) work->pool->algorithm.calc_midstate(work);
     }
   }
+  else if (work->pool->algorithm.calc_midstate) {
+    work->pool->algorithm.calc_midstate(work);
+  }
 
   if (unlikely(!jobj_binary(res_val, "target", work->target, sizeof(work->target), true))) {
     if (opt_morenotices)
@@ -3749,19 +3861,13 @@ static void roll_work(struct work *work)
   work->id = total_work++;
 }
 
-static void *submit_work_thread(void *userdata)
+static void submit_work_task(void *userdata)
 {
   struct work *work = (struct work *)userdata;
   struct pool *pool = work->pool;
   bool resubmit = false;
   struct curl_ent *ce;
 
-  pthread_detach(pthread_self());
-
-  RenameThread("SubmitWork");
-
-  applog(LOG_DEBUG, "Creating extra submit work thread");
-
   ce = pop_curl_entry(pool);
   /* submit solution to bitcoin via JSON-RPC */
   while (!submit_upstream_work(work, ce->curl, ce->curl_err_str, resubmit)) {
@@ -3788,8 +3894,6 @@ static void *submit_work_thread(void *userdata)
     applog(LOG_INFO, "json_rpc_call failed on submit_work, retrying");
   }
   push_curl_entry(ce, pool);
-
-  return NULL;
 }
 
 static struct work *make_clone(struct work *work)
@@ -3880,10 +3984,8 @@ static struct work *clone_work(struct work *work)
 }
 
 #else /* HAVE_LIBCURL */
-static void *submit_work_thread(void __maybe_unused *userdata)
+static void submit_work_task(void __maybe_unused *userdata)
 {
-  pthread_detach(pthread_self());
-  return NULL;
 }
 #endif /* HAVE_LIBCURL */
 
@@ -3980,7 +4082,9 @@ static bool stale_work(struct work *work, bool share)
   struct pool *pool;
   int getwork_delay;
 
-  if (work->work_block != work_block) {
+  /* Blocks on the dual pool's chain are tracked through its stratum job_id
+   * only, so a block change on the primary chain doesn't affect it */
+  if (work->work_block != work_block && work->pool != dual_pool()) {
     applog(LOG_DEBUG, "Work stale due to block mismatch");
     return true;
   }
@@ -4029,7 +4133,8 @@ static bool stale_work(struct work *work, bool share)
     return true;
   }
 
-  if (opt_fail_only && !share && pool != current_pool() && !work->mandatory &&
+  /* The dual pool is mined alongside the current pool, never instead of it */
+  if (opt_fail_only && !share && pool != current_pool() && pool != dual_pool() && !work->mandatory &&
       pool_strategy != POOL_LOADBALANCE && pool_strategy != POOL_BALANCE) {
     applog(LOG_DEBUG, "Work stale due to fail only pool mismatch");
     return true;
@@ -4097,6 +4202,9 @@ static bool pool_unusable(struct pool *pool)
 {
   if (pool->idle)
     return true;
+  /* The dual pool has its own threads and is never switched to */
+  if (pool == dual_pool())
+    return true;
   if (pool->state != POOL_ENABLED)
     return true;
   return false;
@@ -4279,6 +4387,12 @@ static void *restart_thread(void __maybe_unused *arg)
         continue;
       if (cgpu->deven != DEV_ENABLED)
         continue;
+      /* Dual threads only restart on their own pool's new blocks */
+      if (mining_thr[i]->dual)
+        continue;
+      mutex_lock(&stats_lock);
+      cgtime(&mining_thr[i]->tv_restart);
+      mutex_unlock(&stats_lock);
       mining_thr[i]->work_restart = true;
       cgpu->drv->flush_work(cgpu);
     }
@@ -4292,6 +4406,29 @@ static void *restart_thread(void __maybe_unused *arg)
   return NULL;
 }
 
+/* Called by drivers just before they launch work on the device. Measures
+ * how long new work took to get there after a work restart, i.e. the
+ * hashing lost to the previous block. Work begun before the restart is
+ * still the old block's and doesn't count. */
+void work_launched(struct thr_info *thr, struct work *work)
+{
+  struct cgpu_info *cgpu = thr->cgpu;
+  struct timeval now;
+  double secs;
+
+  mutex_lock(&stats_lock);
+  if (unlikely(thr->tv_restart.tv_sec) && !time_less(&work->tv_work_start, &thr->tv_restart)) {
+    cgtime(&now);
+    secs = tdiff(&now, &thr->tv_restart);
+    thr->tv_restart.tv_sec = 0;
+    cgpu->new_work_restarts++;
+    cgpu->new_work_time += (secs - cgpu->new_work_time) / cgpu->new_work_restarts;
+    if (secs > cgpu->new_work_time_max)
+      cgpu->new_work_time_max = secs;
+  }
+  mutex_unlock(&stats_lock);
+}
+
 /* In order to prevent a deadlock via the various drv->flush_work
  * implementations we send the restart messages via a separate thread. */
 static void restart_threads(void)
@@ -4302,6 +4439,31 @@ static void restart_threads(void)
     quit(1, "Failed to create restart thread");
 }
 
+/* Abort the work of the threads mining the dual pool when it moves to a new
+ * block, leaving the threads on the current pool untouched. */
+static void restart_dual_threads(void)
+{
+  struct cgpu_info *cgpu;
+  int i;
+
+  if (!mining_thr)
+    return;
+
+  rd_lock(&mining_thr_lock);
+  for (i = 0; i < mining_threads; i++) {
+    if (!mining_thr[i]->dual)
+      continue;
+    cgpu = mining_thr[i]->cgpu;
+    if (unlikely(!cgpu) || cgpu->deven != DEV_ENABLED)
+      continue;
+    mutex_lock(&stats_lock);
+    cgtime(&mining_thr[i]->tv_restart);
+    mutex_unlock(&stats_lock);
+    mining_thr[i]->work_restart = true;
+  }
+  rd_unlock(&mining_thr_lock);
+}
+
 static void signal_work_update(void)
 {
   int i;
@@ -4636,6 +4798,10 @@ void zero_stats(void)
     cgpu->diff_accepted = 0;
     cgpu->diff_rejected = 0;
     cgpu->last_share_diff = 0;
+    cgpu->new_work_time = 0;
+    cgpu->new_work_time_max = 0;
+    cgpu->new_work_restarts = 0;
+    cgpu->result_overflows = 0;
     mutex_unlock(&hash_lock);
 
     /* Don't take any locks in the driver zero stats function, as
@@ -5406,6 +5572,10 @@ static bool cnx_needed(struct pool *pool)
   if (pool->has_stratum && pool->idle)
     return true;
 
+  /* The dual pool is mined all the time alongside the current pool */
+  if (pool == dual_pool())
+    return true;
+
   /* Getwork pools without opt_fail_only need backup pools up to be able
    * to leak shares */
   cp = current_pool();
@@ -5548,6 +5718,13 @@ static void *stratum_rthread(void *userdata)
 
     if (!parse_method(pool, s) && !parse_stratum_response(pool, s))
       applog(LOG_INFO, "Unknown stratum msg: %s", s);
+    else if (pool->swork.clean && pool == dual_pool()) {
+      /* The dual pool mines a different chain so its blocks must not
+       * enter the block database of the current pool */
+      pool->swork.clean = false;
+      applog(LOG_DEBUG, "Dual pool %s has new work, restarting dual threads", get_pool_name(pool));
+      restart_dual_threads();
+    }
     else if (pool->swork.clean) {
       struct work *work = make_work();
 
@@ -6603,74 +6780,9 @@ static void apply_switcher_options(unsigned long options, struct pool *pool)
     }
   }
 
-  //lookup gap
-  if(opt_isset(options, SWITCHER_APPLY_LG))
-  {
-    if(!empty_string((opt = get_pool_setting(pool->lookup_gap, default_profile.lookup_gap))))
-      set_lookup_gap((char *)opt);
-  }
-
-  //raw intensity from pool
-  if(opt_isset(options, SWITCHER_APPLY_RAWINT))
-  {
-    applog(LOG_DEBUG, "Switching to rawintensity: pool = %s, default = %s", pool->rawintensity, default_profile.rawintensity);
-    opt = get_pool_setting(pool->rawintensity, default_profile.rawintensity);
-    applog(LOG_DEBUG, "rawintensity -> %s", opt);
-    set_rawintensity(opt);
-  }
-  //xintensity
-  else if(opt_isset(options, SWITCHER_APPLY_XINT))
-  {
-    applog(LOG_DEBUG, "Switching to xintensity: pool = %s, default = %s", pool->xintensity, default_profile.xintensity);
-    opt = get_pool_setting(pool->xintensity, default_profile.xintensity);
-    applog(LOG_DEBUG, "xintensity -> %s", opt);
-    set_xintensity(opt);
-  }
-  //intensity
-  else if(opt_isset(options, SWITCHER_APPLY_INT))
-  {
-    applog(LOG_DEBUG, "Switching to intensity: pool = %s, default = %s", pool->intensity, default_profile.intensity);
-    opt = get_pool_setting(pool->intensity, default_profile.intensity);
-    applog(LOG_DEBUG, "intensity -> %s", opt);
-    set_intensity(opt);
-  }
-  //default basic intensity
-  else if(opt_isset(options, SWITCHER_APPLY_INT8))
-  {
-    default_profile.intensity = strdup("8");
-    set_intensity(default_profile.intensity);
-  }
-
-  //shaders
-  if(opt_isset(options, SWITCHER_APPLY_SHADER))
-  {
-    if(!empty_string((opt = get_pool_setting(pool->shaders, default_profile.shaders))))
-      set_shaders((char *)opt);
-  }
-
-  //thread-concurrency
-  if(opt_isset(options, SWITCHER_APPLY_TC))
-  {
-    // neoscrypt - if not specified set TC to 0 so that TC will be calculated by intensity settings
-    if (pool->algorithm.type == ALGO_NEOSCRYPT) {
-      opt = ((empty_string(pool->thread_concurrency))?"0":get_pool_setting(pool->thread_concurrency, default_profile.thread_concurrency));
-    }
-    // otherwise use pool/profile setting or default to default profile setting
-    else {
-      opt = get_pool_setting(pool->thread_concurrency, default_profile.thread_concurrency);
-    }
-
-    if(!empty_string(opt)) {
-      set_thread_concurrency((char *)opt);
-    }
-  }
-
-  //worksize
-  if(opt_isset(options, SWITCHER_APPLY_WORKSIZE))
-  {
-    if(!empty_string((opt = get_pool_setting(pool->worksize, default_profile.worksize))))
-      set_worksize(opt);
-  }
+  //lookup gap, intensity, shaders, thread-concurrency and worksize
+  for (i = 0; i < MAX_GPUDEVICES; i++)
+    apply_pool_gpu_settings(pool, options, i, &gpus[i]);
 
   #ifdef HAVE_ADL
     //GPU clock
@@ -6739,6 +6851,10 @@ static void get_work_prepare_thread(struct thr_info *mythr, struct work *work)
   if(opt_switchmode == SWITCH_OFF)
     return;
 
+  //dual threads stay on the dual pool's algorithm
+  if(mythr->dual)
+    return;
+
   pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
   mutex_lock(&algo_switch_lock);
 
@@ -6769,7 +6885,8 @@ static void get_work_prepare_thread(struct thr_info *mythr, struct work *work)
           for (i = 0; i < mining_threads; i++)
           {
             struct thr_info *thr = mining_thr[i];
-            thr->pool_no = work->pool->pool_no;
+            if(!thr->dual)
+              thr->pool_no = work->pool->pool_no;
           }
 
           rd_unlock(&mining_thr_lock);
@@ -6797,6 +6914,10 @@ static void get_work_prepare_thread(struct thr_info *mythr, struct work *work)
   {
     struct cgpu_info *cgpu = mining_thr[i]->cgpu;
 
+    //dual threads never wait on the switcher
+    if(mining_thr[i]->dual)
+      continue;
+
     //dont count dead/sick GPU threads or we may wait for ever also...
     if(cgpu->deven != DEV_DISABLED && cgpu->status != LIFE_SICK && cgpu->status != LIFE_DEAD)
       active_threads++;
@@ -6811,13 +6932,15 @@ static void get_work_prepare_thread(struct thr_info *mythr, struct work *work)
     applog(LOG_DEBUG, "Applying pool settings for %s...", isnull(get_pool_name(work->pool), ""));
     rd_lock(&mining_thr_lock);
 
-    // Shutdown all threads first (necessary)
+    // Shutdown all threads first (necessary), unless their driver can switch them in place
     if(opt_isset(pool_switch_options, SWITCHER_SOFT_RESET))
     {
       applog(LOG_DEBUG, "Soft Reset... Shutdown threads...");
       for (i = 0; i < mining_threads; i++)
       {
         struct thr_info *thr = mining_thr[i];
+        if(thr->dual || thr->cgpu->drv->thread_switch)
+          continue;
         thr->cgpu->drv->thread_shutdown(thr);
       }
     }
@@ -6967,11 +7090,20 @@ static void get_work_prepare_thread(struct thr_info *mythr, struct work *work)
     if(opt_isset(pool_switch_options, SWITCHER_SOFT_RESET))
       applog(LOG_DEBUG, "Soft Reset... Restarting threads...");
 
-    struct thr_info *thr;
+    struct thr_info *thr, **reset_thr, **switch_thr;
+    int n_reset = 0, n_switch = 0;
+
+    reset_thr = (struct thr_info **)calloc(mining_threads, sizeof(thr));
+    switch_thr = (struct thr_info **)calloc(mining_threads, sizeof(thr));
+    if (unlikely(!reset_thr || !switch_thr))
+      quit(1, "Failed to calloc reset_thr");
 
     for (i = 0; i < mining_threads; i++)
     {
       thr = mining_thr[i];
+      if(thr->dual)
+        continue;
+
       thr->pool_no = work->pool->pool_no; //set thread on new pool
 
       //apply new algorithm if set
@@ -6980,14 +7112,24 @@ static void get_work_prepare_thread(struct thr_info *mythr, struct work *work)
 
       if(opt_isset(pool_switch_options, SWITCHER_SOFT_RESET))
       {
-        thr->cgpu->drv->thread_prepare(thr);
-        thr->cgpu->drv->thread_init(thr);
+        if(thr->cgpu->drv->thread_switch)
+          switch_thr[n_switch++] = thr;
+        else
+          reset_thr[n_reset++] = thr;
       }
 
       // Necessary because algorithms can have dramatically different diffs
       thr->cgpu->drv->working_diff = 1;
     }
 
+    // Switch or rebuild the kernels of all threads at once, then restart them
+    prepare_mining_threads(switch_thr, n_switch, true);
+    prepare_mining_threads(reset_thr, n_reset, false);
+    for (i = 0; i < n_reset; i++)
+      reset_thr[i]->cgpu->drv->thread_init(reset_thr[i]);
+    free(switch_thr);
+    free(reset_thr);
+
     rd_unlock(&mining_thr_lock);
     mutex_unlock(&algo_switch_lock);
 
@@ -7063,14 +7205,84 @@ static void get_work_prepare_thread(struct thr_info *mythr, struct work *work)
   pthread_cleanup_pop(1);
 }
 
+/* The dual pool stays mined while its connection is down, but not once it
+ * has been disabled or removed */
+static bool dual_pool_usable(struct pool *pool)
+{
+  return pool && !pool->removed && pool->state == POOL_ENABLED;
+}
+
+/* Dual threads generate their work directly from the dual pool's stratum
+ * job rather than from the staged queue of the current pool. Returns NULL
+ * when the wait for a job is cut short by a restart, a shutdown or the
+ * pool becoming unusable. */
+static struct work *get_dual_work(struct thr_info *thr, const int thr_id, struct pool *pool)
+{
+  struct work *work;
+
+  applog(LOG_DEBUG, "[THR%d] Generating work from dual pool %s", thr_id, get_pool_name(pool));
+  while (!pool->stratum_active || !pool->stratum_notify) {
+    if (thr->work_restart || thr->cgpu->shutdown || !dual_pool_usable(pool))
+      return NULL;
+    cgsleep_ms(100);
+  }
+
+  work = make_work();
+  work->thr_id = thr_id;
+  gen_stratum_work(pool, work);
+  pool->works++;
+  thr->pool_no = pool->pool_no;
+
+  return work;
+}
+
+/* A dual thread that fell back to the current pool goes back to the dual
+ * pool once it is usable and connected again. Not while an algorithm
+ * switch is gathering threads, which counts the dual threads out. */
+static void resume_dual_thread(struct thr_info *thr, const int thr_id)
+{
+  struct pool *dpool = dual_pool();
+
+  if (thr->dual || !thr->dual_thread || !dual_pool_usable(dpool) || !dpool->stratum_active)
+    return;
+
+  mutex_lock(&algo_switch_lock);
+  if (algo_switch_n == 0) {
+    applog(LOG_NOTICE, "[THR%d] Dual pool available again, mining it", thr_id);
+    thr->dual = true;
+    thr->pool_no = dpool->pool_no;
+  }
+  mutex_unlock(&algo_switch_lock);
+
+  if (thr->dual && thr->cgpu->drv->thread_switch && !thr->cgpu->drv->thread_switch(thr))
+    applog(LOG_ERR, "thread_switch failed for thread %d", thr_id);
+}
+
 struct work *get_work(struct thr_info *thr, const int thr_id)
 {
   struct work *work = NULL;
+  struct pool *dpool;
   time_t diff_t;
 
   thread_reportout(thr);
-  applog(LOG_DEBUG, "[THR%d] Popping work from get queue to get work", thr_id);
   diff_t = time(NULL);
+  resume_dual_thread(thr, thr_id);
+  while (thr->dual && !work && !thr->cgpu->shutdown) {
+    dpool = dual_pool();
+    if (!dual_pool_usable(dpool)) {
+      /* Fall back to the current pool with the device's algorithm */
+      applog(LOG_NOTICE, "[THR%d] Dual pool unavailable, mining the current pool instead", thr_id);
+      thr->dual = false;
+      thr->pool_no = current_pool()->pool_no;
+      if (thr->cgpu->drv->thread_switch && !thr->cgpu->drv->thread_switch(thr))
+        applog(LOG_ERR, "thread_switch failed for thread %d", thr_id);
+      break;
+    }
+    if (!(work = get_dual_work(thr, thr_id, dpool)))
+      thr->work_restart = false;
+  }
+  if (!work)
+    applog(LOG_DEBUG, "[THR%d] Popping work from get queue to get work", thr_id);
   while (!work) {
     work = hash_pop(true);
     if (stale_work(work, false)) {
@@ -7105,7 +7317,6 @@ struct work *get_work(struct thr_info *thr, const int thr_id)
 static void submit_work_async(struct work *work)
 {
   struct pool *pool = work->pool;
-  pthread_t submit_thread;
 
   cgtime(&work->tv_work_found);
 
@@ -7138,9 +7349,8 @@ static void submit_work_async(struct work *work)
       free_work(work);
     }
   } else {
-    applog(LOG_DEBUG, "Pushing submit work to work thread");
-    if (unlikely(pthread_create(&submit_thread, NULL, submit_work_thread, (void *)work)))
-      quit(1, "Failed to create submit_work_thread");
+    applog(LOG_DEBUG, "Queueing submit work task");
+    queue_task(TASK_SUBMIT, submit_work_task, (void *)work);
   }
 }
 
@@ -7157,8 +7367,8 @@ void inc_hw_errors(struct thr_info *thr)
   thr->cgpu->drv->hw_error(thr);
 }
 
-/* Fills in the work nonce and builds the output data in work->hash */
-static void rebuild_nonce(struct work *work, uint32_t nonce)
+/* Fills in the work nonce */
+static void set_work_nonce(struct work *work, uint32_t nonce)
 {
   uint32_t nonce_pos = 76;
   if (work->pool->algorithm.type == ALGO_CRE) nonce_pos = 140;
@@ -7169,18 +7379,22 @@ static void rebuild_nonce(struct work *work, uint32_t nonce)
   uint32_t *work_nonce = (uint32_t *)(work->data + nonce_pos);
 
   *work_nonce = htole32(nonce);
+}
+
+/* Fills in the work nonce and builds the output data in work->hash */
+static void rebuild_nonce(struct work *work, uint32_t nonce)
+{
+  set_work_nonce(work, nonce);
 
   work->pool->algorithm.regenhash(work);
 }
 
-/* For testing a nonce against diff 1 */
-bool test_nonce(struct work *work, uint32_t nonce)
+/* Whether the hash in work->hash meets diff 1 */
+static bool hash_meets_diff1(struct work *work)
 {
   uint32_t *hash_32 = (uint32_t *)(work->hash + 28);
   uint32_t diff1targ;
 
-  rebuild_nonce(work, nonce);
-
   // for Neoscrypt, the diff1targ value is in work->target
   if (work->pool->algorithm.type == ALGO_NEOSCRYPT || work->pool->algorithm.type == ALGO_PLUCK
     || work->pool->algorithm.type == ALGO_YESCRYPT || work->pool->algorithm.type == ALGO_YESCRYPT_MULTI) {
@@ -7193,6 +7407,14 @@ bool test_nonce(struct work *work, uint32_t nonce)
   return (le32toh(*hash_32) <= diff1targ);
 }
 
+/* For testing a nonce against diff 1 */
+bool test_nonce(struct work *work, uint32_t nonce)
+{
+  rebuild_nonce(work, nonce);
+
+  return hash_meets_diff1(work);
+}
+
 static void update_work_stats(struct thr_info *thr, struct work *work)
 {
   double test_diff = current_diff;
@@ -7246,6 +7468,42 @@ bool submit_nonce(struct thr_info *thr, struct work *work, uint32_t nonce)
   return false;
 }
 
+/* submit_nonce for every nonce found in one work item.  Algorithms with a
+ * regenhash_batch hash them together; returns the number of valid shares */
+unsigned int submit_nonces(struct thr_info *thr, struct work *work, const uint32_t *nonces, unsigned int count)
+{
+  unsigned char (*hashes)[32] = NULL;
+  unsigned int i, valid = 0;
+
+  if (work->pool->algorithm.regenhash_batch && count > 1)
+    hashes = (unsigned char (*)[32])malloc(count * sizeof(*hashes));
+
+  if (!hashes) {
+    for (i = 0; i < count; i++) {
+      if (submit_nonce(thr, work, nonces[i]))
+        valid++;
+    }
+    return valid;
+  }
+
+  work->pool->algorithm.regenhash_batch(work, nonces, count, hashes);
+
+  for (i = 0; i < count; i++) {
+    set_work_nonce(work, nonces[i]);
+    memcpy(work->hash, hashes[i], sizeof(hashes[i]));
+
+    if (hash_meets_diff1(work)) {
+      submit_tested_work(thr, work);
+      valid++;
+    }
+    else
+      inc_hw_errors(thr);
+  }
+
+  free(hashes);
+  return valid;
+}
+
 static inline bool abandon_work(struct work *work, struct timeval *wdiff, uint64_t hashes)
 {
   if (wdiff->tv_sec > opt_scantime ||
@@ -7256,6 +7514,64 @@ static inline bool abandon_work(struct work *work, struct timeval *wdiff, uint64
   return false;
 }
 
+/* Only algorithms with a standard header keep a big endian ntime in the
+ * 18th word of work->data */
+static inline bool work_ntime_rollable(struct work *work)
+{
+  switch (work->pool->algorithm.type) {
+    case ALGO_NEOSCRYPT:
+    case ALGO_DECRED:
+    case ALGO_SIA:
+    case ALGO_LBRY:
+    case ALGO_CRE:
+      return false;
+    default:
+      return work->stratum;
+  }
+}
+
+/* Once a device has exhausted the nonce range of a stratum work item, roll
+ * its ntime within drv_rolllimit and start the nonce range again rather
+ * than going back to the scheduler for freshly generated work. */
+static bool roll_exhausted_work(struct thr_info *mythr, struct work *work, struct timeval *wdiff, uint64_t hashes)
+{
+  uint32_t ntime;
+  char *ntime_hex;
+
+  if (work->drv_rolllimit <= 0 || !work_ntime_rollable(work))
+    return false;
+  if (wdiff->tv_sec > opt_scantime || hashes >= 0xfffffffe)
+    return false;
+  if (work->blk.nonce < MAXTHREADS - hashes || mythr->work_restart || stale_work(work, false))
+    return false;
+
+  ntime = be32toh(_get_work_time(work)) + 1;
+  _set_work_time(work, htobe32(ntime));
+
+  /* The submitted ntime must match the one hashed */
+  ntime_hex = offset_ntime(work->ntime, 1);
+  free(work->ntime);
+  work->ntime = ntime_hex;
+
+  work->drv_rolllimit--;
+  work->rolls++;
+  work->blk.nonce = 0;
+  local_work++;
+
+  /* A different work item now, so it needs its own ID for the hashtable */
+  cg_wlock(&control_lock);
+  work->id = total_work++;
+  cg_wunlock(&control_lock);
+
+  if (work->pool->algorithm.calc_midstate)
+    work->pool->algorithm.calc_midstate(work);
+  if (!mythr->cgpu->drv->prepare_work(mythr, work))
+    return false;
+
+  applog(LOG_DEBUG, "[THR%d] Rolled exhausted work ntime to %s", mythr->id, work->ntime);
+  return true;
+}
+
 static void mt_disable(struct thr_info *mythr, const int thr_id,
            struct device_drv *drv)
 {
@@ -7286,6 +7602,7 @@ static void hash_sole_work(struct thr_info *mythr)
   struct timeval diff, sdiff, wdiff = {0, 0};
   uint32_t max_nonce = drv->can_limit_work(mythr);
   int64_t hashes_done = 0;
+  unsigned int sample_works = 0;
 
   tv_end = &getwork_start;
   cgtime(&getwork_start);
@@ -7324,6 +7641,17 @@ static void hash_sole_work(struct thr_info *mythr)
     } else if (drv->working_diff > work->work_difficulty)
       drv->working_diff = work->work_difficulty;
 
+    /* Have the device return only nonces close to the pool target, so
+     * they don't all have to be rehashed and thrown away on the host.
+     * Every opt_device_diff_sample-th work still runs at the working
+     * diff above so hardware errors keep being caught. */
+    if (opt_device_diff_divisor && (!opt_device_diff_sample || ++sample_works % opt_device_diff_sample)) {
+      double device_diff = MIN(drv->max_diff, work->work_difficulty / opt_device_diff_divisor);
+
+      if (device_diff > work->device_diff)
+        work->device_diff = device_diff;
+    }
+
     if (work->pool->algorithm.type == ALGO_NEOSCRYPT) {
       set_target_neoscrypt(work->device_target, work->device_diff, work->thr_id);
     } else {
@@ -7435,7 +7763,8 @@ static void hash_sole_work(struct thr_info *mythr)
         mt_disable(mythr, thr_id, drv);
 
       sdiff.tv_sec = sdiff.tv_usec = 0;
-    } while (!abandon_work(work, &wdiff, cgpu->max_hashes));
+    } while (!abandon_work(work, &wdiff, cgpu->max_hashes) ||
+             roll_exhausted_work(mythr, work, &wdiff, cgpu->max_hashes));
     free_work(work);
   }
   cgpu->deven = DEV_DISABLED;
@@ -7782,12 +8111,10 @@ static void *watchpool_thread(void __maybe_unused *userdata)
         continue;
       }
 
-      /* Don't start testing any pools if the test threads
-       * from startup are still doing their first attempt. */
-      if (unlikely(pool->testing)) {
-        pthread_join(pool->test_thread, NULL);
-        pool->testing = false;
-      }
+      /* Don't test a pool whose first test from startup or
+       * from being added is still running. */
+      if (unlikely(pool->testing))
+        continue;
 
       /* Test pool is idle once every minute */
       if (pool->idle && now.tv_sec - pool->tv_idle.tv_sec > 30) {
@@ -8162,7 +8489,7 @@ char *curses_input(const char *query)
 
 static bool pools_active = false;
 
-static void *test_pool_thread(void *arg)
+static void test_pool_task(void *arg)
 {
   struct pool *pool = (struct pool *)arg;
 
@@ -8189,7 +8516,7 @@ static void *test_pool_thread(void *arg)
     pool_died(pool);
   }
 
-  return NULL;
+  pool->testing = false;
 }
 
 /* Always returns true that the pool details were added unless we are not
@@ -8231,12 +8558,11 @@ bool add_pool_details(struct pool *pool, bool live, char *url, char *user, char
   pool->idle = true;
   enable_pool(pool);
 
-  pthread_create(&pool->test_thread, NULL, test_pool_thread, (void *)pool);
   if (!live) {
-    pthread_join(pool->test_thread, NULL);
-    pool->testing = false;
+    test_pool_task((void *)pool);
     return pools_active;
   }
+  queue_task(TASK_HOUSEKEEPING, test_pool_task, (void *)pool);
   return true;
 }
 
@@ -8572,14 +8898,178 @@ static void probe_pools(void)
     struct pool *pool = pools[i];
 
     pool->testing = true;
-    pthread_create(&pool->test_thread, NULL, test_pool_thread, (void *)pool);
+    queue_task(TASK_HOUSEKEEPING, test_pool_task, (void *)pool);
+  }
+}
+
+/* Build the kernels of every configured pool, one at a time and at low
+ * priority, so that switching to another algorithm later only has to load
+ * cached binaries */
+static void *precompile_thread(void __maybe_unused *userdata)
+{
+  struct pool **list;
+  int i, count, failed = 0;
+
+  pthread_detach(pthread_self());
+  RenameThread("Precompile");
+  set_lowprio();
+
+  /* The builds take long, work on a copy of the pool list. Pools are
+   * only ever marked removed, never freed. */
+  cg_rlock(&control_lock);
+  count = total_pools;
+  list = (struct pool **)malloc(sizeof(struct pool *) * (count ? count : 1));
+  if (list)
+    memcpy(list, pools, sizeof(struct pool *) * count);
+  cg_runlock(&control_lock);
+
+  if (unlikely(!list)) {
+    applog(LOG_ERR, "Failed to malloc pool list in precompile_thread");
+    return NULL;
+  }
+
+  for (i = 0; i < count; i++) {
+    struct pool *pool = list[i];
+
+    if (pool->removed)
+      continue;
+    failed += precompile_pool_kernels(pool, compare_pool_settings(NULL, pool));
+  }
+  free(list);
+
+  applog(LOG_INFO, "Background kernel builds finished, %d failed", failed);
+  return NULL;
+}
+
+/* A pool that is never connected to, used to build the kernels of a
+ * profile or algorithm with the same settings a real pool would get */
+static struct pool *compile_pool(const char *profile, const char *algorithm)
+{
+  struct pool *pool = (struct pool *)calloc(1, sizeof(struct pool));
+
+  if (unlikely(!pool))
+    quit(1, "Failed to calloc pool in compile_pool");
+
+  pool->pool_no = -1;
+  pool->profile = strdup(isnull(profile, ""));
+  if (algorithm)
+    set_algorithm(&pool->algorithm, algorithm);
+  apply_pool_profile(pool);
+
+  return pool;
+}
+
+/* --compile-only: build the binaries initCl would build for every pool,
+ * every profile and every --compile-algorithm on the enabled GPUs, into
+ * the kernel cache, and exit */
+static void compile_only(void)
+{
+  struct pool *pool;
+  char *algorithms, *nextptr;
+  int i, failed = 0;
+
+  for (i = 0; i < total_pools; i++) {
+    applog(LOG_NOTICE, "Building kernels for pool %d (%s)", i, pools[i]->algorithm.name);
+    failed += precompile_pool_kernels(pools[i], compare_pool_settings(NULL, pools[i]));
+  }
+
+  for (i = 0; i < total_profiles; i++) {
+    if (profiles[i]->removed)
+      continue;
+    pool = compile_pool(profiles[i]->name, NULL);
+    applog(LOG_NOTICE, "Building kernels for profile %s (%s)", profiles[i]->name, pool->algorithm.name);
+    failed += precompile_pool_kernels(pool, compare_pool_settings(NULL, pool));
+    free(pool->profile);
+    free(pool);
   }
+
+  if (!empty_string(opt_compile_algorithms)) {
+    algorithms = strdup(opt_compile_algorithms);
+    for (nextptr = strtok(algorithms, ","); nextptr; nextptr = strtok(NULL, ",")) {
+      pool = compile_pool(NULL, nextptr);
+      applog(LOG_NOTICE, "Building kernels for algorithm %s", pool->algorithm.name);
+      failed += precompile_pool_kernels(pool, compare_pool_settings(NULL, pool));
+      free(pool->profile);
+      free(pool);
+    }
+    free(algorithms);
+  }
+
+  if (failed)
+    quit(1, "%d kernel binaries failed to build", failed);
+  quit(0, "All kernel binaries built%s%s", (opt_kernel_cache ? " in " : ""), isnull(opt_kernel_cache, ""));
+}
+
+struct prepare_device_data {
+  struct cgpu_info *cgpu;
+  struct thr_info **thrs;
+  int count;
+  bool do_switch;
+  pthread_t pth;
+  bool started;
+};
+
+static void *prepare_device_thread(void *userdata)
+{
+  struct prepare_device_data *data = (struct prepare_device_data *)userdata;
+  struct thr_info *thr;
+  int i;
+
+  for (i = 0; i < data->count; i++) {
+    thr = data->thrs[i];
+    if (thr->cgpu != data->cgpu)
+      continue;
+    if (data->do_switch) {
+      if (!thr->cgpu->drv->thread_switch(thr))
+        applog(LOG_ERR, "thread_switch failed for thread %d", thr->id);
+    }
+    else if (!thr->cgpu->drv->thread_prepare(thr))
+      applog(LOG_ERR, "thread_prepare failed for thread %d", thr->id);
+  }
+  return NULL;
+}
+
+/* Call thread_prepare, or thread_switch if do_switch is set, for count
+ * mining threads, one device per helper thread, so that kernel builds for
+ * different devices overlap. Threads of the same device share its settings
+ * and are prepared in order. The OpenCL driver builds each distinct binary
+ * only once and limits how many builds run at a time. */
+static void prepare_mining_threads(struct thr_info **thrs, int count, bool do_switch)
+{
+  struct prepare_device_data *data;
+  int i, j, n = 0;
+
+  data = (struct prepare_device_data *)calloc(count ? count : 1, sizeof(struct prepare_device_data));
+  if (unlikely(!data))
+    quit(1, "Failed to calloc prepare_device_data");
+
+  for (i = 0; i < count; i++) {
+    for (j = 0; j < n && data[j].cgpu != thrs[i]->cgpu; j++);
+    if (j < n)
+      continue;
+
+    data[n].cgpu = thrs[i]->cgpu;
+    data[n].thrs = thrs;
+    data[n].count = count;
+    data[n].do_switch = do_switch;
+    data[n].started = !pthread_create(&data[n].pth, NULL, prepare_device_thread, &data[n]);
+    if (!data[n].started)
+      prepare_device_thread(&data[n]);
+    n++;
+  }
+
+  for (j = 0; j < n; j++)
+    if (data[j].started)
+      pthread_join(data[j].pth, NULL);
+
+  free(data);
 }
 
 static void restart_mining_threads(unsigned int new_n_threads)
 {
   struct thr_info *thr;
   unsigned int i, j, k;
+  int dual_threads;
 
   // Stop and free threads
   if (mining_thr)
@@ -8668,6 +9158,12 @@ static void restart_mining_threads(unsigned int new_n_threads)
       continue;
     }
 
+    /* At least one thread of each device keeps mining the current pool */
+    dual_threads = (dual_pool() != NULL) ? MIN(cgpu->dual_threads, cgpu->threads - 1) : 0;
+    if (dual_pool() != NULL && dual_threads < cgpu->dual_threads)
+      applog(LOG_WARNING, "%s%d: only %d of its %d threads can mine the dual pool",
+        cgpu->drv->name, cgpu->device_id, dual_threads, cgpu->threads);
+
     applog(LOG_DEBUG, "Assign threads for device %d", i);
     for (j = 0; j < cgpu->threads; ++j, ++k)
     {
@@ -8677,16 +9173,16 @@ static void restart_mining_threads(unsigned int new_n_threads)
       applog(LOG_DEBUG, "Thread %d set pool = %d (%s)", k, thr->pool_no, isnull(get_pool_name(pools[thr->pool_no]), ""));
       thr->cgpu = cgpu;
       thr->device_thread = j;
+      /* The last dual_threads threads of each device mine the dual pool */
+      thr->dual = thr->dual_thread = ((int)j >= cgpu->threads - dual_threads);
+      if (thr->dual)
+        thr->pool_no = opt_dual_pool;
 
       cgtime(&thr->last);
       cgpu->thr[j] = thr;
-
-      if (!cgpu->drv->thread_prepare(thr)) {
-        applog(LOG_ERR, "thread_prepare failed for thread %d", thr->id);
-        continue;
-      }
     }
   }
+  prepare_mining_threads(mining_thr, k, false);
   rd_unlock(&devices_lock);
   wr_unlock(&mining_thr_lock);
 
@@ -8863,7 +9359,7 @@ int main(int argc, char *argv[])
   load_default_profile();
 
 #ifdef HAVE_CURSES
-  if (opt_realquiet || opt_display_devs)
+  if (opt_realquiet || opt_display_devs || opt_compile_only)
     use_curses = false;
 
   if (use_curses)
@@ -8950,6 +9446,9 @@ int main(int argc, char *argv[])
     most_devices = total_devices;
   }
 
+  if (opt_compile_only)
+    compile_only();
+
 #ifdef HAVE_CURSES
   adj_width(mining_threads, &dev_width);
 #endif
@@ -9002,6 +9501,12 @@ int main(int argc, char *argv[])
       snprintf(pool->rpc_userpass, siz, "%s:%s", pool->rpc_user, pool->rpc_pass);
     }
   }
+  /* Dual threads only take work from a stratum job */
+  if (opt_dual_pool >= total_pools)
+    quit(1, "Dual pool %d does not exist", opt_dual_pool);
+  if (opt_dual_pool >= 0 && !pools[opt_dual_pool]->has_stratum)
+    quit(1, "Dual pool %s must be a stratum+tcp:// pool", get_pool_name(pools[opt_dual_pool]));
+
   /* Set the currentpool to pool 0 */
   currentpool = pools[0];
 
@@ -9086,6 +9591,13 @@ int main(int argc, char *argv[])
   if(slept >= 60)
     applog(LOG_WARNING, "GPUs did not become initialized in 60 seconds...");
 
+  if (opt_precompile && total_pools > 1) {
+    pthread_t pth;
+
+    if (unlikely(pthread_create(&pth, NULL, precompile_thread, NULL)))
+      applog(LOG_WARNING, "Failed to start background kernel builds");
+  }
+
   rd_lock(&devices_lock);
   total_mhashes_done = 0;
   for (i = 0; i < total_devices; i++) {
@@ -0,0 +1,559 @@
+/*
+ * Four-message BLAKE-512, BMW-512, Keccak-512 and Skein-512; see
+ * sph_4way.h.
+ *
+ * The AVX2 code uses the GCC vector extension: a sph_u64x4 holds one
+ * 64-bit word of each of the four messages, and the arithmetic below is
+ * the scalar round function written once for all four lanes.  The
+ * functions that do it are built for AVX2 with a target attribute, so
+ * the rest of the program keeps its baseline instruction set.
+ *
+ * @file     hash_4way.c
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "sph_4way.h"
+#include "sph_blake.h"
+#include "sph_bmw.h"
+#include "sph_keccak.h"
+#include "sph_skein.h"
+
+/*
+ * Define SPH_4WAY_AVX2 to 0 to always hash the messages one at a time.
+ */
+#if !defined SPH_4WAY_AVX2
+#if (defined __x86_64__ || defined __i386__) \
+	&& ((defined __GNUC__ && __GNUC__ >= 5) || defined __clang__)
+#define SPH_4WAY_AVX2   1
+#else
+#define SPH_4WAY_AVX2   0
+#endif
+#endif
+
+#if SPH_4WAY_AVX2
+
+typedef sph_u64 sph_u64x4 __attribute__ ((vector_size (32)));
+
+#define ROTL4(x, n)   (((x) << (n)) | ((x) >> (64 - (n))))
+#define ROTR4(x, n)   (((x) >> (n)) | ((x) << (64 - (n))))
+
+/* Word i of the four padded blocks, decoded with dec */
+#define LANES(blk, i, dec)   ((sph_u64x4){ \
+		dec((blk)[0] + 8 * (i)), dec((blk)[1] + 8 * (i)), \
+		dec((blk)[2] + 8 * (i)), dec((blk)[3] + 8 * (i)) })
+
+#define STORE_LANES(dst, h, n, enc)   do { \
+		int u_, l_; \
+		for (u_ = 0; u_ < (n); u_ ++) \
+			for (l_ = 0; l_ < 4; l_ ++) \
+				enc((unsigned char *)(dst)[l_] + 8 * u_, \
+					(h)[u_][l_]); \
+	} while (0)
+
+static const sph_u64 blake_iv[8] = {
+	SPH_C64(0x6A09E667F3BCC908), SPH_C64(0xBB67AE8584CAA73B),
+	SPH_C64(0x3C6EF372FE94F82B), SPH_C64(0xA54FF53A5F1D36F1),
+	SPH_C64(0x510E527FADE682D1), SPH_C64(0x9B05688C2B3E6C1F),
+	SPH_C64(0x1F83D9ABFB41BD6B), SPH_C64(0x5BE0CD19137E2179)
+};
+
+static const sph_u64 blake_cb[16] = {
+	SPH_C64(0x243F6A8885A308D3), SPH_C64(0x13198A2E03707344),
+	SPH_C64(0xA4093822299F31D0), SPH_C64(0x082EFA98EC4E6C89),
+	SPH_C64(0x452821E638D01377), SPH_C64(0xBE5466CF34E90C6C),
+	SPH_C64(0xC0AC29B7C97C50DD), SPH_C64(0x3F84D5B5B5470917),
+	SPH_C64(0x9216D5D98979FB1B), SPH_C64(0xD1310BA698DFB5AC),
+	SPH_C64(0x2FFD72DBD01ADFB7), SPH_C64(0xB8E1AFED6A267E96),
+	SPH_C64(0xBA7C9045F12C7F99), SPH_C64(0x24A19947B3916CF7),
+	SPH_C64(0x0801F2E2858EFC16), SPH_C64(0x636920D871574E69)
+};
+
+static const unsigned char blake_sigma[10][16] = {
+	{  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+	{ 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 },
+	{ 11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4 },
+	{  7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8 },
+	{  9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13 },
+	{  2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9 },
+	{ 12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11 },
+	{ 13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10 },
+	{  6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5 },
+	{ 10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13,  0 }
+};
+
+#define BLAKE_G(r, i, a, b, c, d)   do { \
+		unsigned s0_ = blake_sigma[(r) % 10][2 * (i)]; \
+		unsigned s1_ = blake_sigma[(r) % 10][2 * (i) + 1]; \
+		v[a] = v[a] + v[b] + (m[s0_] ^ blake_cb[s1_]); \
+		v[d] = ROTR4(v[d] ^ v[a], 32); \
+		v[c] = v[c] + v[d]; \
+		v[b] = ROTR4(v[b] ^ v[c], 25); \
+		v[a] = v[a] + v[b] + (m[s1_] ^ blake_cb[s0_]); \
+		v[d] = ROTR4(v[d] ^ v[a], 16); \
+		v[c] = v[c] + v[d]; \
+		v[b] = ROTR4(v[b] ^ v[c], 11); \
+	} while (0)
+
+/*
+ * One final block per lane, with the message bit count in t0.
+ */
+__attribute__((target("avx2")))
+static void
+blake512_4way_avx2(void *const dst[4], unsigned char blk[4][128], sph_u64 t0)
+{
+	sph_u64x4 m[16], v[16], h[8];
+	int i, r;
+
+	for (i = 0; i < 16; i ++)
+		m[i] = LANES(blk, i, sph_dec64be);
+	for (i = 0; i < 8; i ++) {
+		h[i] = v[i] = (sph_u64x4){ blake_iv[i], blake_iv[i],
+			blake_iv[i], blake_iv[i] };
+		v[8 + i] = (sph_u64x4){ blake_cb[i], blake_cb[i],
+			blake_cb[i], blake_cb[i] };
+	}
+	v[12] ^= t0;
+	v[13] ^= t0;
+	for (r = 0; r < 16; r ++) {
+		BLAKE_G(r, 0, 0, 4,  8, 12);
+		BLAKE_G(r, 1, 1, 5,  9, 13);
+		BLAKE_G(r, 2, 2, 6, 10, 14);
+		BLAKE_G(r, 3, 3, 7, 11, 15);
+		BLAKE_G(r, 4, 0, 5, 10, 15);
+		BLAKE_G(r, 5, 1, 6, 11, 12);
+		BLAKE_G(r, 6, 2, 7,  8, 13);
+		BLAKE_G(r, 7, 3, 4,  9, 14);
+	}
+	for (i = 0; i < 8; i ++)
+		h[i] ^= v[i] ^ v[8 + i];
+	STORE_LANES(dst, h, 8, sph_enc64be);
+}
+
+#define BMW_S0(x)   (((x) >> 1) ^ ((x) << 3) ^ ROTL4(x,  4) ^ ROTL4(x, 37))
+#define BMW_S1(x)   (((x) >> 1) ^ ((x) << 2) ^ ROTL4(x, 13) ^ ROTL4(x, 43))
+#define BMW_S2(x)   (((x) >> 2) ^ ((x) << 1) ^ ROTL4(x, 19) ^ ROTL4(x, 53))
+#define BMW_S3(x)   (((x) >> 2) ^ ((x) << 2) ^ ROTL4(x, 28) ^ ROTL4(x, 59))
+#define BMW_S4(x)   (((x) >> 1) ^ (x))
+#define BMW_S5(x)   (((x) >> 2) ^ (x))
+
+/* The rotation of message word j in the expansion is j + 1 */
+#define BMW_ROTM(j)   ROTL4(m[(j) & 15], ((j) & 15) + 1)
+
+__attribute__((target("avx2")))
+static void
+bmw512_compress_avx2(const sph_u64x4 m[16], const sph_u64x4 h[16],
+	sph_u64x4 dh[16])
+{
+	sph_u64x4 w[16], q[32], xl, xh;
+	int i;
+
+	for (i = 0; i < 16; i ++)
+		w[i] = m[i] ^ h[i];
+	q[ 0] = BMW_S0(w[ 5] - w[ 7] + w[10] + w[13] + w[14]) + h[ 1];
+	q[ 1] = BMW_S1(w[ 6] - w[ 8] + w[11] + w[14] - w[15]) + h[ 2];
+	q[ 2] = BMW_S2(w[ 0] + w[ 7] + w[ 9] - w[12] + w[15]) + h[ 3];
+	q[ 3] = BMW_S3(w[ 0] - w[ 1] + w[ 8] - w[10] + w[13]) + h[ 4];
+	q[ 4] = BMW_S4(w[ 1] + w[ 2] + w[ 9] - w[11] - w[14]) + h[ 5];
+	q[ 5] = BMW_S0(w[ 3] - w[ 2] + w[10] - w[12] + w[15]) + h[ 6];
+	q[ 6] = BMW_S1(w[ 4] - w[ 0] - w[ 3] - w[11] + w[13]) + h[ 7];
+	q[ 7] = BMW_S2(w[ 1] - w[ 4] - w[ 5] - w[12] - w[14]) + h[ 8];
+	q[ 8] = BMW_S3(w[ 2] - w[ 5] - w[ 6] + w[13] - w[15]) + h[ 9];
+	q[ 9] = BMW_S4(w[ 0] - w[ 3] + w[ 6] - w[ 7] + w[14]) + h[10];
+	q[10] = BMW_S0(w[ 8] - w[ 1] - w[ 4] - w[ 7] + w[15]) + h[11];
+	q[11] = BMW_S1(w[ 8] - w[ 0] - w[ 2] - w[ 5] + w[ 9]) + h[12];
+	q[12] = BMW_S2(w[ 1] + w[ 3] - w[ 6] - w[ 9] + w[10]) + h[13];
+	q[13] = BMW_S3(w[ 2] + w[ 4] + w[ 7] + w[10] + w[11]) + h[14];
+	q[14] = BMW_S4(w[ 3] - w[ 5] + w[ 8] - w[11] - w[12]) + h[15];
+	q[15] = BMW_S0(w[12] - w[ 4] - w[ 6] - w[ 9] + w[13]) + h[ 0];
+
+	for (i = 0; i < 16; i ++) {
+		sph_u64x4 add;
+		sph_u64 k = (sph_u64)(i + 16) * SPH_C64(0x0555555555555555);
+
+		add = (BMW_ROTM(i) + BMW_ROTM(i + 3) - BMW_ROTM(i + 10) + k)
+			^ h[(i + 7) & 15];
+		if (i < 2)
+			q[i + 16] = BMW_S1(q[i]) + BMW_S2(q[i + 1])
+				+ BMW_S3(q[i + 2]) + BMW_S0(q[i + 3])
+				+ BMW_S1(q[i + 4]) + BMW_S2(q[i + 5])
+				+ BMW_S3(q[i + 6]) + BMW_S0(q[i + 7])
+				+ BMW_S1(q[i + 8]) + BMW_S2(q[i + 9])
+				+ BMW_S3(q[i + 10]) + BMW_S0(q[i + 11])
+				+ BMW_S1(q[i + 12]) + BMW_S2(q[i + 13])
+				+ BMW_S3(q[i + 14]) + BMW_S0(q[i + 15]) + add;
+		else
+			q[i + 16] = q[i] + ROTL4(q[i + 1], 5)
+				+ q[i + 2] + ROTL4(q[i + 3], 11)
+				+ q[i + 4] + ROTL4(q[i + 5], 27)
+				+ q[i + 6] + ROTL4(q[i + 7], 32)
+				+ q[i + 8] + ROTL4(q[i + 9], 37)
+				+ q[i + 10] + ROTL4(q[i + 11], 43)
+				+ q[i + 12] + ROTL4(q[i + 13], 53)
+				+ BMW_S4(q[i + 14]) + BMW_S5(q[i + 15]) + add;
+	}
+
+	xl = q[16] ^ q[17] ^ q[18] ^ q[19] ^ q[20] ^ q[21] ^ q[22] ^ q[23];
+	xh = xl ^ q[24] ^ q[25] ^ q[26] ^ q[27] ^ q[28] ^ q[29] ^ q[30] ^ q[31];
+	dh[ 0] = ((xh << 5) ^ (q[16] >> 5) ^ m[ 0]) + (xl ^ q[24] ^ q[ 0]);
+	dh[ 1] = ((xh >> 7) ^ (q[17] << 8) ^ m[ 1]) + (xl ^ q[25] ^ q[ 1]);
+	dh[ 2] = ((xh >> 5) ^ (q[18] << 5) ^ m[ 2]) + (xl ^ q[26] ^ q[ 2]);
+	dh[ 3] = ((xh >> 1) ^ (q[19] << 5) ^ m[ 3]) + (xl ^ q[27] ^ q[ 3]);
+	dh[ 4] = ((xh >> 3) ^ q[20] ^ m[ 4]) + (xl ^ q[28] ^ q[ 4]);
+	dh[ 5] = ((xh << 6) ^ (q[21] >> 6) ^ m[ 5]) + (xl ^ q[29] ^ q[ 5]);
+	dh[ 6] = ((xh >> 4) ^ (q[22] << 6) ^ m[ 6]) + (xl ^ q[30] ^ q[ 6]);
+	dh[ 7] = ((xh >> 11) ^ (q[23] << 2) ^ m[ 7]) + (xl ^ q[31] ^ q[ 7]);
+	dh[ 8] = ROTL4(dh[4],  9) + (xh ^ q[24] ^ m[ 8]) + ((xl << 8) ^ q[23] ^ q[ 8]);
+	dh[ 9] = ROTL4(dh[5], 10) + (xh ^ q[25] ^ m[ 9]) + ((xl >> 6) ^ q[16] ^ q[ 9]);
+	dh[10] = ROTL4(dh[6], 11) + (xh ^ q[26] ^ m[10]) + ((xl << 6) ^ q[17] ^ q[10]);
+	dh[11] = ROTL4(dh[7], 12) + (xh ^ q[27] ^ m[11]) + ((xl << 4) ^ q[18] ^ q[11]);
+	dh[12] = ROTL4(dh[0], 13) + (xh ^ q[28] ^ m[12]) + ((xl >> 3) ^ q[19] ^ q[12]);
+	dh[13] = ROTL4(dh[1], 14) + (xh ^ q[29] ^ m[13]) + ((xl >> 4) ^ q[20] ^ q[13]);
+	dh[14] = ROTL4(dh[2], 15) + (xh ^ q[30] ^ m[14]) + ((xl >> 7) ^ q[21] ^ q[14]);
+	dh[15] = ROTL4(dh[3], 16) + (xh ^ q[31] ^ m[15]) + ((xl >> 2) ^ q[22] ^ q[15]);
+}
+
+/*
+ * One padded block per lane, then the finalization compression.
+ */
+__attribute__((target("avx2")))
+static void
+bmw512_4way_avx2(void *const dst[4], unsigned char blk[4][128])
+{
+	sph_u64x4 m[16], h[16], h1[16], h2[16];
+	int i;
+
+	for (i = 0; i < 16; i ++) {
+		sph_u64 iv = SPH_C64(0x8081828384858687)
+			+ (sph_u64)i * SPH_C64(0x0808080808080808);
+		sph_u64 fin = SPH_C64(0xaaaaaaaaaaaaaaa0) + i;
+
+		m[i] = LANES(blk, i, sph_dec64le);
+		h[i] = (sph_u64x4){ iv, iv, iv, iv };
+		h2[i] = (sph_u64x4){ fin, fin, fin, fin };
+	}
+	bmw512_compress_avx2(m, h, h1);
+	bmw512_compress_avx2(h1, h2, h);
+	STORE_LANES(dst, h + 8, 8, sph_enc64le);
+}
+
+static const sph_u64 keccak_rc[24] = {
+	SPH_C64(0x0000000000000001), SPH_C64(0x0000000000008082),
+	SPH_C64(0x800000000000808A), SPH_C64(0x8000000080008000),
+	SPH_C64(0x000000000000808B), SPH_C64(0x0000000080000001),
+	SPH_C64(0x8000000080008081), SPH_C64(0x8000000000008009),
+	SPH_C64(0x000000000000008A), SPH_C64(0x0000000000000088),
+	SPH_C64(0x0000000080008009), SPH_C64(0x000000008000000A),
+	SPH_C64(0x000000008000808B), SPH_C64(0x800000000000008B),
+	SPH_C64(0x8000000000008089), SPH_C64(0x8000000000008003),
+	SPH_C64(0x8000000000008002), SPH_C64(0x8000000000000080),
+	SPH_C64(0x000000000000800A), SPH_C64(0x800000008000000A),
+	SPH_C64(0x8000000080008081), SPH_C64(0x8000000000008080),
+	SPH_C64(0x0000000080000001), SPH_C64(0x8000000080008008)
+};
+
+/*
+ * rho and pi: lane x + 5 * y is rotated and moves to y + 5 * (2x + 3y)
+ */
+#define KECCAK_RHO_PI   do { \
+		b[ 0] = a[ 0]; \
+		b[10] = ROTL4(a[ 1],  1); \
+		b[20] = ROTL4(a[ 2], 62); \
+		b[ 5] = ROTL4(a[ 3], 28); \
+		b[15] = ROTL4(a[ 4], 27); \
+		b[16] = ROTL4(a[ 5], 36); \
+		b[ 1] = ROTL4(a[ 6], 44); \
+		b[11] = ROTL4(a[ 7],  6); \
+		b[21] = ROTL4(a[ 8], 55); \
+		b[ 6] = ROTL4(a[ 9], 20); \
+		b[ 7] = ROTL4(a[10],  3); \
+		b[17] = ROTL4(a[11], 10); \
+		b[ 2] = ROTL4(a[12], 43); \
+		b[12] = ROTL4(a[13], 25); \
+		b[22] = ROTL4(a[14], 39); \
+		b[23] = ROTL4(a[15], 41); \
+		b[ 8] = ROTL4(a[16], 45); \
+		b[18] = ROTL4(a[17], 15); \
+		b[ 3] = ROTL4(a[18], 21); \
+		b[13] = ROTL4(a[19],  8); \
+		b[14] = ROTL4(a[20], 18); \
+		b[24] = ROTL4(a[21],  2); \
+		b[ 9] = ROTL4(a[22], 61); \
+		b[19] = ROTL4(a[23], 56); \
+		b[ 4] = ROTL4(a[24], 14); \
+	} while (0)
+
+#define KECCAK_CHI(y)   do { \
+		a[(y) + 0] = b[(y) + 0] ^ (~b[(y) + 1] & b[(y) + 2]); \
+		a[(y) + 1] = b[(y) + 1] ^ (~b[(y) + 2] & b[(y) + 3]); \
+		a[(y) + 2] = b[(y) + 2] ^ (~b[(y) + 3] & b[(y) + 4]); \
+		a[(y) + 3] = b[(y) + 3] ^ (~b[(y) + 4] & b[(y) + 0]); \
+		a[(y) + 4] = b[(y) + 4] ^ (~b[(y) + 0] & b[(y) + 1]); \
+	} while (0)
+
+/*
+ * One block of 72 bytes per lane, already padded.
+ */
+__attribute__((target("avx2")))
+static void
+keccak512_4way_avx2(void *const dst[4], unsigned char blk[4][128])
+{
+	sph_u64x4 a[25], b[25], c[5], d[5];
+	int i, r;
+
+	for (i = 0; i < 9; i ++)
+		a[i] = LANES(blk, i, sph_dec64le);
+	for (; i < 25; i ++)
+		a[i] = (sph_u64x4){ 0, 0, 0, 0 };
+	for (r = 0; r < 24; r ++) {
+		for (i = 0; i < 5; i ++)
+			c[i] = a[i] ^ a[i + 5] ^ a[i + 10] ^ a[i + 15] ^ a[i + 20];
+		d[0] = c[4] ^ ROTL4(c[1], 1);
+		d[1] = c[0] ^ ROTL4(c[2], 1);
+		d[2] = c[1] ^ ROTL4(c[3], 1);
+		d[3] = c[2] ^ ROTL4(c[4], 1);
+		d[4] = c[3] ^ ROTL4(c[0], 1);
+		for (i = 0; i < 25; i ++)
+			a[i] ^= d[i % 5];
+		KECCAK_RHO_PI;
+		KECCAK_CHI(0);
+		KECCAK_CHI(5);
+		KECCAK_CHI(10);
+		KECCAK_CHI(15);
+		KECCAK_CHI(20);
+		a[0] ^= keccak_rc[r];
+	}
+	STORE_LANES(dst, a, 8, sph_enc64le);
+}
+
+static const sph_u64 skein_iv[8] = {
+	SPH_C64(0x4903ADFF749C51CE), SPH_C64(0x0D95DE399746DF03),
+	SPH_C64(0x8FD1934127C79BCE), SPH_C64(0x9A255629FF352CB1),
+	SPH_C64(0x5DB62599DF6CA7B0), SPH_C64(0xEABE394CA9D5C3F4),
+	SPH_C64(0x991112C71A75B523), SPH_C64(0xAE18A40B660FCC33)
+};
+
+#define SKEIN_MIX(a, b, rc)   do { \
+		x[a] += x[b]; \
+		x[b] = ROTL4(x[b], rc) ^ x[a]; \
+	} while (0)
+
+/* Subkey s, from the key and tweak words repeated past their ends */
+#define SKEIN_INJECT(s)   do { \
+		for (i = 0; i < 8; i ++) \
+			x[i] += k[(s) % 9 + i]; \
+		x[5] += t[(s) % 3]; \
+		x[6] += t[(s) % 3 + 1]; \
+		x[7] += (sph_u64)(s); \
+	} while (0)
+
+/*
+ * One UBI block: h = Threefish-512(key h, tweak t0/t1, m) ^ m.  The
+ * word permutation between rounds is folded into the mix indices, so
+ * eight rounds bring the words back to their places.
+ */
+__attribute__((target("avx2")))
+static void
+skein512_ubi_avx2(sph_u64x4 h[8], const sph_u64x4 m[8], sph_u64 t0,
+	sph_u64 t1)
+{
+	sph_u64x4 k[17], x[8];
+	sph_u64 t[4];
+	int i, s;
+
+	k[8] = (sph_u64x4){ SPH_C64(0x1BD11BDAA9FC1A22),
+		SPH_C64(0x1BD11BDAA9FC1A22), SPH_C64(0x1BD11BDAA9FC1A22),
+		SPH_C64(0x1BD11BDAA9FC1A22) };
+	for (i = 0; i < 8; i ++) {
+		k[i] = h[i];
+		k[8] ^= h[i];
+		x[i] = m[i];
+	}
+	for (i = 0; i < 8; i ++)
+		k[9 + i] = k[i];
+	t[0] = t0;
+	t[1] = t1;
+	t[2] = t0 ^ t1;
+	t[3] = t0;
+	for (s = 0; s < 18; s += 2) {
+		SKEIN_INJECT(s);
+		SKEIN_MIX(0, 1, 46); SKEIN_MIX(2, 3, 36);
+		SKEIN_MIX(4, 5, 19); SKEIN_MIX(6, 7, 37);
+		SKEIN_MIX(2, 1, 33); SKEIN_MIX(4, 7, 27);
+		SKEIN_MIX(6, 5, 14); SKEIN_MIX(0, 3, 42);
+		SKEIN_MIX(4, 1, 17); SKEIN_MIX(6, 3, 49);
+		SKEIN_MIX(0, 5, 36); SKEIN_MIX(2, 7, 39);
+		SKEIN_MIX(6, 1, 44); SKEIN_MIX(0, 7,  9);
+		SKEIN_MIX(2, 5, 54); SKEIN_MIX(4, 3, 56);
+		SKEIN_INJECT(s + 1);
+		SKEIN_MIX(0, 1, 39); SKEIN_MIX(2, 3, 30);
+		SKEIN_MIX(4, 5, 34); SKEIN_MIX(6, 7, 24);
+		SKEIN_MIX(2, 1, 13); SKEIN_MIX(4, 7, 50);
+		SKEIN_MIX(6, 5, 10); SKEIN_MIX(0, 3, 17);
+		SKEIN_MIX(4, 1, 25); SKEIN_MIX(6, 3, 29);
+		SKEIN_MIX(0, 5, 39); SKEIN_MIX(2, 7, 43);
+		SKEIN_MIX(6, 1,  8); SKEIN_MIX(0, 7, 35);
+		SKEIN_MIX(2, 5, 56); SKEIN_MIX(4, 3, 22);
+	}
+	SKEIN_INJECT(18);
+	for (i = 0; i < 8; i ++)
+		h[i] = x[i] ^ m[i];
+}
+
+/*
+ * The message block (first and final) then the output block.
+ */
+__attribute__((target("avx2")))
+static void
+skein512_4way_avx2(void *const dst[4], unsigned char blk[4][128], size_t len)
+{
+	sph_u64x4 h[8], m[8];
+	int i;
+
+	for (i = 0; i < 8; i ++) {
+		h[i] = (sph_u64x4){ skein_iv[i], skein_iv[i],
+			skein_iv[i], skein_iv[i] };
+		m[i] = LANES(blk, i, sph_dec64le);
+	}
+	skein512_ubi_avx2(h, m, len, SPH_C64(0xF000000000000000));
+	for (i = 0; i < 8; i ++)
+		m[i] = (sph_u64x4){ 0, 0, 0, 0 };
+	skein512_ubi_avx2(h, m, 8, SPH_C64(0xFF00000000000000));
+	STORE_LANES(dst, h, 8, sph_enc64le);
+}
+
+#undef ROTL4
+#undef ROTR4
+
+#endif
+
+/* see sph_4way.h */
+int
+sph_4way_avx2(void)
+{
+#if SPH_4WAY_AVX2
+	static int use = -1;
+
+	if (use < 0)
+		use = __builtin_cpu_supports("avx2") ? 1 : 0;
+	return use;
+#else
+	return 0;
+#endif
+}
+
+/* see sph_4way.h */
+void
+sph_blake512_4way(void *const dst[4], const void *const src[4], size_t len)
+{
+	int l;
+
+#if SPH_4WAY_AVX2
+	if (sph_4way_avx2()) {
+		unsigned char blk[4][128];
+
+		for (l = 0; l < 4; l ++) {
+			memcpy(blk[l], src[l], len);
+			memset(blk[l] + len, 0, 128 - len);
+			blk[l][len] = 0x80;
+			blk[l][111] |= 0x01;
+			sph_enc64be(blk[l] + 120, (sph_u64)len << 3);
+		}
+		blake512_4way_avx2(dst, blk, (sph_u64)len << 3);
+		return;
+	}
+#endif
+	for (l = 0; l < 4; l ++) {
+		sph_blake512_context cc;
+
+		sph_blake512_init(&cc);
+		sph_blake512(&cc, src[l], len);
+		sph_blake512_close(&cc, dst[l]);
+	}
+}
+
+/* see sph_4way.h */
+void
+sph_bmw512_4way(void *const dst[4], const void *const src[4], size_t len)
+{
+	int l;
+
+#if SPH_4WAY_AVX2
+	if (sph_4way_avx2()) {
+		unsigned char blk[4][128];
+
+		for (l = 0; l < 4; l ++) {
+			memcpy(blk[l], src[l], len);
+			memset(blk[l] + len, 0, 128 - len);
+			blk[l][len] = 0x80;
+			sph_enc64le(blk[l] + 120, (sph_u64)len << 3);
+		}
+		bmw512_4way_avx2(dst, blk);
+		return;
+	}
+#endif
+	for (l = 0; l < 4; l ++) {
+		sph_bmw512_context cc;
+
+		sph_bmw512_init(&cc);
+		sph_bmw512(&cc, src[l], len);
+		sph_bmw512_close(&cc, dst[l]);
+	}
+}
+
+/* see sph_4way.h */
+void
+sph_keccak512_4way(void *const dst[4], const void *const src[4], size_t len)
+{
+	int l;
+
+#if SPH_4WAY_AVX2
+	if (sph_4way_avx2()) {
+		unsigned char blk[4][128];
+
+		for (l = 0; l < 4; l ++) {
+			memcpy(blk[l], src[l], len);
+			memset(blk[l] + len, 0, 72 - len);
+			blk[l][len] = 0x01;
+			blk[l][71] |= 0x80;
+		}
+		keccak512_4way_avx2(dst, blk);
+		return;
+	}
+#endif
+	for (l = 0; l < 4; l ++) {
+		sph_keccak512_context cc;
+
+		sph_keccak512_init(&cc);
+		sph_keccak512(&cc, src[l], len);
+		sph_keccak512_close(&cc, dst[l]);
+	}
+}
+
+/* see sph_4way.h */
+void
+sph_skein512_4way(void *const dst[4], const void *const src[4], size_t len)
+{
+	int l;
+
+#if SPH_4WAY_AVX2
+	if (sph_4way_avx2()) {
+		unsigned char blk[4][128];
+
+		for (l = 0; l < 4; l ++) {
+			memcpy(blk[l], src[l], len);
+			memset(blk[l] + len, 0, 64 - len);
+		}
+		skein512_4way_avx2(dst, blk, len);
+		return;
+	}
+#endif
+	for (l = 0; l < 4; l ++) {
+		sph_skein512_context cc;
+
+		sph_skein512_init(&cc);
+		sph_skein512(&cc, src[l], len);
+		sph_skein512_close(&cc, dst[l]);
+	}
+}
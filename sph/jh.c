@@ -47,6 +47,24 @@
 #undef SPH_JH_64
 #endif
 
+/*
+ * With the 64-bit state layout on x86 (GCC or Clang), an AVX2 version of
+ * E8 is built alongside the portable one and picked at run time.  Define
+ * SPH_JH_AVX2 to 0 to leave it out.
+ */
+#if !defined SPH_JH_AVX2
+#if SPH_JH_64 && (defined __x86_64__ || defined __i386__) \
+	&& ((defined __GNUC__ && __GNUC__ >= 5) || defined __clang__)
+#define SPH_JH_AVX2   1
+#else
+#define SPH_JH_AVX2   0
+#endif
+#endif
+
+#if SPH_JH_AVX2
+#include <immintrin.h>
+#endif
+
 #ifdef _MSC_VER
 #pragma warning (disable: 4146)
 #endif
@@ -883,6 +901,130 @@ static const sph_u32 IV512[] = {
 
 #endif
 
+#if SPH_JH_AVX2
+
+/*
+ * Register pi holds h(2i) and h(2i+1), i.e. H.wide[4i..4i+3], so S works
+ * on all four registers at once with the even constants in the low lane
+ * and the odd ones in the high lane.  L mixes the low lanes (even words)
+ * with the high lanes (odd words), and Wz only touches the high lanes.
+ */
+#define AVX2_LO2HI(x)   _mm256_permute2x128_si256(x, x, 0x08)
+#define AVX2_HI2LO(x)   _mm256_permute2x128_si256(x, x, 0x81)
+
+#define AVX2_S(r)   do { \
+		__m256i c = _mm256_loadu_si256((const __m256i *)&C[(r) << 2]); \
+		__m256i tmp; \
+		p3 = _mm256_xor_si256(p3, ones); \
+		p0 = _mm256_xor_si256(p0, _mm256_andnot_si256(p2, c)); \
+		tmp = _mm256_xor_si256(c, _mm256_and_si256(p0, p1)); \
+		p0 = _mm256_xor_si256(p0, _mm256_and_si256(p2, p3)); \
+		p3 = _mm256_xor_si256(p3, _mm256_andnot_si256(p1, p2)); \
+		p1 = _mm256_xor_si256(p1, _mm256_and_si256(p0, p2)); \
+		p2 = _mm256_xor_si256(p2, _mm256_andnot_si256(p3, p0)); \
+		p0 = _mm256_xor_si256(p0, _mm256_or_si256(p1, p3)); \
+		p3 = _mm256_xor_si256(p3, _mm256_and_si256(p1, p2)); \
+		p1 = _mm256_xor_si256(p1, _mm256_and_si256(tmp, p0)); \
+		p2 = _mm256_xor_si256(p2, tmp); \
+	} while (0)
+
+#define AVX2_L   do { \
+		__m256i l0 = AVX2_LO2HI(p0); \
+		p0 = _mm256_xor_si256(p0, AVX2_LO2HI(p1)); \
+		p1 = _mm256_xor_si256(p1, AVX2_LO2HI(p2)); \
+		p2 = _mm256_xor_si256(p2, \
+			_mm256_xor_si256(AVX2_LO2HI(p3), l0)); \
+		p3 = _mm256_xor_si256(p3, l0); \
+		l0 = AVX2_HI2LO(p0); \
+		p0 = _mm256_xor_si256(p0, AVX2_HI2LO(p1)); \
+		p1 = _mm256_xor_si256(p1, AVX2_HI2LO(p2)); \
+		p2 = _mm256_xor_si256(p2, \
+			_mm256_xor_si256(AVX2_HI2LO(p3), l0)); \
+		p3 = _mm256_xor_si256(p3, l0); \
+	} while (0)
+
+#define AVX2_WZ1(x, c, n)   _mm256_blend_epi32(x, _mm256_or_si256( \
+		_mm256_and_si256(_mm256_srli_epi64(x, n), c), \
+		_mm256_slli_epi64(_mm256_and_si256(x, c), n)), 0xF0)
+
+#define AVX2_WZ(cv, n)   do { \
+		__m256i c = _mm256_set1_epi64x((long long)SPH_C64(cv)); \
+		p0 = AVX2_WZ1(p0, c, n); \
+		p1 = AVX2_WZ1(p1, c, n); \
+		p2 = AVX2_WZ1(p2, c, n); \
+		p3 = AVX2_WZ1(p3, c, n); \
+	} while (0)
+
+#define AVX2_W0   AVX2_WZ(0x5555555555555555,  1)
+#define AVX2_W1   AVX2_WZ(0x3333333333333333,  2)
+#define AVX2_W2   AVX2_WZ(0x0F0F0F0F0F0F0F0F,  4)
+#define AVX2_W3   AVX2_WZ(0x00FF00FF00FF00FF,  8)
+#define AVX2_W4   AVX2_WZ(0x0000FFFF0000FFFF, 16)
+#define AVX2_W5   AVX2_WZ(0x00000000FFFFFFFF, 32)
+#define AVX2_W6   do { \
+		p0 = _mm256_permute4x64_epi64(p0, 0xB4); \
+		p1 = _mm256_permute4x64_epi64(p1, 0xB4); \
+		p2 = _mm256_permute4x64_epi64(p2, 0xB4); \
+		p3 = _mm256_permute4x64_epi64(p3, 0xB4); \
+	} while (0)
+
+#define AVX2_SL(ro)   do { \
+		AVX2_S(r + ro); \
+		AVX2_L; \
+		AVX2_W ## ro; \
+	} while (0)
+
+/*
+ * Process nblocks 64-byte blocks from data; this is INPUT_BUF1, E8 and
+ * INPUT_BUF2 for each of them.
+ */
+__attribute__((target("avx2")))
+static void
+jh_avx2(sph_u64 *H, const unsigned char *data, size_t nblocks)
+{
+	__m256i p0, p1, p2, p3, m0, m1;
+	const __m256i ones = _mm256_set1_epi32(-1);
+	unsigned r;
+
+	p0 = _mm256_loadu_si256((const __m256i *)(H +  0));
+	p1 = _mm256_loadu_si256((const __m256i *)(H +  4));
+	p2 = _mm256_loadu_si256((const __m256i *)(H +  8));
+	p3 = _mm256_loadu_si256((const __m256i *)(H + 12));
+	for (; nblocks > 0; nblocks --, data += 64) {
+		m0 = _mm256_loadu_si256((const __m256i *)(data +  0));
+		m1 = _mm256_loadu_si256((const __m256i *)(data + 32));
+		p0 = _mm256_xor_si256(p0, m0);
+		p1 = _mm256_xor_si256(p1, m1);
+		for (r = 0; r < 42; r += 7) {
+			AVX2_SL(0);
+			AVX2_SL(1);
+			AVX2_SL(2);
+			AVX2_SL(3);
+			AVX2_SL(4);
+			AVX2_SL(5);
+			AVX2_SL(6);
+		}
+		p2 = _mm256_xor_si256(p2, m0);
+		p3 = _mm256_xor_si256(p3, m1);
+	}
+	_mm256_storeu_si256((__m256i *)(H +  0), p0);
+	_mm256_storeu_si256((__m256i *)(H +  4), p1);
+	_mm256_storeu_si256((__m256i *)(H +  8), p2);
+	_mm256_storeu_si256((__m256i *)(H + 12), p3);
+}
+
+static int
+jh_use_avx2(void)
+{
+	static int use = -1;
+
+	if (use < 0)
+		use = __builtin_cpu_supports("avx2") ? 1 : 0;
+	return use;
+}
+
+#endif
+
 static void
 jh_init(sph_jh_context *sc, const void *iv)
 {
@@ -916,6 +1058,29 @@ jh_core(sph_jh_context *sc, const void *data, size_t len)
 		return;
 	}
 
+#if SPH_JH_AVX2
+	if (jh_use_avx2()) {
+		size_t clen;
+
+		if (ptr > 0) {
+			clen = (sizeof sc->buf) - ptr;
+			memcpy(buf + ptr, data, clen);
+			data = (const unsigned char *)data + clen;
+			len -= clen;
+			jh_avx2(sc->H.wide, buf, 1);
+			sc->block_count ++;
+		}
+		clen = len & ~(size_t)((sizeof sc->buf) - 1);
+		jh_avx2(sc->H.wide, data, clen >> 6);
+		sc->block_count += clen >> 6;
+		data = (const unsigned char *)data + clen;
+		len -= clen;
+		memcpy(buf, data, len);
+		sc->ptr = len;
+		return;
+	}
+#endif
+
 	READ_STATE(sc);
 	while (len > 0) {
 		size_t clen;
@@ -0,0 +1,74 @@
+/*
+ * Four-message versions of the 512-bit hash functions that start the
+ * X11 family chains, for verifying several nonces of one work item at
+ * once.
+ *
+ * Each function hashes four messages of the same length and writes four
+ * 64-byte digests, the same bytes as the matching sph_*512() and
+ * sph_*512_close() calls.  They only handle messages that fit in one
+ * block, which covers the 80-byte header and the 64-byte chained hashes.
+ * On x86 with GCC or Clang the four messages go through the compression
+ * function side by side in AVX2 registers, one message per 64-bit lane;
+ * elsewhere, or on CPUs without AVX2, the messages are hashed one after
+ * the other with the portable code.
+ *
+ * @file     sph_4way.h
+ */
+
+#ifndef SPH_4WAY_H__
+#define SPH_4WAY_H__
+
+#include <stddef.h>
+#include "sph_types.h"
+
+/**
+ * Number of messages hashed by one call.
+ */
+#define SPH_4WAY_LANES   4
+
+/**
+ * Return non-zero if the functions below use AVX2 on this CPU.
+ */
+int sph_4way_avx2(void);
+
+/**
+ * BLAKE-512 of four messages of <code>len</code> bytes each
+ * (<code>len</code> at most 111).
+ *
+ * @param dst   the four 64-byte output buffers
+ * @param src   the four input messages
+ * @param len   the message length (in bytes)
+ */
+void sph_blake512_4way(void *const dst[4], const void *const src[4], size_t len);
+
+/**
+ * BMW-512 of four messages of <code>len</code> bytes each
+ * (<code>len</code> at most 119).
+ *
+ * @param dst   the four 64-byte output buffers
+ * @param src   the four input messages
+ * @param len   the message length (in bytes)
+ */
+void sph_bmw512_4way(void *const dst[4], const void *const src[4], size_t len);
+
+/**
+ * Keccak-512 of four messages of <code>len</code> bytes each
+ * (<code>len</code> at most 71).
+ *
+ * @param dst   the four 64-byte output buffers
+ * @param src   the four input messages
+ * @param len   the message length (in bytes)
+ */
+void sph_keccak512_4way(void *const dst[4], const void *const src[4], size_t len);
+
+/**
+ * Skein-512 of four messages of <code>len</code> bytes each
+ * (<code>len</code> from 1 to 64).
+ *
+ * @param dst   the four 64-byte output buffers
+ * @param src   the four input messages
+ * @param len   the message length (in bytes)
+ */
+void sph_skein512_4way(void *const dst[4], const void *const src[4], size_t len);
+
+#endif
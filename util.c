@@ -818,6 +818,157 @@ out:
   return rval;
 }
 
+/* Short jobs that used to get a thread each run on a fixed set of task
+ * workers instead. Every class has a bounded ring of task records and
+ * workers take from the highest priority class first. Submissions and
+ * housekeeping can block on the network for a long time, so together they
+ * never get the last worker, which is left for verification. Pool tests
+ * and event commands can block for minutes, so housekeeping gets at most
+ * HOUSEKEEPING_WORKERS of the others and never holds up submissions. A
+ * task whose ring is full gets a thread of its own. */
+#define TASK_QUEUE_SIZE 256
+#define MIN_TASK_WORKERS 4
+#define MAX_TASK_WORKERS 16
+#define HOUSEKEEPING_WORKERS 2
+
+struct task {
+  task_fn fn;
+  void *arg;
+};
+
+struct task_queue {
+  struct task tasks[TASK_QUEUE_SIZE];
+  unsigned int head;
+  unsigned int count;
+};
+
+static struct task_queue task_queues[TASK_CLASSES];
+static int task_workers = -1;
+static int task_busy[TASK_CLASSES];	/* workers running each class */
+static pthread_mutex_t task_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t task_cond = PTHREAD_COND_INITIALIZER;
+
+static const char *task_class_names[TASK_CLASSES] = { "Verify", "Submit", "Housekeeping" };
+
+/* Pop the next task a worker may run. Call with task_lock held. */
+static bool pop_task(struct task *task, enum task_class *cls)
+{
+  struct task_queue *tq;
+  int i;
+
+  for (i = 0; i < TASK_CLASSES; i++) {
+    tq = &task_queues[i];
+    if (!tq->count)
+      continue;
+    if (i != TASK_VERIFY && task_busy[TASK_SUBMIT] + task_busy[TASK_HOUSEKEEPING] >= task_workers - 1)
+      continue;
+    if (i == TASK_HOUSEKEEPING && task_busy[TASK_HOUSEKEEPING] >= HOUSEKEEPING_WORKERS)
+      continue;
+
+    *task = tq->tasks[tq->head];
+    tq->head = (tq->head + 1) % TASK_QUEUE_SIZE;
+    tq->count--;
+    *cls = (enum task_class)i;
+    task_busy[i]++;
+    return true;
+  }
+  return false;
+}
+
+static void *task_worker(void __maybe_unused *userdata)
+{
+  enum task_class cls;
+  struct task task;
+
+  pthread_detach(pthread_self());
+  RenameThread("Task");
+
+  mutex_lock(&task_lock);
+  while (42) {
+    if (!pop_task(&task, &cls)) {
+      pthread_cond_wait(&task_cond, &task_lock);
+      continue;
+    }
+    mutex_unlock(&task_lock);
+
+    task.fn(task.arg);
+
+    mutex_lock(&task_lock);
+    task_busy[cls]--;
+    /* An idle worker may have passed over a task this one held back */
+    if (cls != TASK_VERIFY)
+      pthread_cond_signal(&task_cond);
+  }
+
+  return NULL;
+}
+
+/* One worker per CPU within limits. Call with task_lock held. */
+static void start_task_workers(void)
+{
+  int i, n = MIN_TASK_WORKERS;
+  pthread_t pth;
+
+#ifdef _SC_NPROCESSORS_ONLN
+  if (sysconf(_SC_NPROCESSORS_ONLN) > n)
+    n = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+  if (n > MAX_TASK_WORKERS)
+    n = MAX_TASK_WORKERS;
+
+  task_workers = 0;
+  for (i = 0; i < n; i++) {
+    if (unlikely(pthread_create(&pth, NULL, task_worker, NULL)))
+      break;
+    task_workers++;
+  }
+}
+
+static void *task_thread(void *userdata)
+{
+  struct task *task = (struct task *)userdata;
+
+  pthread_detach(pthread_self());
+  task->fn(task->arg);
+  free(task);
+
+  return NULL;
+}
+
+/* Run fn(arg) asynchronously. It always runs, if need be in a thread of
+ * its own or, failing that, right here. */
+void queue_task(enum task_class cls, task_fn fn, void *arg)
+{
+  struct task_queue *tq = &task_queues[cls];
+  struct task *task;
+  pthread_t pth;
+
+  mutex_lock(&task_lock);
+  if (unlikely(task_workers < 0))
+    start_task_workers();
+  if (likely(task_workers > 1 && tq->count < TASK_QUEUE_SIZE)) {
+    task = &tq->tasks[(tq->head + tq->count++) % TASK_QUEUE_SIZE];
+    task->fn = fn;
+    task->arg = arg;
+    pthread_cond_signal(&task_cond);
+    mutex_unlock(&task_lock);
+    return;
+  }
+  mutex_unlock(&task_lock);
+
+  applog(LOG_DEBUG, "%s task queue full, starting a thread", task_class_names[cls]);
+  task = (struct task *)malloc(sizeof(struct task));
+  if (likely(task)) {
+    task->fn = fn;
+    task->arg = arg;
+    if (likely(!pthread_create(&pth, NULL, task_thread, task)))
+      return;
+    free(task);
+  }
+  applog(LOG_WARNING, "Failed to start a %s task thread, running it inline", task_class_names[cls]);
+  fn(arg);
+}
+
 int thr_info_create(struct thr_info *thr, pthread_attr_t *attr, void *(*start) (void *), void *arg)
 {
   cgsem_init(&thr->sem);
@@ -2657,6 +2808,9 @@ void dev_error(struct cgpu_info *dev, enum dev_reason reason)
     case REASON_DEV_THROTTLE:
       dev->dev_throttle_count++;
       break;
+    case REASON_DEV_SELFTEST:
+      dev->dev_selftest_count++;
+      break;
   }
 }
 
@@ -157,6 +157,18 @@ bool cg_completion_timeout(void *fn, void *fnarg, int timeout);
 #define cgsem_wait(_sem) _cgsem_wait(_sem, __FILE__, __func__, __LINE__)
 #define cgsem_mswait(_sem, _timeout) _cgsem_mswait(_sem, _timeout, __FILE__, __func__, __LINE__)
 
+/* Task classes of queue_task(), highest priority first */
+enum task_class {
+  TASK_VERIFY,		/* checking the nonces a device found */
+  TASK_SUBMIT,		/* submitting shares to getwork pools */
+  TASK_HOUSEKEEPING,	/* testing pools, running event commands */
+  TASK_CLASSES
+};
+
+typedef void (*task_fn)(void *arg);
+
+void queue_task(enum task_class cls, task_fn fn, void *arg);
+
 /* Align a size_t to 4 byte boundaries for fussy arches */
 static inline void align_len(size_t *len)
 {